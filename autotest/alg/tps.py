@@ -61,9 +61,97 @@ def tps_1():
 
     return 'success' 
 
+###############################################################################
+# Test the local mode, meant for large numbers of GCPs.
+
+def tps_2():
+
+    drv = gdal.GetDriverByName('MEM')
+    ds = drv.Create('foo', 1000, 1000)
+    gcp_list = []
+    for j in range(30):
+        for i in range(30):
+            pixel = i * 33.3 + (j % 3) * 5
+            line = j * 33.3 + (i % 5) * 3
+            x = 2 + 0.001 * pixel + 0.00001 * line + 1e-7 * pixel * line
+            y = 49 - 0.001 * line + 0.00002 * pixel
+            gcp_list.append(gdal.GCP(x, y, 0, pixel, line))
+    ds.SetGCPs(gcp_list, osr.GetUserInputAsWKT('WGS84'))
+
+    tr_global = gdal.Transformer(ds, None, ['METHOD=GCP_TPS', 'TPS_MODE=GLOBAL'])
+    tr_local = gdal.Transformer(ds, None, ['METHOD=GCP_TPS', 'TPS_MODE=LOCAL'])
+    if tr_global is None or tr_local is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Exact at the GCPs, forward and reverse
+    for gcp in gcp_list[::7]:
+        (success, pnt) = tr_local.TransformPoint(0, gcp.GCPPixel, gcp.GCPLine)
+        if not success or abs(pnt[0] - gcp.GCPX) > 1e-6 or abs(pnt[1] - gcp.GCPY) > 1e-6:
+            gdaltest.post_reason('fail')
+            print(gcp, pnt)
+            return 'fail'
+        (success, pnt) = tr_local.TransformPoint(1, gcp.GCPX, gcp.GCPY)
+        if not success or abs(pnt[0] - gcp.GCPPixel) > 1e-3 or abs(pnt[1] - gcp.GCPLine) > 1e-3:
+            gdaltest.post_reason('fail')
+            print(gcp, pnt)
+            return 'fail'
+
+    # Close to the global spline between them, away from the borders
+    for (pixel, line) in [ (333.3, 120.1), (500.2, 501.7), (700.5, 650.5), (250, 750) ]:
+        (success, pnt_global) = tr_global.TransformPoint(0, pixel, line)
+        (success, pnt_local) = tr_local.TransformPoint(0, pixel, line)
+        if abs(pnt_global[0] - pnt_local[0]) > 1e-5 or abs(pnt_global[1] - pnt_local[1]) > 1e-5:
+            gdaltest.post_reason('fail')
+            print(pixel, line, pnt_global, pnt_local)
+            return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test the local mode with most of the GCPs clustered in a small area.
+
+def tps_3():
+
+    drv = gdal.GetDriverByName('MEM')
+    ds = drv.Create('foo', 1000, 1000)
+    gcp_list = []
+    for j in range(20):
+        for i in range(20):
+            gcp_list.append((i * 50 + 25 + (j % 3) * 5, j * 50 + 25 + (i % 5) * 3))
+    for j in range(50):
+        for i in range(50):
+            gcp_list.append((400 + i * 0.2 + (j % 3) * 0.03, 600 + j * 0.2))
+    for k in range(len(gcp_list)):
+        (pixel, line) = gcp_list[k]
+        x = 2 + 0.001 * pixel + 0.00001 * line + 1e-7 * pixel * line
+        y = 49 - 0.001 * line + 0.00002 * pixel
+        gcp_list[k] = gdal.GCP(x, y, 0, pixel, line)
+    ds.SetGCPs(gcp_list, osr.GetUserInputAsWKT('WGS84'))
+
+    tr = gdal.Transformer(ds, None, ['METHOD=GCP_TPS', 'TPS_MODE=LOCAL'])
+    if tr is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    for gcp in gcp_list[::13]:
+        (success, pnt) = tr.TransformPoint(0, gcp.GCPPixel, gcp.GCPLine)
+        if not success or abs(pnt[0] - gcp.GCPX) > 1e-6 or abs(pnt[1] - gcp.GCPY) > 1e-6:
+            gdaltest.post_reason('fail')
+            print(gcp, pnt)
+            return 'fail'
+        (success, pnt) = tr.TransformPoint(1, gcp.GCPX, gcp.GCPY)
+        if not success or abs(pnt[0] - gcp.GCPPixel) > 1e-3 or abs(pnt[1] - gcp.GCPLine) > 1e-3:
+            gdaltest.post_reason('fail')
+            print(gcp, pnt)
+            return 'fail'
+
+    return 'success'
 
 gdaltest_list = [
     tps_1,
+    tps_2,
+    tps_3,
     ]
 
 if __name__ == '__main__':
@@ -35,6 +35,7 @@
 import os
 import sys
 import shutil
+import struct
 
 sys.path.append( '../pymod' )
 
@@ -1689,7 +1690,255 @@ def warp_51():
         return 'fail'
 
     return 'success'
-    
+
+###############################################################################
+# Test that the rows scheduled by chunks over a varying number of threads
+# give the same result as the mono-threaded computation, and that the
+# reported progress remains monotonic.
+
+def warp_52_progress_callback(pct, message, user_data):
+    if pct < user_data[0]:
+        user_data[1] = False
+    user_data[0] = pct
+    return 1
+
+def warp_52():
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+
+    old_val = gdal.GetConfigOption('GDAL_NUM_THREADS')
+    cs_ref = None
+    for num_threads in [ '1', '3', '16', 'ALL_CPUS' ]:
+        gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+        dst_ds = gdal.GetDriverByName('MEM').Create('', 400, 300)
+        dst_ds.SetProjection(src_ds.GetProjectionRef())
+        dst_ds.SetGeoTransform([440720, 15, 0, 3751320, 0, -20])
+        progress_data = [ 0, True ]
+        ret = gdal.ReprojectImage( src_ds, dst_ds, None, None,
+                                   gdal.GRA_Cubic, 0, 0.125,
+                                   warp_52_progress_callback, progress_data )
+        cs = dst_ds.GetRasterBand(1).Checksum()
+        dst_ds = None
+
+        if ret != 0:
+            gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+            gdaltest.post_reason('failed')
+            print(num_threads)
+            return 'fail'
+        if not progress_data[1] or progress_data[0] < 0.99:
+            gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+            gdaltest.post_reason('non monotonic or incomplete progress')
+            print(num_threads)
+            return 'fail'
+        if cs_ref is None:
+            cs_ref = cs
+        elif cs != cs_ref:
+            gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+            gdaltest.post_reason('failed')
+            print(num_threads, cs, cs_ref)
+            return 'fail'
+
+    gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+
+    return 'success'
+
+###############################################################################
+# Test the grid mode of the approximate transformer against the exact
+# transformer.  The source bands hold the column and row of their pixels,
+# which bilinear resampling interpolates exactly, so that each warped pixel
+# holds the source location computed by the transformer.
+
+def warp_53_reproject(grid, max_error):
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+    coord_ds = gdal.GetDriverByName('MEM').Create('', 100, 100, 2,
+                                                  gdal.GDT_Float64)
+    coord_ds.SetProjection(src_ds.GetProjectionRef())
+    coord_ds.SetGeoTransform(src_ds.GetGeoTransform())
+    cols = []
+    rows = []
+    for y in range(100):
+        for x in range(100):
+            cols.append(x)
+            rows.append(y)
+    coord_ds.GetRasterBand(1).WriteRaster(0, 0, 100, 100,
+        struct.pack('d' * (100 * 100), *cols))
+    coord_ds.GetRasterBand(2).WriteRaster(0, 0, 100, 100,
+        struct.pack('d' * (100 * 100), *rows))
+
+    dst_ds = gdal.GetDriverByName('MEM').Create('', 200, 150, 2,
+                                                gdal.GDT_Float64)
+    sr = osr.SpatialReference()
+    sr.ImportFromEPSG(4326)
+    dst_ds.SetProjection(sr.ExportToWkt())
+    dst_ds.SetGeoTransform([-117.641, 0.00035, 0, 33.902, 0, -0.00035])
+
+    old_val = gdal.GetConfigOption('GDAL_APPROX_TRANSFORMER_GRID')
+    gdal.SetConfigOption('GDAL_APPROX_TRANSFORMER_GRID', grid)
+    ret = gdal.ReprojectImage( coord_ds, dst_ds, None, None,
+                               gdal.GRA_Bilinear, 0, max_error )
+    gdal.SetConfigOption('GDAL_APPROX_TRANSFORMER_GRID', old_val)
+    if ret != 0:
+        return None
+
+    return ( struct.unpack('d' * (200 * 150),
+                 dst_ds.GetRasterBand(1).ReadRaster(0, 0, 200, 150)),
+             struct.unpack('d' * (200 * 150),
+                 dst_ds.GetRasterBand(2).ReadRaster(0, 0, 200, 150)) )
+
+def warp_53():
+
+    max_error = 0.125
+    ref_data = warp_53_reproject('NO', 0)
+    data = warp_53_reproject('YES', max_error)
+    if ref_data is None or data is None:
+        gdaltest.post_reason('failed')
+        return 'fail'
+
+    (ref_x, ref_y) = ref_data
+    (x, y) = data
+    nb_checked = 0
+    for i in range(200 * 150):
+        # Skip the source edges, where bilinear resampling lacks neighbours
+        if ref_x[i] < 1 or ref_x[i] > 98 or ref_y[i] < 1 or ref_y[i] > 98:
+            continue
+        nb_checked = nb_checked + 1
+        error = abs(x[i] - ref_x[i]) + abs(y[i] - ref_y[i])
+        if error > max_error + 1e-6:
+            gdaltest.post_reason('failed')
+            print(i, ref_x[i], ref_y[i], x[i], y[i])
+            return 'fail'
+
+    if nb_checked < 10000:
+        gdaltest.post_reason('failed')
+        print(nb_checked)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test the typed bilinear and cubic paths of Byte and Float32 warps with
+# source nodata and source mask against the general case, which is used
+# when the working data type is Float64.
+
+warp_54_vrt = """<VRTDataset rasterXSize="133" rasterYSize="133" subClass="VRTWarpedDataset">
+  <GeoTransform>440720,45,0,3751320,0,-45</GeoTransform>
+  <VRTRasterBand dataType="%s" band="1" subClass="VRTWarpedRasterBand"/>
+  <BlockXSize>133</BlockXSize>
+  <BlockYSize>133</BlockYSize>
+  <GDALWarpOptions>
+    <ResampleAlg>%s</ResampleAlg>
+    <WorkingDataType>%s</WorkingDataType>
+    <SourceDataset relativeToVRT="0">/vsimem/warp_54_src.tif</SourceDataset>
+    <Transformer>
+      <GenImgProjTransformer>
+        <SrcGeoTransform>440720,60,0,3751320,0,-60</SrcGeoTransform>
+        <SrcInvGeoTransform>-7345.333333333333,0.01666666666666667,0,62522,0,-0.01666666666666667</SrcInvGeoTransform>
+        <DstGeoTransform>440720,45,0,3751320,0,-45</DstGeoTransform>
+        <DstInvGeoTransform>-9793.777777777777,0.02222222222222222,0,83362.66666666667,0,-0.02222222222222222</DstInvGeoTransform>
+      </GenImgProjTransformer>
+    </Transformer>
+    <BandList>
+      <BandMapping src="1" dst="1">%s</BandMapping>
+    </BandList>
+  </GDALWarpOptions>
+</VRTDataset>"""
+
+def warp_54_warp(datatype, resample, working_datatype, band_mapping):
+
+    vrt_ds = gdal.Open( warp_54_vrt % (datatype, resample,
+                                       working_datatype, band_mapping) )
+    if vrt_ds is None:
+        return None
+    data = vrt_ds.GetRasterBand(1).ReadRaster(0, 0, 133, 133,
+                                              buf_type = gdal.GDT_Float64)
+    return struct.unpack('d' * (133 * 133), data)
+
+def warp_54():
+
+    src_ds = gdal.Open('../gcore/data/utmsmall.tif')
+
+    # A hole in the middle of the source, and a masked out band on its
+    # left, so that kernels partly overlap invalid pixels
+    mask = []
+    for y in range(100):
+        for x in range(100):
+            if (x >= 30 and x < 60 and y >= 20 and y < 50) or x < 5:
+                mask.append(0)
+            else:
+                mask.append(255)
+
+    for datatype in [ 'Byte', 'Float32' ]:
+        for masking in [ 'nodata', 'mask' ]:
+
+            gdal_dt = gdal.GetDataTypeByName(datatype)
+            ds = gdal.GetDriverByName('GTiff').Create('/vsimem/warp_54_src.tif',
+                                                       100, 100, 1, gdal_dt)
+            data = list(struct.unpack('f' * (100 * 100),
+                src_ds.GetRasterBand(1).ReadRaster(0, 0, 100, 100,
+                                                   buf_type = gdal.GDT_Float32)))
+            if datatype == 'Float32':
+                data = [ v * 1.25 + 0.5 for v in data ]
+            if masking == 'nodata':
+                for i in range(100 * 100):
+                    if mask[i] == 0:
+                        data[i] = 1
+                band_mapping = '<SrcNoDataReal>1</SrcNoDataReal><SrcNoDataImag>0</SrcNoDataImag><DstNoDataReal>0</DstNoDataReal><DstNoDataImag>0</DstNoDataImag>'
+            else:
+                ds.CreateMaskBand(gdal.GMF_PER_DATASET)
+                ds.GetRasterBand(1).GetMaskBand().WriteRaster(0, 0, 100, 100,
+                    struct.pack('B' * (100 * 100), *mask))
+                band_mapping = ''
+            ds.GetRasterBand(1).WriteRaster(0, 0, 100, 100,
+                struct.pack('f' * (100 * 100), *data),
+                buf_type = gdal.GDT_Float32)
+            ds = None
+
+            for resample in [ 'Bilinear', 'Cubic' ]:
+                ref_data = warp_54_warp(datatype, resample, 'Float64', band_mapping)
+                got_data = warp_54_warp(datatype, resample, datatype, band_mapping)
+                if ref_data is None or got_data is None:
+                    gdal.Unlink('/vsimem/warp_54_src.tif')
+                    gdal.Unlink('/vsimem/warp_54_src.tif.msk')
+                    gdaltest.post_reason('failed')
+                    print(datatype, masking, resample)
+                    return 'fail'
+
+                # Byte values must be identical.  The only exception is a
+                # value that rounds to the destination nodata (0): a Byte
+                # working buffer avoids it and writes 1, whereas the Float64
+                # one only reaches 0 when converted to Byte afterwards.
+                # Float32 values may differ in their last bits, as the
+                # SSE2 code path sums the kernel terms in another order.
+                if datatype == 'Byte':
+                    tolerance = 0
+                else:
+                    tolerance = 1e-3
+                nb_valid = 0
+                for i in range(133 * 133):
+                    if ref_data[i] != 0:
+                        nb_valid = nb_valid + 1
+                    if masking == 'nodata' and datatype == 'Byte' and \
+                       ref_data[i] == 0 and got_data[i] == 1:
+                        continue
+                    if abs(ref_data[i] - got_data[i]) > tolerance:
+                        gdal.Unlink('/vsimem/warp_54_src.tif')
+                        gdal.Unlink('/vsimem/warp_54_src.tif.msk')
+                        gdaltest.post_reason('failed')
+                        print(datatype, masking, resample, i, ref_data[i], got_data[i])
+                        return 'fail'
+                if nb_valid == 0 or nb_valid == 133 * 133:
+                    gdal.Unlink('/vsimem/warp_54_src.tif')
+                    gdal.Unlink('/vsimem/warp_54_src.tif.msk')
+                    gdaltest.post_reason('failed')
+                    print(datatype, masking, resample, nb_valid)
+                    return 'fail'
+
+            gdal.Unlink('/vsimem/warp_54_src.tif')
+            gdal.Unlink('/vsimem/warp_54_src.tif.msk')
+
+    return 'success'
+
 gdaltest_list = [
     warp_1,
     warp_1_short,
@@ -1758,7 +2007,10 @@ gdaltest_list = [
     warp_48,
     warp_49,
     warp_50,
-    warp_51
+    warp_51,
+    warp_52,
+    warp_53,
+    warp_54
     ]
 
 
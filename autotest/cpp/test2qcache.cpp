@@ -0,0 +1,159 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test that the 2Q block cache policy resists scans
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cpl_conv.h"
+#include "gdal_priv.h"
+
+#define BLOCK_SIZE      16
+#define HOT_SIZE        64      /* 4x4 blocks */
+#define SCAN_SIZE       1024    /* 64x64 blocks */
+
+/************************************************************************/
+/*                Band counting the blocks actually read                */
+/************************************************************************/
+
+class CountingRasterBand : public GDALRasterBand
+{
+    public:
+        int nReads;
+
+        CountingRasterBand( GDALDataset* poDSIn, int nSize )
+        {
+            poDS = poDSIn;
+            nBand = 1;
+            nRasterXSize = nSize;
+            nRasterYSize = nSize;
+            eDataType = GDT_Byte;
+            nBlockXSize = BLOCK_SIZE;
+            nBlockYSize = BLOCK_SIZE;
+            nReads = 0;
+        }
+
+        virtual CPLErr IReadBlock( int, int, void* pImage )
+        {
+            nReads ++;
+            memset(pImage, 1, BLOCK_SIZE * BLOCK_SIZE);
+            return CE_None;
+        }
+};
+
+class CountingDataset : public GDALDataset
+{
+    public:
+        CountingDataset( int nSize )
+        {
+            nRasterXSize = nSize;
+            nRasterYSize = nSize;
+            SetBand(1, new CountingRasterBand(this, nSize));
+        }
+};
+
+/* Reference all the blocks of the band */
+static void read_blocks( GDALRasterBand* poBand )
+{
+    int nBlocks = poBand->GetXSize() / BLOCK_SIZE;
+    for( int j = 0; j < nBlocks; j++ )
+    {
+        for( int i = 0; i < nBlocks; i++ )
+        {
+            GDALRasterBlock* poBlock = poBand->GetLockedBlockRef(i, j);
+            if( poBlock != NULL )
+                poBlock->DropLock();
+        }
+    }
+}
+
+int main( int argc, char** argv )
+{
+    int nRet = 0;
+
+    /* Must be set before the first block gets into the cache */
+    CPLSetConfigOption("GDAL_RB_CACHE_POLICY", "2Q");
+
+    GDALAllRegister();
+    argc = GDALGeneralCmdLineProcessor( argc, &argv, 0 );
+    CSLDestroy(argv);
+
+    /* Room for 64 blocks */
+    GDALSetCacheMax( 64 * BLOCK_SIZE * BLOCK_SIZE );
+
+    CountingDataset* poHotDS = new CountingDataset(HOT_SIZE);
+    CountingDataset* poScanDS = new CountingDataset(SCAN_SIZE);
+    CountingRasterBand* poHotBand = (CountingRasterBand*) poHotDS->GetRasterBand(1);
+    CountingRasterBand* poScanBand = (CountingRasterBand*) poScanDS->GetRasterBand(1);
+    int nHotBlocks = (HOT_SIZE / BLOCK_SIZE) * (HOT_SIZE / BLOCK_SIZE);
+
+    /* The second pass references again all the hot blocks, including the */
+    /* newest one, which is at the head of the probation list */
+    read_blocks( poHotBand );
+    read_blocks( poHotBand );
+    if( poHotBand->nReads != nHotBlocks )
+    {
+        fprintf(stderr, "%d hot blocks read instead of %d.\n",
+                poHotBand->nReads, nHotBlocks);
+        nRet = 1;
+    }
+
+    /* A scan over 64 times the cache size must not flush the hot blocks */
+    read_blocks( poScanBand );
+    if( poScanBand->nReads != (SCAN_SIZE / BLOCK_SIZE) * (SCAN_SIZE / BLOCK_SIZE) )
+    {
+        fprintf(stderr, "%d scan blocks read.\n", poScanBand->nReads);
+        nRet = 1;
+    }
+
+    poHotBand->nReads = 0;
+    read_blocks( poHotBand );
+    if( poHotBand->nReads != 0 )
+    {
+        fprintf(stderr, "%d hot blocks out of %d were flushed by the scan.\n",
+                poHotBand->nReads, nHotBlocks);
+        nRet = 1;
+    }
+
+    /* The scan itself must have been limited to the cache size */
+    if( GDALGetCacheUsed64() > GDALGetCacheMax64() )
+    {
+        fprintf(stderr, "Cache used (" CPL_FRMT_GIB ") > cache max (" CPL_FRMT_GIB ").\n",
+                GDALGetCacheUsed64(), GDALGetCacheMax64());
+        nRet = 1;
+    }
+
+    delete poHotDS;
+    delete poScanDS;
+
+    GDALDestroyDriverManager();
+
+    if( nRet == 0 )
+        printf("OK\n");
+
+    return nRet;
+}
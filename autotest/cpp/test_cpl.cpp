@@ -33,6 +33,9 @@
 #include "cpl_list.h"
 #include "cpl_hash_set.h"
 #include "cpl_string.h"
+#include "cpl_csv.h"
+#include "cpl_multiproc.h"
+#include "cpl_minixml.h"
 
 namespace tut
 {
@@ -660,5 +663,203 @@ namespace tut
         ensure( "9g", EQUAL(oNVL.FetchNameValue("D"),"DD") );
     }
 
-} // namespace tut
 
+    static void WriteCSVTestFile( const char* pszFilename, const char* pszContent )
+    {
+        VSILFILE* fp = VSIFOpenL( pszFilename, "wb" );
+        ensure( "cannot create test file", fp != NULL );
+        VSIFWriteL( pszContent, 1, strlen(pszContent), fp );
+        VSIFCloseL( fp );
+    }
+
+    static CPLString GetCSVTestName( const char* pszFilename, const char* pszKey )
+    {
+        CPLString osName( CSVGetField( pszFilename, "CODE", pszKey,
+                                       CC_Integer, "NAME" ) );
+        CSVDeaccess( pszFilename );
+        return osName;
+    }
+
+    // Test compiled CSV files (.csvb)
+    template<>
+    template<>
+    void object::test<10>()
+    {
+        const char* pszCSV = "tmp/test_cpl_10.csv";
+        const char* pszCSVB = "tmp/test_cpl_10.csvb";
+        const char* pszOther = "tmp/test_cpl_10_other.csv";
+
+        WriteCSVTestFile( pszCSV, "CODE,NAME\n1,one\n2,two\n3,six\n" );
+        WriteCSVTestFile( pszOther, "CODE,NAME\n1,ONE\n2,TWO\n3,SIX\n" );
+
+        // Round trip
+        ensure( "10a", CSVCompile( pszCSV, NULL ) );
+        VSIStatBufL sStat;
+        ensure( "10b", VSIStatL( pszCSVB, &sStat ) == 0 );
+        ensure_equals( "10c", GetCSVTestName( pszCSV, "2" ), CPLString("two") );
+        ensure_equals( "10d", GetCSVTestName( pszCSV, "3" ), CPLString("six") );
+
+        // The compiled file is loaded instead of the text : compile another
+        // file of the same size as the companion of the CSV file
+        ensure( "10e", CSVCompile( pszOther, pszCSVB ) );
+        ensure_equals( "10f", GetCSVTestName( pszCSV, "2" ), CPLString("TWO") );
+        CPLSetConfigOption( "CPL_CSV_COMPILED", "NO" );
+        ensure_equals( "10g", GetCSVTestName( pszCSV, "2" ), CPLString("two") );
+        CPLSetConfigOption( "CPL_CSV_COMPILED", NULL );
+
+        // Stale compiled file : size of the CSV file changed
+        WriteCSVTestFile( pszCSV, "CODE,NAME\n1,one\n2,two\n3,six\n4,four\n" );
+        ensure_equals( "10h", GetCSVTestName( pszCSV, "2" ), CPLString("two") );
+        ensure_equals( "10i", GetCSVTestName( pszCSV, "4" ), CPLString("four") );
+
+        // Stale compiled file : CSV file rewritten with the same size
+        WriteCSVTestFile( pszCSV, "CODE,NAME\n1,one\n2,two\n3,six\n" );
+        ensure( "10j", CSVCompile( pszOther, pszCSVB ) );
+        CPLSleep( 1.1 );
+        WriteCSVTestFile( pszCSV, "CODE,NAME\n1,one\n2,owt\n3,six\n" );
+        ensure_equals( "10k", GetCSVTestName( pszCSV, "2" ), CPLString("owt") );
+
+        // Corrupted compiled files : an out of range line offset, and a
+        // truncated file
+        ensure( "10l", CSVCompile( pszCSV, NULL ) );
+        VSILFILE* fp = VSIFOpenL( pszCSVB, "r+b" );
+        ensure( "10m", fp != NULL );
+        GByte abyBadOffset[4] = { 0xFF, 0xFF, 0xFF, 0x7F };
+        VSIFSeekL( fp, 32, SEEK_SET );
+        VSIFWriteL( abyBadOffset, 1, 4, fp );
+        VSIFCloseL( fp );
+        ensure_equals( "10n", GetCSVTestName( pszCSV, "2" ), CPLString("owt") );
+
+        ensure( "10o", CSVCompile( pszCSV, NULL ) );
+        fp = VSIFOpenL( pszCSVB, "r+b" );
+        ensure( "10p", fp != NULL );
+        VSIFTruncateL( fp, 40 );
+        VSIFCloseL( fp );
+        ensure_equals( "10q", GetCSVTestName( pszCSV, "3" ), CPLString("six") );
+
+        VSIUnlink( pszCSV );
+        VSIUnlink( pszCSVB );
+        VSIUnlink( pszOther );
+    }
+
+
+    // Test the XML pull parser
+    template<>
+    template<>
+    void object::test<11>()
+    {
+        const char* pszXML =
+            "<?xml version=\"1.0\"?>"
+            "<!-- first --><a x=\"1\" y='&lt;2&gt;'><b>t&amp;u</b><c/>"
+            "<![CDATA[<raw>]]></a>";
+
+        static const struct
+        {
+            CPLXMLEventType eEvent;
+            const char*     pszName;
+            const char*     pszValue;
+            int             nDepth;
+        } asExpected[] = {
+            { CXE_StartElement, "?xml", NULL, 1 },
+            { CXE_Attribute, "version", "1.0", 1 },
+            { CXE_EndElement, "?xml", NULL, 0 },
+            { CXE_Comment, NULL, " first ", 0 },
+            { CXE_StartElement, "a", NULL, 1 },
+            { CXE_Attribute, "x", "1", 1 },
+            { CXE_Attribute, "y", "<2>", 1 },
+            { CXE_StartElement, "b", NULL, 2 },
+            { CXE_Text, NULL, "t&u", 2 },
+            { CXE_EndElement, "b", NULL, 1 },
+            { CXE_StartElement, "c", NULL, 2 },
+            { CXE_EndElement, "c", NULL, 1 },
+            { CXE_Text, NULL, "<raw>", 1 },
+            { CXE_EndElement, "a", NULL, 0 },
+            { CXE_EndDocument, NULL, NULL, 0 },
+            { CXE_EndDocument, NULL, NULL, 0 }
+        };
+
+        CPLXMLReader* psReader = CPLXMLReaderCreate( pszXML );
+        ensure( "11a", psReader != NULL );
+        for( size_t i = 0; i < sizeof(asExpected) / sizeof(asExpected[0]); i++ )
+        {
+            CPLString osMsg;
+            osMsg.Printf( "11b event %d", (int)i );
+            ensure_equals( osMsg.c_str(), (int)CPLXMLReaderNext( psReader ),
+                           (int)asExpected[i].eEvent );
+            if( asExpected[i].pszName != NULL )
+                ensure_equals( osMsg.c_str(),
+                               CPLString(CPLXMLReaderGetName( psReader )),
+                               CPLString(asExpected[i].pszName) );
+            if( asExpected[i].pszValue != NULL )
+                ensure_equals( osMsg.c_str(),
+                               CPLString(CPLXMLReaderGetValue( psReader )),
+                               CPLString(asExpected[i].pszValue) );
+            ensure_equals( osMsg.c_str(), CPLXMLReaderGetDepth( psReader ),
+                           asExpected[i].nDepth );
+        }
+        CPLXMLReaderDestroy( psReader );
+
+        // Not well formed documents end with CXE_Error, for good
+        const char* apszBadXML[] = { "<a><b></a>", "<a>", "</a>", "<a x=>" };
+        CPLPushErrorHandler( CPLQuietErrorHandler );
+        for( size_t i = 0; i < sizeof(apszBadXML) / sizeof(apszBadXML[0]); i++ )
+        {
+            psReader = CPLXMLReaderCreate( apszBadXML[i] );
+            ensure( "11c", psReader != NULL );
+            CPLXMLEventType eEvent;
+            int nEvents = 0;
+            while( (eEvent = CPLXMLReaderNext( psReader )) != CXE_Error &&
+                   eEvent != CXE_EndDocument && nEvents < 100 )
+                nEvents ++;
+            ensure_equals( apszBadXML[i], (int)eEvent, (int)CXE_Error );
+            ensure_equals( apszBadXML[i], (int)CPLXMLReaderNext( psReader ),
+                           (int)CXE_Error );
+            CPLXMLReaderDestroy( psReader );
+        }
+        CPLPopErrorHandler();
+    }
+
+    // Test arena allocated XML trees
+    template<>
+    template<>
+    void object::test<12>()
+    {
+        const char* pszXML = "<a x=\"1\"><b>text</b><c/></a>";
+
+        CPLXMLNode* psArenaTree = CPLParseXMLStringArena( pszXML );
+        ensure( "12a", psArenaTree != NULL );
+        CPLXMLNode* psTree = CPLParseXMLString( pszXML );
+        ensure( "12b", psTree != NULL );
+
+        char* pszArenaXML = CPLSerializeXMLTree( psArenaTree );
+        char* pszXMLOut = CPLSerializeXMLTree( psTree );
+        ensure_equals( "12c", CPLString(pszArenaXML), CPLString(pszXMLOut) );
+        CPLFree( pszArenaXML );
+        CPLFree( pszXMLOut );
+        ensure_equals( "12d", CPLString(CPLGetXMLValue( psArenaTree, "b", "" )),
+                       CPLString("text") );
+
+        // Trees not returned by CPLParseXMLStringArena() are rejected,
+        // and left untouched
+        CPLErrorReset();
+        CPLPushErrorHandler( CPLQuietErrorHandler );
+        CPLDestroyXMLArenaTree( psTree );
+        ensure_equals( "12e", (int)CPLGetLastErrorType(), (int)CE_Failure );
+        CPLErrorReset();
+        CPLDestroyXMLArenaTree( psArenaTree->psChild );
+        ensure_equals( "12f", (int)CPLGetLastErrorType(), (int)CE_Failure );
+        CPLPopErrorHandler();
+        CPLDestroyXMLNode( psTree );
+
+        CPLErrorReset();
+        CPLDestroyXMLArenaTree( psArenaTree );
+        ensure_equals( "12g", (int)CPLGetLastErrorType(), (int)CE_None );
+
+        // A tree can only be destroyed once
+        CPLPushErrorHandler( CPLQuietErrorHandler );
+        CPLDestroyXMLArenaTree( psArenaTree );
+        CPLPopErrorHandler();
+        ensure_equals( "12h", (int)CPLGetLastErrorType(), (int)CE_Failure );
+    }
+
+} // namespace tut
@@ -0,0 +1,200 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test GDALBorrowBlock() / GDALReleaseBorrowedBlock()
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_virtualmem.h"
+#include "gdal.h"
+
+#define XSIZE   100
+#define YSIZE   50
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) \
+        { \
+            fprintf( stderr, "%s:%d: check '%s' failed\n", \
+                     __FILE__, __LINE__, #cond ); \
+            exit( 1 ); \
+        } \
+    } while(0)
+
+/* Fill band 1 (and 2 if present) of hDS with a known pattern */
+static void fill_pattern( GDALDatasetH hDS )
+{
+    GByte abyLine[XSIZE];
+    for( int iBand = 1; iBand <= GDALGetRasterCount(hDS); iBand++ )
+    {
+        for( int j = 0; j < YSIZE; j++ )
+        {
+            for( int i = 0; i < XSIZE; i++ )
+                abyLine[i] = (GByte)(i + j * 3 + iBand * 7);
+            GDALRasterIO( GDALGetRasterBand(hDS, iBand), GF_Write,
+                          0, j, XSIZE, 1, abyLine, XSIZE, 1, GDT_Byte, 0, 0 );
+        }
+    }
+}
+
+/* Borrow every block of band iBand and compare it with the pattern. */
+/* Returns the number of blocks that were borrowed with a non-NULL handle. */
+static int check_borrow( GDALDatasetH hDS, int iBand )
+{
+    GDALRasterBandH hBand = GDALGetRasterBand(hDS, iBand);
+    int nBlockXSize, nBlockYSize;
+    int nHandles = 0;
+
+    GDALGetBlockSize( hBand, &nBlockXSize, &nBlockYSize );
+    for( int nYBlock = 0; nYBlock * nBlockYSize < YSIZE; nYBlock++ )
+    {
+        for( int nXBlock = 0; nXBlock * nBlockXSize < XSIZE; nXBlock++ )
+        {
+            GSpacing nPixelSpace, nLineSpace;
+            void* hBorrow = NULL;
+            const GByte* pabyData = (const GByte*)
+                GDALBorrowBlock( hBand, nXBlock, nYBlock,
+                                 &nPixelSpace, &nLineSpace, &hBorrow );
+            CHECK( pabyData != NULL );
+            if( hBorrow != NULL )
+                nHandles ++;
+
+            for( int j = 0; j < nBlockYSize; j++ )
+            {
+                int nY = nYBlock * nBlockYSize + j;
+                for( int i = 0; i < nBlockXSize; i++ )
+                {
+                    int nX = nXBlock * nBlockXSize + i;
+                    if( nX >= XSIZE || nY >= YSIZE )
+                        continue;
+                    CHECK( pabyData[j * nLineSpace + i * nPixelSpace] ==
+                            (GByte)(nX + nY * 3 + iBand * 7) );
+                }
+            }
+
+            GDALReleaseBorrowedBlock( hBand, hBorrow );
+        }
+    }
+    return nHandles;
+}
+
+int main( int argc, char* argv[] )
+{
+    GDALAllRegister();
+
+    argc = GDALGeneralCmdLineProcessor( argc, &argv, 0 );
+    CSLDestroy( argv );
+
+    /* MEM: blocks point into the pixel interleaved dataset buffer */
+    GDALDatasetH hDS;
+    GByte* pabyBuffer = (GByte*) CPLCalloc( 2, XSIZE * YSIZE );
+    char szFilename[256];
+    sprintf( szFilename,
+             "MEM:::DATAPOINTER=%p,PIXELS=%d,LINES=%d,BANDS=2,"
+             "PIXELOFFSET=2,BANDOFFSET=1", pabyBuffer, XSIZE, YSIZE );
+    hDS = GDALOpen( szFilename, GA_Update );
+    CHECK( hDS );
+    fill_pattern( hDS );
+    CHECK( check_borrow( hDS, 1 ) == 0 );
+    CHECK( check_borrow( hDS, 2 ) == 0 );
+    {
+        GSpacing nPixelSpace, nLineSpace;
+        void* hBorrow;
+        const void* pData = GDALBorrowBlock( GDALGetRasterBand(hDS, 2), 0, 3,
+                                             &nPixelSpace, &nLineSpace,
+                                             &hBorrow );
+        CHECK( pData == pabyBuffer + 1 + 3 * 2 * XSIZE );
+        CHECK( nPixelSpace == 2 && nLineSpace == 2 * XSIZE );
+        GDALReleaseBorrowedBlock( GDALGetRasterBand(hDS, 2), hBorrow );
+    }
+
+    /* A line written through the block cache must be seen even if not */
+    /* flushed yet to the dataset buffer */
+    {
+        GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+        GByte byVal = 255;
+        /* Upsampling writes go through the block cache */
+        GDALRasterIO( hBand, GF_Write, 0, 5, 2, 1, &byVal, 1, 1, GDT_Byte,
+                      0, 0 );
+
+        GSpacing nPixelSpace, nLineSpace;
+        void* hBorrow;
+        const GByte* pabyData = (const GByte*)
+            GDALBorrowBlock( hBand, 0, 5, &nPixelSpace, &nLineSpace, &hBorrow );
+        CHECK( pabyData[0] == 255 && pabyData[1] == 255 );
+        CHECK( hBorrow != NULL );
+        GDALReleaseBorrowedBlock( hBand, hBorrow );
+    }
+    GDALClose( hDS );
+    CPLFree( pabyBuffer );
+
+    /* GTiff: blocks are borrowed from the block cache */
+    char** papszOptions = NULL;
+    papszOptions = CSLSetNameValue( papszOptions, "TILED", "YES" );
+    papszOptions = CSLSetNameValue( papszOptions, "BLOCKXSIZE", "32" );
+    papszOptions = CSLSetNameValue( papszOptions, "BLOCKYSIZE", "16" );
+    hDS = GDALCreate( GDALGetDriverByName("GTiff"), "/vsimem/borrow.tif",
+                      XSIZE, YSIZE, 1, GDT_Byte, papszOptions );
+    CSLDestroy( papszOptions );
+    CHECK( hDS );
+    fill_pattern( hDS );
+    GDALClose( hDS );
+    hDS = GDALOpen( "/vsimem/borrow.tif", GA_ReadOnly );
+    CHECK( hDS );
+    CHECK( check_borrow( hDS, 1 ) == 4 * 4 );
+    GDALClose( hDS );
+    VSIUnlink( "/vsimem/borrow.tif" );
+
+    /* EHdr: read-only bands of real files are borrowed from a file */
+    /* mapping when available, otherwise from the block cache */
+    CPLString osTmpFile =
+        CPLResetExtension( CPLGenerateTempFilename("borrow"), "bil" );
+    hDS = GDALCreate( GDALGetDriverByName("EHdr"), osTmpFile,
+                      XSIZE, YSIZE, 2, GDT_Byte, NULL );
+    CHECK( hDS );
+    fill_pattern( hDS );
+    GDALClose( hDS );
+    hDS = GDALOpen( osTmpFile, GA_ReadOnly );
+    CHECK( hDS );
+    CHECK( check_borrow( hDS, 2 ) == YSIZE );
+    GDALClose( hDS );
+
+    CPLSetConfigOption( "GDAL_RAW_BORROW_MMAP", "YES" );
+    hDS = GDALOpen( osTmpFile, GA_ReadOnly );
+    CHECK( hDS );
+    int nHandles = check_borrow( hDS, 2 );
+    CHECK( nHandles == YSIZE ||
+           (nHandles == 0 && CPLIsVirtualMemFileMapAvailable()) );
+    GDALClose( hDS );
+    CPLSetConfigOption( "GDAL_RAW_BORROW_MMAP", NULL );
+    GDALDeleteDataset( NULL, osTmpFile );
+
+    GDALDestroyDriverManager();
+
+    printf( "Success !\n" );
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test GDALDatasetCopyWholeRaster() pipelined copy
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cpl_conv.h"
+#include "gdal_alg.h"
+#include "gdal_priv.h"
+
+#define RASTER_SIZE     1000
+#define FAILING_LINE    900
+
+/************************************************************************/
+/*            Band failing to read one of its scanlines                 */
+/************************************************************************/
+
+class FailingRasterBand : public GDALRasterBand
+{
+    public:
+        FailingRasterBand( GDALDataset* poDSIn )
+        {
+            poDS = poDSIn;
+            nBand = 1;
+            nRasterXSize = RASTER_SIZE;
+            nRasterYSize = RASTER_SIZE;
+            eDataType = GDT_Byte;
+            nBlockXSize = RASTER_SIZE;
+            nBlockYSize = 1;
+        }
+
+        virtual CPLErr IReadBlock( int, int nBlockYOff, void* pImage )
+        {
+            if( nBlockYOff == FAILING_LINE )
+            {
+                CPLError(CE_Failure, CPLE_FileIO, "Cannot read line %d",
+                         nBlockYOff);
+                return CE_Failure;
+            }
+            memset(pImage, 1, RASTER_SIZE);
+            return CE_None;
+        }
+};
+
+class FailingDataset : public GDALDataset
+{
+    public:
+        FailingDataset()
+        {
+            nRasterXSize = RASTER_SIZE;
+            nRasterYSize = RASTER_SIZE;
+            SetBand(1, new FailingRasterBand(this));
+        }
+};
+
+/************************************************************************/
+/*                             checksums()                              */
+/************************************************************************/
+
+static void checksums( GDALDatasetH hDS, int* panChecksums )
+{
+    for( int i = 0; i < GDALGetRasterCount(hDS); i++ )
+    {
+        panChecksums[i] = GDALChecksumImage( GDALGetRasterBand(hDS, i + 1),
+                                             0, 0, RASTER_SIZE, RASTER_SIZE );
+    }
+}
+
+/************************************************************************/
+/*                      test_conversion_copy()                          */
+/*                                                                      */
+/*      Copy a Byte dataset into a Float32 one, so that the pipeline     */
+/*      has a conversion stage.                                         */
+/************************************************************************/
+
+static int test_conversion_copy( GDALDatasetH hSrcDS,
+                                 const char* pszInterleave,
+                                 const char* pszPipeline )
+{
+    int anSrcChecksums[3], anDstChecksums[3];
+    checksums( hSrcDS, anSrcChecksums );
+
+    char** papszOptions = NULL;
+    papszOptions = CSLSetNameValue(papszOptions, "TILED", "YES");
+    papszOptions = CSLSetNameValue(papszOptions, "COMPRESS", "DEFLATE");
+    papszOptions = CSLSetNameValue(papszOptions, "INTERLEAVE", pszInterleave);
+    GDALDatasetH hDstDS = GDALCreate( GDALGetDriverByName("GTiff"),
+                                      "/vsimem/testcopywholeraster.tif",
+                                      RASTER_SIZE, RASTER_SIZE, 3,
+                                      GDT_Float32, papszOptions );
+    CSLDestroy(papszOptions);
+
+    papszOptions = NULL;
+    papszOptions = CSLSetNameValue(papszOptions, "COMPRESSED", "YES");
+    papszOptions = CSLSetNameValue(papszOptions, "INTERLEAVE", pszInterleave);
+    papszOptions = CSLSetNameValue(papszOptions, "PIPELINE", pszPipeline);
+    CPLErr eErr = GDALDatasetCopyWholeRaster( hSrcDS, hDstDS, papszOptions,
+                                              NULL, NULL );
+    CSLDestroy(papszOptions);
+    GDALClose(hDstDS);
+
+    int nRet = 0;
+    if( eErr != CE_None )
+    {
+        fprintf(stderr, "INTERLEAVE=%s PIPELINE=%s: copy failed.\n",
+                pszInterleave, pszPipeline);
+        nRet = 1;
+    }
+    else
+    {
+        hDstDS = GDALOpen("/vsimem/testcopywholeraster.tif", GA_ReadOnly);
+        checksums( hDstDS, anDstChecksums );
+        GDALClose(hDstDS);
+        for( int i = 0; i < 3; i++ )
+        {
+            if( anDstChecksums[i] != anSrcChecksums[i] )
+            {
+                fprintf(stderr, "INTERLEAVE=%s PIPELINE=%s: band %d: "
+                        "checksum %d, expected %d.\n",
+                        pszInterleave, pszPipeline, i + 1,
+                        anDstChecksums[i], anSrcChecksums[i]);
+                nRet = 1;
+            }
+        }
+    }
+
+    VSIUnlink("/vsimem/testcopywholeraster.tif");
+    return nRet;
+}
+
+/************************************************************************/
+/*                        test_reader_error()                           */
+/*                                                                      */
+/*      The errors of the reader thread must be reported to the caller. */
+/************************************************************************/
+
+static int test_reader_error()
+{
+    FailingDataset* poSrcDS = new FailingDataset();
+    GDALDatasetH hDstDS = GDALCreate( GDALGetDriverByName("MEM"), "",
+                                      RASTER_SIZE, RASTER_SIZE, 1,
+                                      GDT_Byte, NULL );
+
+    char** papszOptions = CSLSetNameValue(NULL, "PIPELINE", "YES");
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    CPLErrorReset();
+    CPLErr eErr = GDALDatasetCopyWholeRaster( (GDALDatasetH) poSrcDS, hDstDS,
+                                              papszOptions, NULL, NULL );
+    CPLPopErrorHandler();
+    CSLDestroy(papszOptions);
+
+    int nRet = 0;
+    CPLString osExpected;
+    osExpected.Printf("Cannot read line %d", FAILING_LINE);
+    if( eErr != CE_Failure )
+    {
+        fprintf(stderr, "Failure of the reader thread not reported.\n");
+        nRet = 1;
+    }
+    else if( CPLGetLastErrorNo() != CPLE_FileIO ||
+             osExpected != CPLGetLastErrorMsg() )
+    {
+        fprintf(stderr, "Unexpected error: %d, '%s'.\n",
+                CPLGetLastErrorNo(), CPLGetLastErrorMsg());
+        nRet = 1;
+    }
+
+    GDALClose(hDstDS);
+    delete poSrcDS;
+    return nRet;
+}
+
+int main( int argc, char** argv )
+{
+    int nRet = 0;
+
+    GDALAllRegister();
+    argc = GDALGeneralCmdLineProcessor( argc, &argv, 0 );
+    CSLDestroy(argv);
+
+    GDALDatasetH hSrcDS = GDALCreate( GDALGetDriverByName("MEM"), "",
+                                      RASTER_SIZE, RASTER_SIZE, 3,
+                                      GDT_Byte, NULL );
+    GByte* pabyLine = (GByte*) CPLMalloc(RASTER_SIZE);
+    for( int iBand = 0; iBand < 3; iBand++ )
+    {
+        for( int iY = 0; iY < RASTER_SIZE; iY++ )
+        {
+            for( int iX = 0; iX < RASTER_SIZE; iX++ )
+                pabyLine[iX] = (GByte)(iX * (iBand + 1) + iY);
+            GDALRasterIO( GDALGetRasterBand(hSrcDS, iBand + 1), GF_Write,
+                          0, iY, RASTER_SIZE, 1, pabyLine, RASTER_SIZE, 1,
+                          GDT_Byte, 0, 0 );
+        }
+    }
+    CPLFree(pabyLine);
+
+    const char* apszInterleaves[] = { "PIXEL", "BAND" };
+    for( int i = 0; i < 2; i++ )
+    {
+        nRet |= test_conversion_copy( hSrcDS, apszInterleaves[i], "NO" );
+        nRet |= test_conversion_copy( hSrcDS, apszInterleaves[i], "YES" );
+    }
+    GDALClose(hSrcDS);
+
+    nRet |= test_reader_error();
+
+    GDALDestroyDriverManager();
+
+    if( nRet == 0 )
+        printf("OK\n");
+
+    return nRet;
+}
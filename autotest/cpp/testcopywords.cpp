@@ -437,6 +437,57 @@ void check_GDT_CFloat32and64()
     }
 }
 
+/* Compare the conversion of packed buffers, which may use optimized code */
+/* paths, with the conversion of the same values one word at a time */
+void check_packed()
+{
+    const double adfValues[] = { -1e10, -65537, -32769, -256.6, -1.5, -0.5,
+                                 -0.49, 0, 0.49, 0.5, 1.5, 2.5, 127.5,
+                                 254.49, 254.5, 255, 255.5, 256, 32767.5,
+                                 32768, 65535, 65536, 1e10 };
+    const int nValues = sizeof(adfValues) / sizeof(adfValues[0]);
+    const GDALDataType aeTypes[] = { GDT_Byte, GDT_UInt16, GDT_Int16,
+                                     GDT_Float32, GDT_Float64 };
+    const int nTypes = sizeof(aeTypes) / sizeof(aeTypes[0]);
+    const int nWords = 67; /* not a multiple of the vector sizes */
+
+    double adfIn[nWords];
+    for( int i = 0; i < nWords; i++ )
+        adfIn[i] = adfValues[(i * 7) % nValues];
+
+    for( int iIn = 0; iIn < nTypes; iIn++ )
+    {
+        GDALDataType eInType = aeTypes[iIn];
+        int nInSize = GDALGetDataTypeSize(eInType) / 8;
+        GByte abyIn[nWords * 8];
+        GDALCopyWords(adfIn, GDT_Float64, 8, abyIn, eInType, nInSize, nWords);
+
+        for( int iOut = 0; iOut < nTypes; iOut++ )
+        {
+            GDALDataType eOutType = aeTypes[iOut];
+            int nOutSize = GDALGetDataTypeSize(eOutType) / 8;
+            GByte abyPacked[nWords * 8];
+            GByte abyRef[nWords * 8];
+
+            GDALCopyWords(abyIn, eInType, nInSize,
+                          abyPacked, eOutType, nOutSize, nWords);
+            for( int i = 0; i < nWords; i++ )
+                GDALCopyWords(abyIn + i * nInSize, eInType, nInSize,
+                              abyRef + i * nOutSize, eOutType, nOutSize, 1);
+
+            if( memcmp(abyPacked, abyRef, nWords * nOutSize) != 0 )
+            {
+                std::cout << "Packed conversion from " <<
+                             GDALGetDataTypeName(eInType) << " to " <<
+                             GDALGetDataTypeName(eOutType) <<
+                             " differs from word per word conversion" <<
+                             std::endl;
+                bErr = TRUE;
+            }
+        }
+    }
+}
+
 int main(int argc, char* argv[])
 {
     pIn = (char*)malloc(128);
@@ -451,6 +502,7 @@ int main(int argc, char* argv[])
     check_GDT_CInt16();
     check_GDT_CInt32();
     check_GDT_CFloat32and64();
+    check_packed();
     
     free(pIn);
     free(pOut);
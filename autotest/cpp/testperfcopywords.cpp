@@ -61,6 +61,27 @@ int main(int argc, char* argv[])
         }
     }
 
+    /* Packed buffers, as used by data type converting RasterIO() */
+    for(intype=GDT_Byte;intype<=GDT_Float64;intype++)
+    {
+        for(outtype=GDT_Byte;outtype<=GDT_Float64;outtype++)
+        {
+            start = clock();
+
+            for(i=0;i<1000;i++)
+                GDALCopyWords(in, (GDALDataType)intype, GDALGetDataTypeSize((GDALDataType)intype) / 8,
+                              out, (GDALDataType)outtype, GDALGetDataTypeSize((GDALDataType)outtype) / 8,
+                              256 * 256);
+
+            end = clock();
+
+            printf("%s -> %s (packed) : %.2f s\n",
+                   GDALGetDataTypeName((GDALDataType)intype),
+                   GDALGetDataTypeName((GDALDataType)outtype),
+                   (end - start) * 1.0 / CLOCKS_PER_SEC);
+        }
+    }
+
     return 0;
 }
 
@@ -29,6 +29,7 @@
 ###############################################################################
 
 import sys
+import struct
 
 sys.path.append( '../pymod' )
 
@@ -71,7 +72,74 @@ def asyncreader_1():
     return 'success'
 
 
-gdaltest_list = [ asyncreader_1 ]
+###############################################################################
+# Test AsyncReader interface with blocks prefetched by background threads
+
+def asyncreader_2():
+
+    # 100 lines of 16x16 tiles: the reader returns several strips
+    src_ds = gdal.GetDriverByName('MEM').Create('', 50, 100)
+    src_ds.WriteRaster(0, 0, 50, 100, struct.pack('B' * (50 * 100), *[i % 251 for i in range(50 * 100)]))
+    ds = gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/asyncreader_2.tif', src_ds,
+                                                 options = ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16'])
+    ds = None
+    src_ds = None
+
+    ds = gdal.Open('/vsimem/asyncreader_2.tif')
+    expected_data = ds.ReadRaster(0, 0, ds.RasterXSize, ds.RasterYSize)
+
+    # With no time limit, with a timeout that may return GARIO_PENDING,
+    # and with room for a single prefetched block
+    for (timeout, options) in [ (-1, []), (0.5, []), (-1, ['MAX_MEMORY=0']) ]:
+        asyncreader = ds.BeginAsyncReader(0,0,ds.RasterXSize,ds.RasterYSize, options = ['NUM_THREADS=2'] + options)
+        buf = asyncreader.GetBuffer()
+        next_yoff = 0
+        strip_count = 0
+        while True:
+            result = asyncreader.GetNextUpdatedRegion(timeout)
+            if result[0] == gdal.GARIO_ERROR:
+                gdaltest.post_reason('got GARIO_ERROR')
+                return 'fail'
+            if result[0] == gdal.GARIO_PENDING and result[4] == 0:
+                continue
+            if result[1:] != [0, next_yoff, ds.RasterXSize, result[4]]:
+                gdaltest.post_reason('wrong return values for GetNextUpdatedRegion()')
+                print(result)
+                return 'fail'
+            next_yoff += result[4]
+            strip_count += 1
+            if result[0] == gdal.GARIO_COMPLETE:
+                break
+        ds.EndAsyncReader(asyncreader)
+        asyncreader = None
+
+        if next_yoff != ds.RasterYSize:
+            gdaltest.post_reason('did not get all lines')
+            print(next_yoff)
+            return 'fail'
+
+        if strip_count < 2:
+            gdaltest.post_reason('expected several strips')
+            print(strip_count)
+            return 'fail'
+
+        out_ds = gdal.GetDriverByName('MEM').Create('', ds.RasterXSize, ds.RasterYSize)
+        out_ds.WriteRaster(0, 0, ds.RasterXSize, ds.RasterYSize, buf)
+        data = out_ds.ReadRaster(0, 0, ds.RasterXSize, ds.RasterYSize)
+        out_ds = None
+        if data != expected_data:
+            gdaltest.post_reason('did not get expected pixel values')
+            print(timeout)
+            return 'fail'
+
+    ds = None
+    gdal.Unlink('/vsimem/asyncreader_2.tif')
+
+    return 'success'
+
+
+gdaltest_list = [ asyncreader_1,
+                  asyncreader_2 ]
 
 
 if __name__ == '__main__':
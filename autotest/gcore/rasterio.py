@@ -783,6 +783,40 @@ def rasterio_10():
 
     return 'success'
 
+###############################################################################
+# Test pipelined GDALDatasetCopyWholeRaster()
+
+def rasterio_11():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    mem_ds = gdal.GetDriverByName('MEM').Create('', 1000, 1000, 3)
+    for i in range(3):
+        data = src_ds.GetRasterBand(i+1).ReadRaster(0, 0, 50, 50, 1000, 1000)
+        mem_ds.GetRasterBand(i+1).WriteRaster(0, 0, 1000, 1000, data)
+    src_ds = None
+
+    for interleave in [ 'PIXEL', 'BAND' ]:
+        cs = []
+        for pipeline in [ 'NO', 'YES' ]:
+            old_val = gdal.GetConfigOption('GDAL_COPY_WHOLE_RASTER_PIPELINE')
+            gdal.SetConfigOption('GDAL_COPY_WHOLE_RASTER_PIPELINE', pipeline)
+            ds = gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/rasterio_11.tif',
+                mem_ds, options = [ 'COMPRESS=DEFLATE', 'TILED=YES',
+                                    'BLOCKXSIZE=64', 'BLOCKYSIZE=64',
+                                    'INTERLEAVE=' + interleave ])
+            gdal.SetConfigOption('GDAL_COPY_WHOLE_RASTER_PIPELINE', old_val)
+            cs.append([ ds.GetRasterBand(i+1).Checksum() for i in range(3) ])
+            ds = None
+            gdal.GetDriverByName('GTiff').Delete('/vsimem/rasterio_11.tif')
+
+        if cs[0] != cs[1]:
+            gdaltest.post_reason('failure')
+            print(interleave)
+            print(cs)
+            return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     rasterio_1,
     rasterio_2,
@@ -794,6 +828,7 @@ gdaltest_list = [
     rasterio_8,
     rasterio_9,
     rasterio_10,
+    rasterio_11,
     ]
 
 if __name__ == '__main__':
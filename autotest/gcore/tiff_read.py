@@ -348,6 +348,67 @@ def tiff_read_tgz_2():
 
     return 'success'
 
+###############################################################################
+# Read a .tgz file with a persistent index of its content
+
+def tiff_read_tgz_3():
+
+    shutil.copy('data/byte.tgz', 'tmp/byte_tiff_read_tgz_3.tgz')
+
+    gdal.SetConfigOption('CPL_VSIL_TAR_INDEX', 'YES')
+    ds = gdal.Open('/vsitar/tmp/byte_tiff_read_tgz_3.tgz/byte.tif')
+    gdal.SetConfigOption('CPL_VSIL_TAR_INDEX', None)
+    if ds.GetRasterBand(1).Checksum() != 4672:
+        print('Expected checksum = %d. Got = %d' % (4672, ds.GetRasterBand(1).Checksum()))
+        return 'fail'
+    ds = None
+
+    if gdal.VSIStatL('tmp/byte_tiff_read_tgz_3.tgz.taridx') is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # The content of an archive is cached by its name for the life of the
+    # process, so check that the index is used with a copy of the archive
+    # (same size and mtime) whose index lists the file under another name.
+    # Opening that name can only succeed if the listing comes from the index.
+    shutil.copy2('tmp/byte_tiff_read_tgz_3.tgz', 'tmp/byte_tiff_read_tgz_3_bis.tgz')
+    f = open('tmp/byte_tiff_read_tgz_3.tgz.taridx', 'rb')
+    index = f.read()
+    f.close()
+    if index.find(' byte.tif\n'.encode('ascii')) < 0:
+        gdaltest.post_reason('fail')
+        print(index)
+        return 'fail'
+    index = index.replace(' byte.tif\n'.encode('ascii'), ' from_index.tif\n'.encode('ascii'))
+    f = open('tmp/byte_tiff_read_tgz_3_bis.tgz.taridx', 'wb')
+    f.write(index)
+    f.close()
+
+    ds = gdal.Open('/vsitar/tmp/byte_tiff_read_tgz_3_bis.tgz/from_index.tif')
+    if ds is None or ds.GetRasterBand(1).Checksum() != 4672:
+        gdaltest.post_reason('.taridx not used')
+        return 'fail'
+    ds = None
+
+    # The index is ignored when disabled
+    gdal.SetConfigOption('CPL_VSIL_TAR_INDEX', 'NO')
+    shutil.copy2('tmp/byte_tiff_read_tgz_3.tgz', 'tmp/byte_tiff_read_tgz_3_ter.tgz')
+    shutil.copy('tmp/byte_tiff_read_tgz_3_bis.tgz.taridx', 'tmp/byte_tiff_read_tgz_3_ter.tgz.taridx')
+    gdal.PushErrorHandler('CPLQuietErrorHandler')
+    ds = gdal.Open('/vsitar/tmp/byte_tiff_read_tgz_3_ter.tgz/from_index.tif')
+    gdal.PopErrorHandler()
+    gdal.SetConfigOption('CPL_VSIL_TAR_INDEX', None)
+    if ds is not None:
+        gdaltest.post_reason('.taridx used whereas CPL_VSIL_TAR_INDEX=NO')
+        return 'fail'
+
+    for filename in [ 'tmp/byte_tiff_read_tgz_3.tgz', 'tmp/byte_tiff_read_tgz_3_bis.tgz',
+                      'tmp/byte_tiff_read_tgz_3_ter.tgz' ]:
+        gdal.Unlink(filename)
+        gdal.Unlink(filename + '.taridx')
+
+    return 'success'
+
 ###############################################################################
 # Check handling of non-degree angular units (#601)
 
@@ -1265,6 +1326,39 @@ def tiff_read_irregular_tile_size_jpeg_in_tiff():
 
     return 'success'
 
+###############################################################################
+# Test the batched ReadMultiRange() backends of local files through
+# GTIFF_DIRECT_IO
+
+def tiff_read_direct_io_local_multirange():
+
+    src_ds = gdal.Open('data/stefan_full_rgba.tif')
+    gdal.GetDriverByName('GTiff').CreateCopy('tmp/tiff_read_direct_io_local_multirange.tif', src_ds)
+    src_ds = None
+
+    ds = gdal.Open('tmp/tiff_read_direct_io_local_multirange.tif')
+    ref_data = ds.GetRasterBand(1).ReadRaster(10, 10, 100, 80, buf_xsize = 50, buf_ysize = 40)
+    ds = None
+
+    ret = 'success'
+    gdal.SetConfigOption('GTIFF_DIRECT_IO', 'YES')
+    for mode in [ 'NO', 'YES', 'AUTO', 'IO_URING', 'THREADS', 'PREAD' ]:
+        gdal.SetConfigOption('CPL_VSIL_LOCAL_ASYNC_IO', mode)
+        ds = gdal.Open('tmp/tiff_read_direct_io_local_multirange.tif')
+        data = ds.GetRasterBand(1).ReadRaster(10, 10, 100, 80, buf_xsize = 50, buf_ysize = 40)
+        ds = None
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(mode)
+            ret = 'fail'
+            break
+    gdal.SetConfigOption('CPL_VSIL_LOCAL_ASYNC_IO', None)
+    gdal.SetConfigOption('GTIFF_DIRECT_IO', None)
+
+    gdal.GetDriverByName('GTiff').Delete('tmp/tiff_read_direct_io_local_multirange.tif')
+
+    return ret
+
 ###############################################################################
 # Test GTIFF_DIRECT_IO optimization
 
@@ -1588,6 +1682,83 @@ def tiff_direct_and_virtual_mem_io():
 
   return 'success'
 
+###############################################################################
+# Test multi-threaded decoding (NUM_THREADS open option)
+
+def tiff_read_multi_threaded_decoding():
+
+    src_ds = gdal.Open('data/stefan_full_rgba.tif')
+    for options in [ ['COMPRESS=DEFLATE', 'TILED=YES', 'BLOCKXSIZE=32', 'BLOCKYSIZE=32'],
+                     ['COMPRESS=LZW', 'PREDICTOR=2', 'BLOCKYSIZE=3'],
+                     ['COMPRESS=PACKBITS', 'INTERLEAVE=BAND', 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16'] ]:
+        gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/tiff_read_multi_threaded_decoding.tif', src_ds, options = options)
+
+        ds = gdal.Open('/vsimem/tiff_read_multi_threaded_decoding.tif')
+        ref_data = ds.ReadRaster(0, 0, ds.RasterXSize, ds.RasterYSize)
+        ref_band_data = ds.GetRasterBand(2).ReadRaster(7, 11, ds.RasterXSize - 10, ds.RasterYSize - 20)
+        ds = None
+
+        # A small cache forces the request to be split in chunks
+        for cachemax in [ None, 100000 ]:
+            if cachemax is not None:
+                old_cachemax = gdal.GetCacheMax()
+                gdal.SetCacheMax(cachemax)
+            ds = gdal.OpenEx('/vsimem/tiff_read_multi_threaded_decoding.tif', open_options = ['NUM_THREADS=4'])
+            data = ds.ReadRaster(0, 0, ds.RasterXSize, ds.RasterYSize)
+            band_data = ds.GetRasterBand(2).ReadRaster(7, 11, ds.RasterXSize - 10, ds.RasterYSize - 20)
+            ds = None
+            if cachemax is not None:
+                gdal.SetCacheMax(old_cachemax)
+
+            if data != ref_data or band_data != ref_band_data:
+                gdaltest.post_reason('fail')
+                print(options)
+                print(cachemax)
+                return 'fail'
+
+    gdal.Unlink('/vsimem/tiff_read_multi_threaded_decoding.tif')
+
+    return 'success'
+
+###############################################################################
+# Test that decompression errors of the worker threads are reported
+
+def tiff_read_multi_threaded_decoding_error():
+
+    src_ds = gdal.Open('data/byte.tif')
+    gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/tiff_read_multi_threaded_decoding_error.tif', src_ds,
+        options = ['COMPRESS=DEFLATE', 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16'])
+    src_ds = None
+
+    # Corrupt the zlib header of the last tile
+    ds = gdal.Open('/vsimem/tiff_read_multi_threaded_decoding_error.tif')
+    offset = int(ds.GetRasterBand(1).GetMetadataItem('BLOCK_OFFSET_1_1', 'TIFF'))
+    ds = None
+    f = gdal.VSIFOpenL('/vsimem/tiff_read_multi_threaded_decoding_error.tif', 'rb+')
+    gdal.VSIFSeekL(f, offset, 0)
+    gdal.VSIFWriteL('ZZZZ', 1, 4, f)
+    gdal.VSIFCloseL(f)
+
+    ds = gdal.OpenEx('/vsimem/tiff_read_multi_threaded_decoding_error.tif', open_options = ['NUM_THREADS=4'])
+    gdal.ErrorReset()
+    gdal.PushErrorHandler('CPLQuietErrorHandler')
+    data = ds.ReadRaster(0, 0, ds.RasterXSize, ds.RasterYSize)
+    gdal.PopErrorHandler()
+    if data is not None or gdal.GetLastErrorMsg() == '':
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    # Valid blocks can still be read
+    data = ds.ReadRaster(0, 0, 16, 16)
+    if data is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    gdal.Unlink('/vsimem/tiff_read_multi_threaded_decoding_error.tif')
+
+    return 'success'
+
 ###############################################################################################
 
 for item in init_list:
@@ -1611,6 +1782,7 @@ gdaltest_list.append( (tiff_read_tar_1) )
 gdaltest_list.append( (tiff_read_tar_2) )
 gdaltest_list.append( (tiff_read_tgz_1) )
 gdaltest_list.append( (tiff_read_tgz_2) )
+gdaltest_list.append( (tiff_read_tgz_3) )
 gdaltest_list.append( (tiff_grads) )
 gdaltest_list.append( (tiff_citation) )
 gdaltest_list.append( (tiff_linearparmunits) )
@@ -1640,7 +1812,10 @@ gdaltest_list.append( (tiff_read_huge4GB) )
 gdaltest_list.append( (tiff_read_bigtiff) )
 gdaltest_list.append( (tiff_read_tiff_metadata) )
 gdaltest_list.append( (tiff_read_irregular_tile_size_jpeg_in_tiff) )
+gdaltest_list.append( (tiff_read_direct_io_local_multirange) )
 gdaltest_list.append( (tiff_direct_and_virtual_mem_io) )
+gdaltest_list.append( (tiff_read_multi_threaded_decoding) )
+gdaltest_list.append( (tiff_read_multi_threaded_decoding_error) )
 
 gdaltest_list.append( (tiff_read_online_1) )
 gdaltest_list.append( (tiff_read_online_2) )
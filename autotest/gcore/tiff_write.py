@@ -5719,6 +5719,63 @@ def tiff_write_134():
 
     return 'success'
     
+###############################################################################
+# Test multi-threaded compression (NUM_THREADS creation option)
+
+def tiff_write_135():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    mem_ds = gdal.GetDriverByName('MEM').Create('', 500, 500, 3)
+    for i in range(3):
+        data = src_ds.GetRasterBand(i+1).ReadRaster(0, 0, 50, 50, 500, 500)
+        mem_ds.GetRasterBand(i+1).WriteRaster(0, 0, 500, 500, data)
+    src_ds = None
+    expected_cs = [ mem_ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+
+    for options in [ [ 'COMPRESS=DEFLATE', 'TILED=YES', 'BLOCKXSIZE=32', 'BLOCKYSIZE=32' ],
+                     [ 'COMPRESS=LZW', 'PREDICTOR=2', 'BLOCKYSIZE=7' ],
+                     [ 'COMPRESS=PACKBITS', 'TILED=YES', 'INTERLEAVE=BAND' ] ]:
+        options = options + [ 'NUM_THREADS=4' ]
+
+        # CreateCopy() case
+        ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_135.tif', mem_ds, options = options)
+        ds = None
+        ds = gdal.Open('/vsimem/tiff_write_135.tif')
+        cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+        ds = None
+        if cs != expected_cs:
+            gdaltest.post_reason('fail')
+            print(options)
+            print(cs)
+            return 'fail'
+
+        # Create() case, with blocks read back and rewritten before closing
+        ds = gdaltest.tiff_drv.Create('/vsimem/tiff_write_135.tif', 500, 500, 3, options = options)
+        for i in range(3):
+            ds.GetRasterBand(i+1).Fill(255)
+        ds.FlushCache()
+        for i in range(3):
+            if ds.GetRasterBand(i+1).Checksum() != 53502:
+                gdaltest.post_reason('fail')
+                print(options)
+                print(ds.GetRasterBand(i+1).Checksum())
+                return 'fail'
+            data = mem_ds.GetRasterBand(i+1).ReadRaster(0, 0, 500, 500)
+            ds.GetRasterBand(i+1).WriteRaster(0, 0, 500, 500, data)
+        ds = None
+        ds = gdal.Open('/vsimem/tiff_write_135.tif')
+        cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+        ds = None
+        if cs != expected_cs:
+            gdaltest.post_reason('fail')
+            print(options)
+            print(cs)
+            return 'fail'
+
+        gdaltest.tiff_drv.Delete('/vsimem/tiff_write_135.tif')
+
+    return 'success'
+
 ###############################################################################
 # Ask to run again tests with GDAL_API_PROXY=YES
 
@@ -5885,6 +5942,7 @@ gdaltest_list = [
     tiff_write_132,
     tiff_write_133,
     tiff_write_134,
+    tiff_write_135,
     #tiff_write_api_proxy,
     tiff_write_cleanup ]
 
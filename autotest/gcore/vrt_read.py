@@ -600,6 +600,43 @@ def vrt_read_17():
         return 'fail'
 
     return 'success'
+
+###############################################################################
+# Test opening a VRT mosaic with many sources
+
+def vrt_read_18():
+
+    src_ds = gdal.Open('data/byte.tif')
+    ref_cs = src_ds.GetRasterBand(1).Checksum()
+    src_ds = None
+
+    xml = '<VRTDataset rasterXSize="400" rasterYSize="400">\n'
+    xml += '  <VRTRasterBand dataType="Byte" band="1">\n'
+    for j in range(20):
+        for i in range(20):
+            xml += """    <SimpleSource>
+      <SourceFilename relativeToVRT="0">data/byte.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SourceProperties RasterXSize="20" RasterYSize="20" DataType="Byte" BlockXSize="20" BlockYSize="20" />
+      <SrcRect xOff="0" yOff="0" xSize="20" ySize="20" />
+      <DstRect xOff="%d" yOff="%d" xSize="20" ySize="20" />
+    </SimpleSource>\n""" % (i * 20, j * 20)
+    xml += '  </VRTRasterBand>\n'
+    xml += '</VRTDataset>\n'
+
+    vrt_ds = gdal.Open(xml)
+    if vrt_ds is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    for (xoff, yoff) in [ (0, 0), (200, 100), (380, 380) ]:
+        cs = vrt_ds.GetRasterBand(1).Checksum(xoff, yoff, 20, 20)
+        if cs != ref_cs:
+            gdaltest.post_reason('fail')
+            print(xoff, yoff, cs, ref_cs)
+            return 'fail'
+
+    return 'success'
     
 for item in init_list:
     ut = gdaltest.GDALTest( 'VRT', item[0], item[1], item[2] )
@@ -625,6 +662,7 @@ gdaltest_list.append( vrt_read_14 )
 gdaltest_list.append( vrt_read_15 )
 gdaltest_list.append( vrt_read_16 )
 gdaltest_list.append( vrt_read_17 )
+gdaltest_list.append( vrt_read_18 )
 
 if __name__ == '__main__':
 
@@ -28,6 +28,7 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import os
 import sys
 from osgeo import gdal
 from osgeo import ogr
@@ -36,6 +37,7 @@ from sys import version_info
 sys.path.append( '../pymod' )
 
 import gdaltest
+import webserver
 
 ###############################################################################
 #
@@ -285,6 +287,250 @@ def vsicurl_11():
 
     return 'success'
 
+###############################################################################
+# Write a file of size bytes served by the local web server
+
+def vsicurl_create_test_file(filename, size):
+    data = bytearray([(i * 7 + i // 251) % 256 for i in range(size)])
+    f = open(filename, 'wb')
+    f.write(bytes(data))
+    f.close()
+    return data
+
+###############################################################################
+# Read size bytes at offset of a /vsicurl/ file, and compare them to data
+
+def vsicurl_read_and_check(url, data, offset, size):
+    f = gdal.VSIFOpenL(url, 'rb')
+    if f is None:
+        gdaltest.post_reason('cannot open %s' % url)
+        return False
+    gdal.VSIFSeekL(f, offset, 0)
+    content = gdal.VSIFReadL(1, size, f)
+    gdal.VSIFCloseL(f)
+    if content != bytes(data[offset:offset+size]):
+        gdaltest.post_reason('did not get expected content at offset %d' % offset)
+        return False
+    return True
+
+###############################################################################
+# Test that the in-memory region cache is bounded by CPL_VSIL_CURL_CACHE_SIZE_MB
+
+def vsicurl_12():
+    try:
+        drv = gdal.GetDriverByName( 'HTTP' )
+    except:
+        drv = None
+
+    if drv is None:
+        return 'skip'
+
+    (process, port) = webserver.launch()
+    if port == 0:
+        return 'skip'
+
+    filename = 'tmp/vsicurl_12.bin'
+    size = 2 * 1024 * 1024
+    data = vsicurl_create_test_file(filename, size)
+    url = '/vsicurl/http://127.0.0.1:%d/vsicurl_range/%s' % (port, filename)
+
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', 'EMPTY_DIR')
+    ret = 'success'
+
+    # The file does not fit in a 1 MB cache: its start is evicted
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_SIZE_MB', '1')
+    if not vsicurl_read_and_check(url, data, 0, size):
+        ret = 'fail'
+    count = webserver.get_request_count(port, filename)
+    if ret == 'success' and not vsicurl_read_and_check(url, data, 0, 16384):
+        ret = 'fail'
+    if ret == 'success' and webserver.get_request_count(port, filename) == count:
+        gdaltest.post_reason('start of the file should have been evicted')
+        ret = 'fail'
+
+    # It fits in a 8 MB cache: a second read does not issue any request
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_SIZE_MB', '8')
+    if ret == 'success' and not vsicurl_read_and_check(url, data, 0, size):
+        ret = 'fail'
+    count = webserver.get_request_count(port, filename)
+    if ret == 'success' and not vsicurl_read_and_check(url, data, 0, size):
+        ret = 'fail'
+    if ret == 'success' and webserver.get_request_count(port, filename) != count:
+        gdaltest.post_reason('file should have been read from the cache')
+        print(webserver.get_request_count(port, filename) - count)
+        ret = 'fail'
+
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_SIZE_MB', None)
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', None)
+
+    webserver.server_stop(process, port)
+    os.unlink(filename)
+
+    return ret
+
+###############################################################################
+# Test multi-range reads, as a single multipart request and as parallel
+# requests. GTIFF_DIRECT_IO makes GTiff read sub-sampled lines with
+# VSIFReadMultiRangeL()
+
+def vsicurl_13():
+    try:
+        drv = gdal.GetDriverByName( 'HTTP' )
+    except:
+        drv = None
+
+    if drv is None:
+        return 'skip'
+
+    (process, port) = webserver.launch()
+    if port == 0:
+        return 'skip'
+
+    src_ds = gdal.GetDriverByName('MEM').Create('', 2000, 64)
+    src_ds.GetRasterBand(1).WriteRaster(0, 0, 2000, 64,
+        bytes(bytearray([(i * 7 + i // 2000) % 256 for i in range(2000 * 64)])))
+    gdal.GetDriverByName('GTiff').CreateCopy('tmp/vsicurl_13_a.tif', src_ds)
+    gdal.GetDriverByName('GTiff').CreateCopy('tmp/vsicurl_13_b.tif', src_ds)
+    expected_data = src_ds.GetRasterBand(1).ReadRaster(0, 0, 2000, 64, 2000, 16)
+    src_ds = None
+
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', 'EMPTY_DIR')
+    gdal.SetConfigOption('GTIFF_DIRECT_IO', 'YES')
+    gdal.SetConfigOption('CPL_VSIL_CURL_MERGE_GAP', '0')
+    ret = 'success'
+
+    for (filename, max_connections) in [ ('tmp/vsicurl_13_a.tif', None),
+                                         ('tmp/vsicurl_13_b.tif', '4') ]:
+        gdal.SetConfigOption('CPL_VSIL_CURL_MAX_CONNECTIONS', max_connections)
+        ds = gdal.Open('/vsicurl/http://127.0.0.1:%d/vsicurl_range/%s' % (port, filename))
+        if ds is None:
+            gdaltest.post_reason('cannot open %s' % filename)
+            ret = 'fail'
+            break
+        count = webserver.get_request_count(port, filename)
+        data = ds.GetRasterBand(1).ReadRaster(0, 0, 2000, 64, 2000, 16)
+        ds = None
+        count = webserver.get_request_count(port, filename) - count
+        if data != expected_data:
+            gdaltest.post_reason('did not get expected data')
+            print(max_connections)
+            ret = 'fail'
+            break
+        # 16 lines separated by more than the merge gap
+        if (max_connections is None and count != 1) or \
+           (max_connections is not None and count != 16):
+            gdaltest.post_reason('did not get expected number of requests')
+            print(max_connections)
+            print(count)
+            ret = 'fail'
+            break
+
+    gdal.SetConfigOption('CPL_VSIL_CURL_MAX_CONNECTIONS', None)
+    gdal.SetConfigOption('CPL_VSIL_CURL_MERGE_GAP', None)
+    gdal.SetConfigOption('GTIFF_DIRECT_IO', None)
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', None)
+
+    webserver.server_stop(process, port)
+    os.unlink('tmp/vsicurl_13_a.tif')
+    os.unlink('tmp/vsicurl_13_b.tif')
+
+    return ret
+
+###############################################################################
+# Test the persistent disk cache: hits, corrupted chunk files and eviction
+
+def vsicurl_14_cache_files(cache_dir):
+    return [ os.path.join(cache_dir, f) for f in os.listdir(cache_dir) if f.endswith('.bin') ]
+
+def vsicurl_14():
+    try:
+        drv = gdal.GetDriverByName( 'HTTP' )
+    except:
+        drv = None
+
+    if drv is None:
+        return 'skip'
+
+    (process, port) = webserver.launch()
+    if port == 0:
+        return 'skip'
+
+    cache_dir = 'tmp/vsicurl_14_cache'
+    size = 2 * 1024 * 1024
+    data = vsicurl_create_test_file('tmp/vsicurl_14_a.bin', size)
+    vsicurl_create_test_file('tmp/vsicurl_14_b.bin', size)
+    url = '/vsicurl/http://127.0.0.1:%d/vsicurl_range/%s'
+
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', 'EMPTY_DIR')
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_DIR', cache_dir)
+    # The in-memory cache only holds half of the file
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_SIZE_MB', '1')
+    ret = 'success'
+
+    # All the chunks are written in the cache directory
+    filename = 'tmp/vsicurl_14_a.bin'
+    if not vsicurl_read_and_check(url % (port, filename), data, 0, size):
+        ret = 'fail'
+    if ret == 'success' and len(vsicurl_14_cache_files(cache_dir)) != size // 16384:
+        gdaltest.post_reason('did not get expected number of cache files')
+        print(len(vsicurl_14_cache_files(cache_dir)))
+        ret = 'fail'
+
+    # The start of the file, evicted from memory, is read from disk
+    count = webserver.get_request_count(port, filename)
+    if ret == 'success' and not vsicurl_read_and_check(url % (port, filename), data, 0, 16384):
+        ret = 'fail'
+    if ret == 'success' and webserver.get_request_count(port, filename) != count:
+        gdaltest.post_reason('chunk should have been read from the disk cache')
+        ret = 'fail'
+
+    # A corrupted chunk file is ignored, and replaced
+    if ret == 'success':
+        offset = 10 * 16384
+        corrupted = [ f for f in vsicurl_14_cache_files(cache_dir) if f.endswith('_%d.bin' % offset) ][0]
+        f = open(corrupted, 'wb')
+        f.write('x'.encode('ascii') * 1000)
+        f.close()
+        if not vsicurl_read_and_check(url % (port, filename), data, offset, 16384):
+            ret = 'fail'
+        if ret == 'success' and webserver.get_request_count(port, filename) != count + 1:
+            gdaltest.post_reason('corrupted chunk should have been downloaded')
+            ret = 'fail'
+        f = open(corrupted, 'rb')
+        magic = f.read(8)
+        f.close()
+        if ret == 'success' and magic != 'GDALVCC1'.encode('ascii'):
+            gdaltest.post_reason('corrupted chunk should have been written again')
+            ret = 'fail'
+
+    # The least recently used chunks are removed to stay within the budget
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_DIR_SIZE_MB', '1')
+    filename = 'tmp/vsicurl_14_b.bin'
+    if ret == 'success' and not vsicurl_read_and_check(url % (port, filename), data, 0, size):
+        ret = 'fail'
+    if ret == 'success':
+        total_size = 0
+        for f in vsicurl_14_cache_files(cache_dir):
+            total_size += os.stat(f).st_size
+        if total_size == 0 or total_size > 1024 * 1024:
+            gdaltest.post_reason('cache directory not pruned as expected')
+            print(total_size)
+            ret = 'fail'
+
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_DIR_SIZE_MB', None)
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_SIZE_MB', None)
+    gdal.SetConfigOption('CPL_VSIL_CURL_CACHE_DIR', None)
+    gdal.SetConfigOption('GDAL_DISABLE_READDIR_ON_OPEN', None)
+
+    webserver.server_stop(process, port)
+    os.unlink('tmp/vsicurl_14_a.bin')
+    os.unlink('tmp/vsicurl_14_b.bin')
+    for f in os.listdir(cache_dir):
+        os.unlink(os.path.join(cache_dir, f))
+    os.rmdir(cache_dir)
+
+    return ret
+
 gdaltest_list = [ vsicurl_1,
                   vsicurl_2,
                   vsicurl_3,
@@ -295,7 +541,10 @@ gdaltest_list = [ vsicurl_1,
                   vsicurl_8,
                   vsicurl_9,
                   vsicurl_10,
-                  vsicurl_11 ]
+                  vsicurl_11,
+                  vsicurl_12,
+                  vsicurl_13,
+                  vsicurl_14 ]
 
 if __name__ == '__main__':
 
@@ -333,13 +333,197 @@ def vsifile_7():
 
     return 'success'
 
+###############################################################################
+# Test random access in a /vsigzip/ file with a seek index
+
+def vsifile_8():
+
+    gdal.Unlink('tmp/vsifile_8.bin.gz.gzidx')
+
+    data = ''.join([ '%08d' % i for i in range(200000) ])
+    fp = gdal.VSIFOpenL('/vsigzip/tmp/vsifile_8.bin.gz', 'wb')
+    gdal.VSIFWriteL(data, 1, len(data), fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX', 'YES')
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', '65536')
+
+    for iter in range(2):
+        fp = gdal.VSIFOpenL('/vsigzip/tmp/vsifile_8.bin.gz', 'rb')
+        for offset in [ 1000000, 200000, 1500000, 8, 1599992 ]:
+            gdal.VSIFSeekL(fp, offset, 0)
+            got = gdal.VSIFReadL(1, 8, fp).decode('ascii')
+            if got != '%08d' % (offset // 8):
+                gdaltest.post_reason('fail')
+                print(iter)
+                print(offset)
+                print(got)
+                gdal.VSIFCloseL(fp)
+                gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX', None)
+                gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', None)
+                return 'fail'
+        gdal.VSIFSeekL(fp, 0, 2)
+        size = gdal.VSIFTellL(fp)
+        gdal.VSIFCloseL(fp)
+        if size != len(data):
+            gdaltest.post_reason('fail')
+            print(size)
+            gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX', None)
+            gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', None)
+            return 'fail'
+
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX', None)
+    gdal.SetConfigOption('CPL_VSIL_GZIP_INDEX_SPACING', None)
+
+    if gdal.VSIStatL('tmp/vsifile_8.bin.gz.gzidx') is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    gdal.Unlink('tmp/vsifile_8.bin.gz')
+    gdal.Unlink('tmp/vsifile_8.bin.gz.gzidx')
+
+    return 'success'
+
+###############################################################################
+# Test multi-threaded compression in /vsigzip/ and /vsizip/
+
+def vsifile_9():
+
+    data = ''.join([ '%08d' % i for i in range(200000) ])
+
+    gdal.SetConfigOption('CPL_VSIL_DEFLATE_NUM_THREADS', '4')
+    gdal.SetConfigOption('CPL_VSIL_DEFLATE_CHUNK_SIZE', '65536')
+    for filename in [ '/vsigzip/tmp/vsifile_9.bin.gz',
+                      '/vsizip/tmp/vsifile_9.zip/vsifile_9.bin' ]:
+        fp = gdal.VSIFOpenL(filename, 'wb')
+        gdal.VSIFWriteL(data, 1, len(data), fp)
+        gdal.VSIFCloseL(fp)
+    gdal.SetConfigOption('CPL_VSIL_DEFLATE_NUM_THREADS', None)
+    gdal.SetConfigOption('CPL_VSIL_DEFLATE_CHUNK_SIZE', None)
+
+    for filename in [ '/vsigzip/tmp/vsifile_9.bin.gz',
+                      '/vsizip/tmp/vsifile_9.zip/vsifile_9.bin' ]:
+        fp = gdal.VSIFOpenL(filename, 'rb')
+        got = gdal.VSIFReadL(1, len(data) + 1, fp).decode('ascii')
+        gdal.VSIFCloseL(fp)
+        if got != data:
+            gdaltest.post_reason('fail')
+            print(filename)
+            print(len(got))
+            return 'fail'
+
+    gdal.Unlink('tmp/vsifile_9.bin.gz')
+    gdal.Unlink('tmp/vsifile_9.zip')
+
+    return 'success'
+
+###############################################################################
+# Test the process-wide page cache shared by handles on the same file
+
+def vsifile_10():
+
+    ref_data = ''.join(['%08X' % i for i in range(5*32768)])
+    fp = gdal.VSIFOpenL('tmp/vsifile_10.bin', 'wb')
+    gdal.VSIFWriteL(ref_data, 1, len(ref_data), fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    gdal.SetConfigOption('VSI_CACHE_SHARED', 'YES')
+    fp1 = gdal.VSIFOpenL('tmp/vsifile_10.bin', 'rb')
+    fp2 = gdal.VSIFOpenL('tmp/vsifile_10.bin', 'rb')
+    gdal.SetConfigOption('VSI_CACHE', None)
+    gdal.SetConfigOption('VSI_CACHE_SHARED', None)
+
+    ret = 'success'
+    for (fp, offset, size) in [ (fp1, 0, 100000), (fp1, 100000, 100000),
+                                (fp2, 50000, 200000), (fp2, 1200000, 100000),
+                                (fp1, 16384, 5*32768) ]:
+        gdal.VSIFSeekL(fp, offset, 0)
+        data = gdal.VSIFReadL(1, size, fp).decode('ascii')
+        if data != ref_data[offset:offset+size]:
+            gdaltest.post_reason('fail')
+            print(offset)
+            print(size)
+            ret = 'fail'
+            break
+
+    gdal.VSIFCloseL(fp1)
+    gdal.VSIFCloseL(fp2)
+
+    # Rewrite the file with the same size, most likely within the same
+    # second: its cached pages must not be used
+    if ret == 'success':
+        new_data = ''.join(['%08x' % (i + 1) for i in range(5*32768)])
+        fp = gdal.VSIFOpenL('tmp/vsifile_10.bin', 'wb')
+        gdal.VSIFWriteL(new_data, 1, len(new_data), fp)
+        gdal.VSIFCloseL(fp)
+
+        gdal.SetConfigOption('VSI_CACHE', 'YES')
+        gdal.SetConfigOption('VSI_CACHE_SHARED', 'YES')
+        fp = gdal.VSIFOpenL('tmp/vsifile_10.bin', 'rb')
+        gdal.SetConfigOption('VSI_CACHE', None)
+        gdal.SetConfigOption('VSI_CACHE_SHARED', None)
+        data = gdal.VSIFReadL(1, 100000, fp).decode('ascii')
+        gdal.VSIFCloseL(fp)
+        if data != new_data[0:100000]:
+            gdaltest.post_reason('stale cached pages')
+            ret = 'fail'
+
+    gdal.Unlink('tmp/vsifile_10.bin')
+
+    return ret
+
+###############################################################################
+# Test memory mapped reading of local files
+
+def vsifile_11():
+
+    ref_data = ''.join(['%08X' % i for i in range(5*32768)])
+    fp = gdal.VSIFOpenL('tmp/vsifile_11.bin', 'wb')
+    gdal.VSIFWriteL(ref_data, 1, len(ref_data), fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('CPL_VSIL_LOCAL_MMAP', 'YES')
+    fp = gdal.VSIFOpenL('tmp/vsifile_11.bin', 'rb')
+    gdal.SetConfigOption('CPL_VSIL_LOCAL_MMAP', None)
+
+    ret = 'success'
+    for (offset, size) in [ (0, 100000), (100000, 100000), (50000, 8),
+                            (1200000, 100000), (16384, 5*32768) ]:
+        gdal.VSIFSeekL(fp, offset, 0)
+        data = gdal.VSIFReadL(1, size, fp).decode('ascii')
+        if data != ref_data[offset:offset+size]:
+            gdaltest.post_reason('fail')
+            print(offset)
+            print(size)
+            ret = 'fail'
+            break
+
+    if ret == 'success':
+        gdal.VSIFSeekL(fp, 0, 2)
+        if gdal.VSIFTellL(fp) != len(ref_data):
+            gdaltest.post_reason('fail')
+            ret = 'fail'
+        if gdal.VSIFWriteL('a', 1, 1, fp) != 0:
+            gdaltest.post_reason('fail')
+            ret = 'fail'
+
+    gdal.VSIFCloseL(fp)
+    gdal.Unlink('tmp/vsifile_11.bin')
+
+    return ret
+
 gdaltest_list = [ vsifile_1,
                   vsifile_2,
                   vsifile_3,
                   vsifile_4,
                   vsifile_5,
                   vsifile_6,
-                  vsifile_7 ]
+                  vsifile_7,
+                  vsifile_8,
+                  vsifile_9,
+                  vsifile_10,
+                  vsifile_11 ]
 
 if __name__ == '__main__':
 
@@ -36,6 +36,7 @@ sys.path.append( '../pymod' )
 
 import gdaltest
 from osgeo import osr
+from osgeo import gdal
 
 ###############################################################################
 #	Verify that EPSG:26591 picks up the entry from the pcs.override.csv
@@ -197,6 +198,62 @@ def osr_epsg_9():
 
     return 'success'
 
+###############################################################################
+#   Check that definitions served from the EPSG cache match the ones built
+#   from the CSV files, and that the cached EPSGA form is not altered by
+#   importFromEPSG()
+
+def osr_epsg_10():
+
+    for code in [ 4326, 2193, 32631, 27700 ]:
+        gdal.SetConfigOption('OSR_EPSG_CACHE', 'NO')
+        srs = osr.SpatialReference()
+        srs.ImportFromEPSGA( code )
+        ref_wkt_a = srs.ExportToWkt()
+        srs = osr.SpatialReference()
+        srs.ImportFromEPSG( code )
+        ref_wkt = srs.ExportToWkt()
+        gdal.SetConfigOption('OSR_EPSG_CACHE', None)
+
+        for iter in range(2):
+            srs = osr.SpatialReference()
+            srs.ImportFromEPSG( code )
+            if srs.ExportToWkt() != ref_wkt:
+                gdaltest.post_reason('fail')
+                print(code)
+                print(srs.ExportToWkt())
+                return 'fail'
+
+            srs = osr.SpatialReference()
+            srs.ImportFromEPSGA( code )
+            if srs.ExportToWkt() != ref_wkt_a:
+                gdaltest.post_reason('fail')
+                print(code)
+                print(srs.ExportToWkt())
+                return 'fail'
+
+    # Definitions evicted from a small cache are rebuilt identically
+    gdal.SetConfigOption('OSR_EPSG_CACHE_SIZE', '2')
+    for iter in range(2):
+        for code in [ 4326, 2193, 32631, 27700 ]:
+            gdal.SetConfigOption('OSR_EPSG_CACHE', 'NO')
+            srs = osr.SpatialReference()
+            srs.ImportFromEPSG( code )
+            ref_wkt = srs.ExportToWkt()
+            gdal.SetConfigOption('OSR_EPSG_CACHE', None)
+
+            srs = osr.SpatialReference()
+            srs.ImportFromEPSG( code )
+            if srs.ExportToWkt() != ref_wkt:
+                gdal.SetConfigOption('OSR_EPSG_CACHE_SIZE', None)
+                gdaltest.post_reason('fail')
+                print(code)
+                print(srs.ExportToWkt())
+                return 'fail'
+    gdal.SetConfigOption('OSR_EPSG_CACHE_SIZE', None)
+
+    return 'success'
+
 ###############################################################################
 
 gdaltest_list = [ 
@@ -209,6 +266,7 @@ gdaltest_list = [
     osr_epsg_7,
     osr_epsg_8,
     osr_epsg_9,
+    osr_epsg_10,
     None ]
 
 if __name__ == '__main__':
@@ -35,6 +35,7 @@ except:
     from http.server import BaseHTTPRequestHandler, HTTPServer
 from threading import Thread
 
+import os
 import time
 import sys
 import gdaltest
@@ -47,6 +48,75 @@ class GDAL_Handler(BaseHTTPRequestHandler):
     def log_request(self, code='-', size='-'):
         return
 
+    # Serve a file of the current directory, with support of Range requests
+    # (single range, or multipart/byteranges for several ranges).
+    # The number of GET requests per file is reported by /vsicurl_range_stats/
+    def send_file_range(self, filename, head_only = False):
+        try:
+            f = open(filename, 'rb')
+            content = f.read()
+            f.close()
+        except IOError:
+            self.send_error(404,'File Not Found: %s' % self.path)
+            return
+
+        if not head_only:
+            self.server.get_count[filename] = self.server.get_count.get(filename, 0) + 1
+
+        size = len(content)
+        etag = '"%d-%d"' % (int(os.stat(filename).st_mtime), size)
+        range_header = self.headers.get('Range')
+        if head_only or range_header is None or not range_header.startswith('bytes='):
+            self.send_response(200)
+            self.send_header('Content-Length', '%d' % size)
+            self.send_header('Accept-Ranges', 'bytes')
+            self.send_header('ETag', etag)
+            self.end_headers()
+            if not head_only:
+                self.wfile.write(content)
+            return
+
+        ranges = []
+        for range_spec in range_header[len('bytes='):].split(','):
+            (start, end) = range_spec.strip().split('-')
+            start = int(start)
+            if end == '' or int(end) >= size:
+                end = size - 1
+            else:
+                end = int(end)
+            ranges.append((start, end))
+
+        if len(ranges) == 1:
+            (start, end) = ranges[0]
+            self.send_response(206)
+            self.send_header('Content-Length', '%d' % (end + 1 - start))
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, size))
+            self.send_header('ETag', etag)
+            self.end_headers()
+            self.wfile.write(content[start:end+1])
+            return
+
+        boundary = 'GDAL_RANGE_BOUNDARY'
+        body = ''.encode('ascii')
+        for (start, end) in ranges:
+            body += ('--%s\r\nContent-Type: application/octet-stream\r\n' % boundary).encode('ascii')
+            body += ('Content-Range: bytes %d-%d/%d\r\n\r\n' % (start, end, size)).encode('ascii')
+            body += content[start:end+1] + '\r\n'.encode('ascii')
+        body += ('--%s--\r\n' % boundary).encode('ascii')
+        self.send_response(206)
+        self.send_header('Content-Type', 'multipart/byteranges; boundary=%s' % boundary)
+        self.send_header('Content-Length', '%d' % len(body))
+        self.send_header('ETag', etag)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_HEAD(self):
+        if self.path.startswith('/vsicurl_range/'):
+            self.send_file_range(self.path[len('/vsicurl_range/'):], head_only = True)
+            return
+
+        self.send_error(404,'File Not Found: %s' % self.path)
+
     def do_DELETE(self):
         if do_log:
             f = open('/tmp/log.txt', 'a')
@@ -93,6 +163,19 @@ class GDAL_Handler(BaseHTTPRequestHandler):
                 self.end_headers()
                 return
 
+            # Below is for /vsicurl/
+            if self.path.startswith('/vsicurl_range/'):
+                self.send_file_range(self.path[len('/vsicurl_range/'):])
+                return
+
+            if self.path.startswith('/vsicurl_range_stats/'):
+                filename = self.path[len('/vsicurl_range_stats/'):]
+                self.send_response(200)
+                self.send_header('Content-type', 'text/plain')
+                self.end_headers()
+                self.wfile.write(('%d' % self.server.get_count.get(filename, 0)).encode('ascii'))
+                return
+
 
             # Below is for ElasticSearch
             if self.path.find('/fakeelasticsearch') != -1:
@@ -403,6 +486,7 @@ class GDAL_HttpServer(HTTPServer):
         HTTPServer.__init__(self, server_address, handlerClass)
         self.running = False
         self.stop_requested = False
+        self.get_count = {}
 
     def is_running(self):
         return self.running
@@ -496,6 +580,15 @@ def launch():
 
     return (process, port)
 
+# Number of GET requests received for a file served by /vsicurl_range/
+def get_request_count(port, filename):
+    f = gdaltest.gdalurlopen('http://127.0.0.1:%d/vsicurl_range_stats/%s' % (port, filename))
+    if f is None:
+        return -1
+    count = int(f.read())
+    f.close()
+    return count
+
 def server_stop(process, port):
     gdaltest.gdalurlopen('http://127.0.0.1:%d/shutdown' % port)
     gdaltest.wait_process(process)
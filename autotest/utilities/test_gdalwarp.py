@@ -1318,6 +1318,31 @@ def test_gdalwarp_41():
 
     return 'success'
 
+###############################################################################
+# Test -multi with several chunks warped concurrently (CHUNK_THREADS)
+
+def test_gdalwarp_42():
+    if test_cli_utilities.get_gdalwarp_path() is None:
+        return 'skip'
+
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' ../gcore/data/utmsmall.tif tmp/test_gdalwarp_42_ref.tif -overwrite -t_srs EPSG:4326 -ts 500 500 -r cubic -wm 1')
+    ds = gdal.Open('tmp/test_gdalwarp_42_ref.tif')
+    cs_ref = ds.GetRasterBand(1).Checksum()
+    ds = None
+
+    for opts in [ '-wo CHUNK_THREADS=4', '-wo CHUNK_THREADS=ALL_CPUS -wo NUM_THREADS=2',
+                  '-wo CHUNK_THREADS=3 -wo STREAMABLE_OUTPUT=YES' ]:
+        gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' ../gcore/data/utmsmall.tif tmp/test_gdalwarp_42.tif -overwrite -t_srs EPSG:4326 -ts 500 500 -r cubic -wm 1 -multi ' + opts)
+        ds = gdal.Open('tmp/test_gdalwarp_42.tif')
+        cs = ds.GetRasterBand(1).Checksum()
+        ds = None
+        if cs != cs_ref:
+            gdaltest.post_reason('failure')
+            print(opts, cs, cs_ref)
+            return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup
 
@@ -1391,6 +1416,11 @@ def test_gdalwarp_cleanup():
         os.remove('tmp/test_gdalwarp_41.tif')
     except:
         pass
+    try:
+        os.remove('tmp/test_gdalwarp_42_ref.tif')
+        os.remove('tmp/test_gdalwarp_42.tif')
+    except:
+        pass
     return 'success'
 
 gdaltest_list = [
@@ -1436,6 +1466,7 @@ gdaltest_list = [
     test_gdalwarp_39,
     test_gdalwarp_40,
     test_gdalwarp_41,
+    test_gdalwarp_42,
     test_gdalwarp_cleanup
     ]
 
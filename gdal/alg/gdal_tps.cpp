@@ -44,6 +44,12 @@ CPLXMLNode *GDALSerializeTPSTransformer( void *pTransformArg );
 void *GDALDeserializeTPSTransformer( CPLXMLNode *psTree );
 CPL_C_END
 
+/* Number of GCPs above which TPS_MODE=AUTO selects the local mode */
+#define TPS_LOCAL_MODE_THRESHOLD    1000
+
+/* Maximum number of GCPs per cell in the local mode */
+#define TPS_LOCAL_MODE_CELL_POINTS  8
+
 typedef struct
 {
     GDALTransformerInfo  sTI;
@@ -54,6 +60,7 @@ typedef struct
     int                  bReverseSolved;
 
     int       bReversed;
+    int       bLocal;
 
     int       nGCPCount;
     GDAL_GCP *pasGCPList;
@@ -88,8 +95,11 @@ void* GDALCreateSimilarTPSTransformer( void *hTransformArg, double dfRatioX, dou
             pasGCPList[i].dfGCPPixel /= dfRatioX;
             pasGCPList[i].dfGCPLine /= dfRatioY;
         }
-        psInfo = (TPSTransformInfo *) GDALCreateTPSTransformer( psInfo->nGCPCount, pasGCPList,
-                                           psInfo->bReversed );
+        char **papszOptions = CSLSetNameValue( NULL, "TPS_MODE",
+                                    psInfo->bLocal ? "LOCAL" : "GLOBAL" );
+        psInfo = (TPSTransformInfo *) GDALCreateTPSTransformerInt( psInfo->nGCPCount, pasGCPList,
+                                           psInfo->bReversed, papszOptions );
+        CSLDestroy( papszOptions );
         GDALDeinitGCPs( psInfo->nGCPCount, pasGCPList );
         CPLFree( pasGCPList );
     }
@@ -116,6 +126,14 @@ void* GDALCreateSimilarTPSTransformer( void *hTransformArg, double dfRatioX, dou
  * for large numbers of GCPs.  For instance, for reference, it takes on the 
  * order of 10s for 400 GCPs on a 2GHz Athlon processor. 
  *
+ * With the TPS_MODE=LOCAL option of GDALCreateGenImgProjTransformer2(),
+ * the transformer is approximated by local thin plate splines, each fitted
+ * on the GCPs of a small neighbourhood and blended together.  The result is
+ * still exact at the GCPs, and the cost grows about linearly with the number
+ * of GCPs instead of cubically, but it only approximates the global spline
+ * between the GCPs.  TPS_MODE=AUTO selects the local mode above 1000 GCPs.
+ * The default, GLOBAL, always solves the global spline.
+ *
  * TPS Transformers are serializable. 
  *
  * The GDAL Thin Plate Spline transformer is based on code provided by
@@ -161,6 +179,20 @@ void *GDALCreateTPSTransformerInt( int nGCPCount, const GDAL_GCP *pasGCPList,
     psInfo->poForward = new VizGeorefSpline2D( 2 );
     psInfo->poReverse = new VizGeorefSpline2D( 2 );
 
+    const char* pszMode = CSLFetchNameValueDef(papszOptions, "TPS_MODE", "GLOBAL");
+    if( EQUAL(pszMode, "LOCAL") )
+        psInfo->bLocal = TRUE;
+    else if( EQUAL(pszMode, "AUTO") )
+        psInfo->bLocal = ( nGCPCount > TPS_LOCAL_MODE_THRESHOLD );
+    else
+        psInfo->bLocal = FALSE;
+
+    if( psInfo->bLocal )
+    {
+        psInfo->poForward->set_local_mode( TPS_LOCAL_MODE_CELL_POINTS );
+        psInfo->poReverse->set_local_mode( TPS_LOCAL_MODE_CELL_POINTS );
+    }
+
     memcpy( psInfo->sTI.abySignature, GDAL_GTI2_SIGNATURE, strlen(GDAL_GTI2_SIGNATURE) );
     psInfo->sTI.pszClassName = "GDALTPSTransformer";
     psInfo->sTI.pfnTransform = GDALTPSTransform;
@@ -342,6 +374,12 @@ CPLXMLNode *GDALSerializeTPSTransformer( void *pTransformArg )
     CPLCreateXMLElementAndValue( 
         psTree, "Reversed", 
         CPLString().Printf( "%d", psInfo->bReversed ) );
+
+/* -------------------------------------------------------------------- */
+/*      Serialize the mode, if it is not the default one.               */
+/* -------------------------------------------------------------------- */
+    if( psInfo->bLocal )
+        CPLCreateXMLElementAndValue( psTree, "Mode", "LOCAL" );
                                  
 /* -------------------------------------------------------------------- */
 /*	Attach GCP List. 						*/
@@ -390,7 +428,11 @@ void *GDALDeserializeTPSTransformer( CPLXMLNode *psTree )
 /* -------------------------------------------------------------------- */
 /*      Generate transformation.                                        */
 /* -------------------------------------------------------------------- */
-    pResult = GDALCreateTPSTransformer( nGCPCount, pasGCPList, bReversed );
+    char **papszOptions = CSLSetNameValue( NULL, "TPS_MODE",
+                               CPLGetXMLValue(psTree,"Mode","GLOBAL") );
+    pResult = GDALCreateTPSTransformerInt( nGCPCount, pasGCPList, bReversed,
+                                           papszOptions );
+    CSLDestroy( papszOptions );
     
 /* -------------------------------------------------------------------- */
 /*      Cleanup GCP copy.                                               */
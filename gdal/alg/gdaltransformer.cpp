@@ -1142,6 +1142,10 @@ static GDALGenImgProjTransformInfo* GDALCreateGenImgProjTransformerInternal()
  * <li> MAX_GCP_ORDER: the maximum order to use for GCP derived polynomials if
  * possible.  The default is to autoselect based on the number of GCPs.  
  * A value of -1 triggers use of Thin Plate Spline instead of polynomials.
+ * <li> TPS_MODE: GLOBAL (the default), LOCAL or AUTO.  With LOCAL, the Thin
+ * Plate Spline is approximated by blending local splines fitted on the
+ * neighbourhood of each GCP, which is practical for large numbers of GCPs.
+ * AUTO selects LOCAL above 1000 GCPs.
  * <li> SRC_METHOD: may have a value which is one of GEOTRANSFORM, 
  * GCP_POLYNOMIAL, GCP_TPS, GEOLOC_ARRAY, RPC to force only one geolocation 
  * method to be considered on the source dataset. Will be used for pixel/line 
@@ -2491,6 +2495,40 @@ GDALDeserializeReprojectionTransformer( CPLXMLNode *psTree )
 /* ==================================================================== */
 /************************************************************************/
 
+/* Exactly transformed rows of grid nodes, bounding the band of scanlines */
+/* currently approximated in grid mode.  A row holds the nNodes nodes, */
+/* followed by the nNodes - 1 midpoints of the tile edges along the row. */
+typedef struct
+{
+    int               bDstToSrc;
+    int               nPoints;      /* layout of the scanlines */
+    double            dfX0;
+    double            dfXStep;
+    double            dfZ;
+
+    int               nColStep;     /* points between two node columns */
+    int               nNodes;
+    int               nRowPoints;   /* 2 * nNodes - 1 */
+    int               nRowStep;     /* height of the next band, in lines */
+    double            dfLineStep;   /* y distance between two scanlines */
+
+    int               bHasLastY;
+    double            dfLastY;
+
+    int               bHasTopRow;
+    int               bHasBottomRow;
+    double            dfYTop;
+    double            dfYBottom;
+
+    double           *padfTop;      /* x, y and z of the row points */
+    int              *panTopSuccess;
+    double           *padfBottom;
+    int              *panBottomSuccess;
+    double           *padfCheck;    /* x, y and z of the tile centers, */
+    int              *panCheckSuccess; /* then of the vertical edge midpoints */
+    GByte            *pabyTileValid;
+} ApproxTransformGrid;
+
 typedef struct 
 {
     GDALTransformerInfo sTI;
@@ -2500,8 +2538,36 @@ typedef struct
     double	      dfMaxError;
 
     int               bOwnSubtransformer;
+
+    int               nGridStep;    /* 0 if grid mode is disabled */
+    ApproxTransformGrid *psGrid;
 } ApproxTransformInfo;
 
+static int GDALApproxTransformInternal( ApproxTransformInfo *psATInfo,
+                                        int bDstToSrc, int nPoints,
+                                        double *x, double *y, double *z,
+                                        int *panSuccess );
+
+/************************************************************************/
+/*                        GDALApproxGridFree()                          */
+/************************************************************************/
+
+static void GDALApproxGridFree( ApproxTransformGrid *psGrid )
+
+{
+    if( psGrid == NULL )
+        return;
+
+    CPLFree( psGrid->padfTop );
+    CPLFree( psGrid->panTopSuccess );
+    CPLFree( psGrid->padfBottom );
+    CPLFree( psGrid->panBottomSuccess );
+    CPLFree( psGrid->padfCheck );
+    CPLFree( psGrid->panCheckSuccess );
+    CPLFree( psGrid->pabyTileValid );
+    CPLFree( psGrid );
+}
+
 /************************************************************************/
 /*                  GDALCreateSimilarApproxTransformer()                */
 /************************************************************************/
@@ -2518,6 +2584,7 @@ void* GDALCreateSimilarApproxTransformer( void *hTransformArg, double dfSrcRatio
         CPLMalloc(sizeof(ApproxTransformInfo));
 
     memcpy(psClonedInfo, psInfo, sizeof(ApproxTransformInfo));
+    psClonedInfo->psGrid = NULL;
     if( psClonedInfo->pBaseCBData )
     {
         psClonedInfo->pBaseCBData = GDALCreateSimilarTransformer( psInfo->pBaseCBData,
@@ -2601,6 +2668,19 @@ GDALSerializeApproxTransformer( void *pTransformArg )
  * circumstances as little internal validation is done, in order to keep things
  * fast. 
  *
+ * If the GDAL_APPROX_TRANSFORMER_GRID configuration option is set to YES,
+ * consecutive scanlines are instead approximated by bilinear interpolation
+ * within tiles of a grid of exactly transformed nodes, that are reused
+ * from one scanline to the next.  The error of each tile is checked at
+ * its center and at the midpoints of its edges, the size of the tiles is
+ * adapted so that most of them are within the threshold, and the remaining
+ * ones are approximated by scanline as above.  The maximum size of the
+ * tiles, in pixels and scanlines, is set with
+ * GDAL_APPROX_TRANSFORMER_GRID_STEP (64 by default).  In this mode the
+ * transformer keeps state between calls, so an instance must not be used
+ * by several threads at the same time; GDALCloneTransformer() can be used
+ * to get one instance per thread.
+ *
  * @param pfnBaseTransformer the high precision transformer which should be
  * approximated. 
  * @param pBaseTransformArg the callback argument for the high precision 
@@ -2623,6 +2703,14 @@ void *GDALCreateApproxTransformer( GDALTransformerFunc pfnBaseTransformer,
     psATInfo->pBaseCBData = pBaseTransformArg;
     psATInfo->dfMaxError = dfMaxError;
     psATInfo->bOwnSubtransformer = FALSE;
+    psATInfo->psGrid = NULL;
+    psATInfo->nGridStep = 0;
+    if( CSLTestBoolean(CPLGetConfigOption("GDAL_APPROX_TRANSFORMER_GRID",
+                                          "NO")) )
+    {
+        psATInfo->nGridStep = MAX(2, atoi(CPLGetConfigOption(
+                            "GDAL_APPROX_TRANSFORMER_GRID_STEP", "64")));
+    }
 
     memcpy( psATInfo->sTI.abySignature, GDAL_GTI2_SIGNATURE, strlen(GDAL_GTI2_SIGNATURE) );
     psATInfo->sTI.pszClassName = "GDALApproxTransformer";
@@ -2669,9 +2757,456 @@ void GDALDestroyApproxTransformer( void * pCBData )
     if( psATInfo->bOwnSubtransformer ) 
         GDALDestroyTransformer( psATInfo->pBaseCBData );
 
+    GDALApproxGridFree( psATInfo->psGrid );
+
     CPLFree( pCBData );
 }
 
+/************************************************************************/
+/*                      GDALApproxGridSetColStep()                      */
+/*                                                                      */
+/*      (Re)allocate the rows of the grid for node columns every        */
+/*      nColStep points of the scanlines.                               */
+/************************************************************************/
+
+static void GDALApproxGridSetColStep( ApproxTransformGrid *psGrid,
+                                      int nColStep )
+
+{
+    psGrid->nColStep = nColStep;
+    psGrid->nNodes = (psGrid->nPoints - 2) / nColStep + 2;
+    psGrid->nRowPoints = 2 * psGrid->nNodes - 1;
+
+    CPLFree( psGrid->padfTop );
+    CPLFree( psGrid->panTopSuccess );
+    CPLFree( psGrid->padfBottom );
+    CPLFree( psGrid->panBottomSuccess );
+    CPLFree( psGrid->padfCheck );
+    CPLFree( psGrid->panCheckSuccess );
+    CPLFree( psGrid->pabyTileValid );
+
+    psGrid->padfTop = (double *)
+        CPLMalloc( sizeof(double) * 3 * psGrid->nRowPoints );
+    psGrid->panTopSuccess = (int *)
+        CPLMalloc( sizeof(int) * psGrid->nRowPoints );
+    psGrid->padfBottom = (double *)
+        CPLMalloc( sizeof(double) * 3 * psGrid->nRowPoints );
+    psGrid->panBottomSuccess = (int *)
+        CPLMalloc( sizeof(int) * psGrid->nRowPoints );
+    psGrid->padfCheck = (double *)
+        CPLMalloc( sizeof(double) * 3 * psGrid->nRowPoints );
+    psGrid->panCheckSuccess = (int *)
+        CPLMalloc( sizeof(int) * psGrid->nRowPoints );
+    psGrid->pabyTileValid = (GByte *) CPLMalloc( psGrid->nNodes );
+
+    psGrid->bHasTopRow = FALSE;
+    psGrid->bHasBottomRow = FALSE;
+}
+
+/************************************************************************/
+/*                      GDALApproxGridSetLayout()                       */
+/*                                                                      */
+/*      (Re)initialize the grid for scanlines of nPoints points         */
+/*      starting at dfX0 and separated by dfXStep.                      */
+/************************************************************************/
+
+static ApproxTransformGrid *
+GDALApproxGridSetLayout( ApproxTransformInfo *psATInfo, int bDstToSrc,
+                         int nPoints, double dfX0, double dfXStep, double dfZ )
+
+{
+    ApproxTransformGrid *psGrid = psATInfo->psGrid;
+
+    if( psGrid != NULL && psGrid->bDstToSrc == bDstToSrc
+        && psGrid->nPoints == nPoints && psGrid->dfX0 == dfX0
+        && psGrid->dfXStep == dfXStep && psGrid->dfZ == dfZ )
+        return psGrid;
+
+    if( psGrid == NULL || psGrid->nPoints != nPoints )
+    {
+        GDALApproxGridFree( psGrid );
+
+        psGrid = (ApproxTransformGrid *)
+            CPLCalloc( sizeof(ApproxTransformGrid), 1 );
+        psGrid->nPoints = nPoints;
+        GDALApproxGridSetColStep( psGrid, psATInfo->nGridStep );
+        psATInfo->psGrid = psGrid;
+    }
+
+    psGrid->bDstToSrc = bDstToSrc;
+    psGrid->nPoints = nPoints;
+    psGrid->dfX0 = dfX0;
+    psGrid->dfXStep = dfXStep;
+    psGrid->dfZ = dfZ;
+    psGrid->nRowStep = psATInfo->nGridStep;
+    /* Until two scanlines have been seen, assume square pixels */
+    psGrid->dfLineStep = fabs( dfXStep );
+    psGrid->bHasLastY = FALSE;
+    psGrid->bHasTopRow = FALSE;
+    psGrid->bHasBottomRow = FALSE;
+
+    return psGrid;
+}
+
+/************************************************************************/
+/*                     GDALApproxGridNodeIndex()                        */
+/************************************************************************/
+
+static CPL_INLINE int GDALApproxGridNodeIndex( const ApproxTransformGrid *psGrid,
+                                               int iNode )
+{
+    return MIN( iNode * psGrid->nColStep, psGrid->nPoints - 1 );
+}
+
+/************************************************************************/
+/*                     GDALApproxGridTransformRow()                     */
+/*                                                                      */
+/*      Exactly transform the nodes of a row of the grid, and the       */
+/*      midpoints between them.                                         */
+/************************************************************************/
+
+static void GDALApproxGridTransformRow( ApproxTransformInfo *psATInfo,
+                                        ApproxTransformGrid *psGrid,
+                                        double dfY, double *padfRow,
+                                        int *panRowSuccess )
+
+{
+    int     nNodes = psGrid->nNodes;
+    int     nRowPoints = psGrid->nRowPoints;
+    double *padfX = padfRow;
+    double *padfY = padfRow + nRowPoints;
+    double *padfZ = padfRow + 2 * nRowPoints;
+    int     iNode, i;
+
+    for( iNode = 0; iNode < nNodes; iNode++ )
+        padfX[iNode] = psGrid->dfX0 + psGrid->dfXStep *
+                                GDALApproxGridNodeIndex( psGrid, iNode );
+    for( iNode = 0; iNode < nNodes - 1; iNode++ )
+        padfX[nNodes + iNode] = 0.5 * (padfX[iNode] + padfX[iNode+1]);
+
+    for( i = 0; i < nRowPoints; i++ )
+    {
+        padfY[i] = dfY;
+        padfZ[i] = psGrid->dfZ;
+    }
+
+    if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                       psGrid->bDstToSrc, nRowPoints,
+                                       padfX, padfY, padfZ, panRowSuccess ) )
+        memset( panRowSuccess, 0, sizeof(int) * nRowPoints );
+}
+
+/************************************************************************/
+/*                     GDALApproxGridBuildBand()                        */
+/*                                                                      */
+/*      Compute the bottom row of the band starting at the top row,     */
+/*      and flag the tiles that are close enough to the bilinear        */
+/*      interpolation of their corners at their center and at the       */
+/*      midpoints of their 4 edges.  The band height is halved until    */
+/*      at least 3/4 of the tiles are valid.  If the tiles mostly fail  */
+/*      along the rows, which a lower band cannot fix, the distance     */
+/*      between node columns is halved instead.                         */
+/************************************************************************/
+
+static void GDALApproxGridBuildBand( ApproxTransformInfo *psATInfo,
+                                     ApproxTransformGrid *psGrid )
+
+{
+    int     nRowStep = psGrid->nRowStep;
+    int     nInvalid;
+
+    for( ;; )
+    {
+        int     nNodes = psGrid->nNodes;
+        int     nTiles = nNodes - 1;
+        int     nRowPoints = psGrid->nRowPoints;
+        int     nInvalidAlongRows = 0;
+        int     iTile, iNode, i;
+        double  dfYMiddle;
+
+        const double *padfTopX = psGrid->padfTop;
+        const double *padfTopY = psGrid->padfTop + nRowPoints;
+        const int    *panTopSuccess = psGrid->panTopSuccess;
+        const double *padfBotX = psGrid->padfBottom;
+        const double *padfBotY = psGrid->padfBottom + nRowPoints;
+        const int    *panBotSuccess = psGrid->panBottomSuccess;
+        double *padfCX = psGrid->padfCheck;
+        double *padfCY = psGrid->padfCheck + nRowPoints;
+        double *padfCZ = psGrid->padfCheck + 2 * nRowPoints;
+        const int    *panCSuccess = psGrid->panCheckSuccess;
+
+        psGrid->dfYBottom = psGrid->dfYTop + nRowStep * psGrid->dfLineStep;
+        dfYMiddle = 0.5 * (psGrid->dfYTop + psGrid->dfYBottom);
+        GDALApproxGridTransformRow( psATInfo, psGrid, psGrid->dfYBottom,
+                                    psGrid->padfBottom,
+                                    psGrid->panBottomSuccess );
+
+/* -------------------------------------------------------------------- */
+/*      Tile centers, then midpoints of the vertical edges.             */
+/* -------------------------------------------------------------------- */
+        for( iTile = 0; iTile < nTiles; iTile++ )
+            padfCX[iTile] = psGrid->dfX0 + psGrid->dfXStep * 0.5 *
+                ( GDALApproxGridNodeIndex( psGrid, iTile )
+                  + GDALApproxGridNodeIndex( psGrid, iTile + 1 ) );
+        for( iNode = 0; iNode < nNodes; iNode++ )
+            padfCX[nTiles + iNode] = psGrid->dfX0 + psGrid->dfXStep *
+                GDALApproxGridNodeIndex( psGrid, iNode );
+        for( i = 0; i < nRowPoints; i++ )
+        {
+            padfCY[i] = dfYMiddle;
+            padfCZ[i] = psGrid->dfZ;
+        }
+
+        if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                           psGrid->bDstToSrc, nRowPoints,
+                                           padfCX, padfCY, padfCZ,
+                                           psGrid->panCheckSuccess ) )
+            memset( psGrid->panCheckSuccess, 0, sizeof(int) * nRowPoints );
+
+        nInvalid = 0;
+        for( iTile = 0; iTile < nTiles; iTile++ )
+        {
+            int iTopMid = nNodes + iTile;
+            int iLeft = nTiles + iTile;
+            int bValid = panTopSuccess[iTile] && panTopSuccess[iTile+1]
+                && panBotSuccess[iTile] && panBotSuccess[iTile+1]
+                && panTopSuccess[iTopMid] && panBotSuccess[iTopMid]
+                && panCSuccess[iTile]
+                && panCSuccess[iLeft] && panCSuccess[iLeft+1];
+
+            if( bValid )
+            {
+                double dfError, dfMaxError = 0.0;
+
+                /* center */
+                dfError =
+                    fabs( 0.25 * (padfTopX[iTile] + padfTopX[iTile+1]
+                                  + padfBotX[iTile] + padfBotX[iTile+1])
+                          - padfCX[iTile] )
+                  + fabs( 0.25 * (padfTopY[iTile] + padfTopY[iTile+1]
+                                  + padfBotY[iTile] + padfBotY[iTile+1])
+                          - padfCY[iTile] );
+                dfMaxError = MAX( dfMaxError, dfError );
+
+                /* top and bottom edges */
+                double dfRowError =
+                    fabs( 0.5 * (padfTopX[iTile] + padfTopX[iTile+1])
+                          - padfTopX[iTopMid] )
+                  + fabs( 0.5 * (padfTopY[iTile] + padfTopY[iTile+1])
+                          - padfTopY[iTopMid] );
+                dfError =
+                    fabs( 0.5 * (padfBotX[iTile] + padfBotX[iTile+1])
+                          - padfBotX[iTopMid] )
+                  + fabs( 0.5 * (padfBotY[iTile] + padfBotY[iTile+1])
+                          - padfBotY[iTopMid] );
+                dfRowError = MAX( dfRowError, dfError );
+                if( dfRowError > psATInfo->dfMaxError )
+                    nInvalidAlongRows++;
+                dfMaxError = MAX( dfMaxError, dfRowError );
+
+                /* left and right edges */
+                dfError =
+                    fabs( 0.5 * (padfTopX[iTile] + padfBotX[iTile])
+                          - padfCX[iLeft] )
+                  + fabs( 0.5 * (padfTopY[iTile] + padfBotY[iTile])
+                          - padfCY[iLeft] );
+                dfMaxError = MAX( dfMaxError, dfError );
+                dfError =
+                    fabs( 0.5 * (padfTopX[iTile+1] + padfBotX[iTile+1])
+                          - padfCX[iLeft+1] )
+                  + fabs( 0.5 * (padfTopY[iTile+1] + padfBotY[iTile+1])
+                          - padfCY[iLeft+1] );
+                dfMaxError = MAX( dfMaxError, dfError );
+
+                bValid = ( dfMaxError <= psATInfo->dfMaxError );
+            }
+
+            psGrid->pabyTileValid[iTile] = (GByte) bValid;
+            if( !bValid )
+                nInvalid++;
+        }
+
+        if( nInvalid * 4 <= nTiles )
+            break;
+
+        if( nInvalidAlongRows * 4 > nTiles && psGrid->nColStep > 2 )
+        {
+            GDALApproxGridSetColStep( psGrid, psGrid->nColStep / 2 );
+            GDALApproxGridTransformRow( psATInfo, psGrid, psGrid->dfYTop,
+                                        psGrid->padfTop,
+                                        psGrid->panTopSuccess );
+            psGrid->bHasTopRow = TRUE;
+            continue;
+        }
+
+        if( nRowStep == 1 )
+            break;
+
+        nRowStep /= 2;
+    }
+
+    psGrid->bHasBottomRow = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      Try higher bands again when the approximation is good.          */
+/* -------------------------------------------------------------------- */
+    if( nInvalid == 0 )
+        psGrid->nRowStep = MIN( nRowStep * 2, psATInfo->nGridStep );
+    else
+        psGrid->nRowStep = nRowStep;
+}
+
+/************************************************************************/
+/*                      GDALApproxGridTransform()                       */
+/*                                                                      */
+/*      Grid mode of GDALApproxTransform().  The scanline is            */
+/*      interpolated in the band of the grid that contains it,          */
+/*      computing a new band if needed.  The bottom row of a band is    */
+/*      the top row of the next one, so proceeding scanline by          */
+/*      scanline only costs one exactly transformed row of nodes per    */
+/*      band.                                                           */
+/************************************************************************/
+
+static int GDALApproxGridTransform( ApproxTransformInfo *psATInfo,
+                                    int bDstToSrc, int nPoints,
+                                    double *x, double *y, double *z,
+                                    int *panSuccess )
+
+{
+    int     nMiddle = (nPoints-1)/2;
+
+/* -------------------------------------------------------------------- */
+/*      We need a scanline of regularly spaced points.                  */
+/* -------------------------------------------------------------------- */
+    if( y[0] != y[nPoints-1] || y[0] != y[nMiddle]
+        || z[0] != z[nPoints-1]
+        || x[0] == x[nPoints-1] || x[0] == x[nMiddle]
+        || psATInfo->dfMaxError == 0.0 || nPoints <= 5 )
+    {
+        return GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints,
+                                            x, y, z, panSuccess );
+    }
+
+    double  dfXStep = (x[nPoints-1] - x[0]) / (nPoints - 1);
+    if( fabs( x[0] + dfXStep * nMiddle - x[nMiddle] ) > 1e-8 * fabs(dfXStep) )
+    {
+        return GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints,
+                                            x, y, z, panSuccess );
+    }
+
+    ApproxTransformGrid *psGrid =
+        GDALApproxGridSetLayout( psATInfo, bDstToSrc, nPoints,
+                                 x[0], dfXStep, z[0] );
+    double  dfY = y[0];
+    double  dfT = 0.0;
+
+    if( psGrid->bHasTopRow && psGrid->bHasBottomRow )
+        dfT = (dfY - psGrid->dfYTop) / (psGrid->dfYBottom - psGrid->dfYTop);
+
+/* -------------------------------------------------------------------- */
+/*      Band heights are counted in scanlines, so learn the distance    */
+/*      between consecutive ones.  Scanlines going the other way than   */
+/*      the current band make the next band go their way.  Jumps of     */
+/*      more than one band are not taken as a line step.                */
+/* -------------------------------------------------------------------- */
+    if( psGrid->bHasLastY && dfY != psGrid->dfLastY
+        && psGrid->bHasTopRow && psGrid->bHasBottomRow
+        && dfT >= -1.0 && dfT <= 1.0 )
+    {
+        psGrid->dfLineStep = dfY - psGrid->dfLastY;
+    }
+    psGrid->dfLastY = dfY;
+    psGrid->bHasLastY = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      Find or compute the band containing the scanline.  The bottom   */
+/*      row is excluded, so that it becomes the top of the next band.   */
+/* -------------------------------------------------------------------- */
+    if( !(psGrid->bHasTopRow && psGrid->bHasBottomRow
+          && dfT >= 0.0 && dfT < 1.0
+          && (psGrid->dfYBottom - psGrid->dfYTop) * psGrid->dfLineStep > 0) )
+    {
+        if( psGrid->bHasBottomRow && dfY == psGrid->dfYBottom )
+        {
+            double *padfTmp = psGrid->padfTop;
+            int    *panTmp = psGrid->panTopSuccess;
+
+            psGrid->padfTop = psGrid->padfBottom;
+            psGrid->panTopSuccess = psGrid->panBottomSuccess;
+            psGrid->padfBottom = padfTmp;
+            psGrid->panBottomSuccess = panTmp;
+            psGrid->dfYTop = dfY;
+        }
+        else if( !(psGrid->bHasTopRow && dfY == psGrid->dfYTop) )
+        {
+            psGrid->dfYTop = dfY;
+            GDALApproxGridTransformRow( psATInfo, psGrid, dfY,
+                                        psGrid->padfTop,
+                                        psGrid->panTopSuccess );
+        }
+        psGrid->bHasTopRow = TRUE;
+        psGrid->bHasBottomRow = FALSE;
+
+        GDALApproxGridBuildBand( psATInfo, psGrid );
+
+        dfT = (dfY - psGrid->dfYTop) / (psGrid->dfYBottom - psGrid->dfYTop);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Interpolate the points of each tile from its corners, or        */
+/*      approximate them by scanline for the invalid tiles.             */
+/* -------------------------------------------------------------------- */
+    int     nNodes = psGrid->nNodes;
+    int     nTiles = nNodes - 1;
+    int     nRowPoints = psGrid->nRowPoints;
+    double  dfOneMinusT = 1.0 - dfT;
+    const double *padfTop = psGrid->padfTop;
+    const double *padfBot = psGrid->padfBottom;
+    int     iTile;
+
+    for( iTile = 0; iTile < nTiles; iTile++ )
+    {
+        int iStart = GDALApproxGridNodeIndex( psGrid, iTile );
+        int iEnd = GDALApproxGridNodeIndex( psGrid, iTile + 1 );
+        int nTilePoints = (iTile == nTiles - 1) ? iEnd - iStart + 1
+                                                : iEnd - iStart;
+
+        if( !psGrid->pabyTileValid[iTile] )
+        {
+            if( !GDALApproxTransformInternal( psATInfo, bDstToSrc,
+                                              nTilePoints,
+                                              x + iStart, y + iStart,
+                                              z + iStart,
+                                              panSuccess + iStart ) )
+                return FALSE;
+            continue;
+        }
+
+        double adfLeft[3], adfDelta[3];
+        int    iCoord, i;
+
+        for( iCoord = 0; iCoord < 3; iCoord++ )
+        {
+            int iOff = iCoord * nRowPoints + iTile;
+            double dfLeft = padfTop[iOff] * dfOneMinusT + padfBot[iOff] * dfT;
+            double dfRight = padfTop[iOff+1] * dfOneMinusT
+                                + padfBot[iOff+1] * dfT;
+            adfLeft[iCoord] = dfLeft;
+            adfDelta[iCoord] = (dfRight - dfLeft) / (iEnd - iStart);
+        }
+
+        for( i = 0; i < nTilePoints; i++ )
+        {
+            x[iStart+i] = adfLeft[0] + adfDelta[0] * i;
+            y[iStart+i] = adfLeft[1] + adfDelta[1] * i;
+            z[iStart+i] = adfLeft[2] + adfDelta[2] * i;
+            panSuccess[iStart+i] = TRUE;
+        }
+    }
+
+    return TRUE;
+}
+
 /************************************************************************/
 /*                        GDALApproxTransform()                         */
 /************************************************************************/
@@ -2690,6 +3225,27 @@ int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints,
 
 {
     ApproxTransformInfo *psATInfo = (ApproxTransformInfo *) pCBData;
+
+    if( psATInfo->nGridStep > 0 )
+        return GDALApproxGridTransform( psATInfo, bDstToSrc, nPoints,
+                                        x, y, z, panSuccess );
+
+    return GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints,
+                                        x, y, z, panSuccess );
+}
+
+/************************************************************************/
+/*                    GDALApproxTransformInternal()                     */
+/*                                                                      */
+/*      Linear approximation of a single scanline.                      */
+/************************************************************************/
+
+static int GDALApproxTransformInternal( ApproxTransformInfo *psATInfo,
+                                        int bDstToSrc, int nPoints,
+                                        double *x, double *y, double *z,
+                                        int *panSuccess )
+
+{
     double x2[3], y2[3], z2[3], dfDeltaX, dfDeltaY, dfError, dfDist, dfDeltaZ;
     int nMiddle, anSuccess2[3], i, bSuccess;
 
@@ -2747,16 +3303,16 @@ int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints,
 #endif
 
         bSuccess = 
-            GDALApproxTransform( psATInfo, bDstToSrc, nMiddle, 
-                                 x, y, z, panSuccess );
+            GDALApproxTransformInternal( psATInfo, bDstToSrc, nMiddle, 
+                                         x, y, z, panSuccess );
             
         if( !bSuccess )
             return FALSE;
 
         bSuccess = 
-            GDALApproxTransform( psATInfo, bDstToSrc, nPoints - nMiddle,
-                                 x+nMiddle, y+nMiddle, z+nMiddle,
-                                 panSuccess+nMiddle );
+            GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints - nMiddle,
+                                         x+nMiddle, y+nMiddle, z+nMiddle,
+                                         panSuccess+nMiddle );
 
         if( !bSuccess )
             return FALSE;
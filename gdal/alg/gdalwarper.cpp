@@ -873,6 +873,13 @@ GDALWarpDstAlphaMasker( void *pMaskFuncArg, int nBandCount,
  * set the number of threads to use to parallelize the computation part of the
  * warping. If not set, computation will be done in a single thread.
  *
+ * - CHUNK_THREADS: Can be set to a numeric value or ALL_CPUS to set the number
+ * of chunks that GDALWarpOperation::ChunkAndWarpMulti() processes concurrently.
+ * The reading and writing of chunks remains serialized, but overlaps with the
+ * masking and warping of the other chunks. dfWarpMemoryLimit then applies to
+ * all chunks in flight together. If not set, one chunk is read or written
+ * while another one is warped.
+ *
  * - STREAMABLE_OUTPUT: (GDAL >= 2.0) This defaults to FALSE, but may be set to TRUE when
  * outputing typically to a streamed file. The gdalwarp utility automatically
  * sets this option when outputing to /vsistdout/ or a named pipe (on Unix).
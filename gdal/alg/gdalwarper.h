@@ -344,6 +344,7 @@ public:
 /************************************************************************/
 
 typedef struct _GDALWarpChunk GDALWarpChunk;
+typedef struct _GDALWarpChunkJob GDALWarpChunkJob;
 
 class CPL_DLL GDALWarpOperation {
 private:
@@ -376,7 +377,28 @@ private:
     CPLErr          CollectChunkList( int nDstXOff, int nDstYOff, 
                                       int nDstXSize, int nDstYSize );
     void            ReportTiming( const char * );
-    
+
+    CPLErr          ChunkAndWarpConcurrent( int nThreads,
+                                            int nDstXOff, int nDstYOff,
+                                            int nDstXSize, int nDstYSize );
+    static void     ChunkJobThreadMain( void *pData );
+    CPLErr          WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                        int nDstXSize, int nDstYSize,
+                                        int nSrcXOff, int nSrcYOff,
+                                        int nSrcXSize, int nSrcYSize,
+                                        int nSrcXExtraSize, int nSrcYExtraSize,
+                                        double dfProgressBase, double dfProgressScale,
+                                        GDALWarpChunkJob *psJob );
+    CPLErr          WarpRegionToBufferInternal( int nDstXOff, int nDstYOff,
+                                        int nDstXSize, int nDstYSize,
+                                        void *pDataBuf,
+                                        GDALDataType eBufDataType,
+                                        int nSrcXOff, int nSrcYOff,
+                                        int nSrcXSize, int nSrcYSize,
+                                        int nSrcXExtraSize, int nSrcYExtraSize,
+                                        double dfProgressBase, double dfProgressScale,
+                                        GDALWarpChunkJob *psJob );
+
 public:
                     GDALWarpOperation();
     virtual        ~GDALWarpOperation();
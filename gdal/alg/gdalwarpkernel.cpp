@@ -39,6 +39,7 @@
 #include "cpl_string.h"
 #include "gdalwarpkernel_opencl.h"
 #include "cpl_atomic_ops.h"
+#include "cpl_worker_thread_pool.h"
 #include "cpl_multiproc.h"
 #include <limits>
 
@@ -149,6 +150,7 @@ static CPLErr GWKAverageOrMode( GDALWarpKernel * );
 static CPLErr GWKCubicNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
 static CPLErr GWKCubicSplineNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
 static CPLErr GWKBilinearNoMasksOrDstDensityOnlyUShort( GDALWarpKernel * );
+static CPLErr GWKRealCase( GDALWarpKernel * );
 
 /************************************************************************/
 /*                           GWKJobStruct                               */
@@ -158,16 +160,19 @@ typedef struct _GWKJobStruct GWKJobStruct;
 
 struct _GWKJobStruct
 {
-    CPLJoinableThread *hThread;
     GDALWarpKernel *poWK;
     int             iYMin;
     int             iYMax;
     volatile int   *pnCounter;
     volatile int   *pbStop;
-    CPLCond        *hCond;
-    CPLMutex       *hCondMutex;
     int           (*pfnProgress)(GWKJobStruct* psJob);
     void           *pTransformerArg;
+
+    /* Multi-threaded case: the destination rows are processed by chunks */
+    /* of nChunkRows, that each thread claims in turn through pnNextRow. */
+    void          (*pfnFunc)(void *pUserData);
+    volatile int   *pnNextRow;
+    int             nChunkRows;
 } ;
 
 /************************************************************************/
@@ -177,13 +182,34 @@ struct _GWKJobStruct
 /* Return TRUE if the computation must be interrupted */
 static int GWKProgressThread(GWKJobStruct* psJob)
 {
-    CPLAcquireMutex(psJob->hCondMutex, 1.0);
-    (*(psJob->pnCounter)) ++;
-    CPLCondSignal(psJob->hCond);
-    int bStop = *(psJob->pbStop);
-    CPLReleaseMutex(psJob->hCondMutex);
+    CPLAtomicInc(psJob->pnCounter);
+    return *(psJob->pbStop);
+}
+
+/************************************************************************/
+/*                      GWKProgressCallerThread()                       */
+/*                                                                      */
+/*      Progress function of the rows processed by the thread that     */
+/*      called GWKRun(), which is the one reporting the progress of     */
+/*      all threads.                                                    */
+/************************************************************************/
 
-    return bStop;
+/* Return TRUE if the computation must be interrupted */
+static int GWKProgressCallerThread(GWKJobStruct* psJob)
+{
+    GDALWarpKernel *poWK = psJob->poWK;
+    int nCounter = CPLAtomicInc(psJob->pnCounter);
+    if( *(psJob->pbStop) )
+        return TRUE;
+    if( !poWK->pfnProgress( poWK->dfProgressBase + poWK->dfProgressScale *
+                            (nCounter / (double) poWK->nDstYSize),
+                            "", poWK->pProgress ) )
+    {
+        CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        *(psJob->pbStop) = TRUE;
+        return TRUE;
+    }
+    return FALSE;
 }
 
 /************************************************************************/
@@ -222,17 +248,45 @@ static CPLErr GWKGenericMonoThread( GDALWarpKernel *poWK,
     sThreadJob.iYMin = 0;
     sThreadJob.iYMax = poWK->nDstYSize;
     sThreadJob.pbStop = &bStop;
-    sThreadJob.hCond = NULL;
-    sThreadJob.hCondMutex = NULL;
-    sThreadJob.hThread = NULL;
     sThreadJob.pfnProgress = GWKProgressMonoThread;
     sThreadJob.pTransformerArg = poWK->pTransformerArg;
+    sThreadJob.pfnFunc = pfnFunc;
+    sThreadJob.pnNextRow = NULL;
+    sThreadJob.nChunkRows = 0;
 
     pfnFunc(&sThreadJob);
 
     return !bStop ? CE_None : CE_Failure;
 }
 
+/************************************************************************/
+/*                       GWKWorkStealingThread()                        */
+/*                                                                      */
+/*      Claim chunks of destination rows and process them, until       */
+/*      there are no more left.  Threads that get cheap rows (for       */
+/*      instance fully masked ones) thus take a larger share of the     */
+/*      work, instead of idling while the others complete a fixed       */
+/*      band of rows.                                                   */
+/************************************************************************/
+
+static void GWKWorkStealingThread( void* pData )
+{
+    GWKJobStruct* psJob = (GWKJobStruct*) pData;
+    int nDstYSize = psJob->poWK->nDstYSize;
+
+    while( !*(psJob->pbStop) )
+    {
+        int iYMax = CPLAtomicAdd( psJob->pnNextRow, psJob->nChunkRows );
+        int iYMin = iYMax - psJob->nChunkRows;
+        if( iYMin >= nDstYSize )
+            break;
+
+        psJob->iYMin = iYMin;
+        psJob->iYMax = MIN(iYMax, nDstYSize);
+        psJob->pfnFunc( psJob );
+    }
+}
+
 /************************************************************************/
 /*                                GWKRun()                              */
 /************************************************************************/
@@ -275,117 +329,123 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
     {
         return GWKGenericMonoThread(poWK, pfnFunc);
     }
-    else
+
+/* -------------------------------------------------------------------- */
+/*      The calling thread takes part in the computation, so we need    */
+/*      nThreads - 1 threads of the shared pool.                        */
+/* -------------------------------------------------------------------- */
+    CPLWorkerThreadPool* poPool = CPLGetGlobalWorkerThreadPool(nThreads - 1);
+    if (poPool == NULL)
     {
-        GWKJobStruct* pasThreadJob =
-            (GWKJobStruct*)CPLCalloc(sizeof(GWKJobStruct), nThreads);
+        CPLDebug("WARP", "Multithreading disabled. "
+                 "Falling back to mono-thread computation");
+        return GWKGenericMonoThread(poWK, pfnFunc);
+    }
+
+    GWKJobStruct* pasThreadJob =
+        (GWKJobStruct*)CPLCalloc(sizeof(GWKJobStruct), nThreads);
 
 /* -------------------------------------------------------------------- */
-/*      Duplicate pTransformerArg per thread.                           */
+/*      Duplicate pTransformerArg for each pool thread.                 */
 /* -------------------------------------------------------------------- */
-        int i;
-        int bTransformerCloningSuccess = TRUE;
+    int i;
+    int bTransformerCloningSuccess = TRUE;
 
-        for(i=0;i<nThreads;i++)
+    pasThreadJob[0].pTransformerArg = poWK->pTransformerArg;
+    for(i=1;i<nThreads;i++)
+    {
+        pasThreadJob[i].pTransformerArg = GDALCloneTransformer(poWK->pTransformerArg);
+        if( pasThreadJob[i].pTransformerArg == NULL )
         {
-            pasThreadJob[i].pTransformerArg = GDALCloneTransformer(poWK->pTransformerArg);
-            if( pasThreadJob[i].pTransformerArg == NULL )
-            {
-                CPLDebug("WARP", "Cannot deserialize transformer");
-                bTransformerCloningSuccess = FALSE;
-                break;
-            }
+            CPLDebug("WARP", "Cannot deserialize transformer");
+            bTransformerCloningSuccess = FALSE;
+            break;
         }
+    }
 
-        if (!bTransformerCloningSuccess)
+    if (!bTransformerCloningSuccess)
+    {
+        for(i=1;i<nThreads;i++)
         {
-            for(i=0;i<nThreads;i++)
-            {
-                if( pasThreadJob[i].pTransformerArg )
-                    GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
-            }
-            CPLFree(pasThreadJob);
-
-            CPLDebug("WARP", "Cannot duplicate transformer function. "
-                     "Falling back to mono-thread computation");
-            return GWKGenericMonoThread(poWK, pfnFunc);
+            if( pasThreadJob[i].pTransformerArg )
+                GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
         }
+        CPLFree(pasThreadJob);
 
-        CPLCond* hCond = CPLCreateCond();
-        if (hCond == NULL)
-        {
-            for(i=0;i<nThreads;i++)
-            {
-                if( pasThreadJob[i].pTransformerArg )
-                    GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
-            }
-            CPLFree(pasThreadJob);
-
-            CPLDebug("WARP", "Multithreading disabled. "
-                     "Falling back to mono-thread computation");
-            return GWKGenericMonoThread(poWK, pfnFunc);
-        }
+        CPLDebug("WARP", "Cannot duplicate transformer function. "
+                 "Falling back to mono-thread computation");
+        return GWKGenericMonoThread(poWK, pfnFunc);
+    }
 
-        CPLDebug("WARP", "Using %d threads", nThreads);
+/* -------------------------------------------------------------------- */
+/*      Use chunks small enough for the threads to balance their       */
+/*      load, but not so small that the per-chunk setup of the          */
+/*      kernel functions becomes significant.                           */
+/* -------------------------------------------------------------------- */
+    int nChunkRows = MAX(1, nDstYSize / (nThreads * 8));
 
-        CPLMutex* hCondMutex = CPLCreateMutex(); /* and take implicitely the mutex */
+    CPLDebug("WARP", "Using %d threads, by chunks of %d rows",
+             nThreads, nChunkRows);
 
-        volatile int bStop = FALSE;
-        volatile int nCounter = 0;
+    volatile int bStop = FALSE;
+    volatile int nCounter = 0;
+    volatile int nNextRow = 0;
 
-/* -------------------------------------------------------------------- */
-/*      Lannch worker threads                                           */
-/* -------------------------------------------------------------------- */
-        for(i=0;i<nThreads;i++)
-        {
-            pasThreadJob[i].poWK = poWK;
-            pasThreadJob[i].pnCounter = &nCounter;
-            pasThreadJob[i].iYMin = (int)(((GIntBig)i) * nDstYSize / nThreads);
-            pasThreadJob[i].iYMax = (int)(((GIntBig)(i + 1)) * nDstYSize / nThreads);
-            pasThreadJob[i].pbStop = &bStop;
-            pasThreadJob[i].hCond = hCond;
-            pasThreadJob[i].hCondMutex = hCondMutex;
-            pasThreadJob[i].pfnProgress = GWKProgressThread;
-            pasThreadJob[i].hThread = CPLCreateJoinableThread( pfnFunc,
-                                                  (void*) &pasThreadJob[i] );
-        }
+    for(i=0;i<nThreads;i++)
+    {
+        pasThreadJob[i].poWK = poWK;
+        pasThreadJob[i].pnCounter = &nCounter;
+        pasThreadJob[i].pbStop = &bStop;
+        pasThreadJob[i].pfnProgress = (i == 0) ? GWKProgressCallerThread
+                                               : GWKProgressThread;
+        pasThreadJob[i].pfnFunc = pfnFunc;
+        pasThreadJob[i].pnNextRow = &nNextRow;
+        pasThreadJob[i].nChunkRows = nChunkRows;
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Report progress.                                                */
+/*      Submit the jobs of the pool threads, and run our own.  Jobs     */
+/*      that the pool could not start by the time we are done are       */
+/*      run (and immediately return) in WaitGroupCompletion().          */
 /* -------------------------------------------------------------------- */
-        while(nCounter < nDstYSize)
-        {
-            CPLCondWait(hCond, hCondMutex);
+    int nPendingJobs = 0;
 
-            if( !poWK->pfnProgress( poWK->dfProgressBase + poWK->dfProgressScale *
-                                    (nCounter / (double) nDstYSize),
-                                    "", poWK->pProgress ) )
-            {
-                CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-                bStop = TRUE;
-                break;
-            }
-        }
+    for(i=1;i<nThreads;i++)
+        poPool->SubmitJob( GWKWorkStealingThread, &pasThreadJob[i],
+                           &nPendingJobs );
 
-        /* Release mutex before joining threads, otherwise they will dead-lock */
-        /* forever in GWKProgressThread() */
-        CPLReleaseMutex(hCondMutex);
+    GWKWorkStealingThread( &pasThreadJob[0] );
 
 /* -------------------------------------------------------------------- */
-/*      Wait for all threads to complete and finish.                    */
+/*      Keep on reporting the rows completed by the pool threads        */
+/*      while they process their last chunks.                           */
 /* -------------------------------------------------------------------- */
-        for(i=0;i<nThreads;i++)
+    while( !poPool->WaitGroupCompletion( &nPendingJobs, 0.1 ) )
+    {
+        if( !bStop && !poWK->pfnProgress( poWK->dfProgressBase +
+                                          poWK->dfProgressScale *
+                                          (nCounter / (double) nDstYSize),
+                                          "", poWK->pProgress ) )
         {
-            CPLJoinThread(pasThreadJob[i].hThread);
-            GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            bStop = TRUE;
         }
+    }
 
-        CPLFree(pasThreadJob);
-        CPLDestroyCond(hCond);
-        CPLDestroyMutex(hCondMutex);
-
-        return !bStop ? CE_None : CE_Failure;
+    if( !bStop && !poWK->pfnProgress( poWK->dfProgressBase +
+                                      poWK->dfProgressScale,
+                                      "", poWK->pProgress ) )
+    {
+        CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        bStop = TRUE;
     }
+
+    for(i=1;i<nThreads;i++)
+        GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
+
+    CPLFree(pasThreadJob);
+
+    return !bStop ? CE_None : CE_Failure;
 }
 
 /************************************************************************/
@@ -1082,6 +1142,13 @@ CPLErr GDALWarpKernel::PerformWarp()
     if( eResample == GRA_Q3 )
         return GWKAverageOrMode( this );
 
+    if( (eWorkingDataType == GDT_Byte || eWorkingDataType == GDT_Int16 ||
+         eWorkingDataType == GDT_UInt16 || eWorkingDataType == GDT_Float32)
+        && (eResample == GRA_Bilinear || eResample == GRA_Cubic)
+        && dfXScale >= 0.95 && dfYScale >= 0.95
+        && pafUnifiedSrcDensity == NULL )
+        return GWKRealCase( this );
+
     return GWKGeneralCase( this );
 }
                                   
@@ -3954,6 +4021,475 @@ static void GWKGeneralCaseThread( void* pData)
         GWKResampleDeleteWrkStruct(psWrkStruct);
 }
 
+/************************************************************************/
+/*                         GWKIsPixelValid()                            */
+/************************************************************************/
+
+static CPL_INLINE int GWKIsPixelValid( const GUInt32* panValid, int iOffset )
+{
+    return panValid == NULL ||
+           (panValid[iOffset>>5] & (0x01 << (iOffset & 0x1f))) != 0;
+}
+
+/************************************************************************/
+/*                  GWKBilinearResampleValid4SampleT()                  */
+/*                                                                      */
+/*      Bilinear interpolation of 4 valid source pixels of a real       */
+/*      data type.  Gives the same result as                            */
+/*      GWKBilinearResample4Sample(), to which the caller must fall     */
+/*      back when FALSE is returned, that is at the borders of the      */
+/*      source window or if one of the pixels is invalid.               */
+/************************************************************************/
+
+template<class T>
+static CPL_INLINE int GWKBilinearResampleValid4SampleT( GDALWarpKernel *poWK,
+                                                        const T* pSrc,
+                                                        const GUInt32* panBandSrcValid,
+                                                        double dfSrcX, double dfSrcY,
+                                                        double *pdfValue )
+{
+    int     nSrcXSize = poWK->nSrcXSize;
+    int     iSrcX = (int) floor(dfSrcX - 0.5);
+    int     iSrcY = (int) floor(dfSrcY - 0.5);
+
+    if( iSrcX < 0 || iSrcX + 1 >= nSrcXSize ||
+        iSrcY < 0 || iSrcY + 1 >= poWK->nSrcYSize )
+        return FALSE;
+
+    int     iSrcOffset = iSrcX + iSrcY * nSrcXSize;
+    const GUInt32* panUnifiedSrcValid = poWK->panUnifiedSrcValid;
+    if( !GWKIsPixelValid(panUnifiedSrcValid, iSrcOffset) ||
+        !GWKIsPixelValid(panUnifiedSrcValid, iSrcOffset + 1) ||
+        !GWKIsPixelValid(panUnifiedSrcValid, iSrcOffset + nSrcXSize) ||
+        !GWKIsPixelValid(panUnifiedSrcValid, iSrcOffset + nSrcXSize + 1) ||
+        !GWKIsPixelValid(panBandSrcValid, iSrcOffset) ||
+        !GWKIsPixelValid(panBandSrcValid, iSrcOffset + 1) ||
+        !GWKIsPixelValid(panBandSrcValid, iSrcOffset + nSrcXSize) ||
+        !GWKIsPixelValid(panBandSrcValid, iSrcOffset + nSrcXSize + 1) )
+        return FALSE;
+
+    double  dfRatioX = 1.5 - (dfSrcX - iSrcX);
+    double  dfRatioY = 1.5 - (dfSrcY - iSrcY);
+    double  dfMult1 = dfRatioX * dfRatioY;
+    double  dfMult2 = (1.0-dfRatioX) * dfRatioY;
+    double  dfMult3 = dfRatioX * (1.0-dfRatioY);
+    double  dfMult4 = (1.0-dfRatioX) * (1.0-dfRatioY);
+
+    /* Same order of operations as in GWKBilinearResample4Sample() */
+    double  dfAccumulator = 0.0;
+    dfAccumulator += (double)pSrc[iSrcOffset] * dfMult1;
+    dfAccumulator += (double)pSrc[iSrcOffset+1] * dfMult2;
+    dfAccumulator += (double)pSrc[iSrcOffset+nSrcXSize] * dfMult3;
+    dfAccumulator += (double)pSrc[iSrcOffset+nSrcXSize+1] * dfMult4;
+
+    double  dfAccumulatorDivisor = 0.0;
+    dfAccumulatorDivisor += dfMult1;
+    dfAccumulatorDivisor += dfMult2;
+    dfAccumulatorDivisor += dfMult3;
+    dfAccumulatorDivisor += dfMult4;
+
+    if( dfAccumulatorDivisor == 1.0 )
+        *pdfValue = dfAccumulator;
+    else
+        *pdfValue = dfAccumulator / dfAccumulatorDivisor;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                     GWKCubicConvolution4Rows()                       */
+/*                                                                      */
+/*      Apply CubicConvolution() to 4 rows of 4 values, given by        */
+/*      column (padfCol[i*4+j] is the i-th value of row j).             */
+/************************************************************************/
+
+#if defined(__x86_64) || defined(_M_X64)
+
+static CPL_INLINE void GWKCubicConvolution4Rows( double dfDelta,
+                                                 double dfDelta2,
+                                                 double dfDelta3,
+                                                 const double* padfCol,
+                                                 double* padfRow )
+{
+    /* Each lane does the same operations as CubicConvolution() */
+    const double adfDelta[2] = { dfDelta, dfDelta };
+    const double adfDelta2[2] = { dfDelta2, dfDelta2 };
+    const double adfDelta3[2] = { dfDelta3, dfDelta3 };
+    static const double adfHalf[2] = { 0.5, 0.5 };
+    static const double adfTwo[2] = { 2.0, 2.0 };
+    static const double adfThree[2] = { 3.0, 3.0 };
+    static const double adfFour[2] = { 4.0, 4.0 };
+    static const double adfFive[2] = { 5.0, 5.0 };
+
+    XMMReg2Double v_d1 = XMMReg2Double::Load2Val(adfDelta);
+    XMMReg2Double v_d2 = XMMReg2Double::Load2Val(adfDelta2);
+    XMMReg2Double v_d3 = XMMReg2Double::Load2Val(adfDelta3);
+    XMMReg2Double v_half = XMMReg2Double::Load2Val(adfHalf);
+    XMMReg2Double v_two = XMMReg2Double::Load2Val(adfTwo);
+    XMMReg2Double v_three = XMMReg2Double::Load2Val(adfThree);
+    XMMReg2Double v_four = XMMReg2Double::Load2Val(adfFour);
+    XMMReg2Double v_five = XMMReg2Double::Load2Val(adfFive);
+
+    for( int j = 0; j < 4; j += 2 )
+    {
+        XMMReg2Double f0 = XMMReg2Double::Load2Val(padfCol + j);
+        XMMReg2Double f1 = XMMReg2Double::Load2Val(padfCol + 4 + j);
+        XMMReg2Double f2 = XMMReg2Double::Load2Val(padfCol + 8 + j);
+        XMMReg2Double f3 = XMMReg2Double::Load2Val(padfCol + 12 + j);
+
+        XMMReg2Double v_term1 = v_d1 * (f2 - f0);
+        XMMReg2Double v_term2 = v_d2 * (v_two * f0 - v_five * f1 + v_four * f2 - f3);
+        XMMReg2Double v_term3 = v_d3 * (v_three * (f1 - f2) + f3 - f0);
+        XMMReg2Double v_res = f1 + v_half * (v_term1 + v_term2 + v_term3);
+        v_res.Store2Double(padfRow + j);
+    }
+}
+
+#else
+
+static CPL_INLINE void GWKCubicConvolution4Rows( double dfDelta,
+                                                 double dfDelta2,
+                                                 double dfDelta3,
+                                                 const double* padfCol,
+                                                 double* padfRow )
+{
+    for( int j = 0; j < 4; j++ )
+        padfRow[j] = CubicConvolution(dfDelta, dfDelta2, dfDelta3,
+                                      padfCol[j], padfCol[4+j],
+                                      padfCol[8+j], padfCol[12+j]);
+}
+
+#endif /* defined(__x86_64) || defined(_M_X64) */
+
+/************************************************************************/
+/*                   GWKCubicResampleValid4SampleT()                    */
+/*                                                                      */
+/*      Cubic convolution of 16 valid source pixels of a real data      */
+/*      type.  Gives the same result as GWKCubicResample4Sample(), to   */
+/*      which the caller must fall back when FALSE is returned.         */
+/************************************************************************/
+
+template<class T>
+static CPL_INLINE int GWKCubicResampleValid4SampleT( GDALWarpKernel *poWK,
+                                                     const T* pSrc,
+                                                     const GUInt32* panBandSrcValid,
+                                                     double dfSrcX, double dfSrcY,
+                                                     double *pdfValue )
+{
+    int     nSrcXSize = poWK->nSrcXSize;
+    int     iSrcX = (int) (dfSrcX - 0.5);
+    int     iSrcY = (int) (dfSrcY - 0.5);
+
+    if ( iSrcX - 1 < 0 || iSrcX + 2 >= nSrcXSize
+         || iSrcY - 1 < 0 || iSrcY + 2 >= poWK->nSrcYSize )
+        return FALSE;
+
+    int     iSrcOffset = iSrcX + iSrcY * nSrcXSize;
+    const GUInt32* panUnifiedSrcValid = poWK->panUnifiedSrcValid;
+    double  adfCol[16];
+    int     i, j;
+
+    for ( j = 0; j < 4; j++ )
+    {
+        int iOffset = iSrcOffset + (j - 1) * nSrcXSize - 1;
+        for ( i = 0; i < 4; i++ )
+        {
+            if( !GWKIsPixelValid(panUnifiedSrcValid, iOffset + i) ||
+                !GWKIsPixelValid(panBandSrcValid, iOffset + i) )
+                return FALSE;
+            adfCol[i * 4 + j] = (double)pSrc[iOffset + i];
+        }
+    }
+
+    double  dfDeltaX = dfSrcX - 0.5 - iSrcX;
+    double  dfDeltaY = dfSrcY - 0.5 - iSrcY;
+    double  dfDeltaX2 = dfDeltaX * dfDeltaX;
+    double  dfDeltaY2 = dfDeltaY * dfDeltaY;
+    double  dfDeltaX3 = dfDeltaX2 * dfDeltaX;
+    double  dfDeltaY3 = dfDeltaY2 * dfDeltaY;
+    double  adfValue[4];
+
+    GWKCubicConvolution4Rows(dfDeltaX, dfDeltaX2, dfDeltaX3, adfCol, adfValue);
+
+    *pdfValue = CubicConvolution(dfDeltaY, dfDeltaY2, dfDeltaY3,
+                                 adfValue[0], adfValue[1],
+                                 adfValue[2], adfValue[3]);
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        GWKMixWithDstValueT()                         */
+/************************************************************************/
+
+template<class T>
+static CPL_INLINE double GWKMixWithDstValueT( GDALWarpKernel *poWK,
+                                              const T* pDst, int iDstOffset,
+                                              double dfDensity, double dfReal )
+{
+    double dfDstDensity = 1.0;
+
+    if( poWK->pafDstDensity != NULL )
+        dfDstDensity = poWK->pafDstDensity[iDstOffset];
+    else if( poWK->panDstValid != NULL
+             && !((poWK->panDstValid[iDstOffset>>5]
+                   & (0x01 << (iDstOffset & 0x1f))) ) )
+        dfDstDensity = 0.0;
+
+    double dfDstReal = pDst[iDstOffset];
+    double dfDstInfluence = (1.0 - dfDensity) * dfDstDensity;
+
+    return (dfReal * dfDensity + dfDstReal * dfDstInfluence)
+                / (dfDensity + dfDstInfluence);
+}
+
+/************************************************************************/
+/*                      GWKSetPixelValueFromDoubleT()                   */
+/*                                                                      */
+/*      Same as GWKSetPixelValue() for a real data type.                */
+/************************************************************************/
+
+template<class T>
+static CPL_INLINE void GWKSetPixelValueFromDoubleT( GDALWarpKernel *poWK, int iBand,
+                                                    int iDstOffset, double dfDensity,
+                                                    double dfReal )
+{
+    T *pDst = (T*)(poWK->papabyDstImage[iBand]);
+
+    if( dfDensity < 0.9999 )
+    {
+        if( dfDensity < 0.0001 )
+            return;
+        dfReal = GWKMixWithDstValueT(poWK, pDst, iDstOffset, dfDensity, dfReal);
+    }
+
+    pDst[iDstOffset] = GWKClampValueT<T>(dfReal);
+
+    /* Avoid using the destination nodata value if by chance it is equal */
+    /* to the computed pixel value */
+    if (poWK->padfDstNoDataReal != NULL &&
+        poWK->padfDstNoDataReal[iBand] == (double)pDst[iDstOffset])
+    {
+        if (pDst[iDstOffset] == std::numeric_limits<T>::min())
+            pDst[iDstOffset] = std::numeric_limits<T>::min() + 1;
+        else
+            pDst[iDstOffset] --;
+    }
+}
+
+template<>
+void GWKSetPixelValueFromDoubleT<float>( GDALWarpKernel *poWK, int iBand,
+                                         int iDstOffset, double dfDensity,
+                                         double dfReal )
+{
+    float *pDst = (float*)(poWK->papabyDstImage[iBand]);
+
+    if( dfDensity < 0.9999 )
+    {
+        if( dfDensity < 0.0001 )
+            return;
+        dfReal = GWKMixWithDstValueT(poWK, pDst, iDstOffset, dfDensity, dfReal);
+    }
+
+    pDst[iDstOffset] = (float) dfReal;
+}
+
+/************************************************************************/
+/*                            GWKRealCase()                             */
+/*                                                                      */
+/*      Bilinear and cubic resampling of real data types, with source   */
+/*      and destination validity masks.  Pixels whose whole kernel is   */
+/*      valid and inside the source window are directly interpolated    */
+/*      from the typed source buffer, the others go through the same    */
+/*      functions as GWKGeneralCase(), so the result is identical.      */
+/************************************************************************/
+
+template<class T, GDALResampleAlg eResample>
+static void GWKRealCaseThread( void* pData )
+
+{
+    GWKJobStruct* psJob = (GWKJobStruct*) pData;
+    GDALWarpKernel *poWK = psJob->poWK;
+    int iYMin = psJob->iYMin;
+    int iYMax = psJob->iYMax;
+
+    int iDstY;
+    int nDstXSize = poWK->nDstXSize;
+    int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
+
+    CPLAssert( poWK->pafUnifiedSrcDensity == NULL );
+
+/* -------------------------------------------------------------------- */
+/*      Allocate x,y,z coordinate arrays for transformation ... one     */
+/*      scanlines worth of positions.                                   */
+/* -------------------------------------------------------------------- */
+    double *padfX, *padfY, *padfZ;
+    int    *pabSuccess;
+
+    padfX = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    padfY = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
+    pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
+
+/* ==================================================================== */
+/*      Loop over output lines.                                         */
+/* ==================================================================== */
+    for( iDstY = iYMin; iDstY < iYMax; iDstY++ )
+    {
+        int iDstX;
+
+/* -------------------------------------------------------------------- */
+/*      Setup points to transform to source image space.                */
+/* -------------------------------------------------------------------- */
+        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
+        {
+            padfX[iDstX] = iDstX + 0.5 + poWK->nDstXOff;
+            padfY[iDstX] = iDstY + 0.5 + poWK->nDstYOff;
+            padfZ[iDstX] = 0.0;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Transform the points from destination pixel/line coordinates    */
+/*      to source pixel/line coordinates.                               */
+/* -------------------------------------------------------------------- */
+        poWK->pfnTransformer( psJob->pTransformerArg, TRUE, nDstXSize,
+                              padfX, padfY, padfZ, pabSuccess );
+
+/* ==================================================================== */
+/*      Loop over pixels in output scanline.                            */
+/* ==================================================================== */
+        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
+        {
+            int iSrcOffset;
+            if( !GWKCheckAndComputeSrcOffsets(pabSuccess, iDstX, padfX, padfY,
+                                    poWK, nSrcXSize, nSrcYSize, iSrcOffset) )
+                continue;
+
+            if( poWK->panUnifiedSrcValid != NULL
+                && !(poWK->panUnifiedSrcValid[iSrcOffset>>5]
+                     & (0x01 << (iSrcOffset & 0x1f))) )
+                continue;
+
+            double dfSrcX = padfX[iDstX] - poWK->nSrcXOff;
+            double dfSrcY = padfY[iDstX] - poWK->nSrcYOff;
+            int iDstOffset = iDstX + iDstY * nDstXSize;
+            int iBand;
+            int bHasFoundDensity = FALSE;
+
+            for( iBand = 0; iBand < poWK->nBands; iBand++ )
+            {
+                const T* pSrc = (const T*) poWK->papabySrcImage[iBand];
+                const GUInt32* panBandSrcValid =
+                    (poWK->papanBandSrcValid != NULL) ?
+                        poWK->papanBandSrcValid[iBand] : NULL;
+                double dfBandDensity = 1.0;
+                double dfValueReal = 0.0;
+                double dfValueImag = 0.0;
+
+/* -------------------------------------------------------------------- */
+/*      Collect the source value.                                       */
+/* -------------------------------------------------------------------- */
+                if ( nSrcXSize == 1 || nSrcYSize == 1 )
+                {
+                    GWKGetPixelValue( poWK, iBand, iSrcOffset,
+                                      &dfBandDensity, &dfValueReal, &dfValueImag );
+                }
+                else if ( eResample == GRA_Bilinear )
+                {
+                    if( !GWKBilinearResampleValid4SampleT( poWK, pSrc,
+                                                           panBandSrcValid,
+                                                           dfSrcX, dfSrcY,
+                                                           &dfValueReal ) )
+                        GWKBilinearResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                                    &dfBandDensity,
+                                                    &dfValueReal, &dfValueImag );
+                }
+                else
+                {
+                    if( !GWKCubicResampleValid4SampleT( poWK, pSrc,
+                                                        panBandSrcValid,
+                                                        dfSrcX, dfSrcY,
+                                                        &dfValueReal ) )
+                        GWKCubicResample4Sample( poWK, iBand, dfSrcX, dfSrcY,
+                                                 &dfBandDensity,
+                                                 &dfValueReal, &dfValueImag );
+                }
+
+                // If we didn't find any valid inputs skip to next band.
+                if ( dfBandDensity < 0.0000000001 )
+                    continue;
+
+                bHasFoundDensity = TRUE;
+
+                GWKSetPixelValueFromDoubleT<T>( poWK, iBand, iDstOffset,
+                                                dfBandDensity, dfValueReal );
+            }
+
+            if (!bHasFoundDensity)
+              continue;
+
+/* -------------------------------------------------------------------- */
+/*      Update destination density/validity masks.                      */
+/* -------------------------------------------------------------------- */
+            GWKOverlayDensity( poWK, iDstOffset, 1.0 );
+
+            if( poWK->panDstValid != NULL )
+            {
+                poWK->panDstValid[iDstOffset>>5] |=
+                    0x01 << (iDstOffset & 0x1f);
+            }
+
+        } /* Next iDstX */
+
+/* -------------------------------------------------------------------- */
+/*      Report progress to the user, and optionally cancel out.         */
+/* -------------------------------------------------------------------- */
+        if (psJob->pfnProgress(psJob))
+            break;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Cleanup and return.                                             */
+/* -------------------------------------------------------------------- */
+    CPLFree( padfX );
+    CPLFree( padfY );
+    CPLFree( padfZ );
+    CPLFree( pabSuccess );
+}
+
+static CPLErr GWKRealCase( GDALWarpKernel *poWK )
+{
+    void (*pfnFunc)(void*) = NULL;
+
+    switch( poWK->eWorkingDataType )
+    {
+        case GDT_Byte:
+            pfnFunc = (poWK->eResample == GRA_Bilinear) ?
+                GWKRealCaseThread<GByte, GRA_Bilinear> :
+                GWKRealCaseThread<GByte, GRA_Cubic>;
+            break;
+        case GDT_Int16:
+            pfnFunc = (poWK->eResample == GRA_Bilinear) ?
+                GWKRealCaseThread<GInt16, GRA_Bilinear> :
+                GWKRealCaseThread<GInt16, GRA_Cubic>;
+            break;
+        case GDT_UInt16:
+            pfnFunc = (poWK->eResample == GRA_Bilinear) ?
+                GWKRealCaseThread<GUInt16, GRA_Bilinear> :
+                GWKRealCaseThread<GUInt16, GRA_Cubic>;
+            break;
+        case GDT_Float32:
+            pfnFunc = (poWK->eResample == GRA_Bilinear) ?
+                GWKRealCaseThread<float, GRA_Bilinear> :
+                GWKRealCaseThread<float, GRA_Cubic>;
+            break;
+        default:
+            return GWKGeneralCase( poWK );
+    }
+
+    return GWKRun( poWK, "GWKRealCase", pfnFunc );
+}
+
 /************************************************************************/
 /*                GWKResampleNoMasksOrDstDensityOnlyThreadInternal()           */
 /************************************************************************/
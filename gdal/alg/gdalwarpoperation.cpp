@@ -29,8 +29,11 @@
  ****************************************************************************/
 
 #include "gdalwarper.h"
+#include "gdal_alg_priv.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
+#include "cpl_worker_thread_pool.h"
 #include "ogr_api.h"
 
 CPL_CVSID("$Id$");
@@ -145,10 +148,9 @@ GDALWarpOperation::~GDALWarpOperation()
     WipeOptions();
 
     if( hIOMutex != NULL )
-    {
         CPLDestroyMutex( hIOMutex );
+    if( hWarpMutex != NULL )
         CPLDestroyMutex( hWarpMutex );
-    }
 
     WipeChunkList();
 }
@@ -816,6 +818,13 @@ static void ChunkThreadMain( void *pThreadData )
  * internally this method uses multiple threads to interleave input/output
  * for one region while the processing is being done for another.
  *
+ * If the CHUNK_THREADS warp option is set to a value greater than 1, or to
+ * ALL_CPUS, that number of chunks is processed concurrently instead : the
+ * reading and writing of the chunks is still serialized, but the masking
+ * and warping of each chunk proceeds in parallel with the input/output
+ * and the warping of the others.  The memory limit then applies to all the
+ * chunks in flight together.
+ *
  * @param nDstXOff X offset to window of destination data to be produced.
  * @param nDstYOff Y offset to window of destination data to be produced.
  * @param nDstXSize Width of output window on destination file to be produced.
@@ -828,11 +837,38 @@ CPLErr GDALWarpOperation::ChunkAndWarpMulti(
     int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize )
 
 {
-    hIOMutex = CPLCreateMutex();
-    hWarpMutex = CPLCreateMutex();
+    const char* pszChunkThreads =
+        CSLFetchNameValue( psOptions->papszWarpOptions, "CHUNK_THREADS" );
+    if( pszChunkThreads != NULL )
+    {
+        int nThreads;
+        if( EQUAL(pszChunkThreads, "ALL_CPUS") )
+            nThreads = CPLGetNumCPUs();
+        else
+            nThreads = atoi(pszChunkThreads);
+        if( nThreads > 128 )
+            nThreads = 128;
+        if( nThreads > 1 )
+        {
+            CPLErr eErr = ChunkAndWarpConcurrent( nThreads,
+                                                  nDstXOff, nDstYOff,
+                                                  nDstXSize, nDstYSize );
+            /* CE_Warning means that the concurrent mode is not available */
+            if( eErr != CE_Warning )
+                return eErr;
+        }
+    }
 
-    CPLReleaseMutex( hIOMutex );
-    CPLReleaseMutex( hWarpMutex );
+    if( hIOMutex == NULL )
+    {
+        hIOMutex = CPLCreateMutex();
+        CPLReleaseMutex( hIOMutex );
+    }
+    if( hWarpMutex == NULL )
+    {
+        hWarpMutex = CPLCreateMutex();
+        CPLReleaseMutex( hWarpMutex );
+    }
 
     CPLCond* hCond = CPLCreateCond();
     CPLMutex* hCondMutex = CPLCreateMutex();
@@ -954,6 +990,313 @@ CPLErr GDALWarpOperation::ChunkAndWarpMulti(
     return eErr;
 }
 
+/************************************************************************/
+/*                          GDALWarpChunkJob                            */
+/*                                                                      */
+/*      State of one of the threads of ChunkAndWarpConcurrent(), and   */
+/*      state shared by all of them.                                    */
+/************************************************************************/
+
+typedef struct
+{
+    CPLMutex          *hMutex;
+    CPLCond           *hCond;
+
+    GDALWarpChunk     *pasChunkList;
+    int                nChunkListCount;
+    volatile int       nNextChunk;         /* next chunk to be claimed */
+    int                nNextChunkToWrite;  /* only used if bOrderedWrites */
+    int                bOrderedWrites;
+    volatile int       bStop;
+
+    double             dfTotalPixels;
+    double             dfPixelsProcessed;
+    GDALProgressFunc   pfnProgress;
+    void              *pProgressArg;
+} GDALWarpChunkShared;
+
+struct _GDALWarpChunkJob
+{
+    GDALWarpOperation   *poOperation;
+    GDALWarpChunkShared *psShared;
+    void                *pTransformerArg;
+    CPLErr               eErr;
+
+    int                  iChunk;
+    double               dfChunkPixels;
+    double               dfChunkComplete;
+};
+
+/************************************************************************/
+/*                       GDALWarpChunkProgress()                        */
+/*                                                                      */
+/*      Progress function installed in the kernel of each chunk.  It    */
+/*      accumulates the progress of all chunks in flight, and reports   */
+/*      it to the user progress function from one thread at a time.    */
+/************************************************************************/
+
+static int CPL_STDCALL GDALWarpChunkProgress( double dfComplete,
+                                              CPL_UNUSED const char *pszMessage,
+                                              void *pProgressArg )
+{
+    GDALWarpChunkJob *psJob = (GDALWarpChunkJob *) pProgressArg;
+    GDALWarpChunkShared *psShared = psJob->psShared;
+    CPLMutexHolderD( &(psShared->hMutex) );
+
+    if( dfComplete > psJob->dfChunkComplete )
+    {
+        psShared->dfPixelsProcessed +=
+            (dfComplete - psJob->dfChunkComplete) * psJob->dfChunkPixels;
+        psJob->dfChunkComplete = dfComplete;
+    }
+
+    if( psShared->bStop )
+        return FALSE;
+
+    double dfTotalComplete =
+        MIN(1.0, psShared->dfPixelsProcessed / psShared->dfTotalPixels);
+    if( !psShared->pfnProgress( dfTotalComplete, "", psShared->pProgressArg ) )
+    {
+        psShared->bStop = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       WaitChunkWriteTurn()                           */
+/************************************************************************/
+
+static void WaitChunkWriteTurn( GDALWarpChunkJob *psJob )
+{
+    GDALWarpChunkShared *psShared = psJob->psShared;
+
+    CPLAcquireMutex( psShared->hMutex, 1000.0 );
+    while( psShared->nNextChunkToWrite != psJob->iChunk && !psShared->bStop )
+        CPLCondWait( psShared->hCond, psShared->hMutex );
+    CPLReleaseMutex( psShared->hMutex );
+}
+
+/************************************************************************/
+/*                         ChunkJobThreadMain()                         */
+/************************************************************************/
+
+void GDALWarpOperation::ChunkJobThreadMain( void *pData )
+
+{
+    GDALWarpChunkJob *psJob = (GDALWarpChunkJob *) pData;
+    GDALWarpChunkShared *psShared = psJob->psShared;
+    GDALWarpOperation *poOperation = psJob->poOperation;
+
+    while( !psShared->bStop )
+    {
+        int iChunk = CPLAtomicInc( &(psShared->nNextChunk) ) - 1;
+        if( iChunk >= psShared->nChunkListCount )
+            break;
+
+        GDALWarpChunk *pasThisChunk = psShared->pasChunkList + iChunk;
+
+        psJob->iChunk = iChunk;
+        psJob->dfChunkPixels = pasThisChunk->dsx * (double) pasThisChunk->dsy;
+        psJob->dfChunkComplete = 0.0;
+
+/* -------------------------------------------------------------------- */
+/*      WarpRegionInternal() releases the IO mutex while the chunk is   */
+/*      being warped, and takes it back to write it.                    */
+/* -------------------------------------------------------------------- */
+        CPLErr eErr;
+        if( !CPLAcquireMutex( poOperation->hIOMutex, 600.0 ) )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Failed to acquire IOMutex in WarpRegion()." );
+            eErr = CE_Failure;
+        }
+        else
+        {
+            eErr = poOperation->WarpRegionInternal(
+                                    pasThisChunk->dx, pasThisChunk->dy,
+                                    pasThisChunk->dsx, pasThisChunk->dsy,
+                                    pasThisChunk->sx, pasThisChunk->sy,
+                                    pasThisChunk->ssx, pasThisChunk->ssy,
+                                    pasThisChunk->sExtraSx, pasThisChunk->sExtraSy,
+                                    0.0, 1.0, psJob );
+            CPLReleaseMutex( poOperation->hIOMutex );
+        }
+
+        CPLAcquireMutex( psShared->hMutex, 1000.0 );
+        if( eErr != CE_None )
+        {
+            psJob->eErr = eErr;
+            psShared->bStop = TRUE;
+        }
+        if( psShared->bOrderedWrites )
+        {
+            psShared->nNextChunkToWrite ++;
+            CPLCondBroadcast( psShared->hCond );
+        }
+        else if( psShared->bStop )
+        {
+            CPLCondBroadcast( psShared->hCond );
+        }
+        CPLReleaseMutex( psShared->hMutex );
+    }
+}
+
+/************************************************************************/
+/*                       ChunkAndWarpConcurrent()                       */
+/*                                                                      */
+/*      Implementation of ChunkAndWarpMulti() when CHUNK_THREADS is     */
+/*      set.  Each of the threads claims the next chunk to process,     */
+/*      reads it, warps it and writes it.  The reads and writes are     */
+/*      serialized by hIOMutex, as datasets are not thread-safe, and    */
+/*      are also done in the chunk order if STREAMABLE_OUTPUT is set.   */
+/*                                                                      */
+/*      Returns CE_Warning if the concurrent mode cannot be used.       */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::ChunkAndWarpConcurrent(
+    int nThreads, int nDstXOff, int nDstYOff, int nDstXSize, int nDstYSize )
+
+{
+/* -------------------------------------------------------------------- */
+/*      Each thread warps with its own copy of the transformer, so that */
+/*      the one of the options is only used under the IO mutex, to      */
+/*      compute source windows.                                         */
+/* -------------------------------------------------------------------- */
+    GDALWarpChunkJob *pasJobs = (GDALWarpChunkJob *)
+        CPLCalloc( sizeof(GDALWarpChunkJob), nThreads );
+    int i;
+
+    for( i = 0; i < nThreads; i++ )
+    {
+        pasJobs[i].pTransformerArg =
+            GDALCloneTransformer( psOptions->pTransformerArg );
+        if( pasJobs[i].pTransformerArg == NULL )
+            break;
+    }
+    if( i < nThreads )
+    {
+        for( i = 0; i < nThreads; i++ )
+        {
+            if( pasJobs[i].pTransformerArg != NULL )
+                GDALDestroyTransformer( pasJobs[i].pTransformerArg );
+        }
+        CPLFree( pasJobs );
+        CPLDebug( "WARP", "Cannot duplicate transformer function. "
+                  "Falling back to interleaved input/output and computation" );
+        return CE_Warning;
+    }
+
+    CPLWorkerThreadPool* poPool = CPLGetGlobalWorkerThreadPool( nThreads - 1 );
+    if( poPool == NULL )
+    {
+        for( i = 0; i < nThreads; i++ )
+            GDALDestroyTransformer( pasJobs[i].pTransformerArg );
+        CPLFree( pasJobs );
+        return CE_Warning;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Collect the list of chunks to operate on, so that nThreads of   */
+/*      them fit together in the memory limit.                          */
+/* -------------------------------------------------------------------- */
+    double dfWarpMemoryLimit = psOptions->dfWarpMemoryLimit;
+    psOptions->dfWarpMemoryLimit = dfWarpMemoryLimit / nThreads;
+
+    WipeChunkList();
+    CollectChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+
+    psOptions->dfWarpMemoryLimit = dfWarpMemoryLimit;
+
+    /* Sort chucks from top to bottom, and for equal y, from left to right */
+    qsort(pasChunkList, nChunkListCount, sizeof(GDALWarpChunk), OrderWarpChunk);
+
+    GDALWarpChunkShared sShared;
+    memset( &sShared, 0, sizeof(sShared) );
+    sShared.hMutex = CPLCreateMutex();
+    CPLReleaseMutex( sShared.hMutex );
+    sShared.hCond = CPLCreateCond();
+    sShared.pasChunkList = pasChunkList;
+    sShared.nChunkListCount = nChunkListCount;
+    sShared.bOrderedWrites =
+        CSLFetchBoolean( psOptions->papszWarpOptions, "STREAMABLE_OUTPUT", FALSE );
+    sShared.pfnProgress = psOptions->pfnProgress;
+    sShared.pProgressArg = psOptions->pProgressArg;
+
+    for( i = 0; i < nChunkListCount; i++ )
+        sShared.dfTotalPixels += pasChunkList[i].dsx * (double) pasChunkList[i].dsy;
+
+    for( i = 0; i < nThreads; i++ )
+    {
+        pasJobs[i].poOperation = this;
+        pasJobs[i].psShared = &sShared;
+        pasJobs[i].eErr = CE_None;
+    }
+
+    int nActiveThreads = MIN(nThreads, MAX(1, nChunkListCount));
+
+    CPLDebug( "WARP", "Processing %d chunks with %d threads%s",
+              nChunkListCount, nActiveThreads,
+              sShared.bOrderedWrites ? ", in order" : "" );
+
+/* -------------------------------------------------------------------- */
+/*      The warp mutex of the two threads mode would serialize the      */
+/*      computations.                                                   */
+/* -------------------------------------------------------------------- */
+    if( hWarpMutex != NULL )
+    {
+        CPLDestroyMutex( hWarpMutex );
+        hWarpMutex = NULL;
+    }
+    if( hIOMutex == NULL )
+    {
+        hIOMutex = CPLCreateMutex();
+        CPLReleaseMutex( hIOMutex );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Run the jobs of the pool threads, and our own.                  */
+/* -------------------------------------------------------------------- */
+    int nPendingJobs = 0;
+
+    for( i = 1; i < nActiveThreads; i++ )
+        poPool->SubmitJob( ChunkJobThreadMain, &pasJobs[i], &nPendingJobs );
+
+    ChunkJobThreadMain( &pasJobs[0] );
+
+    poPool->WaitGroupCompletion( &nPendingJobs );
+
+/* -------------------------------------------------------------------- */
+/*      Cleanup.                                                        */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = CE_None;
+    for( i = 0; i < nActiveThreads; i++ )
+    {
+        if( eErr == CE_None )
+            eErr = pasJobs[i].eErr;
+    }
+    if( eErr == CE_None && sShared.bStop )
+    {
+        CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+        eErr = CE_Failure;
+    }
+
+
+    for( i = 0; i < nThreads; i++ )
+        GDALDestroyTransformer( pasJobs[i].pTransformerArg );
+    CPLFree( pasJobs );
+
+    CPLDestroyCond( sShared.hCond );
+    CPLDestroyMutex( sShared.hMutex );
+
+    CPLDestroyMutex( hIOMutex );
+    hIOMutex = NULL;
+
+    WipeChunkList();
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                         GDALChunkAndWarpMulti()                      */
 /************************************************************************/
@@ -1250,6 +1593,27 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
                                       int nSrcXExtraSize, int nSrcYExtraSize,
                                       double dfProgressBase,
                                       double dfProgressScale)
+{
+    return WarpRegionInternal(nDstXOff, nDstYOff,
+                              nDstXSize, nDstYSize,
+                              nSrcXOff, nSrcYOff,
+                              nSrcXSize, nSrcYSize,
+                              nSrcXExtraSize, nSrcYExtraSize,
+                              dfProgressBase, dfProgressScale, NULL);
+}
+
+/************************************************************************/
+/*                         WarpRegionInternal()                         */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                              int nDstXSize, int nDstYSize,
+                                              int nSrcXOff, int nSrcYOff,
+                                              int nSrcXSize, int nSrcYSize,
+                                              int nSrcXExtraSize, int nSrcYExtraSize,
+                                              double dfProgressBase,
+                                              double dfProgressScale,
+                                              GDALWarpChunkJob *psJob )
 
 {
     CPLErr eErr;
@@ -1372,11 +1736,11 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
 /* -------------------------------------------------------------------- */
 /*      Perform the warp.                                               */
 /* -------------------------------------------------------------------- */
-    eErr = WarpRegionToBuffer( nDstXOff, nDstYOff, nDstXSize, nDstYSize, 
-                               pDstBuffer, psOptions->eWorkingDataType, 
-                               nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
-                               nSrcXExtraSize, nSrcYExtraSize,
-                               dfProgressBase, dfProgressScale);
+    eErr = WarpRegionToBufferInternal( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                       pDstBuffer, psOptions->eWorkingDataType,
+                                       nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                       nSrcXExtraSize, nSrcYExtraSize,
+                                       dfProgressBase, dfProgressScale, psJob );
 
 /* -------------------------------------------------------------------- */
 /*      Write the output data back to disk if all went well.            */
@@ -1494,6 +1858,29 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
     int nSrcXExtraSize, int nSrcYExtraSize,
     double dfProgressBase, double dfProgressScale)
+{
+    return WarpRegionToBufferInternal(nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                      pDataBuf, eBufDataType,
+                                      nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                      nSrcXExtraSize, nSrcYExtraSize,
+                                      dfProgressBase, dfProgressScale, NULL);
+}
+
+/************************************************************************/
+/*                     WarpRegionToBufferInternal()                     */
+/*                                                                      */
+/*      psJob is set when called from ChunkAndWarpConcurrent(), to      */
+/*      warp with the transformer and report progress through the       */
+/*      progress function of the calling thread.                        */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::WarpRegionToBufferInternal(
+    int nDstXOff, int nDstYOff, int nDstXSize, int nDstYSize,
+    void *pDataBuf, GDALDataType eBufDataType,
+    int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
+    int nSrcXExtraSize, int nSrcYExtraSize,
+    double dfProgressBase, double dfProgressScale,
+    GDALWarpChunkJob *psJob )
 
 {
     CPLErr eErr = CE_None;
@@ -1534,6 +1921,13 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     oWK.dfProgressBase = dfProgressBase;
     oWK.dfProgressScale = dfProgressScale;
 
+    if( psJob != NULL )
+    {
+        oWK.pTransformerArg = psJob->pTransformerArg;
+        oWK.pfnProgress = GDALWarpChunkProgress;
+        oWK.pProgress = psJob;
+    }
+
     oWK.papszWarpOptions = psOptions->papszWarpOptions;
     
     oWK.padfDstNoDataReal = psOptions->padfDstNoDataReal;
@@ -1685,6 +2079,51 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
                                         TRUE, oWK.pafDstDensity );
     }
     
+/* -------------------------------------------------------------------- */
+/*      Generate a source validity mask if we have a source mask for     */
+/*      the whole input dataset (and didn't already treat it as         */
+/*      alpha band).                                                    */
+/* -------------------------------------------------------------------- */
+    GDALRasterBandH hSrcBand = NULL;
+    if( psOptions->nBandCount > 0 )
+        hSrcBand = GDALGetRasterBand(psOptions->hSrcDS,
+                                     psOptions->panSrcBands[0]);
+    
+    if( eErr == CE_None 
+        && oWK.pafUnifiedSrcDensity == NULL 
+        && (GDALGetMaskFlags(hSrcBand) & GMF_PER_DATASET) &&
+        nSrcXSize > 0 && nSrcYSize > 0 )
+
+    {
+        eErr = CreateKernelMask( &oWK, 0, "UnifiedSrcValid" );
+        
+        if( eErr == CE_None )
+            eErr = 
+                GDALWarpSrcMaskMasker( psOptions, 
+                                       psOptions->nBandCount, 
+                                       psOptions->eWorkingDataType,
+                                       oWK.nSrcXOff, oWK.nSrcYOff, 
+                                       oWK.nSrcXSize, oWK.nSrcYSize,
+                                       oWK.papabySrcImage,
+                                       FALSE, oWK.panUnifiedSrcValid );
+    }
+    
+/* -------------------------------------------------------------------- */
+/*      Release IO Mutex, and acquire warper mutex.  The nodata         */
+/*      masks below only depend on the buffers of this chunk, so they   */
+/*      are computed outside of the IO mutex.                           */
+/* -------------------------------------------------------------------- */
+    if( hIOMutex != NULL )
+    {
+        CPLReleaseMutex( hIOMutex );
+        if( hWarpMutex != NULL && !CPLAcquireMutex( hWarpMutex, 600.0 ) )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined, 
+                      "Failed to acquire WarpMutex in WarpRegion()." );
+            return CE_Failure;
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      If we have source nodata values create, or update the           */
 /*      validity mask.                                                  */
@@ -1724,54 +2163,33 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
         {
             int nBytesInMask = (oWK.nSrcXSize * oWK.nSrcYSize + 31) / 8;
             int iWord;
+            GUInt32 *panMergedMask = (GUInt32 *) CPLCalloc(nBytesInMask/4+1,4);
 
+            /* The unified mask may already hold the source mask band, */
+            /* computed under the IO mutex, so we AND into it. */
             eErr = CreateKernelMask( &oWK, i, "UnifiedSrcValid" );
 
-            memset( oWK.panUnifiedSrcValid, 0, nBytesInMask );
-            
             for( i = 0; i < psOptions->nBandCount; i++ )
             {
                 for( iWord = nBytesInMask/4 - 1; iWord >= 0; iWord-- )
-                    oWK.panUnifiedSrcValid[iWord] |= 
+                    panMergedMask[iWord] |= 
                         oWK.papanBandSrcValid[i][iWord];
                 CPLFree( oWK.papanBandSrcValid[i] );
                 oWK.papanBandSrcValid[i] = NULL;
             }
-            
+
+            if( eErr == CE_None )
+            {
+                for( iWord = nBytesInMask/4 - 1; iWord >= 0; iWord-- )
+                    oWK.panUnifiedSrcValid[iWord] &= panMergedMask[iWord];
+            }
+
+            CPLFree( panMergedMask );
             CPLFree( oWK.papanBandSrcValid );
             oWK.papanBandSrcValid = NULL;
         }
     }
 
-/* -------------------------------------------------------------------- */
-/*      Generate a source validity mask if we have a source mask for     */
-/*      the whole input dataset (and didn't already treat it as         */
-/*      alpha band).                                                    */
-/* -------------------------------------------------------------------- */
-    GDALRasterBandH hSrcBand = NULL;
-    if( psOptions->nBandCount > 0 )
-        hSrcBand = GDALGetRasterBand(psOptions->hSrcDS,
-                                     psOptions->panSrcBands[0]);
-    
-    if( eErr == CE_None 
-        && oWK.pafUnifiedSrcDensity == NULL 
-        && (GDALGetMaskFlags(hSrcBand) & GMF_PER_DATASET) &&
-        nSrcXSize > 0 && nSrcYSize > 0 )
-
-    {
-        eErr = CreateKernelMask( &oWK, 0, "UnifiedSrcValid" );
-        
-        if( eErr == CE_None )
-            eErr = 
-                GDALWarpSrcMaskMasker( psOptions, 
-                                       psOptions->nBandCount, 
-                                       psOptions->eWorkingDataType,
-                                       oWK.nSrcXOff, oWK.nSrcYOff, 
-                                       oWK.nSrcXSize, oWK.nSrcYSize,
-                                       oWK.papabySrcImage,
-                                       FALSE, oWK.panUnifiedSrcValid );
-    }
-    
 /* -------------------------------------------------------------------- */
 /*      If we have destination nodata values create, or update the      */
 /*      validity mask.  We clear the DstValid for any pixel that we     */
@@ -1826,20 +2244,6 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
         }
     }
         
-/* -------------------------------------------------------------------- */
-/*      Release IO Mutex, and acquire warper mutex.                     */
-/* -------------------------------------------------------------------- */
-    if( hIOMutex != NULL )
-    {
-        CPLReleaseMutex( hIOMutex );
-        if( !CPLAcquireMutex( hWarpMutex, 600.0 ) )
-        {
-            CPLError( CE_Failure, CPLE_AppDefined, 
-                      "Failed to acquire WarpMutex in WarpRegion()." );
-            return CE_Failure;
-        }
-    }
-
 /* -------------------------------------------------------------------- */
 /*      Optional application provided prewarp chunk processor.          */
 /* -------------------------------------------------------------------- */
@@ -1868,7 +2272,10 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
 /* -------------------------------------------------------------------- */
     if( hIOMutex != NULL )
     {
-        CPLReleaseMutex( hWarpMutex );
+        if( hWarpMutex != NULL )
+            CPLReleaseMutex( hWarpMutex );
+        if( psJob != NULL && psJob->psShared->bOrderedWrites )
+            WaitChunkWriteTurn( psJob );
         if( !CPLAcquireMutex( hIOMutex, 600.0 ) )
         {
             CPLError( CE_Failure, CPLE_AppDefined, 
@@ -38,6 +38,8 @@
 
 #include "thinplatespline.h"
 
+#include <algorithm>
+
 /////////////////////////////////////////////////////////////////////////////////////
 //// vizGeorefSpline2D
 /////////////////////////////////////////////////////////////////////////////////////
@@ -363,6 +365,8 @@ int VizGeorefSpline2D::solve(void)
 {
     int r, c;
     int p;
+
+    delete_patches();
 	
     //	No points at all
     if ( _nof_points < 1 )
@@ -464,6 +468,9 @@ int VizGeorefSpline2D::solve(void)
         return(3);
     }
 	
+    if ( _local_points > 0 && _nof_points > 4 * _local_points )
+        return solve_local( xmin, xmax, ymin, ymax );
+
     type = VIZ_GEOREF_SPLINE_FULL;
     // Make the necessary memory allocations
 
@@ -651,6 +658,8 @@ int VizGeorefSpline2D::get_point( const double Px, const double Py, double *vars
         }
         break;
     }
+	case VIZ_GEOREF_SPLINE_LOCAL :
+		return get_point_local( Px, Py, vars );
 	case VIZ_GEOREF_SPLINE_POINT_WAS_ADDED :
 		fprintf(stderr, " A point was added after the last solve\n");
 		fprintf(stderr, " NO interpolation - return values are zero\n");
@@ -672,6 +681,352 @@ int VizGeorefSpline2D::get_point( const double Px, const double Py, double *vars
 	return(1);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+//// Local mode
+////
+//// The bounding box of the points is split into a kd-tree, at the median of
+//// the points along the longest side of each cell, until no cell holds more
+//// than _local_points points, so that the cells follow the density of the
+//// points.  The spline of each leaf is fitted on the points of its support,
+//// that is its cell widened by a margin, which is shrunk around dense
+//// clusters so that no spline is fitted on more than LOCAL_MAX_POINTS_FACTOR
+//// * _local_points points, and grown in empty areas.  A point is
+//// interpolated by blending the splines of the supports holding it, with
+//// weights that are 1 on the cell, fall to 0 with a smoothstep across the
+//// margin, and are normalized to sum to 1.  As every spline contributing at
+//// a control point has been fitted on it, the interpolation remains exact
+//// at the control points.
+/////////////////////////////////////////////////////////////////////////////////////
+
+#define LOCAL_MAX_DEPTH          48
+#define LOCAL_MAX_POINTS_FACTOR  16
+#define LOCAL_MAX_SHRINK         64
+
+class VizGeorefCoordCompare
+{
+    const double *coord;
+  public:
+    VizGeorefCoordCompare( const double *coordIn ) : coord(coordIn) {}
+    bool operator()( int a, int b ) const { return coord[a] < coord[b]; }
+};
+
+class VizGeorefCoordBelow
+{
+    const double *coord;
+    double value;
+  public:
+    VizGeorefCoordBelow( const double *coordIn, double valueIn ) :
+        coord(coordIn), value(valueIn) {}
+    bool operator()( int a ) const { return coord[a] < value; }
+};
+
+static double LocalWeight( double c, double lo, double hi, double margin )
+{
+    double d = MAX( lo - c, c - hi );
+    if ( d <= 0.0 )
+        return 1.0;
+    if ( d >= margin )
+        return 0.0;
+    double t = d / margin;
+    return 1.0 - t * t * ( 3.0 - 2.0 * t );
+}
+
+void VizGeorefSpline2D::delete_patches()
+{
+    for( size_t i = 0; i < _nodes.size(); i++ )
+        delete _nodes[i].patch;
+    _nodes.clear();
+}
+
+/* Counts the points inside query (xmin, ymin, xmax, ymax), and stores
+   their indices in points if not NULL. */
+int VizGeorefSpline2D::collect_local_points( const double *query,
+                                             const std::vector<int>& order,
+                                             const std::vector<int>& node_start,
+                                             const std::vector<int>& node_count,
+                                             int *points )
+{
+    int stack[LOCAL_MAX_DEPTH + 2];
+    int nof_stack = 0, nof_found = 0;
+
+    stack[nof_stack++] = 0;
+    while ( nof_stack > 0 )
+    {
+        int k = stack[--nof_stack];
+        const LocalNode& node = _nodes[k];
+
+        if ( node.box[0] > query[2] || node.box[2] < query[0] ||
+             node.box[1] > query[3] || node.box[3] < query[1] )
+            continue;
+
+        if ( node.child >= 0 )
+        {
+            stack[nof_stack++] = node.child;
+            stack[nof_stack++] = node.child + 1;
+            continue;
+        }
+
+        for ( int i = node_start[k]; i < node_start[k] + node_count[k]; i++ )
+        {
+            int p = order[i];
+            if ( x[p] >= query[0] && x[p] <= query[2] &&
+                 y[p] >= query[1] && y[p] <= query[3] )
+            {
+                if ( points != NULL )
+                    points[nof_found] = p;
+                nof_found++;
+            }
+        }
+    }
+
+    return nof_found;
+}
+
+int VizGeorefSpline2D::solve_local( double xmin, double xmax,
+                                    double ymin, double ymax )
+{
+    int p, v;
+    size_t k;
+    std::vector<int> order( _nof_points );
+    std::vector<int> node_start, node_count, node_depth;
+
+    for ( p = 0; p < _nof_points; p++ )
+        order[p] = p;
+
+/* -------------------------------------------------------------------- */
+/*      Build the kd-tree.  Children always follow their parent.        */
+/* -------------------------------------------------------------------- */
+    LocalNode root;
+    root.box[0] = xmin;
+    root.box[1] = ymin;
+    root.box[2] = xmax;
+    root.box[3] = ymax;
+    root.child = -1;
+    root.patch = NULL;
+    _nodes.push_back( root );
+    node_start.push_back( 0 );
+    node_count.push_back( _nof_points );
+    node_depth.push_back( 0 );
+
+    for ( k = 0; k < _nodes.size(); k++ )
+    {
+        int count = node_count[k];
+        if ( count <= _local_points || node_depth[k] >= LOCAL_MAX_DEPTH )
+            continue;
+
+        LocalNode child = _nodes[k];
+        int axis = ( child.box[2] - child.box[0] >=
+                     child.box[3] - child.box[1] ) ? 0 : 1;
+        const double *coord = ( axis == 0 ) ? x : y;
+        int *first = &order[node_start[k]];
+        int half = count / 2;
+
+        std::nth_element( first, first + half, first + count,
+                          VizGeorefCoordCompare( coord ) );
+        double split = coord[first[half]];
+
+        // Many points on the side of the cell: split it in the middle
+        if ( !( split > child.box[axis] && split < child.box[axis + 2] ) )
+        {
+            split = 0.5 * ( child.box[axis] + child.box[axis + 2] );
+            half = (int) ( std::partition( first, first + count,
+                               VizGeorefCoordBelow( coord, split ) ) - first );
+        }
+
+        _nodes[k].child = (int) _nodes.size();
+
+        child.box[axis + 2] = split;
+        _nodes.push_back( child );
+        node_start.push_back( node_start[k] );
+        node_count.push_back( half );
+        node_depth.push_back( node_depth[k] + 1 );
+
+        child.box[axis + 2] = _nodes[k].box[axis + 2];
+        child.box[axis] = split;
+        _nodes.push_back( child );
+        node_start.push_back( node_start[k] + half );
+        node_count.push_back( count - half );
+        node_depth.push_back( node_depth[k] + 1 );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Fit the spline of each leaf on the points of its support.      */
+/* -------------------------------------------------------------------- */
+    int min_points = MIN( _local_points, _nof_points );
+    int max_points = LOCAL_MAX_POINTS_FACTOR * _local_points;
+    std::vector<int> patch_points( _nof_points );
+    int ret = 5;
+
+    for ( k = 0; ret && k < _nodes.size(); k++ )
+    {
+        LocalNode& node = _nodes[k];
+        if ( node.child >= 0 )
+            continue;
+
+        double width = node.box[2] - node.box[0];
+        double height = node.box[3] - node.box[1];
+        double factor = 1.0;
+        double query[4];
+        int count;
+
+#define SET_QUERY(f) \
+        query[0] = node.box[0] - (f) * width; \
+        query[1] = node.box[1] - (f) * height; \
+        query[2] = node.box[2] + (f) * width; \
+        query[3] = node.box[3] + (f) * height
+
+        SET_QUERY( factor );
+        count = collect_local_points( query, order, node_start, node_count,
+                                      NULL );
+
+        // Grow the support of cells in empty areas
+        while ( count < min_points &&
+                ( factor * width < xmax - xmin ||
+                  factor * height < ymax - ymin ) )
+        {
+            factor *= 2.0;
+            SET_QUERY( factor );
+            count = collect_local_points( query, order, node_start,
+                                          node_count, NULL );
+        }
+
+        // Shrink the support of cells next to dense clusters, bisecting
+        // for a margin that leaves between 3 and max_points points
+        double factor_min = 0.0, factor_max = factor;
+        for ( int i = 0; count > max_points && i < LOCAL_MAX_SHRINK; i++ )
+        {
+            double factor_mid = 0.5 * ( factor_min + factor_max );
+            SET_QUERY( factor_mid );
+            int count_mid = collect_local_points( query, order, node_start,
+                                                  node_count, NULL );
+            if ( count_mid > max_points )
+                factor_max = factor_mid;
+            else if ( count_mid < MIN( 3, min_points ) )
+                factor_min = factor_mid;
+            else
+            {
+                factor = factor_mid;
+                count = count_mid;
+            }
+        }
+
+        SET_QUERY( factor );
+#undef SET_QUERY
+
+        node.margin[0] = factor * width;
+        node.margin[1] = factor * height;
+        memcpy( node.support, query, sizeof(query) );
+
+        count = collect_local_points( query, order, node_start, node_count,
+                                      &patch_points[0] );
+
+        // The spline is solved in coordinates relative to its support,
+        // which leaves it unchanged but keeps small systems well conditioned
+        node.origin[0] = 0.5 * ( query[0] + query[2] );
+        node.origin[1] = 0.5 * ( query[1] + query[3] );
+        node.scale = 1.0 / MAX( query[2] - query[0], query[3] - query[1] );
+
+        node.patch = new VizGeorefSpline2D( _nof_vars );
+        for ( p = 0; p < count; p++ )
+        {
+            double vars[VIZGEOREF_MAX_VARS];
+            int i = patch_points[p];
+            for ( v = 0; v < _nof_vars; v++ )
+                vars[v] = rhs[v][i + 3];
+            node.patch->add_point( ( x[i] - node.origin[0] ) * node.scale,
+                                   ( y[i] - node.origin[1] ) * node.scale,
+                                   vars );
+        }
+
+        if ( !node.patch->solve() )
+            ret = 0;
+    }
+
+    if ( !ret )
+    {
+        delete_patches();
+        return 0;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Propagate the supports of the leaves up the tree.               */
+/* -------------------------------------------------------------------- */
+    for ( k = _nodes.size(); k-- > 0; )
+    {
+        LocalNode& node = _nodes[k];
+        if ( node.child < 0 )
+            continue;
+
+        const LocalNode& c1 = _nodes[node.child];
+        const LocalNode& c2 = _nodes[node.child + 1];
+        node.support[0] = MIN( c1.support[0], c2.support[0] );
+        node.support[1] = MIN( c1.support[1], c2.support[1] );
+        node.support[2] = MAX( c1.support[2], c2.support[2] );
+        node.support[3] = MAX( c1.support[3], c2.support[3] );
+    }
+
+    type = VIZ_GEOREF_SPLINE_LOCAL;
+    return ret;
+}
+
+int VizGeorefSpline2D::get_point_local( const double Px, const double Py,
+                                        double *vars )
+{
+    int v;
+    const double *root = _nodes[0].box;
+
+    // Weights are computed at the position clamped to the bounding box
+    double cx = MAX( root[0], MIN( Px, root[2] ) );
+    double cy = MAX( root[1], MIN( Py, root[3] ) );
+
+    int stack[LOCAL_MAX_DEPTH + 2];
+    int nof_stack = 0;
+    double sum_weights = 0.0;
+
+    for ( v = 0; v < _nof_vars; v++ )
+        vars[v] = 0.0;
+
+    stack[nof_stack++] = 0;
+    while ( nof_stack > 0 )
+    {
+        const LocalNode& node = _nodes[stack[--nof_stack]];
+
+        if ( cx < node.support[0] || cx > node.support[2] ||
+             cy < node.support[1] || cy > node.support[3] )
+            continue;
+
+        if ( node.child >= 0 )
+        {
+            stack[nof_stack++] = node.child;
+            stack[nof_stack++] = node.child + 1;
+            continue;
+        }
+
+        double weight =
+            LocalWeight( cx, node.box[0], node.box[2], node.margin[0] ) *
+            LocalWeight( cy, node.box[1], node.box[3], node.margin[1] );
+        if ( weight == 0.0 )
+            continue;
+
+        double patch_vars[VIZGEOREF_MAX_VARS];
+        if ( !node.patch->get_point( ( Px - node.origin[0] ) * node.scale,
+                                     ( Py - node.origin[1] ) * node.scale,
+                                     patch_vars ) )
+            return 0;
+        for ( v = 0; v < _nof_vars; v++ )
+            vars[v] += weight * patch_vars[v];
+        sum_weights += weight;
+    }
+
+    if ( sum_weights == 0.0 )
+        return 0;
+
+    for ( v = 0; v < _nof_vars; v++ )
+        vars[v] /= sum_weights;
+
+    return 1;
+}
+
 #ifndef HAVE_ARMADILLO
 static int matrixInvert( int N, double input[], double output[] )
 {
@@ -33,6 +33,8 @@
 #include "gdal_alg.h"
 #include "cpl_conv.h"
 
+#include <vector>
+
 typedef enum
 {
 	VIZ_GEOREF_SPLINE_ZERO_POINTS,
@@ -40,6 +42,7 @@ typedef enum
 	VIZ_GEOREF_SPLINE_TWO_POINTS,
 	VIZ_GEOREF_SPLINE_ONE_DIMENSIONAL,
 	VIZ_GEOREF_SPLINE_FULL,
+	VIZ_GEOREF_SPLINE_LOCAL,
 	
 	VIZ_GEOREF_SPLINE_POINT_WAS_ADDED,
 	VIZ_GEOREF_SPLINE_POINT_WAS_DELETED
@@ -67,6 +70,7 @@ class VizGeorefSpline2D
         _nof_points = 0;
         _nof_vars = nof_vars;
         _max_nof_points = 0;
+        _local_points = 0;
         grow_points();
         type = VIZ_GEOREF_SPLINE_ZERO_POINTS;
     }
@@ -82,6 +86,7 @@ class VizGeorefSpline2D
             CPLFree( rhs[i] );
             CPLFree( coef[i] );
         }
+        delete_patches();
     }
 
 #if 0
@@ -135,6 +140,12 @@ class VizGeorefSpline2D
     void grow_points();
     int add_point( const double Px, const double Py, const double *Pvars );
     int get_point( const double Px, const double Py, double *Pvars );
+
+    // Maximum number of points per cell of the local mode, or 0 to solve
+    // the global system.  Must be called before solve().
+    void set_local_mode( int nof_points_per_cell ) {
+        _local_points = nof_points_per_cell;
+    }
 #if 0
     int delete_point(const double Px, const double Py );
     bool get_xy(int index, double& x, double& y);
@@ -145,6 +156,15 @@ class VizGeorefSpline2D
 
   private:	
 
+    int solve_local( double xmin, double xmax, double ymin, double ymax );
+    int get_point_local( const double Px, const double Py, double *Pvars );
+    int collect_local_points( const double *query,
+                              const std::vector<int>& order,
+                              const std::vector<int>& node_start,
+                              const std::vector<int>& node_count,
+                              int *points );
+    void delete_patches();
+
     vizGeorefInterType type;
 
     int _nof_vars;
@@ -167,4 +187,20 @@ class VizGeorefSpline2D
     double *u; // [VIZ_GEOREF_SPLINE_MAX_POINTS];
     int *unused; // [VIZ_GEOREF_SPLINE_MAX_POINTS];
     int *index; // [VIZ_GEOREF_SPLINE_MAX_POINTS];
+
+    // Local mode: kd-tree of cells, each leaf holding a spline fitted on
+    // the points of its support
+    struct LocalNode
+    {
+        double box[4];      // xmin, ymin, xmax, ymax of the cell
+        double support[4];  // union of the supports of the leaves below
+        double margin[2];   // leaves: extent of the support around the cell
+        double origin[2];   // leaves: center of the support
+        double scale;       // leaves: inverse of the size of the support
+        int    child;       // index of the first of the 2 children, or -1
+        VizGeorefSpline2D *patch;
+    };
+
+    int _local_points;
+    std::vector<LocalNode> _nodes;
 };
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Compile CSV support files (gcs.csv, pcs.csv, ...) into their
+ *           binary form, for faster loading by the CSV lookup functions.
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_csv.h"
+#include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_multiproc.h"
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                               Usage()                                */
+/************************************************************************/
+
+static void Usage()
+
+{
+    printf( "Usage: gdal_compile_csv [-q] file.csv*\n"
+            "\n"
+            "Writes next to each CSV file its compiled form (.csvb) used by\n"
+            "the CSV lookup functions of GDAL instead of parsing the CSV file.\n" );
+    exit( 1 );
+}
+
+/************************************************************************/
+/*                                main()                                */
+/************************************************************************/
+
+int main( int nArgc, char ** papszArgv )
+
+{
+    int i, bQuiet = FALSE, nFiles = 0, nErrors = 0;
+
+    for( i = 1; i < nArgc; i++ )
+    {
+        if( EQUAL(papszArgv[i], "-q") || EQUAL(papszArgv[i], "-quiet") )
+            bQuiet = TRUE;
+        else if( papszArgv[i][0] == '-' )
+            Usage();
+        else
+        {
+            nFiles ++;
+            if( CSVCompile( papszArgv[i], NULL ) )
+            {
+                if( !bQuiet )
+                    printf( "Compiled %s\n", papszArgv[i] );
+            }
+            else
+                nErrors ++;
+        }
+    }
+
+    if( nFiles == 0 )
+        Usage();
+
+    CPLCleanupTLS();
+
+    return nErrors == 0 ? 0 : 1;
+}
@@ -53,6 +53,7 @@
 #include "gt_wkt_srs_priv.h"
 #include "tifvsi.h"
 #include "cpl_multiproc.h"
+#include "cpl_worker_thread_pool.h"
 #include "cplkeywordparser.h"
 #include "gt_jpeg_copy.h"
 #include "cpl_vsi_virtual.h"
@@ -154,6 +155,7 @@ enum
 /* ==================================================================== */
 /************************************************************************/
 
+class GTiffDataset;
 class GTiffRasterBand;
 class GTiffRGBABand;
 class GTiffBitmapBand;
@@ -167,6 +169,45 @@ typedef enum
     VIRTUAL_MEM_IO_IF_ENOUGH_RAM
 } VirtualMemIOEnum;
 
+/* A strip or tile to compress by a worker thread */
+typedef struct
+{
+    GTiffDataset   *poDS;
+    char           *pszTmpFilename;
+    GByte          *pabyBuffer;
+    int             nBufferSize;
+    int             nHeight;
+    int             nStripOrTile; /* -1 if the job slot is free */
+    int             bTIFFIsBigEndian;
+    GByte          *pabyCompressedBuffer;
+    int             nCompressedBufferSize;
+    int             bReady;
+} GTiffCompressionJob;
+
+/* A strip or tile to decompress by a worker thread */
+typedef struct
+{
+    GTiffDataset   *poDS;
+    int             nBlockId;
+    int             nBlockReqSize;
+    int             nBlockBufSize;
+    GByte          *pabyBuffer;     /* pixel interleaved block, or NULL */
+    GByte         **papabyDstBlock; /* one cached block per decoded band */
+    GDALRasterBlock **papoBlocks;
+    int             nDstBlockCount;
+    int             bSuccess;
+    int             nErrNo;         /* error of a failed decoding, to be */
+    char           *pszErrMsg;      /* emitted by the calling thread */
+} GTiffDecompressionJob;
+
+/* A TIFF handle on the same directory, private to a decompression job */
+typedef struct
+{
+    TIFF           *hTIFF;
+    VSILFILE       *fpL;
+    int             bInUse;
+} GTiffDecompressionHandle;
+
 class GTiffDataset : public GDALPamDataset
 {
     friend class GTiffRasterBand;
@@ -288,6 +329,44 @@ class GTiffDataset : public GDALPamDataset
     int          WriteEncodedTile(uint32 tile, GByte* pabyData, int bPreserveDataBuffer);
     int          WriteEncodedStrip(uint32 strip, GByte* pabyData, int bPreserveDataBuffer);
 
+    CPLWorkerThreadPool *poCompressThreadPool; /* the global pool */
+    int          nCompressThreads; /* max. of our jobs in flight */
+    int          nCompressPendingJobs; /* our job group in the pool */
+    std::vector<GTiffCompressionJob> asCompressionJobs;
+    std::vector<int> anQueuedCompressionJobs; /* in submission order */
+    CPLMutex    *hCompressThreadPoolMutex;
+    uint16       nCompressPredictor;
+    void         InitCompressionThreads( char** papszOptions );
+    void         DestroyCompressionThreads();
+    int          SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
+                                       int cc, int nHeight );
+    void         WriteCompressionJob( GTiffCompressionJob* psJob );
+    void         WaitCompletionForBlock( int nBlockId );
+    void         FlushCompressionJobs();
+    static void  ThreadCompressionFunc( void* pData );
+
+    int          nDecompressThreads;
+    CPLWorkerThreadPool *poDecompressThreadPool; /* the global pool */
+    std::vector<GTiffDecompressionHandle> asDecompressionHandles;
+    CPLMutex    *hDecompressionHandlesMutex;
+    CPLString    osDecompressionFilename;
+    int          CanUseDecompressionThreads();
+    void         DestroyDecompressionThreads();
+    TIFF        *AcquireDecompressionHandle();
+    void         ReleaseDecompressionHandle( TIFF* hTIFFHandle );
+    CPLErr       CacheBlocksMultiThreaded( int nBlockX1, int nBlockY1,
+                                           int nBlockX2, int nBlockY2,
+                                           int nBandCount, int *panBandMap );
+    int          MultiThreadedRead( GTiffRasterBand* poBand,
+                                    int nXOff, int nYOff, int nXSize, int nYSize,
+                                    void * pData, int nBufXSize, int nBufYSize,
+                                    GDALDataType eBufType,
+                                    int nBandCount, int *panBandMap,
+                                    GSpacing nPixelSpace, GSpacing nLineSpace,
+                                    GSpacing nBandSpace,
+                                    GDALRasterIOExtraArg* psExtraArg );
+    static void  ThreadDecompressionFunc( void* pData );
+
     GTiffDataset* poMaskDS;
     GTiffDataset* poBaseDS;
 
@@ -1640,7 +1719,16 @@ CPLErr GTiffDataset::IRasterIO( GDALRWFlag eRWFlag,
     }
 
     nJPEGOverviewVisibilityFlag ++;
-    eErr =  GDALPamDataset::IRasterIO(
+    int nErr = -1;
+    if( eRWFlag == GF_Read )
+        nErr = MultiThreadedRead(
+                NULL, nXOff, nYOff, nXSize, nYSize,
+                pData, nBufXSize, nBufYSize, eBufType,
+                nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace, psExtraArg);
+    if( nErr >= 0 )
+        eErr = (CPLErr)nErr;
+    else
+        eErr =  GDALPamDataset::IRasterIO(
                 eRWFlag, nXOff, nYOff, nXSize, nYSize,
                 pData, nBufXSize, nBufYSize, eBufType,
                 nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace, psExtraArg);
@@ -2506,7 +2594,16 @@ CPLErr GTiffRasterBand::IRasterIO( GDALRWFlag eRWFlag,
     }
 
     poGDS->nJPEGOverviewVisibilityFlag ++;
-    eErr = GDALPamRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
+    int nErr = -1;
+    if( eRWFlag == GF_Read )
+        nErr = poGDS->MultiThreadedRead(this, nXOff, nYOff, nXSize, nYSize,
+                                        pData, nBufXSize, nBufYSize, eBufType,
+                                        1, &nBand, nPixelSpace, nLineSpace, 0,
+                                        psExtraArg);
+    if( nErr >= 0 )
+        eErr = (CPLErr)nErr;
+    else
+        eErr = GDALPamRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
                                         pData, nBufXSize, nBufYSize, eBufType,
                                         nPixelSpace, nLineSpace, psExtraArg);
     poGDS->nJPEGOverviewVisibilityFlag --;
@@ -4978,6 +5075,16 @@ GTiffDataset::GTiffDataset()
     nRefBaseMapping = 0;
     
     bHasDiscardedLsb = FALSE;
+
+    poCompressThreadPool = NULL;
+    nCompressThreads = 0;
+    nCompressPendingJobs = 0;
+    hCompressThreadPoolMutex = NULL;
+    nCompressPredictor = PREDICTOR_NONE;
+
+    nDecompressThreads = 0;
+    poDecompressThreadPool = NULL;
+    hDecompressionHandlesMutex = NULL;
 }
 
 /************************************************************************/
@@ -5045,6 +5152,9 @@ int GTiffDataset::Finalize()
 /* -------------------------------------------------------------------- */
     FlushCache();
 
+    DestroyCompressionThreads();
+    DestroyDecompressionThreads();
+
 /* -------------------------------------------------------------------- */
 /*      If there is still changed metadata, then presumably we want     */
 /*      to push it into PAM.                                            */
@@ -5237,6 +5347,9 @@ void GTiffDataset::FillEmptyTiles()
     if (!SetDirectory())
         return;
 
+    /* Blocks being compressed are not yet accounted in the byte counts */
+    FlushCompressionJobs();
+
 /* -------------------------------------------------------------------- */
 /*      How many blocks are there in this file?                         */
 /* -------------------------------------------------------------------- */
@@ -5412,6 +5525,9 @@ int GTiffDataset::WriteEncodedTile(uint32 tile, GByte *pabyData,
         return 0;
     }
 
+    if( poCompressThreadPool != NULL )
+        return SubmitCompressionJob(tile, pabyData, cc, nBlockYSize) ? cc : -1;
+
     return TIFFWriteEncodedTile(hTIFF, tile, pabyData, cc);
 }
 
@@ -5423,6 +5539,7 @@ int  GTiffDataset::WriteEncodedStrip(uint32 strip, GByte* pabyData,
                                      int bPreserveDataBuffer)
 {
     int cc = TIFFStripSize( hTIFF );
+    int nStripHeight = nRowsPerStrip;
     
 /* -------------------------------------------------------------------- */
 /*      If this is the last strip in the image, and is partial, then    */
@@ -5433,8 +5550,8 @@ int  GTiffDataset::WriteEncodedStrip(uint32 strip, GByte* pabyData,
 
     if( (int) ((nStripWithinBand+1) * nRowsPerStrip) > GetRasterYSize() )
     {
-        cc = (cc / nRowsPerStrip)
-            * (GetRasterYSize() - nStripWithinBand * nRowsPerStrip);
+        nStripHeight = GetRasterYSize() - nStripWithinBand * nRowsPerStrip;
+        cc = (cc / nRowsPerStrip) * nStripHeight;
         CPLDebug( "GTiff", "Adjusted bytes to write from %d to %d.", 
                   (int) TIFFStripSize(hTIFF), cc );
     }
@@ -5480,6 +5597,9 @@ int  GTiffDataset::WriteEncodedStrip(uint32 strip, GByte* pabyData,
         return 0;
     }
 
+    if( poCompressThreadPool != NULL )
+        return SubmitCompressionJob(strip, pabyData, cc, nStripHeight) ? cc : -1;
+
     return TIFFWriteEncodedStrip(hTIFF, strip, pabyData, cc);
 }
 
@@ -5591,6 +5711,856 @@ CPLErr  GTiffDataset::WriteEncodedTileOrStrip(uint32 tile_or_strip, void* data,
     return eErr;
 }
 
+/************************************************************************/
+/*                        GTiffGetThreadCount()                         */
+/*                                                                      */
+/*      Number of worker threads requested with the NUM_THREADS         */
+/*      creation or open option. Multi-threading is only enabled on     */
+/*      explicit request for the dataset.                               */
+/************************************************************************/
+
+static int GTiffGetThreadCount( char** papszOptions )
+
+{
+    const char* pszValue = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszValue == NULL )
+        return 0;
+
+    int nThreads;
+    if( EQUAL(pszValue, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszValue);
+    if( nThreads > 128 )
+        nThreads = 128;
+    return nThreads;
+}
+
+/************************************************************************/
+/*                       InitCompressionThreads()                       */
+/*                                                                      */
+/*      Setup the compression of the strips/tiles by the global pool    */
+/*      of worker threads when the NUM_THREADS creation option is set.  */
+/*      Blocks are still written to the file by the calling thread, in  */
+/*      the order they have been submitted.                             */
+/************************************************************************/
+
+void GTiffDataset::InitCompressionThreads( char** papszOptions )
+
+{
+    /* The blocks of streamed files must be written in sequence */
+    if( bStreamingOut )
+        return;
+
+    int nThreads = GTiffGetThreadCount( papszOptions );
+    if( nThreads <= 1 )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Only codecs without state shared between blocks can be run     */
+/*      on a separate TIFF handle. JPEG tables for example are shared.  */
+/* -------------------------------------------------------------------- */
+    if( nCompression != COMPRESSION_ADOBE_DEFLATE &&
+        nCompression != COMPRESSION_DEFLATE &&
+        nCompression != COMPRESSION_LZW &&
+        nCompression != COMPRESSION_PACKBITS &&
+        nCompression != COMPRESSION_LZMA )
+    {
+        CPLDebug( "GTiff",
+                  "NUM_THREADS ignored with compression method %d",
+                  nCompression );
+        return;
+    }
+
+    poCompressThreadPool = CPLGetGlobalWorkerThreadPool( nThreads );
+    if( poCompressThreadPool == NULL )
+        return;
+
+    if( !TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &nCompressPredictor ) )
+        nCompressPredictor = PREDICTOR_NONE;
+
+    /* Raw writes don't setup the data buffer of a newly created file, */
+    /* and libtiff then refuses to read back blocks */
+    TIFFWriteBufferSetup( hTIFF, NULL,
+                          TIFFIsTiled(hTIFF) ? TIFFTileSize(hTIFF) :
+                                               TIFFStripSize(hTIFF) );
+
+    hCompressThreadPoolMutex = CPLCreateMutex();
+    CPLReleaseMutex( hCompressThreadPoolMutex );
+
+    /* The pool may have more threads than requested by another user, */
+    /* so the number of our jobs in flight is bounded in */
+    /* SubmitCompressionJob(). Twice as many job slots allow nThreads */
+    /* blocks to be compressed while the oldest ones are being written */
+    nCompressThreads = nThreads;
+    asCompressionJobs.resize( 2 * nThreads );
+    for( size_t i = 0; i < asCompressionJobs.size(); i++ )
+    {
+        GTiffCompressionJob* psJob = &asCompressionJobs[i];
+        memset( psJob, 0, sizeof(GTiffCompressionJob) );
+        psJob->poDS = this;
+        psJob->pszTmpFilename = CPLStrdup(
+            CPLSPrintf("/vsimem/gtiff/thread/job/%p", psJob) );
+        psJob->nStripOrTile = -1;
+    }
+}
+
+/************************************************************************/
+/*                     DestroyCompressionThreads()                      */
+/************************************************************************/
+
+void GTiffDataset::DestroyCompressionThreads()
+
+{
+    if( poCompressThreadPool == NULL )
+        return;
+
+    /* Jobs that couldn't be flushed (FlushCache() not run) are discarded */
+    /* once they are complete */
+    poCompressThreadPool->WaitGroupCompletion( &nCompressPendingJobs );
+    poCompressThreadPool = NULL;
+
+    for( size_t i = 0; i < asCompressionJobs.size(); i++ )
+    {
+        CPLFree( asCompressionJobs[i].pszTmpFilename );
+        CPLFree( asCompressionJobs[i].pabyBuffer );
+        CPLFree( asCompressionJobs[i].pabyCompressedBuffer );
+    }
+    asCompressionJobs.clear();
+    anQueuedCompressionJobs.clear();
+
+    CPLDestroyMutex( hCompressThreadPoolMutex );
+    hCompressThreadPoolMutex = NULL;
+}
+
+/************************************************************************/
+/*                       ThreadCompressionFunc()                        */
+/*                                                                      */
+/*      Compress a strip/tile by writing it as the single strip of a    */
+/*      temporary in-memory TIFF file with the same compression         */
+/*      settings, and grab the resulting compressed bytes.              */
+/************************************************************************/
+
+void GTiffDataset::ThreadCompressionFunc( void* pData )
+
+{
+    GTiffCompressionJob* psJob = (GTiffCompressionJob*) pData;
+    GTiffDataset* poDS = psJob->poDS;
+
+    VSILFILE* fpTmp = VSIFOpenL( psJob->pszTmpFilename, "wb+" );
+    TIFF* hTIFFTmp = NULL;
+    if( fpTmp != NULL )
+        hTIFFTmp = VSI_TIFFOpen( psJob->pszTmpFilename,
+                                 psJob->bTIFFIsBigEndian ? "w+b" : "w+l",
+                                 fpTmp );
+    if( hTIFFTmp != NULL )
+    {
+        TIFFSetField( hTIFFTmp, TIFFTAG_IMAGEWIDTH, poDS->nBlockXSize );
+        TIFFSetField( hTIFFTmp, TIFFTAG_IMAGELENGTH, psJob->nHeight );
+        TIFFSetField( hTIFFTmp, TIFFTAG_BITSPERSAMPLE, poDS->nBitsPerSample );
+        TIFFSetField( hTIFFTmp, TIFFTAG_COMPRESSION, poDS->nCompression );
+        TIFFSetField( hTIFFTmp, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK );
+        TIFFSetField( hTIFFTmp, TIFFTAG_SAMPLEFORMAT, poDS->nSampleFormat );
+        TIFFSetField( hTIFFTmp, TIFFTAG_SAMPLESPERPIXEL,
+                      poDS->nPlanarConfig == PLANARCONFIG_CONTIG ?
+                                            poDS->nSamplesPerPixel : 1 );
+        TIFFSetField( hTIFFTmp, TIFFTAG_ROWSPERSTRIP, psJob->nHeight );
+        TIFFSetField( hTIFFTmp, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG );
+        if( poDS->nCompressPredictor != PREDICTOR_NONE )
+            TIFFSetField( hTIFFTmp, TIFFTAG_PREDICTOR,
+                          poDS->nCompressPredictor );
+        if( (poDS->nCompression == COMPRESSION_ADOBE_DEFLATE ||
+             poDS->nCompression == COMPRESSION_DEFLATE) &&
+            poDS->nZLevel != -1 )
+            TIFFSetField( hTIFFTmp, TIFFTAG_ZIPQUALITY, poDS->nZLevel );
+        else if( poDS->nCompression == COMPRESSION_LZMA &&
+                 poDS->nLZMAPreset != -1 )
+            TIFFSetField( hTIFFTmp, TIFFTAG_LZMAPRESET, poDS->nLZMAPreset );
+
+        toff_t *panOffsets = NULL;
+        toff_t *panByteCounts = NULL;
+        if( TIFFWriteEncodedStrip( hTIFFTmp, 0, psJob->pabyBuffer,
+                                   psJob->nBufferSize ) != -1 &&
+            TIFFGetField( hTIFFTmp, TIFFTAG_STRIPOFFSETS, &panOffsets ) &&
+            TIFFGetField( hTIFFTmp, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts ) )
+        {
+            vsi_l_offset nFileSize = 0;
+            GByte* pabyFile = VSIGetMemFileBuffer( psJob->pszTmpFilename,
+                                                   &nFileSize, FALSE );
+            if( pabyFile != NULL &&
+                panOffsets[0] + panByteCounts[0] <= nFileSize )
+            {
+                psJob->nCompressedBufferSize = (int) panByteCounts[0];
+                psJob->pabyCompressedBuffer = (GByte*)
+                    VSIMalloc( psJob->nCompressedBufferSize );
+                if( psJob->pabyCompressedBuffer != NULL )
+                    memcpy( psJob->pabyCompressedBuffer,
+                            pabyFile + panOffsets[0],
+                            psJob->nCompressedBufferSize );
+            }
+        }
+        XTIFFClose( hTIFFTmp );
+    }
+    if( fpTmp != NULL )
+        VSIFCloseL( fpTmp );
+    VSIUnlink( psJob->pszTmpFilename );
+
+    CPLAcquireMutex( poDS->hCompressThreadPoolMutex, 1000.0 );
+    psJob->bReady = TRUE;
+    CPLReleaseMutex( poDS->hCompressThreadPoolMutex );
+}
+
+/************************************************************************/
+/*                        SubmitCompressionJob()                        */
+/************************************************************************/
+
+int GTiffDataset::SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
+                                        int cc, int nHeight )
+
+{
+/* -------------------------------------------------------------------- */
+/*      Find a free job slot, writing the oldest queued job if there    */
+/*      is none.                                                        */
+/* -------------------------------------------------------------------- */
+    if( anQueuedCompressionJobs.size() == asCompressionJobs.size() )
+        WriteCompressionJob( &asCompressionJobs[anQueuedCompressionJobs[0]] );
+
+    int iJob = 0;
+    while( asCompressionJobs[iJob].nStripOrTile >= 0 )
+        iJob++;
+
+    GTiffCompressionJob* psJob = &asCompressionJobs[iJob];
+    if( psJob->nBufferSize < cc )
+    {
+        GByte* pabyNewBuffer = (GByte*) VSIRealloc( psJob->pabyBuffer, cc );
+        if( pabyNewBuffer == NULL )
+        {
+            CPLError( CE_Failure, CPLE_OutOfMemory,
+                      "Cannot allocate %d bytes for compression job", cc );
+            return FALSE;
+        }
+        psJob->pabyBuffer = pabyNewBuffer;
+    }
+    memcpy( psJob->pabyBuffer, pabyData, cc );
+    psJob->nBufferSize = cc;
+    psJob->nHeight = nHeight;
+    psJob->nStripOrTile = nStripOrTile;
+    psJob->bTIFFIsBigEndian = TIFFIsBigEndian( hTIFF );
+    psJob->bReady = FALSE;
+
+    anQueuedCompressionJobs.push_back( iJob );
+
+    /* Do not have more than NUM_THREADS jobs in flight */
+    poCompressThreadPool->WaitGroupCompletion( &nCompressPendingJobs, -1.0,
+                                               nCompressThreads - 1 );
+    if( !poCompressThreadPool->SubmitJob( ThreadCompressionFunc, psJob,
+                                          &nCompressPendingJobs ) )
+    {
+        /* Should not happen as the pool has been successfully setup */
+        ThreadCompressionFunc( psJob );
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        WriteCompressionJob()                         */
+/*                                                                      */
+/*      Wait for the compression of the oldest queued job to be         */
+/*      complete and write it in the current directory.                 */
+/************************************************************************/
+
+void GTiffDataset::WriteCompressionJob( GTiffCompressionJob* psJob )
+
+{
+    CPLAssert( psJob == &asCompressionJobs[anQueuedCompressionJobs[0]] );
+
+    /* If the job is not complete yet, wait for our whole group. The */
+    /* calling thread then runs our queued jobs instead of waiting for */
+    /* the threads of the pool, which might be busy with other work */
+    CPLAcquireMutex( hCompressThreadPoolMutex, 1000.0 );
+    int bReady = psJob->bReady;
+    CPLReleaseMutex( hCompressThreadPoolMutex );
+    if( !bReady )
+        poCompressThreadPool->WaitGroupCompletion( &nCompressPendingJobs );
+
+    int nRet = -1;
+    if( psJob->pabyCompressedBuffer != NULL )
+    {
+        /* Unlike TIFFWriteEncodedTile(), raw writes go at the current */
+        /* write offset, which is the end of the previously written */
+        /* block. Reset it so that an existing block is rewritten in */
+        /* place if it fits, or appended at the end of file otherwise */
+        TIFFSetWriteOffset( hTIFF, 0 );
+
+        if( TIFFIsTiled( hTIFF ) )
+            nRet = TIFFWriteRawTile( hTIFF, psJob->nStripOrTile,
+                                     psJob->pabyCompressedBuffer,
+                                     psJob->nCompressedBufferSize );
+        else
+            nRet = TIFFWriteRawStrip( hTIFF, psJob->nStripOrTile,
+                                      psJob->pabyCompressedBuffer,
+                                      psJob->nCompressedBufferSize );
+    }
+    if( nRet == -1 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Compression or writing of block %d failed.",
+                  psJob->nStripOrTile );
+        /* Reported at next IWriteBlock() */
+        bWriteErrorInFlushBlockBuf = TRUE;
+    }
+
+    CPLFree( psJob->pabyCompressedBuffer );
+    psJob->pabyCompressedBuffer = NULL;
+    psJob->nCompressedBufferSize = 0;
+    psJob->nStripOrTile = -1;
+    anQueuedCompressionJobs.erase( anQueuedCompressionJobs.begin() );
+}
+
+/************************************************************************/
+/*                       WaitCompletionForBlock()                       */
+/*                                                                      */
+/*      Make sure that a block being compressed is written before it    */
+/*      is read back. Must be called with our directory active.         */
+/************************************************************************/
+
+void GTiffDataset::WaitCompletionForBlock( int nBlockId )
+
+{
+    for( size_t i = anQueuedCompressionJobs.size(); i > 0; i-- )
+    {
+        if( asCompressionJobs[anQueuedCompressionJobs[i-1]].nStripOrTile ==
+                                                                    nBlockId )
+        {
+            /* Jobs are written in order */
+            while( i > 0 )
+            {
+                WriteCompressionJob(
+                        &asCompressionJobs[anQueuedCompressionJobs[0]] );
+                i--;
+            }
+            break;
+        }
+    }
+}
+
+/************************************************************************/
+/*                        FlushCompressionJobs()                        */
+/************************************************************************/
+
+void GTiffDataset::FlushCompressionJobs()
+
+{
+    if( anQueuedCompressionJobs.empty() || !SetDirectory() )
+        return;
+
+    while( !anQueuedCompressionJobs.empty() )
+        WriteCompressionJob( &asCompressionJobs[anQueuedCompressionJobs[0]] );
+}
+
+/************************************************************************/
+/*                     CanUseDecompressionThreads()                     */
+/*                                                                      */
+/*      Whether strips/tiles of this directory can be decoded by the    */
+/*      global pool of worker threads (NUM_THREADS open option), and if */
+/*      so get the pool at first call.                                  */
+/************************************************************************/
+
+int GTiffDataset::CanUseDecompressionThreads()
+
+{
+    if( nDecompressThreads <= 1 || eAccess == GA_Update || bStreamingIn )
+        return FALSE;
+
+    /* Bands with their own IReadBlock() logic are not handled */
+    if( bTreatAsRGBA || bTreatAsSplit || bTreatAsSplitBitmap )
+        return FALSE;
+    if( nBitsPerSample != 8 && nBitsPerSample != 16 &&
+        nBitsPerSample != 32 && nBitsPerSample != 64 &&
+        nBitsPerSample != 128 )
+        return FALSE;
+    if( nSampleFormat == SAMPLEFORMAT_IEEEFP && nBitsPerSample == 16 )
+        return FALSE;
+
+    /* Same restriction as for compression : each thread uses its own */
+    /* TIFF handle, so codecs with shared state (JPEG tables, YCbCr */
+    /* conversion settings) are excluded */
+    if( nCompression != COMPRESSION_ADOBE_DEFLATE &&
+        nCompression != COMPRESSION_DEFLATE &&
+        nCompression != COMPRESSION_LZW &&
+        nCompression != COMPRESSION_PACKBITS &&
+        nCompression != COMPRESSION_LZMA )
+        return FALSE;
+
+    if( poDecompressThreadPool != NULL )
+        return TRUE;
+
+    /* Overviews and masks are read from the file of the main image */
+    GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+    if( poRootDS->osFilename.size() == 0 )
+    {
+        nDecompressThreads = 0;
+        return FALSE;
+    }
+    osDecompressionFilename = poRootDS->osFilename;
+
+    poDecompressThreadPool = CPLGetGlobalWorkerThreadPool( nDecompressThreads );
+    if( poDecompressThreadPool == NULL )
+    {
+        nDecompressThreads = 0;
+        return FALSE;
+    }
+
+    hDecompressionHandlesMutex = CPLCreateMutex();
+    CPLReleaseMutex( hDecompressionHandlesMutex );
+
+    CPLDebug( "GTiff", "Using %d threads for decompression",
+              nDecompressThreads );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                    DestroyDecompressionThreads()                     */
+/************************************************************************/
+
+void GTiffDataset::DestroyDecompressionThreads()
+
+{
+    if( poDecompressThreadPool == NULL )
+        return;
+
+    /* Our jobs are all complete once CacheBlocksMultiThreaded() returns */
+    poDecompressThreadPool = NULL;
+
+    for( size_t i = 0; i < asDecompressionHandles.size(); i++ )
+    {
+        XTIFFClose( asDecompressionHandles[i].hTIFF );
+        VSIFCloseL( asDecompressionHandles[i].fpL );
+    }
+    asDecompressionHandles.clear();
+
+    CPLDestroyMutex( hDecompressionHandlesMutex );
+    hDecompressionHandlesMutex = NULL;
+}
+
+/************************************************************************/
+/*                     AcquireDecompressionHandle()                     */
+/*                                                                      */
+/*      Return a TIFF handle on our directory that no other thread      */
+/*      uses, opening a new one if needed.                              */
+/************************************************************************/
+
+TIFF* GTiffDataset::AcquireDecompressionHandle()
+
+{
+    CPLAcquireMutex( hDecompressionHandlesMutex, 1000.0 );
+    for( size_t i = 0; i < asDecompressionHandles.size(); i++ )
+    {
+        if( !asDecompressionHandles[i].bInUse )
+        {
+            asDecompressionHandles[i].bInUse = TRUE;
+            CPLReleaseMutex( hDecompressionHandlesMutex );
+            return asDecompressionHandles[i].hTIFF;
+        }
+    }
+    CPLReleaseMutex( hDecompressionHandlesMutex );
+
+    GTiffDecompressionHandle sHandle;
+    sHandle.fpL = VSIFOpenL( osDecompressionFilename, "rb" );
+    if( sHandle.fpL == NULL )
+        return NULL;
+    sHandle.hTIFF = VSI_TIFFOpen( osDecompressionFilename, "rc", sHandle.fpL );
+    if( sHandle.hTIFF != NULL &&
+        !TIFFSetSubDirectory( sHandle.hTIFF, nDirOffset ) )
+    {
+        XTIFFClose( sHandle.hTIFF );
+        sHandle.hTIFF = NULL;
+    }
+    if( sHandle.hTIFF == NULL )
+    {
+        VSIFCloseL( sHandle.fpL );
+        return NULL;
+    }
+    sHandle.bInUse = TRUE;
+
+    CPLAcquireMutex( hDecompressionHandlesMutex, 1000.0 );
+    asDecompressionHandles.push_back( sHandle );
+    CPLReleaseMutex( hDecompressionHandlesMutex );
+
+    return sHandle.hTIFF;
+}
+
+/************************************************************************/
+/*                     ReleaseDecompressionHandle()                     */
+/************************************************************************/
+
+void GTiffDataset::ReleaseDecompressionHandle( TIFF* hTIFFHandle )
+
+{
+    CPLAcquireMutex( hDecompressionHandlesMutex, 1000.0 );
+    for( size_t i = 0; i < asDecompressionHandles.size(); i++ )
+    {
+        if( asDecompressionHandles[i].hTIFF == hTIFFHandle )
+        {
+            asDecompressionHandles[i].bInUse = FALSE;
+            break;
+        }
+    }
+    CPLReleaseMutex( hDecompressionHandlesMutex );
+}
+
+/************************************************************************/
+/*                      ThreadDecompressionFunc()                       */
+/************************************************************************/
+
+void GTiffDataset::ThreadDecompressionFunc( void* pData )
+
+{
+    GTiffDecompressionJob* psJob = (GTiffDecompressionJob*) pData;
+    GTiffDataset* poDS = psJob->poDS;
+
+    /* Errors are collected in the job, so that the calling thread */
+    /* reports them */
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+    CPLErrorReset();
+
+    TIFF* hTIFFHandle = poDS->AcquireDecompressionHandle();
+    if( hTIFFHandle == NULL )
+    {
+        psJob->nErrNo = CPLE_OpenFailed;
+        psJob->pszErrMsg = CPLStrdup(
+            CPLSPrintf( "Cannot open %s for decompression of block %d",
+                        poDS->osDecompressionFilename.c_str(),
+                        psJob->nBlockId ) );
+    }
+    else
+    {
+        GByte* pabyDst = psJob->pabyBuffer != NULL ? psJob->pabyBuffer :
+                                                     psJob->papabyDstBlock[0];
+        if( psJob->nBlockReqSize < psJob->nBlockBufSize )
+            memset( pabyDst, 0, psJob->nBlockBufSize );
+
+        int nRet;
+        if( TIFFIsTiled( hTIFFHandle ) )
+            nRet = (int) TIFFReadEncodedTile( hTIFFHandle, psJob->nBlockId,
+                                              pabyDst, psJob->nBlockReqSize );
+        else
+            nRet = (int) TIFFReadEncodedStrip( hTIFFHandle, psJob->nBlockId,
+                                               pabyDst, psJob->nBlockReqSize );
+        psJob->bSuccess = (nRet != -1);
+        if( !psJob->bSuccess )
+        {
+            psJob->nErrNo = CPLGetLastErrorNo();
+            if( strlen(CPLGetLastErrorMsg()) > 0 )
+                psJob->pszErrMsg = CPLStrdup( CPLGetLastErrorMsg() );
+            else
+                psJob->pszErrMsg = CPLStrdup(
+                    CPLSPrintf( "Decompression of block %d failed",
+                                psJob->nBlockId ) );
+        }
+
+        poDS->ReleaseDecompressionHandle( hTIFFHandle );
+    }
+
+    CPLPopErrorHandler();
+
+/* -------------------------------------------------------------------- */
+/*      Dispatch a pixel interleaved block in the blocks of each band.  */
+/* -------------------------------------------------------------------- */
+    if( psJob->bSuccess && psJob->pabyBuffer != NULL )
+    {
+        GDALDataType eDT = poDS->GetRasterBand(1)->GetRasterDataType();
+        int nWordBytes = poDS->nBitsPerSample / 8;
+        int nBlockPixels = poDS->nBlockXSize * poDS->nBlockYSize;
+
+        for( int iBand = 0; iBand < psJob->nDstBlockCount; iBand++ )
+        {
+            GDALCopyWords( psJob->pabyBuffer + iBand * nWordBytes, eDT,
+                           nWordBytes * psJob->nDstBlockCount,
+                           psJob->papabyDstBlock[iBand], eDT, nWordBytes,
+                           nBlockPixels );
+        }
+    }
+}
+
+/************************************************************************/
+/*                      FinishDecompressionJob()                        */
+/*                                                                      */
+/*      Unlock the cached blocks of a job. Blocks that could not be     */
+/*      decoded are removed from the cache, so that they do not get     */
+/*      used with a garbage content.                                    */
+/************************************************************************/
+
+static void FinishDecompressionJob( GTiffDecompressionJob* psJob )
+
+{
+    for( int i = 0; i < psJob->nDstBlockCount; i++ )
+    {
+        GDALRasterBlock* poBlock = psJob->papoBlocks[i];
+        if( poBlock == NULL )
+            continue;
+
+        GDALRasterBand* poBand = poBlock->GetBand();
+        int nXBlockOff = poBlock->GetXOff();
+        int nYBlockOff = poBlock->GetYOff();
+
+        poBlock->DropLock();
+        if( !psJob->bSuccess )
+            poBand->FlushBlock( nXBlockOff, nYBlockOff, FALSE );
+    }
+
+    CPLFree( psJob->papoBlocks );
+    CPLFree( psJob->papabyDstBlock );
+    VSIFree( psJob->pabyBuffer );
+    CPLFree( psJob->pszErrMsg );
+}
+
+/************************************************************************/
+/*                      CacheBlocksMultiThreaded()                      */
+/*                                                                      */
+/*      Decode in the block cache, with the worker threads, the blocks  */
+/*      of the passed range that are not cached yet. The first          */
+/*      decoding error is emitted again from the calling thread.        */
+/************************************************************************/
+
+CPLErr GTiffDataset::CacheBlocksMultiThreaded( int nBlockX1, int nBlockY1,
+                                               int nBlockX2, int nBlockY2,
+                                               int nBandCount, int *panBandMap )
+
+{
+    if( !SetDirectory() )
+        return CE_Failure;
+
+    int bPixelInterleaved = ( nPlanarConfig == PLANARCONFIG_CONTIG &&
+                              nBands > 1 );
+    int nBlockBufSize = TIFFIsTiled( hTIFF ) ? TIFFTileSize( hTIFF ) :
+                                               TIFFStripSize( hTIFF );
+    int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+
+    /* All the bands are decoded at once from a pixel interleaved block */
+    int nJobsPerBlock = bPixelInterleaved ? 1 : nBandCount;
+    int nDstBlockCount = bPixelInterleaved ? nBands : 1;
+
+    std::vector<GTiffDecompressionJob> asJobs;
+
+    for( int nBlockYOff = nBlockY1; nBlockYOff <= nBlockY2; nBlockYOff++ )
+    {
+        for( int nBlockXOff = nBlockX1; nBlockXOff <= nBlockX2; nBlockXOff++ )
+        {
+            for( int iJob = 0; iJob < nJobsPerBlock; iJob++ )
+            {
+                int nBlockId = nBlockXOff + nBlockYOff * nBlocksPerRow;
+                int nFirstBand = bPixelInterleaved ? 1 : panBandMap[iJob];
+                if( nPlanarConfig == PLANARCONFIG_SEPARATE )
+                    nBlockId += (nFirstBand - 1) * nBlocksPerBand;
+
+/* -------------------------------------------------------------------- */
+/*      Skip blocks already cached, and missing blocks that are         */
+/*      quickly zero filled by IReadBlock().                            */
+/* -------------------------------------------------------------------- */
+                int bCached = FALSE;
+                for( int i = 0; i < nDstBlockCount && !bCached; i++ )
+                {
+                    GTiffRasterBand* poBand = (GTiffRasterBand*)
+                        GetRasterBand(nFirstBand + i);
+                    GDALRasterBlock* poBlock =
+                        poBand->TryGetLockedBlockRef( nBlockXOff, nBlockYOff );
+                    if( poBlock != NULL )
+                    {
+                        poBlock->DropLock();
+                        bCached = TRUE;
+                    }
+                }
+                if( bCached || !IsBlockAvailable(nBlockId) )
+                    continue;
+
+                GTiffDecompressionJob sJob;
+                memset( &sJob, 0, sizeof(sJob) );
+                sJob.poDS = this;
+                sJob.nBlockId = nBlockId;
+                sJob.nBlockBufSize = nBlockBufSize;
+
+                /* See IReadBlock() regarding partially encoded blocks */
+                sJob.nBlockReqSize = nBlockBufSize;
+                if( (nBlockYOff+1) * (int)nBlockYSize > nRasterYSize )
+                    sJob.nBlockReqSize = (nBlockBufSize / nBlockYSize)
+                        * (nBlockYSize - (((nBlockYOff+1) * nBlockYSize)
+                                          % nRasterYSize));
+
+                sJob.nDstBlockCount = nDstBlockCount;
+                sJob.papoBlocks = (GDALRasterBlock**)
+                    CPLCalloc( nDstBlockCount, sizeof(GDALRasterBlock*) );
+                sJob.papabyDstBlock = (GByte**)
+                    CPLCalloc( nDstBlockCount, sizeof(GByte*) );
+
+                int bOK = TRUE;
+                for( int i = 0; i < nDstBlockCount && bOK; i++ )
+                {
+                    GDALRasterBlock* poBlock =
+                        GetRasterBand(nFirstBand + i)->GetLockedBlockRef(
+                                            nBlockXOff, nBlockYOff, TRUE );
+                    if( poBlock == NULL )
+                        bOK = FALSE;
+                    else
+                    {
+                        sJob.papoBlocks[i] = poBlock;
+                        sJob.papabyDstBlock[i] = (GByte*) poBlock->GetDataRef();
+                    }
+                }
+                if( bOK && bPixelInterleaved )
+                {
+                    sJob.pabyBuffer = (GByte*) VSIMalloc( nBlockBufSize );
+                    bOK = ( sJob.pabyBuffer != NULL );
+                }
+                if( !bOK )
+                {
+                    FinishDecompressionJob( &sJob );
+                    continue;
+                }
+
+                asJobs.push_back( sJob );
+            }
+        }
+    }
+
+    /* The pool may have more threads than requested by another user: */
+    /* do not have more than NUM_THREADS jobs (and handles) in flight */
+    int nPendingJobs = 0;
+    for( size_t i = 0; i < asJobs.size(); i++ )
+    {
+        poDecompressThreadPool->WaitGroupCompletion( &nPendingJobs, -1.0,
+                                                     nDecompressThreads - 1 );
+        if( !poDecompressThreadPool->SubmitJob( ThreadDecompressionFunc,
+                                                &asJobs[i], &nPendingJobs ) )
+            ThreadDecompressionFunc( &asJobs[i] );
+    }
+    poDecompressThreadPool->WaitGroupCompletion( &nPendingJobs );
+
+    CPLErr eErr = CE_None;
+    for( size_t i = 0; i < asJobs.size(); i++ )
+    {
+        if( !asJobs[i].bSuccess && eErr == CE_None )
+        {
+            CPLError( CE_Failure, asJobs[i].nErrNo, "%s",
+                      asJobs[i].pszErrMsg );
+            eErr = CE_Failure;
+        }
+        FinishDecompressionJob( &asJobs[i] );
+    }
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                         MultiThreadedRead()                          */
+/*                                                                      */
+/*      Decode the blocks intersecting a read request with the worker   */
+/*      threads before the generic RasterIO() implementation fetches    */
+/*      them from the block cache. Requests larger than the cache are   */
+/*      processed by chunks of block rows, so that decoded blocks are   */
+/*      not evicted before being used.                                  */
+/*                                                                      */
+/*      Returns -1 if the generic implementation must still be run by   */
+/*      the caller, or a CPLErr otherwise.                              */
+/************************************************************************/
+
+int GTiffDataset::MultiThreadedRead( GTiffRasterBand* poBand,
+                                     int nXOff, int nYOff,
+                                     int nXSize, int nYSize,
+                                     void * pData, int nBufXSize, int nBufYSize,
+                                     GDALDataType eBufType,
+                                     int nBandCount, int *panBandMap,
+                                     GSpacing nPixelSpace, GSpacing nLineSpace,
+                                     GSpacing nBandSpace,
+                                     GDALRasterIOExtraArg* psExtraArg )
+
+{
+    if( !CanUseDecompressionThreads() )
+        return -1;
+
+    int nBlockX1 = nXOff / nBlockXSize;
+    int nBlockY1 = nYOff / nBlockYSize;
+    int nBlockX2 = (nXOff + nXSize - 1) / nBlockXSize;
+    int nBlockY2 = (nYOff + nYSize - 1) / nBlockYSize;
+    if( nBlockX1 == nBlockX2 && nBlockY1 == nBlockY2 )
+        return -1;
+
+/* -------------------------------------------------------------------- */
+/*      How many rows of blocks can stay in a quarter of the cache ?    */
+/* -------------------------------------------------------------------- */
+    int nDecodedBands = ( nPlanarConfig == PLANARCONFIG_CONTIG ) ? nBands :
+                                                                   nBandCount;
+    GIntBig nBlockRowBytes = (GIntBig) nDecodedBands *
+        (nBlockX2 - nBlockX1 + 1) * nBlockXSize * nBlockYSize *
+        (GDALGetDataTypeSize(GetRasterBand(1)->GetRasterDataType()) / 8);
+    GIntBig nMaxBytes = GDALGetCacheMax64() / 4;
+    if( nBlockRowBytes > nMaxBytes )
+    {
+        CPLDebug( "GTiff", "Cache too small for multi-threaded decoding of "
+                  "the request" );
+        return -1;
+    }
+    int nChunkBlockRows = (int) MIN( nMaxBytes / nBlockRowBytes,
+                                     nBlockY2 - nBlockY1 + 1 );
+
+    if( nChunkBlockRows == nBlockY2 - nBlockY1 + 1 )
+    {
+        if( CacheBlocksMultiThreaded( nBlockX1, nBlockY1, nBlockX2, nBlockY2,
+                                      nBandCount, panBandMap ) != CE_None )
+            return CE_Failure;
+        return -1;
+    }
+
+    /* Splitting a resampled request would change its result */
+    if( nXSize != nBufXSize || nYSize != nBufYSize )
+        return -1;
+
+    CPLErr eErr = CE_None;
+    for( int nChunkY1 = nBlockY1;
+         eErr == CE_None && nChunkY1 <= nBlockY2;
+         nChunkY1 += nChunkBlockRows )
+    {
+        int nChunkY2 = MIN( nChunkY1 + nChunkBlockRows - 1, nBlockY2 );
+        eErr = CacheBlocksMultiThreaded( nBlockX1, nChunkY1, nBlockX2, nChunkY2,
+                                         nBandCount, panBandMap );
+        if( eErr != CE_None )
+            break;
+
+        int nChunkYOff = MAX( nYOff, nChunkY1 * (int)nBlockYSize );
+        int nChunkYSize = MIN( nYOff + nYSize,
+                               (nChunkY2 + 1) * (int)nBlockYSize ) - nChunkYOff;
+        GByte* pabyChunkData = (GByte*) pData + (nChunkYOff - nYOff) * nLineSpace;
+
+        GDALRasterIOExtraArg sExtraArg;
+        GDALCopyRasterIOExtraArg( &sExtraArg, psExtraArg );
+        sExtraArg.pfnProgress = GDALScaledProgress;
+        sExtraArg.pProgressData = GDALCreateScaledProgress(
+            (double)(nChunkYOff - nYOff) / nYSize,
+            (double)(nChunkYOff + nChunkYSize - nYOff) / nYSize,
+            psExtraArg->pfnProgress, psExtraArg->pProgressData );
+
+        if( poBand != NULL )
+            eErr = poBand->GDALPamRasterBand::IRasterIO(
+                GF_Read, nXOff, nChunkYOff, nXSize, nChunkYSize,
+                pabyChunkData, nXSize, nChunkYSize, eBufType,
+                nPixelSpace, nLineSpace, &sExtraArg );
+        else
+            eErr = GDALPamDataset::IRasterIO(
+                GF_Read, nXOff, nChunkYOff, nXSize, nChunkYSize,
+                pabyChunkData, nXSize, nChunkYSize, eBufType,
+                nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace,
+                &sExtraArg );
+
+        GDALDestroyScaledProgress( sExtraArg.pProgressData );
+    }
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                           FlushBlockBuf()                            */
 /************************************************************************/
@@ -5975,6 +6945,8 @@ void GTiffCacheOffsetOrCount(VSILFILE* fp,
 int GTiffDataset::IsBlockAvailable( int nBlockId )
 
 {
+    WaitCompletionForBlock( nBlockId );
+
 #ifdef INTERNAL_LIBTIFF
 
     /* Optimization to avoid fetching the whole Strip/TileCounts and Strip/TileOffsets arrays */
@@ -6102,6 +7074,8 @@ void GTiffDataset::FlushCache()
     nLoadedBlock = -1;
     bLoadedBlockDirty = FALSE;
 
+    FlushCompressionJobs();
+
     if (!SetDirectory())
         return;
     FlushDirectory();
@@ -8387,6 +9361,8 @@ GDALDataset *GTiffDataset::Open( GDALOpenInfo * poOpenInfo )
     poDS->fpL = poOpenInfo->fpL;
     poOpenInfo->fpL = NULL;
     poDS->bStreamingIn = bStreaming;
+    poDS->nDecompressThreads =
+        GTiffGetThreadCount( poOpenInfo->papszOpenOptions );
 
     if( poDS->OpenOffset( hTIFF, &(poDS->poActiveDS),
                           TIFFCurrentDirOffset(hTIFF), TRUE,
@@ -8898,6 +9874,8 @@ GDALDataset *GTiffDataset::OpenDir( GDALOpenInfo * poOpenInfo )
     poDS->osFilename = poOpenInfo->pszFilename;
     poDS->poActiveDS = poDS;
     poDS->fpL = fpL;
+    poDS->nDecompressThreads =
+        GTiffGetThreadCount( poOpenInfo->papszOpenOptions );
 
     if( !EQUAL(pszFilename,poOpenInfo->pszFilename) 
         && !EQUALN(poOpenInfo->pszFilename,"GTIFF_RAW:",10) )
@@ -10135,6 +11113,7 @@ void GTiffDataset::ScanDirectories()
                                nOverviewCount * (sizeof(void*)));
                 papoOverviewDS[nOverviewCount-1] = poODS;
                 poODS->poBaseDS = this;
+                poODS->nDecompressThreads = nDecompressThreads;
             }
         }
             
@@ -10169,6 +11148,7 @@ void GTiffDataset::ScanDirectories()
             {
                 CPLDebug( "GTiff", "Opened band mask.\n");
                 poMaskDS->poBaseDS = this;
+                poMaskDS->nDecompressThreads = nDecompressThreads;
                     
                 poMaskDS->bPromoteTo8Bits = CSLTestBoolean(CPLGetConfigOption("GDAL_TIFF_INTERNAL_MASK_TO_8BIT", "YES"));
             }
@@ -10202,6 +11182,7 @@ void GTiffDataset::ScanDirectories()
                         ((GTiffDataset*)papoOverviewDS[i])->poMaskDS = poDS;
                         poDS->bPromoteTo8Bits = CSLTestBoolean(CPLGetConfigOption("GDAL_TIFF_INTERNAL_MASK_TO_8BIT", "YES"));
                         poDS->poBaseDS = this;
+                        poDS->nDecompressThreads = nDecompressThreads;
                         break;
                     }
                 }
@@ -11460,6 +12441,7 @@ GDALDataset *GTiffDataset::Create( const char * pszFilename,
     }
 
     poDS->GetDiscardLsbOption(papszParmList);
+    poDS->InitCompressionThreads(papszParmList);
 
     if( poDS->nPlanarConfig == PLANARCONFIG_CONTIG && nBands != 1 )
         poDS->SetMetadataItem( "INTERLEAVE", "PIXEL", "IMAGE_STRUCTURE" );
@@ -12293,6 +13275,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
     poDS->nJpegQuality = GTiffGetJpegQuality(papszOptions);
     poDS->nJpegTablesMode = GTiffGetJpegTablesMode(papszOptions);
     poDS->GetDiscardLsbOption(papszOptions);
+    poDS->InitCompressionThreads(papszOptions);
 
     if (nCompression == COMPRESSION_ADOBE_DEFLATE)
     {
@@ -13756,6 +14739,7 @@ void GDALRegister_GTiff()
 "   <Option name='TIFFTAG_TRANSFERRANGE_BLACK' type='string' description='Transfer range for black'/>"
 "   <Option name='TIFFTAG_TRANSFERRANGE_WHITE' type='string' description='Transfer range for white'/>"
 "   <Option name='STREAMABLE_OUTPUT' type='boolean' default='NO' description='Enforce a mode compatible with a streamable file'/>"
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
 "</CreationOptionList>" );
                  
 /* -------------------------------------------------------------------- */
@@ -13772,6 +14756,10 @@ void GDALRegister_GTiff()
                                    "Float64 CInt16 CInt32 CFloat32 CFloat64" );
         poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST, 
                                    szCreateOptions );
+        poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST, 
+"<OpenOptionList>\n"
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for decompression. Can be set to ALL_CPUS' default='1'/>\n"
+"</OpenOptionList>\n" );
         poDriver->SetMetadataItem( GDAL_DMD_SUBDATASETS, "YES" );
         poDriver->SetMetadataItem( GDAL_DCAP_VIRTUALIO, "YES" );
 
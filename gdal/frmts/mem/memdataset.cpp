@@ -187,6 +187,39 @@ CPLErr MEMRasterBand::IWriteBlock( CPL_UNUSED int nBlockXOff,
     return CE_None;
 }
 
+/************************************************************************/
+/*                            BorrowBlock()                             */
+/*                                                                      */
+/*      Return a pointer to the scanline in our own buffer, unless a    */
+/*      (possibly dirty) copy of it is in the block cache.              */
+/************************************************************************/
+
+const void *MEMRasterBand::BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                        GSpacing *pnPixelSpace,
+                                        GSpacing *pnLineSpace,
+                                        void **ppBorrowHandle )
+{
+    GDALRasterBlock *poBlock = NULL;
+
+    if( nXBlockOff != 0 || nYBlockOff < 0 || nYBlockOff >= nRasterYSize
+        || (poBlock = TryGetLockedBlockRef( nXBlockOff, nYBlockOff )) != NULL )
+    {
+        if( poBlock != NULL )
+            poBlock->DropLock();
+        return GDALRasterBand::BorrowBlock( nXBlockOff, nYBlockOff,
+                                            pnPixelSpace, pnLineSpace,
+                                            ppBorrowHandle );
+    }
+
+    if( pnPixelSpace )
+        *pnPixelSpace = nPixelOffset;
+    if( pnLineSpace )
+        *pnLineSpace = nLineOffset;
+    *ppBorrowHandle = NULL;
+
+    return pabyData + nLineOffset * (size_t)nYBlockOff;
+}
+
 /************************************************************************/
 /*                             IRasterIO()                              */
 /************************************************************************/
@@ -138,6 +138,10 @@ class CPL_DLL MEMRasterBand : public GDALPamRasterBand
                                   GSpacing nPixelSpaceBuf,
                                   GSpacing nLineSpaceBuf,
                                   GDALRasterIOExtraArg* psExtraArg );
+    virtual const void *BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                     GSpacing *pnPixelSpace,
+                                     GSpacing *pnLineSpace,
+                                     void **ppBorrowHandle );
     virtual double GetNoDataValue( int *pbSuccess = NULL );
     virtual CPLErr SetNoDataValue( double );
 
@@ -139,6 +139,11 @@ class EHdrRasterBand : public RawRasterBand
     virtual CPLErr IReadBlock( int, int, void * );
     virtual CPLErr IWriteBlock( int, int, void * );
 
+    virtual const void *BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                     GSpacing *pnPixelSpace,
+                                     GSpacing *pnLineSpace,
+                                     void **ppBorrowHandle );
+
     virtual double GetNoDataValue( int *pbSuccess = NULL );
     virtual double GetMinimum( int *pbSuccess = NULL );
     virtual double GetMaximum(int *pbSuccess = NULL );
@@ -379,6 +384,29 @@ CPLErr EHdrRasterBand::IRasterIO( GDALRWFlag eRWFlag,
                                           eBufType, nPixelSpace, nLineSpace, psExtraArg );
 }
 
+/************************************************************************/
+/*                            BorrowBlock()                             */
+/************************************************************************/
+
+const void *EHdrRasterBand::BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                         GSpacing *pnPixelSpace,
+                                         GSpacing *pnLineSpace,
+                                         void **ppBorrowHandle )
+
+{
+    // Defer to RawRasterBand
+    if (nBits >= 8)
+        return RawRasterBand::BorrowBlock( nXBlockOff, nYBlockOff,
+                                           pnPixelSpace, pnLineSpace,
+                                           ppBorrowHandle );
+
+    // Sub-byte pixels are unpacked by IReadBlock()
+    else
+        return GDALRasterBand::BorrowBlock( nXBlockOff, nYBlockOff,
+                                            pnPixelSpace, pnLineSpace,
+                                            ppBorrowHandle );
+}
+
 /************************************************************************/
 /*                              OSR_GDS()                               */
 /************************************************************************/
@@ -155,6 +155,9 @@ void RawRasterBand::Initialize()
 
     bDirty = FALSE;
 
+    psBorrowVMem = NULL;
+    bBorrowVMemTried = FALSE;
+
 /* -------------------------------------------------------------------- */
 /*      Allocate working scanline.                                      */
 /* -------------------------------------------------------------------- */
@@ -195,6 +198,9 @@ RawRasterBand::~RawRasterBand()
     CSLDestroy( papszCategoryNames );
 
     FlushCache();
+
+    if( psBorrowVMem != NULL )
+        CPLVirtualMemFree( psBorrowVMem );
     
     if (bOwnsFP)
     {
@@ -704,12 +710,25 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
                                   + ((vsi_l_offset)nYOff
                                   + (vsi_l_offset)(iLine * dfSrcYInc)) * nLineOffset
                                   + nXOff * nPixelOffset;
-                if ( AccessBlock( nOffset,
-                                  nBytesToRW, pabyData ) != CE_None )
+
+/* -------------------------------------------------------------------- */
+/*      If the file is memory mapped and no byte swapping is needed,    */
+/*      copy directly from the mapping instead of reading the line.     */
+/* -------------------------------------------------------------------- */
+                const GByte *pabySrc = NULL;
+                if( bIsVSIL && (bNativeOrder || eDataType == GDT_Byte) )
+                    pabySrc = (const GByte *)
+                        VSIFGetMappedAddressL( fpRawL, nOffset, nBytesToRW );
+                if( pabySrc == NULL )
                 {
-                    CPLError( CE_Failure, CPLE_FileIO,
-                              "Failed to read %d bytes at " CPL_FRMT_GUIB ".",
-                              nBytesToRW, nOffset );
+                    if ( AccessBlock( nOffset,
+                                      nBytesToRW, pabyData ) != CE_None )
+                    {
+                        CPLError( CE_Failure, CPLE_FileIO,
+                                  "Failed to read %d bytes at " CPL_FRMT_GUIB ".",
+                                  nBytesToRW, nOffset );
+                    }
+                    pabySrc = pabyData;
                 }
 
 /* -------------------------------------------------------------------- */
@@ -718,7 +737,7 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 /* -------------------------------------------------------------------- */
                 if ( nXSize == nBufXSize && nYSize == nBufYSize )
                 {
-                    GDALCopyWords( pabyData, eDataType, nPixelOffset,
+                    GDALCopyWords( (void *) pabySrc, eDataType, nPixelOffset,
                                    (GByte *)pData + (vsi_l_offset)iLine * nLineSpace,
                                    eBufType, nPixelSpace, nXSize );
                 }
@@ -728,8 +747,8 @@ CPLErr RawRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 
                     for ( iPixel = 0; iPixel < nBufXSize; iPixel++ )
                     {
-                        GDALCopyWords( pabyData +
-                                       (vsi_l_offset)(iPixel * dfSrcXInc) * nPixelOffset,
+                        GDALCopyWords( (void *) (pabySrc +
+                                       (vsi_l_offset)(iPixel * dfSrcXInc) * nPixelOffset),
                                        eDataType, nPixelOffset,
                                        (GByte *)pData + (vsi_l_offset)iLine * nLineSpace +
                                        (vsi_l_offset)iPixel * nPixelSpace,
@@ -1130,6 +1149,70 @@ CPLVirtualMem  *RawRasterBand::GetVirtualMemAuto( GDALRWFlag eRWFlag,
     }
 }
 
+/************************************************************************/
+/*                            BorrowBlock()                             */
+/*                                                                      */
+/*      If GDAL_RAW_BORROW_MMAP=YES, for read-only bands of a real     */
+/*      file in native byte order, the file is mapped into memory on   */
+/*      the first call, and the blocks (scanlines) are returned        */
+/*      directly from that mapping.                                    */
+/************************************************************************/
+
+const void *RawRasterBand::BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                        GSpacing *pnPixelSpace,
+                                        GSpacing *pnLineSpace,
+                                        void **ppBorrowHandle )
+{
+    if( !bBorrowVMemTried && eAccess == GA_ReadOnly )
+    {
+        bBorrowVMemTried = TRUE;
+
+        if( bIsVSIL && VSIFGetNativeFileDescriptorL(fpRawL) != NULL &&
+            CPLIsVirtualMemFileMapAvailable() &&
+            (eDataType == GDT_Byte || bNativeOrder) &&
+            nPixelOffset >= 0 && nLineOffset >= 0 &&
+            CSLTestBoolean(CPLGetConfigOption("GDAL_RAW_BORROW_MMAP", "NO")) )
+        {
+            vsi_l_offset nSize =
+                (vsi_l_offset)(nRasterYSize - 1) * nLineOffset +
+                (vsi_l_offset)(nRasterXSize - 1) * nPixelOffset +
+                GDALGetDataTypeSize(eDataType) / 8;
+
+            if( (size_t)nSize == nSize )
+            {
+                CPLPushErrorHandler( CPLQuietErrorHandler );
+                psBorrowVMem = CPLVirtualMemFileMapNew( fpRawL, nImgOffset,
+                                                        nSize,
+                                                        VIRTUALMEM_READONLY,
+                                                        NULL, NULL );
+                CPLPopErrorHandler();
+            }
+        }
+    }
+
+    GDALRasterBlock *poBlock = NULL;
+
+    if( psBorrowVMem == NULL || nXBlockOff != 0 ||
+        nYBlockOff < 0 || nYBlockOff >= nRasterYSize ||
+        (poBlock = TryGetLockedBlockRef( nXBlockOff, nYBlockOff )) != NULL )
+    {
+        if( poBlock != NULL )
+            poBlock->DropLock();
+        return GDALRasterBand::BorrowBlock( nXBlockOff, nYBlockOff,
+                                            pnPixelSpace, pnLineSpace,
+                                            ppBorrowHandle );
+    }
+
+    if( pnPixelSpace )
+        *pnPixelSpace = nPixelOffset;
+    if( pnLineSpace )
+        *pnLineSpace = nLineOffset;
+    *ppBorrowHandle = NULL;
+
+    return (GByte *) CPLVirtualMemGetAddr( psBorrowVMem )
+        + (size_t)nLineOffset * nYBlockOff;
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*      RawDataset                                                      */
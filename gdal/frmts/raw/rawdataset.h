@@ -100,6 +100,9 @@ protected:
     
     int         bOwnsFP;
 
+    CPLVirtualMem *psBorrowVMem;
+    int         bBorrowVMemTried;
+
     int         Seek( vsi_l_offset, int );
     size_t      Read( void *, size_t, size_t );
     size_t      Write( void *, size_t, size_t );
@@ -153,6 +156,11 @@ public:
                                                GIntBig *pnLineSpace,
                                                char **papszOptions );
 
+    virtual const void *BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                     GSpacing *pnPixelSpace,
+                                     GSpacing *pnLineSpace,
+                                     void **ppBorrowHandle );
+
     CPLErr          AccessLine( int iLine );
 
     void            SetAccess( GDALAccess eAccess );
@@ -1043,7 +1043,9 @@ CPLErr VRTWarpedDataset::XMLInit( CPLXMLNode *psTree, const char *pszVRTPath )
 
 /* -------------------------------------------------------------------- */
 /*      Adjust the SourceDataset in the warp options to take into       */
-/*      account that it is relative to the VRT if appropriate.          */
+/*      account that it is relative to the VRT if appropriate.  This    */
+/*      is done on a copy, as the passed tree may be read-only (see     */
+/*      CPLParseXMLStringArena()).                                      */
 /* -------------------------------------------------------------------- */
     int bRelativeToVRT = 
         atoi(CPLGetXMLValue(psOptionsTree,
@@ -1060,6 +1062,12 @@ CPLErr VRTWarpedDataset::XMLInit( CPLXMLNode *psTree, const char *pszVRTPath )
     else
         pszAbsolutePath = CPLStrdup(pszRelativePath);
 
+    psOptionsTree = CPLCloneXMLTree( psOptionsTree->psChild );
+    CPLXMLNode *psOptionsCopy =
+        CPLCreateXMLNode( NULL, CXT_Element, "GDALWarpOptions" );
+    psOptionsCopy->psChild = psOptionsTree;
+    psOptionsTree = psOptionsCopy;
+
     CPLSetXMLValue( psOptionsTree, "SourceDataset", pszAbsolutePath );
     CPLFree( pszAbsolutePath );
 
@@ -1070,6 +1078,7 @@ CPLErr VRTWarpedDataset::XMLInit( CPLXMLNode *psTree, const char *pszVRTPath )
     GDALWarpOptions *psWO;
 
     psWO = GDALDeserializeWarpOptions( psOptionsTree );
+    CPLDestroyXMLNode( psOptionsTree );
     if( psWO == NULL )
         return CE_Failure;
 
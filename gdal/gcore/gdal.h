@@ -152,9 +152,16 @@ typedef struct
     double                 dfXSize;
     /*! Height in pixels of the area of interest. Only valid if bFloatingPointWindowValidity = TRUE */
     double                 dfYSize;
+
+    /*! Hint that the request is part of a sequential scan of the raster
+        (e.g. whole raster copy). The blocks it reads are then not promoted
+        in the block cache when GDAL_RB_CACHE_POLICY=2Q, so that the scan
+        does not evict frequently used blocks. Only read if nVersion >= 2.
+        @since GDAL 2.0 */
+    int                    bSequentialScan;
 } GDALRasterIOExtraArg;
 
-#define RASTERIO_EXTRA_ARG_CURRENT_VERSION  1
+#define RASTERIO_EXTRA_ARG_CURRENT_VERSION  2
 
 /** Macro to initialize an instance of GDALRasterIOExtraArg structure.
   * @since GDAL 2.0
@@ -164,7 +171,8 @@ typedef struct
          (s).eResampleAlg = GRIORA_NearestNeighbour; \
          (s).pfnProgress = NULL; \
          (s).pProgressData = NULL; \
-         (s).bFloatingPointWindowValidity = FALSE; } while(0)
+         (s).bFloatingPointWindowValidity = FALSE; \
+         (s).bSequentialScan = FALSE; } while(0)
 
 /*! Types of color interpretation for raster bands. */
 typedef enum
@@ -655,6 +663,12 @@ GDALRasterIOEx( GDALRasterBandH hRBand, GDALRWFlag eRWFlag,
               GDALRasterIOExtraArg* psExtraArg );
 CPLErr CPL_DLL CPL_STDCALL GDALReadBlock( GDALRasterBandH, int, int, void * );
 CPLErr CPL_DLL CPL_STDCALL GDALWriteBlock( GDALRasterBandH, int, int, void * );
+const void CPL_DLL * CPL_STDCALL
+GDALBorrowBlock( GDALRasterBandH hBand, int nXBlockOff, int nYBlockOff,
+                 GSpacing *pnPixelSpace, GSpacing *pnLineSpace,
+                 void **ppBorrowHandle );
+void CPL_DLL CPL_STDCALL GDALReleaseBorrowedBlock( GDALRasterBandH hBand,
+                                                   void *pBorrowHandle );
 int CPL_DLL CPL_STDCALL GDALGetRasterBandXSize( GDALRasterBandH );
 int CPL_DLL CPL_STDCALL GDALGetRasterBandYSize( GDALRasterBandH );
 GDALAccess CPL_DLL CPL_STDCALL GDALGetRasterAccess( GDALRasterBandH );
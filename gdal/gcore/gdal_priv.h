@@ -44,6 +44,7 @@ class GDALRasterAttributeTable;
 class GDALProxyDataset;
 class GDALProxyRasterBand;
 class GDALAsyncReader;
+class GDALBlockPrefetcher;
 
 /* -------------------------------------------------------------------- */
 /*      Pull in the public declarations.  This gets the C apis, and     */
@@ -419,6 +420,14 @@ class CPL_DLL GDALDataset : public GDALMajorObject
 
 private:
     CPLMutex        *m_hMutex;
+    GDALBlockPrefetcher *m_poPrefetcher;
+
+    void            PrefetchBlocks( int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    int nBandCount, int *panBandMap,
+                                    char **papszOptions );
+
+    friend class GDALDefaultAsyncReader;
 
     OGRLayer*       BuildLayerFromSelectInfo(void* psSelectInfo,
                                              OGRGeometry *poSpatialFilter,
@@ -485,6 +494,8 @@ private:
 
 //! A single raster block in the block cache.
 
+struct GDALRBCacheShard;
+
 class CPL_DLL GDALRasterBlock
 {
     GDALDataType        eType;
@@ -506,10 +517,13 @@ class CPL_DLL GDALRasterBlock
     GDALRasterBlock     *poPrevious;
     
     int                  bMustDetach;
+    int                  bProtected;
     
-    void        Touch_unlocked( void );
+    void        Touch_unlocked( int bHit = FALSE );
     void        Detach_unlocked( void );
 
+    static GDALRasterBlock *GetFlushCandidate_unlocked( GDALRBCacheShard* );
+
   public:
                 GDALRasterBlock( GDALRasterBand *, int, int );
     virtual     ~GDALRasterBlock();
@@ -543,6 +557,12 @@ class CPL_DLL GDALRasterBlock
     static void Verify();
 
     static int  SafeLockBlock( GDALRasterBlock ** );
+
+    static int  SetSequentialScanHint( int bSequentialScan );
+    static int  GetSequentialScanHint();
+
+    static int  SetDirtyBlockFlushDisabled( int bDisabled );
+    static int  IsDirtyBlockFlushDisabled();
     
     /* Should only be called by GDALDestroyDriverManager() */
     static void DestroyRBMutex();
@@ -614,6 +634,13 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     int         nSubBlocksPerColumn;
     GDALRasterBlock **papoBlocks;
 
+    /* sparse (radix tree) block index, used for very big rasters */
+    int         bSparseBlockIndex;
+    int         nSparseLeafXBits;
+    int         nSparseLeafYBits;
+    int         nSparseLeavesPerRow;
+    int         nSparseRootSize;
+
     int         nBlockReads;
     int         bForceCachedIO;
 
@@ -626,6 +653,7 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     friend class GDALDataset;
     friend class GDALProxyRasterBand;
     friend class GDALDefaultOverviews;
+    friend class GDALBlockPrefetcher;
 
     CPLErr RasterIOResampled( GDALRWFlag, int, int, int, int,
                               void *, int, int, GDALDataType,
@@ -648,9 +676,13 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
                                      GSpacing, GSpacing, GDALRasterIOExtraArg* psExtraArg );
 
     int            InitBlockInfo();
+    GDALRasterBlock **GetSparseBlockSlot( int nXBlockOff, int nYBlockOff,
+                                          int bCreate );
 
     CPLErr         AdoptBlock( int, int, GDALRasterBlock * );
     GDALRasterBlock *TryGetLockedBlockRef( int nXBlockOff, int nYBlockYOff );
+    int              FetchPrefetchedBlock( int nXBlockOff, int nYBlockOff,
+                                          GDALRasterBlock *poBlock );
 
   public:
                 GDALRasterBand();
@@ -681,6 +713,12 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
                                         int bJustInitialize = FALSE );
     CPLErr      FlushBlock( int = -1, int = -1, int bWriteDirtyBlock = TRUE );
 
+    virtual const void *BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                     GSpacing *pnPixelSpace,
+                                     GSpacing *pnLineSpace,
+                                     void **ppBorrowHandle );
+    virtual void        ReleaseBorrowedBlock( void *pBorrowHandle );
+
     unsigned char*  GetIndexColorTranslationTo(/* const */ GDALRasterBand* poReferenceBand,
                                                unsigned char* pTranslationTable = NULL,
                                                int* pApproximateMatching = NULL);
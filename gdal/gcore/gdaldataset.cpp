@@ -29,6 +29,7 @@
  ****************************************************************************/
 
 #include "gdal_priv.h"
+#include "gdalprefetch_priv.h"
 #include "cpl_string.h"
 #include "cpl_hash_set.h"
 #include "cpl_multiproc.h"
@@ -188,6 +189,7 @@ GDALDataset::GDALDataset()
     
     m_poStyleTable = NULL;
     m_hMutex = NULL;
+    m_poPrefetcher = NULL;
 }
 
 
@@ -275,6 +277,11 @@ GDALDataset::~GDALDataset()
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      Stop prefetching.                                               */
+/* -------------------------------------------------------------------- */
+    delete m_poPrefetcher;
+
 /* -------------------------------------------------------------------- */
 /*      Destroy the raster bands if they exist.                         */
 /* -------------------------------------------------------------------- */
@@ -1719,7 +1726,8 @@ CPLErr GDALDataset::RasterIO( GDALRWFlag eRWFlag,
         INIT_RASTERIO_EXTRA_ARG(sExtraArg);
         psExtraArg = &sExtraArg;
     }
-    else if( psExtraArg->nVersion != RASTERIO_EXTRA_ARG_CURRENT_VERSION )
+    else if( psExtraArg->nVersion < 1 ||
+             psExtraArg->nVersion > RASTERIO_EXTRA_ARG_CURRENT_VERSION )
     {
         ReportError( CE_Failure, CPLE_AppDefined,
                      "Unhandled version of GDALRasterIOExtraArg" );
@@ -1789,6 +1797,12 @@ CPLErr GDALDataset::RasterIO( GDALRWFlag eRWFlag,
     }
 
 
+    int bOldSequentialScan = FALSE;
+    int bSequentialScan = psExtraArg->nVersion >= 2 &&
+                          psExtraArg->bSequentialScan;
+    if( bSequentialScan )
+        bOldSequentialScan = GDALRasterBlock::SetSequentialScanHint( TRUE );
+
 /* -------------------------------------------------------------------- */
 /*      We are being forced to use cached IO instead of a driver        */
 /*      specific implementation.                                        */
@@ -1819,6 +1833,9 @@ CPLErr GDALDataset::RasterIO( GDALRWFlag eRWFlag,
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
+    if( bSequentialScan )
+        GDALRasterBlock::SetSequentialScanHint( bOldSequentialScan );
+
     if( bNeedToFreeBandMap )
         CPLFree( panBandMap );
 
@@ -2023,6 +2040,19 @@ int CPL_STDCALL GDALGetAccess( GDALDatasetH hDS )
  * @param papszOptions a list of name=value strings with special control 
  * options.  Normally this is NULL.
  *
+ * Unless the driver has its own implementation, the blocks intersecting the
+ * region are read ahead of time by background threads when the region is to
+ * be read at full resolution, the dataset is opened in read-only mode, and
+ * the NUM_THREADS option is set to a number of threads, or ALL_CPUS. The
+ * threads are taken from a pool shared by the whole process (see
+ * CPLGetGlobalWorkerThreadPool()), but no more than NUM_THREADS blocks
+ * are read at once, each with one of up to NUM_THREADS handles on the
+ * dataset. Blocks that have not been requested yet are held outside of the
+ * block cache, so they use memory on top of GDAL_CACHEMAX: at most the
+ * number of megabytes set by the MAX_MEMORY option, or a quarter of the
+ * block cache size by default. Blocks from previous calls to AdviseRead()
+ * that are outside of the new region are discarded.
+ *
  * @return CE_Failure if the request is invalid and CE_None if it works or
  * is ignored. 
  */
@@ -2067,6 +2097,45 @@ CPLErr GDALDataset::AdviseRead( int nXOff, int nYOff, int nXSize, int nYSize,
     return CE_None;
 }
 
+/************************************************************************/
+/*                           PrefetchBlocks()                           */
+/*                                                                      */
+/*      Default AdviseRead() behaviour: let background threads read     */
+/*      the blocks of the region, if NUM_THREADS is set.                */
+/************************************************************************/
+
+void GDALDataset::PrefetchBlocks( int nXOff, int nYOff, int nXSize, int nYSize,
+                                  int nBandCount, int *panBandMap,
+                                  char **papszOptions )
+
+{
+    if( eAccess != GA_ReadOnly || poDriver == NULL ||
+        EQUAL(GetDescription(), "") ||
+        EQUAL(poDriver->GetDescription(), "MEM") )
+        return;
+
+    if( m_poPrefetcher == NULL )
+    {
+        int nThreads = GDALBlockPrefetcher::GetThreadCount( papszOptions );
+        if( nThreads <= 0 )
+            return;
+
+        m_poPrefetcher = new GDALBlockPrefetcher( this );
+        if( !m_poPrefetcher->Setup( nThreads,
+                        GDALBlockPrefetcher::GetMaxMemory( papszOptions ) ) )
+        {
+            delete m_poPrefetcher;
+            m_poPrefetcher = NULL;
+            return;
+        }
+        CPLDebug( "GDAL", "Using %d threads for prefetching blocks of %s",
+                  nThreads, GetDescription() );
+    }
+
+    m_poPrefetcher->Advise( this, nXOff, nYOff, nXSize, nYSize,
+                            nBandCount, panBandMap );
+}
+
 /************************************************************************/
 /*                       GDALDatasetAdviseRead()                        */
 /************************************************************************/
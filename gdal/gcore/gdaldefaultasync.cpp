@@ -29,6 +29,7 @@
  ****************************************************************************/
 
 #include "gdal_priv.h"
+#include "gdalprefetch_priv.h"
 
 CPL_CVSID("$Id: gdaldataset.cpp 16796 2009-04-17 23:35:04Z normanb $");
 
@@ -189,6 +190,8 @@ class GDALDefaultAsyncReader : public GDALAsyncReader
 {
   private:
     char **         papszOptions;
+    int             nNextYOff;     /* first source line not yet read */
+    int             nStripHeight;  /* source lines returned per update */
 
   public:
     GDALDefaultAsyncReader(GDALDataset* poDS,
@@ -269,11 +272,39 @@ GDALDefaultAsyncReader( GDALDataset* poDS,
             this->panBandMap[i] = i+1;
     }
     
+    if( nPixelSpace == 0 )
+        nPixelSpace = GDALGetDataTypeSize( eBufType ) / 8;
+    if( nLineSpace == 0 )
+        nLineSpace = nPixelSpace * nBufXSize;
+    if( nBandSpace == 0 )
+        nBandSpace = nLineSpace * nBufYSize;
+
     this->nPixelSpace = nPixelSpace;
     this->nLineSpace = nLineSpace;
     this->nBandSpace = nBandSpace;
 
     this->papszOptions = CSLDuplicate(papszOptions);
+
+    poDS->AdviseRead( nXOff, nYOff, nXSize, nYSize, nBufXSize, nBufYSize,
+                      eBufType, nBandCount, this->panBandMap, papszOptions );
+
+/* -------------------------------------------------------------------- */
+/*      When AdviseRead() has started prefetching threads, full         */
+/*      resolution requests are returned by strips of block rows, each  */
+/*      of them as soon as its blocks have been read.                   */
+/* -------------------------------------------------------------------- */
+    nNextYOff = nYOff;
+    nStripHeight = nYSize;
+    if( poDS->m_poPrefetcher != NULL &&
+        nBufXSize == nXSize && nBufYSize == nYSize && nBandCount > 0 )
+    {
+        int nBlockXSize, nBlockYSize;
+        poDS->GetRasterBand( this->panBandMap[0] )->GetBlockSize(
+                                                &nBlockXSize, &nBlockYSize );
+        nStripHeight = nBlockYSize;
+        while( nStripHeight < 32 )
+            nStripHeight += nBlockYSize;
+    }
 }
 
 /************************************************************************/
@@ -292,27 +323,60 @@ GDALDefaultAsyncReader::~GDALDefaultAsyncReader()
 /************************************************************************/
 
 GDALAsyncStatusType
-GDALDefaultAsyncReader::GetNextUpdatedRegion(CPL_UNUSED double dfTimeout,
+GDALDefaultAsyncReader::GetNextUpdatedRegion(double dfTimeout,
                                              int* pnBufXOff,
                                              int* pnBufYOff,
                                              int* pnBufXSize,
                                              int* pnBufYSize )
 {
+    *pnBufXOff = 0;
+    *pnBufYOff = 0;
+    *pnBufXSize = 0;
+    *pnBufYSize = 0;
+
+    if( nNextYOff == nYOff + nYSize )
+        return GARIO_COMPLETE;
+
+/* -------------------------------------------------------------------- */
+/*      The next strip ends on a block boundary.                        */
+/* -------------------------------------------------------------------- */
+    int nStripYSize = nYSize;
+    if( nStripHeight < nYSize )
+    {
+        nStripYSize = ((nNextYOff / nStripHeight) + 1) * nStripHeight
+            - nNextYOff;
+        if( nNextYOff + nStripYSize > nYOff + nYSize )
+            nStripYSize = nYOff + nYSize - nNextYOff;
+    }
+
+    if( poDS->m_poPrefetcher != NULL &&
+        !poDS->m_poPrefetcher->WaitForBlocks( poDS, nXOff, nNextYOff,
+                                              nXSize, nStripYSize,
+                                              nBandCount, panBandMap,
+                                              dfTimeout ) )
+        return GARIO_PENDING;
+
     CPLErr eErr;
+    int nBufYOff = (nStripHeight < nYSize) ? nNextYOff - nYOff : 0;
+    int nBufYSizeStrip = (nStripHeight < nYSize) ? nStripYSize : nBufYSize;
 
-    eErr = poDS->RasterIO( GF_Read, nXOff, nYOff, nXSize, nYSize,
-                           pBuf, nBufXSize, nBufYSize, eBufType,
+    eErr = poDS->RasterIO( GF_Read, nXOff, nNextYOff, nXSize, nStripYSize,
+                           ((GByte*) pBuf) + (GIntBig)nBufYOff * nLineSpace,
+                           nBufXSize, nBufYSizeStrip, eBufType,
                            nBandCount, panBandMap,
                            nPixelSpace, nLineSpace, nBandSpace,
                            NULL );
+    if( eErr != CE_None )
+        return GARIO_ERROR;
 
-    *pnBufXOff = 0;
-    *pnBufYOff = 0;
+    nNextYOff += nStripYSize;
+
+    *pnBufYOff = nBufYOff;
     *pnBufXSize = nBufXSize;
-    *pnBufYSize = nBufYSize;
+    *pnBufYSize = nBufYSizeStrip;
 
-    if( eErr == CE_None )
+    if( nNextYOff == nYOff + nYSize )
         return GARIO_COMPLETE;
     else
-        return GARIO_ERROR;
+        return GARIO_UPDATE;
 }
@@ -35,6 +35,7 @@
 #include "cpl_multiproc.h"
 #include "gdal_pam.h"
 #include "gdal_alg_priv.h"
+#include "cpl_worker_thread_pool.h"
 
 #ifdef _MSC_VER
 #  ifdef MSVC_USE_VLD
@@ -234,6 +235,11 @@ GDALDriverManager::~GDALDriverManager()
 /* -------------------------------------------------------------------- */
     OSRCleanup();
 
+/* -------------------------------------------------------------------- */
+/*      Stop the threads of the shared worker thread pool.              */
+/* -------------------------------------------------------------------- */
+    CPLCleanupGlobalWorkerThreadPool();
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup VSIFileManager.                                         */
 /* -------------------------------------------------------------------- */
@@ -283,6 +289,11 @@ GDALDriverManager::~GDALDriverManager()
 /* -------------------------------------------------------------------- */
     CPLCleanupSetlocaleMutex();
 
+/* -------------------------------------------------------------------- */
+/*      Cleanup the mutex of the registry of arena allocated XML trees  */
+/* -------------------------------------------------------------------- */
+    CPLCleanupXMLArenaMutex();
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup the master CPL mutex, which governs the creation        */
 /*      of all other mutexes.                                           */ 
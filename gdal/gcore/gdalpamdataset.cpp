@@ -613,6 +613,7 @@ CPLErr GDALPamDataset::TryLoadXML(char **papszSiblingFiles)
 
 {
     CPLXMLNode *psTree = NULL;
+    int         bArenaTree = TRUE;
 
     PamInitialize();
 
@@ -647,7 +648,7 @@ CPLErr GDALPamDataset::TryLoadXML(char **papszSiblingFiles)
         {
             CPLErrorReset();
             CPLPushErrorHandler( CPLQuietErrorHandler );
-            psTree = CPLParseXMLFile( psPam->pszPamFilename );
+            psTree = CPLParseXMLFileArena( psPam->pszPamFilename );
             CPLPopErrorHandler();
         }
     }
@@ -658,7 +659,7 @@ CPLErr GDALPamDataset::TryLoadXML(char **papszSiblingFiles)
     {
         CPLErrorReset();
         CPLPushErrorHandler( CPLQuietErrorHandler );
-        psTree = CPLParseXMLFile( psPam->pszPamFilename );
+        psTree = CPLParseXMLFileArena( psPam->pszPamFilename );
         CPLPopErrorHandler();
     }
 
@@ -689,8 +690,9 @@ CPLErr GDALPamDataset::TryLoadXML(char **papszSiblingFiles)
         if( psSubTree != NULL )
             psSubTree = CPLCloneXMLTree( psSubTree );
 
-        CPLDestroyXMLNode( psTree );
+        CPLDestroyXMLArenaTree( psTree );
         psTree = psSubTree;
+        bArenaTree = FALSE;
     }
 
 /* -------------------------------------------------------------------- */
@@ -707,7 +709,10 @@ CPLErr GDALPamDataset::TryLoadXML(char **papszSiblingFiles)
     CPLString osVRTPath(CPLGetPath(psPam->pszPamFilename));
     eErr = XMLInit( psTree, osVRTPath );
 
-    CPLDestroyXMLNode( psTree );
+    if( bArenaTree )
+        CPLDestroyXMLArenaTree( psTree );
+    else
+        CPLDestroyXMLNode( psTree );
 
     if( eErr != CE_None )
         PamClear();
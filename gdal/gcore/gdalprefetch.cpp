@@ -0,0 +1,611 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Background prefetching of raster blocks for AdviseRead()
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "gdalprefetch_priv.h"
+#include "cpl_string.h"
+
+CPL_CVSID("$Id$");
+
+#define STATE_QUEUED    0
+#define STATE_RUNNING   1
+#define STATE_DONE      2
+
+/************************************************************************/
+/*                        GDALBlockPrefetcher()                         */
+/************************************************************************/
+
+GDALBlockPrefetcher::GDALBlockPrefetcher( GDALDataset* poDS )
+
+{
+    osFilename = poDS->GetDescription();
+    osDriverName = poDS->GetDriver()->GetDescription();
+    papszOpenOptions = CSLDuplicate( poDS->GetOpenOptions() );
+    nRasterXSize = poDS->GetRasterXSize();
+    nRasterYSize = poDS->GetRasterYSize();
+    nBands = poDS->GetRasterCount();
+    for( int i = 0; i < nBands; i++ )
+    {
+        GDALRasterBand* poBand = poDS->GetRasterBand( i + 1 );
+        int nBlockXSize, nBlockYSize;
+        poBand->GetBlockSize( &nBlockXSize, &nBlockYSize );
+        anBlockXSize.push_back( nBlockXSize );
+        anBlockYSize.push_back( nBlockYSize );
+        aeDataType.push_back( poBand->GetRasterDataType() );
+    }
+
+    poThreadPool = NULL;
+    nPendingJobs = 0;
+    nMaxJobs = 0;
+    nActiveJobs = 0;
+    nIdleJobs = 0;
+    hMutex = NULL;
+    hCond = NULL;
+    nBytesInUse = 0;
+    nMaxBytes = 0;
+    bStop = FALSE;
+    bFailed = FALSE;
+}
+
+/************************************************************************/
+/*                        ~GDALBlockPrefetcher()                        */
+/************************************************************************/
+
+GDALBlockPrefetcher::~GDALBlockPrefetcher()
+
+{
+    if( hMutex != NULL )
+    {
+        CPLAcquireMutex( hMutex, 1000.0 );
+        bStop = TRUE;
+        CPLCondBroadcast( hCond );
+        CPLReleaseMutex( hMutex );
+
+        if( poThreadPool != NULL )
+            poThreadPool->WaitGroupCompletion( &nPendingJobs );
+
+        /* Running entries have completed, and no worker remains */
+        while( !oMapEntries.empty() )
+            RemoveEntry( oMapEntries.begin() );
+
+        CPLDestroyCond( hCond );
+        CPLDestroyMutex( hMutex );
+    }
+
+    for( size_t i = 0; i < apoAllHandles.size(); i++ )
+        GDALClose( (GDALDatasetH) apoAllHandles[i] );
+
+    CSLDestroy( papszOpenOptions );
+}
+
+/************************************************************************/
+/*                               Setup()                                */
+/************************************************************************/
+
+int GDALBlockPrefetcher::Setup( int nThreads, GIntBig nMaxBytesIn )
+
+{
+    nMaxJobs = nThreads;
+    nMaxBytes = nMaxBytesIn;
+
+    hCond = CPLCreateCond();
+    hMutex = CPLCreateMutex();
+    if( hMutex == NULL || hCond == NULL )
+    {
+        if( hCond != NULL )
+            CPLDestroyCond( hCond );
+        if( hMutex != NULL )
+        {
+            CPLReleaseMutex( hMutex );
+            CPLDestroyMutex( hMutex );
+        }
+        hMutex = NULL;
+        hCond = NULL;
+        return FALSE;
+    }
+    CPLReleaseMutex( hMutex );
+
+    poThreadPool = CPLGetGlobalWorkerThreadPool( nThreads );
+    return poThreadPool != NULL;
+}
+
+/************************************************************************/
+/*                           GetThreadCount()                           */
+/*                                                                      */
+/*      Number of prefetching threads requested by the NUM_THREADS     */
+/*      option of AdviseRead(). 0 means that prefetching is disabled,   */
+/*      which is the default.                                           */
+/************************************************************************/
+
+int GDALBlockPrefetcher::GetThreadCount( char** papszOptions )
+
+{
+    const char* pszValue = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszValue == NULL )
+        return 0;
+
+    int nThreads;
+    if( EQUAL(pszValue, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszValue);
+    if( nThreads > 128 )
+        nThreads = 128;
+    return nThreads;
+}
+
+/************************************************************************/
+/*                            GetMaxMemory()                            */
+/*                                                                      */
+/*      Maximum size of the blocks read ahead of time and not requested */
+/*      yet, set in megabytes by the MAX_MEMORY option of AdviseRead(). */
+/*      They are held outside of the block cache, so this comes on top  */
+/*      of GDAL_CACHEMAX. Defaults to a quarter of the cache size.      */
+/************************************************************************/
+
+GIntBig GDALBlockPrefetcher::GetMaxMemory( char** papszOptions )
+
+{
+    const char* pszValue = CSLFetchNameValue( papszOptions, "MAX_MEMORY" );
+    if( pszValue == NULL )
+        return GDALGetCacheMax64() / 4;
+
+    return MAX( 0, atoi(pszValue) ) * (GIntBig)(1024 * 1024);
+}
+
+/************************************************************************/
+/*                            RemoveEntry()                             */
+/*                                                                      */
+/*      Must be called with the mutex held.                             */
+/************************************************************************/
+
+void GDALBlockPrefetcher::RemoveEntry(
+                            std::map<Key, Entry*, KeyLess>::iterator oIter )
+
+{
+    Entry* psEntry = oIter->second;
+
+    if( psEntry->nState == STATE_QUEUED )
+        oQueue.erase( oIter->first );
+    else if( psEntry->nState == STATE_RUNNING )
+        psEntry->bAbandoned = TRUE; /* will be freed by the worker */
+    else
+    {
+        VSIFree( psEntry->pabyData );
+        nBytesInUse -= psEntry->nSize;
+        CPLCondBroadcast( hCond );
+        StartJobs();
+    }
+
+    if( psEntry->nState != STATE_RUNNING )
+        delete psEntry;
+    oMapEntries.erase( oIter );
+}
+
+/************************************************************************/
+/*                             StartJobs()                              */
+/*                                                                      */
+/*      Submit jobs for the queued blocks that there is room for, with  */
+/*      no more than NUM_THREADS of them in flight, whatever the number */
+/*      of threads of the shared pool. Called when blocks are queued,   */
+/*      when a job completes and when memory is released. Must be      */
+/*      called with the mutex held.                                     */
+/************************************************************************/
+
+void GDALBlockPrefetcher::StartJobs()
+
+{
+    if( bStop || bFailed || oQueue.empty() )
+        return;
+
+    if( nBytesInUse > 0 &&
+        nBytesInUse + (GIntBig)oMapEntries[*oQueue.begin()]->nSize > nMaxBytes )
+        return;
+
+    while( nActiveJobs < nMaxJobs && nIdleJobs < (int)oQueue.size() )
+    {
+        if( !poThreadPool->SubmitJob( ThreadFunc, this, &nPendingJobs ) )
+            break;
+        nActiveJobs ++;
+        nIdleJobs ++;
+    }
+}
+
+/************************************************************************/
+/*                               Advise()                               */
+/*                                                                      */
+/*      Queue the blocks of the bands intersecting the window. Blocks  */
+/*      previously advised for those bands that are outside of the     */
+/*      window are discarded.                                           */
+/************************************************************************/
+
+void GDALBlockPrefetcher::Advise( GDALDataset* poDS,
+                                  int nXOff, int nYOff,
+                                  int nXSize, int nYSize,
+                                  int nBandCount, int *panBandMap )
+
+{
+    CPLAcquireMutex( hMutex, 1000.0 );
+
+    for( int i = 0; i < nBandCount && !bFailed; i++ )
+    {
+        int nBand = panBandMap[i];
+        if( nBand < 1 || nBand > nBands )
+            continue;
+
+        GDALRasterBand* poBand = poDS->GetRasterBand( nBand );
+        int nBlockXSize, nBlockYSize;
+        poBand->GetBlockSize( &nBlockXSize, &nBlockYSize );
+        int nXBlock1 = nXOff / nBlockXSize;
+        int nXBlock2 = (nXOff + nXSize - 1) / nBlockXSize;
+        int nYBlock1 = nYOff / nBlockYSize;
+        int nYBlock2 = (nYOff + nYSize - 1) / nBlockYSize;
+
+        GIntBig nSize = (GIntBig)nBlockXSize * nBlockYSize *
+            (GDALGetDataTypeSize(poBand->GetRasterDataType()) / 8);
+        if( (GIntBig)(size_t)nSize != nSize )
+            continue;
+
+/* -------------------------------------------------------------------- */
+/*      Discard the blocks of this band outside of the new window.      */
+/* -------------------------------------------------------------------- */
+        std::map<Key, Entry*, KeyLess>::iterator oIter = oMapEntries.begin();
+        while( oIter != oMapEntries.end() )
+        {
+            const Key& sKey = oIter->first;
+            std::map<Key, Entry*, KeyLess>::iterator oCur = oIter ++;
+            if( sKey.nBand == nBand &&
+                (sKey.nXBlock < nXBlock1 || sKey.nXBlock > nXBlock2 ||
+                 sKey.nYBlock < nYBlock1 || sKey.nYBlock > nYBlock2) )
+                RemoveEntry( oCur );
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Queue the blocks that are neither known, nor already cached.    */
+/* -------------------------------------------------------------------- */
+        for( int nYBlock = nYBlock1; nYBlock <= nYBlock2; nYBlock++ )
+        {
+            for( int nXBlock = nXBlock1; nXBlock <= nXBlock2; nXBlock++ )
+            {
+                Key sKey;
+                sKey.nYBlock = nYBlock;
+                sKey.nXBlock = nXBlock;
+                sKey.nBand = nBand;
+                if( oMapEntries.find( sKey ) != oMapEntries.end() )
+                    continue;
+
+                GDALRasterBlock* poBlock =
+                    poBand->TryGetLockedBlockRef( nXBlock, nYBlock );
+                if( poBlock != NULL )
+                {
+                    poBlock->DropLock();
+                    continue;
+                }
+
+                Entry* psEntry = new Entry;
+                psEntry->nState = STATE_QUEUED;
+                psEntry->bAbandoned = FALSE;
+                psEntry->nSize = (size_t)nSize;
+                psEntry->pabyData = NULL;
+                psEntry->eErr = CE_None;
+                oMapEntries[sKey] = psEntry;
+                oQueue.insert( sKey );
+            }
+        }
+    }
+
+    StartJobs();
+
+    CPLCondBroadcast( hCond );
+    CPLReleaseMutex( hMutex );
+}
+
+/************************************************************************/
+/*                            IsCompatible()                            */
+/*                                                                      */
+/*      Check that a reopened dataset has the same block layout as the  */
+/*      dataset being prefetched.                                       */
+/************************************************************************/
+
+int GDALBlockPrefetcher::IsCompatible( GDALDataset* poHandle )
+
+{
+    if( poHandle->GetRasterXSize() != nRasterXSize ||
+        poHandle->GetRasterYSize() != nRasterYSize ||
+        poHandle->GetRasterCount() != nBands )
+        return FALSE;
+
+    for( int i = 0; i < nBands; i++ )
+    {
+        GDALRasterBand* poBand = poHandle->GetRasterBand( i + 1 );
+        int nBlockXSize, nBlockYSize;
+        poBand->GetBlockSize( &nBlockXSize, &nBlockYSize );
+        if( nBlockXSize != anBlockXSize[i] ||
+            nBlockYSize != anBlockYSize[i] ||
+            poBand->GetRasterDataType() != aeDataType[i] )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           AcquireHandle()                            */
+/************************************************************************/
+
+GDALDataset* GDALBlockPrefetcher::AcquireHandle()
+
+{
+    CPLAcquireMutex( hMutex, 1000.0 );
+    if( !apoFreeHandles.empty() )
+    {
+        GDALDataset* poHandle = apoFreeHandles.back();
+        apoFreeHandles.pop_back();
+        CPLReleaseMutex( hMutex );
+        return poHandle;
+    }
+    CPLReleaseMutex( hMutex );
+
+    const char* apszAllowedDrivers[2];
+    apszAllowedDrivers[0] = osDriverName.c_str();
+    apszAllowedDrivers[1] = NULL;
+
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+    GDALDataset* poHandle = (GDALDataset*)
+        GDALOpenEx( osFilename, GDAL_OF_RASTER | GDAL_OF_INTERNAL,
+                    apszAllowedDrivers, papszOpenOptions, NULL );
+    CPLPopErrorHandler();
+
+    if( poHandle != NULL && !IsCompatible( poHandle ) )
+    {
+        GDALClose( (GDALDatasetH) poHandle );
+        poHandle = NULL;
+    }
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    if( poHandle != NULL )
+        apoAllHandles.push_back( poHandle );
+    else if( !bFailed )
+    {
+        CPLDebug( "GDAL", "Cannot reopen %s for prefetching",
+                  osFilename.c_str() );
+        bFailed = TRUE;
+        CPLCondBroadcast( hCond );
+    }
+    CPLReleaseMutex( hMutex );
+
+    return poHandle;
+}
+
+/************************************************************************/
+/*                           ReleaseHandle()                            */
+/************************************************************************/
+
+void GDALBlockPrefetcher::ReleaseHandle( GDALDataset* poHandle )
+
+{
+    CPLAcquireMutex( hMutex, 1000.0 );
+    apoFreeHandles.push_back( poHandle );
+    CPLReleaseMutex( hMutex );
+}
+
+/************************************************************************/
+/*                             ThreadFunc()                             */
+/************************************************************************/
+
+void GDALBlockPrefetcher::ThreadFunc( void* pData )
+
+{
+    ((GDALBlockPrefetcher*) pData)->ProcessNext();
+}
+
+/************************************************************************/
+/*                            ProcessNext()                             */
+/*                                                                      */
+/*      Read the first queued block, and start the job of the next    */
+/*      one. If there is no room for it, the job returns rather than    */
+/*      blocking a thread of the shared pool, and the block is read by  */
+/*      a job started once memory is released.                          */
+/************************************************************************/
+
+void GDALBlockPrefetcher::ProcessNext()
+
+{
+    CPLAcquireMutex( hMutex, 1000.0 );
+
+    nIdleJobs --;
+    if( bStop || bFailed || oQueue.empty() ||
+        (nBytesInUse > 0 &&
+         nBytesInUse + (GIntBig)oMapEntries[*oQueue.begin()]->nSize > nMaxBytes) )
+    {
+        nActiveJobs --;
+        CPLReleaseMutex( hMutex );
+        return;
+    }
+
+    Key sKey = *oQueue.begin();
+    oQueue.erase( oQueue.begin() );
+    Entry* psEntry = oMapEntries[sKey];
+    psEntry->nState = STATE_RUNNING;
+    nBytesInUse += psEntry->nSize;
+
+    CPLReleaseMutex( hMutex );
+
+    GByte* pabyData = (GByte*) VSIMalloc( psEntry->nSize );
+    GDALDataset* poHandle = (pabyData != NULL) ? AcquireHandle() : NULL;
+    CPLErr eErr = CE_Failure;
+    if( poHandle != NULL )
+    {
+        CPLPushErrorHandler( CPLQuietErrorHandler );
+        eErr = poHandle->GetRasterBand( sKey.nBand )->ReadBlock(
+                                        sKey.nXBlock, sKey.nYBlock, pabyData );
+        CPLPopErrorHandler();
+        ReleaseHandle( poHandle );
+    }
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    if( psEntry->bAbandoned )
+    {
+        VSIFree( pabyData );
+        nBytesInUse -= psEntry->nSize;
+        delete psEntry;
+    }
+    else
+    {
+        psEntry->pabyData = pabyData;
+        psEntry->eErr = eErr;
+        psEntry->nState = STATE_DONE;
+    }
+    nActiveJobs --;
+    StartJobs();
+    CPLCondBroadcast( hCond );
+    CPLReleaseMutex( hMutex );
+}
+
+/************************************************************************/
+/*                               Fetch()                                */
+/*                                                                      */
+/*      Copy the prefetched content of a block in pData, waiting for   */
+/*      it if it is being read. Returns FALSE if the block must be     */
+/*      read by the caller, in which case it is no longer prefetched.  */
+/************************************************************************/
+
+int GDALBlockPrefetcher::Fetch( int nBand, int nXBlock, int nYBlock,
+                                void* pData, size_t nSize )
+
+{
+    Key sKey;
+    sKey.nYBlock = nYBlock;
+    sKey.nXBlock = nXBlock;
+    sKey.nBand = nBand;
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+
+    std::map<Key, Entry*, KeyLess>::iterator oIter;
+    while( (oIter = oMapEntries.find( sKey )) != oMapEntries.end() &&
+           oIter->second->nState == STATE_RUNNING )
+        CPLCondWait( hCond, hMutex );
+
+    int bRet = FALSE;
+    if( oIter != oMapEntries.end() )
+    {
+        Entry* psEntry = oIter->second;
+        if( psEntry->nState == STATE_DONE && psEntry->eErr == CE_None &&
+            psEntry->nSize == nSize )
+        {
+            memcpy( pData, psEntry->pabyData, nSize );
+            bRet = TRUE;
+        }
+        RemoveEntry( oIter );
+    }
+
+    CPLReleaseMutex( hMutex );
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                             IsPending()                              */
+/*                                                                      */
+/*      Whether a block is being read, or will be read without         */
+/*      requiring memory to be released first. Called with the mutex   */
+/*      held.                                                           */
+/************************************************************************/
+
+int GDALBlockPrefetcher::IsPending( const Key& sKey )
+
+{
+    std::map<Key, Entry*, KeyLess>::iterator oIter = oMapEntries.find( sKey );
+    if( oIter == oMapEntries.end() )
+        return FALSE;
+
+    Entry* psEntry = oIter->second;
+    if( psEntry->nState == STATE_RUNNING )
+        return TRUE;
+    if( psEntry->nState == STATE_DONE || bFailed )
+        return FALSE;
+
+    return nBytesInUse == 0 ||
+           nBytesInUse + (GIntBig)psEntry->nSize <= nMaxBytes;
+}
+
+/************************************************************************/
+/*                           WaitForBlocks()                            */
+/*                                                                      */
+/*      Wait until none of the blocks of the window is pending. Returns */
+/*      FALSE if dfTimeout seconds (< 0 for no limit) elapse without    */
+/*      any read being completed.                                       */
+/************************************************************************/
+
+int GDALBlockPrefetcher::WaitForBlocks( GDALDataset* poDS,
+                                        int nXOff, int nYOff,
+                                        int nXSize, int nYSize,
+                                        int nBandCount, int *panBandMap,
+                                        double dfTimeout )
+
+{
+    std::vector<Key> asKeys;
+    for( int i = 0; i < nBandCount; i++ )
+    {
+        int nBlockXSize, nBlockYSize;
+        poDS->GetRasterBand( panBandMap[i] )->GetBlockSize( &nBlockXSize,
+                                                            &nBlockYSize );
+        Key sKey;
+        sKey.nBand = panBandMap[i];
+        for( sKey.nYBlock = nYOff / nBlockYSize;
+             sKey.nYBlock <= (nYOff + nYSize - 1) / nBlockYSize;
+             sKey.nYBlock++ )
+        {
+            for( sKey.nXBlock = nXOff / nBlockXSize;
+                 sKey.nXBlock <= (nXOff + nXSize - 1) / nBlockXSize;
+                 sKey.nXBlock++ )
+                asKeys.push_back( sKey );
+        }
+    }
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+
+    int bPending = TRUE;
+    int bTimedOut = FALSE;
+    while( TRUE )
+    {
+        bPending = FALSE;
+        for( size_t i = 0; i < asKeys.size() && !bPending; i++ )
+            bPending = IsPending( asKeys[i] );
+        if( !bPending || bTimedOut || dfTimeout == 0 )
+            break;
+
+        /* Woken up when a read completes, or memory is released */
+        if( dfTimeout < 0 )
+            CPLCondWait( hCond, hMutex );
+        else
+            bTimedOut = !CPLCondTimedWait( hCond, hMutex, dfTimeout );
+    }
+
+    CPLReleaseMutex( hMutex );
+
+    return !bPending;
+}
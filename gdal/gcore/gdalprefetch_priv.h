@@ -0,0 +1,141 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Background prefetching of raster blocks for AdviseRead()
+ *
+ ******************************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef GDALPREFETCH_PRIV_H_INCLUDED
+#define GDALPREFETCH_PRIV_H_INCLUDED
+
+#include "gdal_priv.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/************************************************************************/
+/*                         GDALBlockPrefetcher                          */
+/*                                                                      */
+/*      Reads blocks of a read-only dataset ahead of time, in jobs of   */
+/*      the global worker thread pool that use their own dataset        */
+/*      handles on the same file.                                       */
+/*      The main dataset never sees these threads: when one of its      */
+/*      bands misses a block in the block cache, it asks Fetch() for    */
+/*      a prefetched copy before reading the block itself.              */
+/************************************************************************/
+
+class GDALBlockPrefetcher
+{
+  public:
+    typedef struct
+    {
+        int nYBlock;
+        int nXBlock;
+        int nBand;
+    } Key;
+
+  private:
+    typedef struct
+    {
+        int     nState;
+        int     bAbandoned; /* cancelled while being read */
+        size_t  nSize;
+        GByte  *pabyData;
+        CPLErr  eErr;
+    } Entry;
+
+    struct KeyLess
+    {
+        bool operator()( const Key& a, const Key& b ) const
+        {
+            if( a.nYBlock != b.nYBlock ) return a.nYBlock < b.nYBlock;
+            if( a.nXBlock != b.nXBlock ) return a.nXBlock < b.nXBlock;
+            return a.nBand < b.nBand;
+        }
+    };
+
+    CPLString               osFilename;
+    CPLString               osDriverName;
+    char                  **papszOpenOptions;
+    int                     nRasterXSize;
+    int                     nRasterYSize;
+    int                     nBands;
+    std::vector<int>        anBlockXSize;
+    std::vector<int>        anBlockYSize;
+    std::vector<GDALDataType> aeDataType;
+
+    CPLWorkerThreadPool    *poThreadPool; /* the global pool */
+    int                     nPendingJobs; /* our job group in the pool */
+    int                     nMaxJobs;   /* NUM_THREADS */
+    int                     nActiveJobs; /* submitted and not completed */
+    int                     nIdleJobs;  /* submitted and not started */
+    CPLMutex               *hMutex;
+    CPLCond                *hCond;     /* signaled when a read completes or
+                                          memory is released */
+
+    std::map<Key, Entry*, KeyLess> oMapEntries;
+    std::set<Key, KeyLess>  oQueue;    /* entries not yet started, read in
+                                          (row, column, band) order */
+    GIntBig                 nBytesInUse;
+    GIntBig                 nMaxBytes;
+    int                     bStop;
+    int                     bFailed;   /* handles cannot be opened */
+
+    std::vector<GDALDataset*> apoFreeHandles;
+    std::vector<GDALDataset*> apoAllHandles;
+
+    int                     IsCompatible( GDALDataset* poHandle );
+    GDALDataset            *AcquireHandle();
+    void                    ReleaseHandle( GDALDataset* poHandle );
+    void                    RemoveEntry( std::map<Key, Entry*, KeyLess>::iterator oIter );
+    void                    StartJobs();
+    int                     IsPending( const Key& sKey );
+    void                    ProcessNext();
+    static void             ThreadFunc( void* pData );
+
+  public:
+                            GDALBlockPrefetcher( GDALDataset* poDS );
+                           ~GDALBlockPrefetcher();
+
+    int                     Setup( int nThreads, GIntBig nMaxBytesIn );
+
+    void                    Advise( GDALDataset* poDS,
+                                    int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    int nBandCount, int *panBandMap );
+    int                     Fetch( int nBand, int nXBlock, int nYBlock,
+                                   void* pData, size_t nSize );
+    int                     WaitForBlocks( GDALDataset* poDS,
+                                           int nXOff, int nYOff,
+                                           int nXSize, int nYSize,
+                                           int nBandCount, int *panBandMap,
+                                           double dfTimeout );
+
+    static int              GetThreadCount( char** papszOptions );
+    static GIntBig          GetMaxMemory( char** papszOptions );
+};
+
+#endif /* GDALPREFETCH_PRIV_H_INCLUDED */
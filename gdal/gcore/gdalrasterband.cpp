@@ -30,6 +30,7 @@
  ****************************************************************************/
 
 #include "gdal_priv.h"
+#include "gdalprefetch_priv.h"
 #include "gdal_rat.h"
 #include "cpl_string.h"
 
@@ -37,6 +38,17 @@
 #define TO_SUBBLOCK(x) ((x) >> 6)
 #define WITHIN_SUBBLOCK(x) ((x) & 0x3f)
 
+/* Sparse block index: a 3 level radix tree (root, intermediate nodes and */
+/* leaves of SPARSE_NODE_SIZE entries), whose nodes are only allocated */
+/* when blocks are adopted in them. Each leaf covers a rectangle of */
+/* 2^nSparseLeafXBits * 2^nSparseLeafYBits blocks. */
+#define SPARSE_NODE_BITS 8
+#define SPARSE_NODE_SIZE (1 << SPARSE_NODE_BITS)
+#define SPARSE_NODE_MASK (SPARSE_NODE_SIZE - 1)
+
+/* Number of blocks above which the sparse block index is used by default */
+#define SPARSE_AUTO_THRESHOLD (64 * 1024)
+
 CPL_CVSID("$Id$");
 
 /************************************************************************/
@@ -62,6 +74,10 @@ GDALRasterBand::GDALRasterBand()
     bSubBlockingActive = FALSE;
     papoBlocks = NULL;
 
+    bSparseBlockIndex = FALSE;
+    nSparseLeafXBits = nSparseLeafYBits = 0;
+    nSparseLeavesPerRow = nSparseRootSize = 0;
+
     poMask = NULL;
     bOwnMask = false;
     nMaskFlags = 0;
@@ -188,7 +204,8 @@ CPLErr GDALRasterBand::RasterIO( GDALRWFlag eRWFlag,
         INIT_RASTERIO_EXTRA_ARG(sExtraArg);
         psExtraArg = &sExtraArg;
     }
-    else if( psExtraArg->nVersion != RASTERIO_EXTRA_ARG_CURRENT_VERSION )
+    else if( psExtraArg->nVersion < 1 ||
+             psExtraArg->nVersion > RASTERIO_EXTRA_ARG_CURRENT_VERSION )
     {
         ReportError( CE_Failure, CPLE_AppDefined,
                      "Unhandled version of GDALRasterIOExtraArg" );
@@ -266,14 +283,26 @@ CPLErr GDALRasterBand::RasterIO( GDALRWFlag eRWFlag,
 /* -------------------------------------------------------------------- */
 /*      Call the format specific function.                              */
 /* -------------------------------------------------------------------- */
+    int bOldSequentialScan = FALSE;
+    int bSequentialScan = psExtraArg->nVersion >= 2 &&
+                          psExtraArg->bSequentialScan;
+    if( bSequentialScan )
+        bOldSequentialScan = GDALRasterBlock::SetSequentialScanHint( TRUE );
+
+    CPLErr eErr;
     if( bForceCachedIO )
-        return GDALRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
+        eErr = GDALRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
                                          pData, nBufXSize, nBufYSize, eBufType,
                                          nPixelSpace, nLineSpace, psExtraArg );
     else
-        return IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
+        eErr = IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
                           pData, nBufXSize, nBufYSize, eBufType,
                           nPixelSpace, nLineSpace, psExtraArg ) ;
+
+    if( bSequentialScan )
+        GDALRasterBlock::SetSequentialScanHint( bOldSequentialScan );
+
+    return eErr;
 }
 
 /************************************************************************/
@@ -753,7 +782,53 @@ int GDALRasterBand::InitBlockInfo()
     nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
     nBlocksPerColumn = DIV_ROUND_UP(nRasterYSize, nBlockYSize);
 
-    if( nBlocksPerRow < SUBBLOCK_SIZE/2 )
+/* -------------------------------------------------------------------- */
+/*      For very big rasters, the block arrays would cost a lot of      */
+/*      memory even if only a few blocks are accessed, so we use a      */
+/*      sparse index instead. GDAL_BAND_BLOCK_CACHE can be set to       */
+/*      ARRAY or SPARSE to force one of the methods.                    */
+/* -------------------------------------------------------------------- */
+    const char* pszBlockCache =
+        CPLGetConfigOption("GDAL_BAND_BLOCK_CACHE", "AUTO");
+    if( EQUAL(pszBlockCache, "SPARSE") )
+        bSparseBlockIndex = TRUE;
+    else if( EQUAL(pszBlockCache, "ARRAY") )
+        bSparseBlockIndex = FALSE;
+    else
+        bSparseBlockIndex = ((GIntBig)nBlocksPerRow * nBlocksPerColumn
+                                                    > SPARSE_AUTO_THRESHOLD);
+
+    if( bSparseBlockIndex )
+    {
+        bSubBlockingActive = FALSE;
+
+        /* Leaves are squares of 16x16 blocks, unless the raster is */
+        /* narrower, typically when it is organized in strips */
+        nSparseLeafXBits = 0;
+        while( nSparseLeafXBits < SPARSE_NODE_BITS / 2 &&
+               (1 << nSparseLeafXBits) < nBlocksPerRow )
+            nSparseLeafXBits++;
+        nSparseLeafYBits = SPARSE_NODE_BITS - nSparseLeafXBits;
+
+        nSparseLeavesPerRow = DIV_ROUND_UP(nBlocksPerRow, 1 << nSparseLeafXBits);
+        int nSparseLeavesPerColumn =
+            DIV_ROUND_UP(nBlocksPerColumn, 1 << nSparseLeafYBits);
+
+        if (nSparseLeavesPerRow < INT_MAX / nSparseLeavesPerColumn)
+        {
+            nSparseRootSize = DIV_ROUND_UP(
+                nSparseLeavesPerRow * nSparseLeavesPerColumn, SPARSE_NODE_SIZE);
+            papoBlocks = (GDALRasterBlock **)
+                VSICalloc( sizeof(void*), nSparseRootSize );
+        }
+        else
+        {
+            ReportError( CE_Failure, CPLE_NotSupported, "Too many blocks : %d x %d",
+                     nBlocksPerRow, nBlocksPerColumn );
+            return FALSE;
+        }
+    }
+    else if( nBlocksPerRow < SUBBLOCK_SIZE/2 )
     {
         bSubBlockingActive = FALSE;
 
@@ -799,6 +874,61 @@ int GDALRasterBand::InitBlockInfo()
     return TRUE;
 }
 
+/************************************************************************/
+/*                         GetSparseBlockSlot()                         */
+/*                                                                      */
+/*      Return the address of the entry of the sparse block index      */
+/*      for the specified block, creating the intermediate nodes if    */
+/*      bCreate is TRUE. Returns NULL if the entry does not exist, or  */
+/*      on allocation failure.                                          */
+/************************************************************************/
+
+GDALRasterBlock **GDALRasterBand::GetSparseBlockSlot( int nXBlockOff,
+                                                      int nYBlockOff,
+                                                      int bCreate )
+
+{
+    int nLeaf = (nXBlockOff >> nSparseLeafXBits)
+        + (nYBlockOff >> nSparseLeafYBits) * nSparseLeavesPerRow;
+
+    void **papRoot = (void **) papoBlocks;
+    void **papNode = (void **) papRoot[nLeaf >> SPARSE_NODE_BITS];
+    if( papNode == NULL )
+    {
+        if( !bCreate )
+            return NULL;
+        papNode = (void **) VSICalloc( sizeof(void*), SPARSE_NODE_SIZE );
+        if( papNode == NULL )
+        {
+            ReportError( CE_Failure, CPLE_OutOfMemory,
+                      "Out of memory in GetSparseBlockSlot()." );
+            return NULL;
+        }
+        papRoot[nLeaf >> SPARSE_NODE_BITS] = papNode;
+    }
+
+    GDALRasterBlock **papoLeaf =
+        (GDALRasterBlock **) papNode[nLeaf & SPARSE_NODE_MASK];
+    if( papoLeaf == NULL )
+    {
+        if( !bCreate )
+            return NULL;
+        papoLeaf = (GDALRasterBlock **)
+            VSICalloc( sizeof(GDALRasterBlock*), SPARSE_NODE_SIZE );
+        if( papoLeaf == NULL )
+        {
+            ReportError( CE_Failure, CPLE_OutOfMemory,
+                      "Out of memory in GetSparseBlockSlot()." );
+            return NULL;
+        }
+        papNode[nLeaf & SPARSE_NODE_MASK] = papoLeaf;
+    }
+
+    return papoLeaf
+        + (nXBlockOff & ((1 << nSparseLeafXBits) - 1))
+        + ((nYBlockOff & ((1 << nSparseLeafYBits) - 1)) << nSparseLeafXBits);
+}
+
 /************************************************************************/
 /*                             AdoptBlock()                             */
 /*                                                                      */
@@ -817,7 +947,29 @@ CPLErr GDALRasterBand::AdoptBlock( int nXBlockOff, int nYBlockOff,
     
     if( !InitBlockInfo() )
         return CE_Failure;
-    
+
+/* -------------------------------------------------------------------- */
+/*      Sparse block index.                                             */
+/* -------------------------------------------------------------------- */
+    if( bSparseBlockIndex )
+    {
+        GDALRasterBlock **ppoSlot =
+            GetSparseBlockSlot( nXBlockOff, nYBlockOff, TRUE );
+        if( ppoSlot == NULL )
+            return CE_Failure;
+
+        if( *ppoSlot == poBlock )
+            return CE_None;
+
+        if( *ppoSlot != NULL )
+            FlushBlock( nXBlockOff, nYBlockOff );
+
+        *ppoSlot = poBlock;
+        poBlock->Touch();
+
+        return CE_None;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Simple case without subblocking.                                */
 /* -------------------------------------------------------------------- */
@@ -909,6 +1061,55 @@ CPLErr GDALRasterBand::FlushCache()
     if (papoBlocks == NULL)
         return eGlobalErr;
 
+/* -------------------------------------------------------------------- */
+/*      Flush all blocks of the sparse index, and free its nodes.       */
+/* -------------------------------------------------------------------- */
+    if( bSparseBlockIndex )
+    {
+        const int nLeafXSize = 1 << nSparseLeafXBits;
+        void **papRoot = (void **) papoBlocks;
+
+        for( int iRoot = 0; iRoot < nSparseRootSize; iRoot++ )
+        {
+            void **papNode = (void **) papRoot[iRoot];
+            if( papNode == NULL )
+                continue;
+
+            for( int iNode = 0; iNode < SPARSE_NODE_SIZE; iNode++ )
+            {
+                GDALRasterBlock **papoLeaf = (GDALRasterBlock **) papNode[iNode];
+                if( papoLeaf == NULL )
+                    continue;
+
+                int nLeaf = (iRoot << SPARSE_NODE_BITS) + iNode;
+                int nXBlockStart = (nLeaf % nSparseLeavesPerRow) << nSparseLeafXBits;
+                int nYBlockStart = (nLeaf / nSparseLeavesPerRow) << nSparseLeafYBits;
+
+                for( int i = 0; i < SPARSE_NODE_SIZE; i++ )
+                {
+                    if( papoLeaf[i] != NULL )
+                    {
+                        CPLErr eErr;
+
+                        eErr = FlushBlock( nXBlockStart + (i % nLeafXSize),
+                                           nYBlockStart + (i / nLeafXSize),
+                                           eGlobalErr == CE_None );
+                        if( eErr != CE_None )
+                            eGlobalErr = eErr;
+                    }
+                }
+
+                papNode[iNode] = NULL;
+                CPLFree( papoLeaf );
+            }
+
+            papRoot[iRoot] = NULL;
+            CPLFree( papNode );
+        }
+
+        return eGlobalErr;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Flush all blocks in memory ... this case is without subblocking.*/
 /* -------------------------------------------------------------------- */
@@ -1032,10 +1233,21 @@ CPLErr GDALRasterBand::UnreferenceBlock( int nXBlockOff, int nYBlockOff )
         return( CE_Failure );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Sparse block index.                                             */
+/* -------------------------------------------------------------------- */
+    if( bSparseBlockIndex )
+    {
+        GDALRasterBlock **ppoSlot =
+            GetSparseBlockSlot( nXBlockOff, nYBlockOff, FALSE );
+        if( ppoSlot != NULL )
+            *ppoSlot = NULL;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Simple case for single level caches.                            */
 /* -------------------------------------------------------------------- */
-    if( !bSubBlockingActive )
+    else if( !bSubBlockingActive )
     {
         int nBlockIndex = nXBlockOff + nYBlockOff * nBlocksPerRow;
 
@@ -1111,10 +1323,26 @@ CPLErr GDALRasterBand::FlushBlock( int nXBlockOff, int nYBlockOff,
         return( CE_Failure );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Sparse block index.                                             */
+/* -------------------------------------------------------------------- */
+    if( bSparseBlockIndex )
+    {
+        GDALRasterBlock **ppoSlot =
+            GetSparseBlockSlot( nXBlockOff, nYBlockOff, FALSE );
+        if( ppoSlot == NULL )
+            return CE_None;
+
+        GDALRasterBlock::SafeLockBlock( ppoSlot );
+
+        poBlock = *ppoSlot;
+        *ppoSlot = NULL;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Simple case for single level caches.                            */
 /* -------------------------------------------------------------------- */
-    if( !bSubBlockingActive )
+    else if( !bSubBlockingActive )
     {
         nBlockIndex = nXBlockOff + nYBlockOff * nBlocksPerRow;
 
@@ -1228,6 +1456,21 @@ GDALRasterBlock *GDALRasterBand::TryGetLockedBlockRef( int nXBlockOff,
         return( NULL );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Sparse block index.                                             */
+/* -------------------------------------------------------------------- */
+    if( bSparseBlockIndex )
+    {
+        GDALRasterBlock **ppoSlot =
+            GetSparseBlockSlot( nXBlockOff, nYBlockOff, FALSE );
+        if( ppoSlot == NULL )
+            return NULL;
+
+        GDALRasterBlock::SafeLockBlock( ppoSlot );
+
+        return *ppoSlot;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Simple case for single level caches.                            */
 /* -------------------------------------------------------------------- */
@@ -1263,6 +1506,26 @@ GDALRasterBlock *GDALRasterBand::TryGetLockedBlockRef( int nXBlockOff,
     return papoSubBlockGrid[nBlockInSubBlock];
 }
 
+/************************************************************************/
+/*                        FetchPrefetchedBlock()                        */
+/*                                                                      */
+/*      Fill a newly created block from the blocks read ahead of time   */
+/*      on behalf of AdviseRead(), if available.                        */
+/************************************************************************/
+
+int GDALRasterBand::FetchPrefetchedBlock( int nXBlockOff, int nYBlockOff,
+                                          GDALRasterBlock *poBlock )
+
+{
+    if( poDS == NULL || poDS->m_poPrefetcher == NULL ||
+        nBand < 1 || nBand > poDS->nBands || poDS->papoBands[nBand-1] != this )
+        return FALSE;
+
+    return poDS->m_poPrefetcher->Fetch( nBand, nXBlockOff, nYBlockOff,
+                                        poBlock->GetDataRef(),
+                                        poBlock->GetBlockSize() );
+}
+
 /************************************************************************/
 /*                         GetLockedBlockRef()                          */
 /************************************************************************/
@@ -1362,6 +1625,7 @@ GDALRasterBlock * GDALRasterBand::GetLockedBlockRef( int nXBlockOff,
         }
 
         if( !bJustInitialize
+         && !FetchPrefetchedBlock( nXBlockOff, nYBlockOff, poBlock )
          && IReadBlock(nXBlockOff,nYBlockOff,poBlock->GetDataRef()) != CE_None)
         {
             poBlock->DropLock();
@@ -1387,6 +1651,144 @@ GDALRasterBlock * GDALRasterBand::GetLockedBlockRef( int nXBlockOff,
     return poBlock;
 }
 
+/************************************************************************/
+/*                            BorrowBlock()                             */
+/************************************************************************/
+
+/**
+ * \brief Borrow a read-only pointer to the data of a raster block.
+ *
+ * This method gives access to the content of a block without copying it
+ * into a user buffer, which is useful when the data is directly consumed
+ * (e.g. by an image encoder) in the layout it has in memory.
+ *
+ * The default implementation returns the data of the block as held by the
+ * block cache (reading it from the driver if needed), and keeps the block
+ * locked until ReleaseBorrowedBlock() is called, so that it cannot be
+ * evicted meanwhile. Drivers that keep the whole raster in memory, or can
+ * map it into memory (MEM, raw formats), may return a pointer into that
+ * storage instead, in which case the pixels of the block are not
+ * necessarily contiguous : the element of block coordinates (x, y) is at
+ * (GByte*)p + x * *pnPixelSpace + y * *pnLineSpace.
+ *
+ * The data is in the data type of the band. For blocks at the right and
+ * bottom edges of the raster, only the part of the block that is inside
+ * the raster has significant content.
+ *
+ * The returned memory must not be modified, and the band must not be
+ * written while a block is borrowed. Each successful call must be paired
+ * with a call to ReleaseBorrowedBlock() with the returned handle (that may
+ * be NULL) before the band is destroyed.
+ *
+ * This method is the same as the C function GDALBorrowBlock().
+ *
+ * @param nXBlockOff the horizontal block offset, with zero indicating
+ * the left most block, 1 the next block and so forth.
+ *
+ * @param nYBlockOff the vertical block offset, with zero indicating
+ * the top most block, 1 the next block and so forth.
+ *
+ * @param pnPixelSpace Output parameter (may be NULL) receiving the byte offset
+ * between the start of two consecutive pixels of a block line.
+ *
+ * @param pnLineSpace Output parameter (may be NULL) receiving the byte offset
+ * between the start of two consecutive lines of the block.
+ *
+ * @param ppBorrowHandle Output parameter receiving the handle to pass to
+ * ReleaseBorrowedBlock().
+ *
+ * @return a pointer to the block data, or NULL on failure.
+ *
+ * @since GDAL 2.0
+ */
+
+const void *GDALRasterBand::BorrowBlock( int nXBlockOff, int nYBlockOff,
+                                         GSpacing *pnPixelSpace,
+                                         GSpacing *pnLineSpace,
+                                         void **ppBorrowHandle )
+
+{
+    *ppBorrowHandle = NULL;
+
+    GDALRasterBlock *poBlock = GetLockedBlockRef( nXBlockOff, nYBlockOff );
+    if( poBlock == NULL )
+        return NULL;
+
+    int nWordSize = GDALGetDataTypeSize( eDataType ) / 8;
+    if( pnPixelSpace )
+        *pnPixelSpace = nWordSize;
+    if( pnLineSpace )
+        *pnLineSpace = (GSpacing)nWordSize * nBlockXSize;
+
+    *ppBorrowHandle = poBlock;
+    return poBlock->GetDataRef();
+}
+
+/************************************************************************/
+/*                          GDALBorrowBlock()                           */
+/************************************************************************/
+
+/**
+ * \brief Borrow a read-only pointer to the data of a raster block.
+ *
+ * @see GDALRasterBand::BorrowBlock()
+ */
+
+const void * CPL_STDCALL
+GDALBorrowBlock( GDALRasterBandH hBand, int nXBlockOff, int nYBlockOff,
+                 GSpacing *pnPixelSpace, GSpacing *pnLineSpace,
+                 void **ppBorrowHandle )
+
+{
+    VALIDATE_POINTER1( hBand, "GDALBorrowBlock", NULL );
+    VALIDATE_POINTER1( ppBorrowHandle, "GDALBorrowBlock", NULL );
+
+    GDALRasterBand *poBand = static_cast<GDALRasterBand*>(hBand);
+    return poBand->BorrowBlock( nXBlockOff, nYBlockOff,
+                                pnPixelSpace, pnLineSpace, ppBorrowHandle );
+}
+
+/************************************************************************/
+/*                        ReleaseBorrowedBlock()                        */
+/************************************************************************/
+
+/**
+ * \brief Release a block borrowed with BorrowBlock().
+ *
+ * This method is the same as the C function GDALReleaseBorrowedBlock().
+ *
+ * @param pBorrowHandle the handle returned by BorrowBlock().
+ *
+ * @since GDAL 2.0
+ */
+
+void GDALRasterBand::ReleaseBorrowedBlock( void *pBorrowHandle )
+
+{
+    if( pBorrowHandle != NULL )
+        ((GDALRasterBlock *) pBorrowHandle)->DropLock();
+}
+
+/************************************************************************/
+/*                      GDALReleaseBorrowedBlock()                      */
+/************************************************************************/
+
+/**
+ * \brief Release a block borrowed with GDALBorrowBlock().
+ *
+ * @see GDALRasterBand::ReleaseBorrowedBlock()
+ */
+
+void CPL_STDCALL GDALReleaseBorrowedBlock( GDALRasterBandH hBand,
+                                           void *pBorrowHandle )
+
+{
+    VALIDATE_POINTER0( hBand, "GDALReleaseBorrowedBlock" );
+
+    GDALRasterBand *poBand = static_cast<GDALRasterBand*>(hBand);
+    poBand->ReleaseBorrowedBlock( pBorrowHandle );
+}
+
 /************************************************************************/
 /*                               Fill()                                 */
 /************************************************************************/
@@ -3392,16 +3794,30 @@ CPLErr CPL_STDCALL GDALGetDefaultHistogram( GDALRasterBandH hBand,
  * @param papszOptions a list of name=value strings with special control 
  * options.  Normally this is NULL.
  *
+ * Unless the driver has its own implementation, the blocks intersecting the
+ * region may be read ahead of time by background threads. See
+ * GDALDataset::AdviseRead() for the conditions and the NUM_THREADS option.
+ *
  * @return CE_Failure if the request is invalid and CE_None if it works or
  * is ignored. 
  */
 
-CPLErr GDALRasterBand::AdviseRead(
-    CPL_UNUSED int nXOff, CPL_UNUSED int nYOff,
-    CPL_UNUSED int nXSize, CPL_UNUSED int nYSize,
-    CPL_UNUSED int nBufXSize, CPL_UNUSED int nBufYSize,
-    CPL_UNUSED GDALDataType eBufType, CPL_UNUSED char **papszOptions )
+CPLErr GDALRasterBand::AdviseRead( int nXOff, int nYOff,
+                                   int nXSize, int nYSize,
+                                   int nBufXSize, int nBufYSize,
+                                   CPL_UNUSED GDALDataType eBufType,
+                                   char **papszOptions )
 {
+    if( poDS != NULL && nBand >= 1 && nBand <= poDS->nBands &&
+        poDS->papoBands[nBand-1] == this &&
+        nXOff >= 0 && nXSize >= 1 && nXOff + nXSize <= nRasterXSize &&
+        nYOff >= 0 && nYSize >= 1 && nYOff + nYSize <= nRasterYSize &&
+        nBufXSize == nXSize && nBufYSize == nYSize )
+    {
+        poDS->PrefetchBlocks( nXOff, nYOff, nXSize, nYSize,
+                              1, &nBand, papszOptions );
+    }
+
     return CE_None;
 }
 
@@ -31,24 +31,69 @@
 
 #include "gdal_priv.h"
 #include "cpl_multiproc.h"
+#include "cpl_atomic_ops.h"
 
 CPL_CVSID("$Id$");
 
 static int bCacheMaxInitialized = FALSE;
 static GIntBig nCacheMax = 40 * 1024*1024;
-static volatile GIntBig nCacheUsed = 0;
 
-static GDALRasterBlock *poOldest = NULL;    /* tail */
-static GDALRasterBlock *poNewest = NULL;    /* head */
+/* -------------------------------------------------------------------- */
+/*      The block cache is made of one or several independent LRU      */
+/*      lists ("shards"), each one protected by its own lock. By        */
+/*      default there is a single shard, which is the historical        */
+/*      behaviour. The number of shards can be increased with the       */
+/*      GDAL_RB_CACHE_SHARDS configuration option, so that threads      */
+/*      working on different blocks do not contend on the same lock.    */
+/*      A block is assigned to a shard from a hash of its address,      */
+/*      which is stable during its whole lifetime and can be computed   */
+/*      without dereferencing the block.                                */
+/* -------------------------------------------------------------------- */
+#define RB_MAX_SHARDS   64
 
-#if 0
-static CPLMutex *hRBLock = NULL;
-#define INITIALIZE_LOCK         CPLMutexHolderD( &hRBLock )
-#define TAKE_LOCK               CPLMutexHolderOptionalLockD( hRBLock )
-#define DESTROY_LOCK            CPLDestroyMutex( hRBLock )
-#else
+/* -------------------------------------------------------------------- */
+/*      Each shard has two lists. With the default LRU policy, only     */
+/*      the first one is used. With the 2Q policy (GDAL_RB_CACHE_POLICY */
+/*      =2Q), new blocks enter the "probation" list and are moved to    */
+/*      the "protected" list when they are referenced again. Blocks in  */
+/*      probation are evicted first, so that a scan over a big raster   */
+/*      does not flush the blocks that are frequently used.             */
+/* -------------------------------------------------------------------- */
+typedef enum
+{
+    RB_POLICY_LRU,
+    RB_POLICY_2Q
+} GDALRBCachePolicy;
+
+struct GDALRBCacheShard
+{
+    CPLLock         *hLock;
+    GDALRasterBlock *poOldest;    /* tail of probation list */
+    GDALRasterBlock *poNewest;    /* head of probation list */
+    GDALRasterBlock *poProtectedOldest;
+    GDALRasterBlock *poProtectedNewest;
+    volatile GIntBig nUsed;       /* in both lists */
+    volatile GIntBig nProtectedUsed;
+};
+
+static GDALRBCacheShard asShards[RB_MAX_SHARDS];
+static int nShards = 1;
+static GDALRBCachePolicy eCachePolicy = RB_POLICY_LRU;
+static volatile int bShardsInitialized = FALSE;
+static CPLMutex *hRBInitMutex = NULL;
+
+/* Sum of the nUsed of all shards. It is updated atomically, so that it */
+/* can be read without taking the locks of the other shards */
+static volatile GIntBig nTotalUsed = 0;
+#if !defined(HAVE_GCC_ATOMIC_BUILTINS) && \
+    !(defined(__GNUC__) && defined(__x86_64__))
+static CPLMutex *hTotalUsedMutex = NULL;
+#endif
+
+/* Fraction of the cache under which the probation list is not evicted */
+/* in priority with the 2Q policy */
+#define RB_2Q_PROBATION_RATIO   4
 
-static CPLLock* hRBLock = NULL;
 static int bDebugContention = FALSE;
 static CPLLockType GetLockType()
 {
@@ -74,12 +119,136 @@ static CPLLockType GetLockType()
     return (CPLLockType) nLockType;
 }
 
-#define INITIALIZE_LOCK         CPLLockHolderD( &hRBLock, GetLockType() ); \
-                                CPLLockSetDebugPerf(hRBLock, bDebugContention)
-#define TAKE_LOCK               CPLLockHolderOptionalLockD( hRBLock )
-#define DESTROY_LOCK            CPLDestroyLock( hRBLock )
+#define INITIALIZE_LOCK(psShard) CPLLockHolderD( &((psShard)->hLock), GetLockType() ); \
+                                 CPLLockSetDebugPerf((psShard)->hLock, bDebugContention)
+#define TAKE_LOCK(psShard)       CPLLockHolderOptionalLockD( (psShard)->hLock )
+#define DESTROY_LOCK(psShard)    CPLDestroyLock( (psShard)->hLock )
+
+/************************************************************************/
+/*                          GetShardCount()                             */
+/************************************************************************/
+
+static int GetShardCount()
+{
+    static int nShardCount = -1;
+    if( nShardCount < 0 )
+    {
+        const char* pszShards = CPLGetConfigOption("GDAL_RB_CACHE_SHARDS", "1");
+        int nVal;
+        if( EQUAL(pszShards, "ALL_CPUS") )
+            nVal = CPLGetNumCPUs();
+        else
+            nVal = atoi(pszShards);
+        if( nVal < 1 )
+            nVal = 1;
+        else if( nVal > RB_MAX_SHARDS )
+        {
+            CPLDebug("GDAL", "GDAL_RB_CACHE_SHARDS=%s too big. Limiting to %d",
+                     pszShards, RB_MAX_SHARDS);
+            nVal = RB_MAX_SHARDS;
+        }
+        nShardCount = nVal;
+    }
+    return nShardCount;
+}
+
+/************************************************************************/
+/*                          GetCachePolicy()                            */
+/************************************************************************/
+
+static GDALRBCachePolicy GetCachePolicy()
+{
+    const char* pszPolicy = CPLGetConfigOption("GDAL_RB_CACHE_POLICY", "LRU");
+    if( EQUAL(pszPolicy, "2Q") )
+        return RB_POLICY_2Q;
+    if( !EQUAL(pszPolicy, "LRU") )
+    {
+        CPLError(CE_Warning, CPLE_NotSupported,
+                 "GDAL_RB_CACHE_POLICY=%s not supported. Falling back to LRU",
+                 pszPolicy);
+    }
+    return RB_POLICY_LRU;
+}
+
+/************************************************************************/
+/*                            InitShards()                              */
+/*                                                                      */
+/*      Must be called before any block gets into the cache.            */
+/************************************************************************/
+
+static void InitShards()
+{
+    if( bShardsInitialized )
+        return;
 
+    CPLMutexHolderD( &hRBInitMutex );
+    if( bShardsInitialized )
+        return;
+
+    nShards = GetShardCount();
+    eCachePolicy = GetCachePolicy();
+    for( int i = nShards - 1; i >= 0; i-- )
+    {
+        INITIALIZE_LOCK(&asShards[i]);
+    }
+
+    /* Full barrier, so that the shards are visible to other threads */
+    /* before the flag */
+    CPLAtomicInc( &bShardsInitialized );
+}
+
+/************************************************************************/
+/*                             GetShard()                               */
+/************************************************************************/
+
+static GDALRBCacheShard* GetShard( const GDALRasterBlock* poBlock )
+{
+    if( nShards == 1 )
+        return &asShards[0];
+    /* Low bits of heap addresses are not significant */
+    GUInt32 nHash = (GUInt32)(((size_t)poBlock) >> 4) * 2654435761U;
+    return &asShards[(nHash >> 8) % nShards];
+}
+
+/************************************************************************/
+/*                          AtomicAddTotalUsed()                        */
+/************************************************************************/
+
+static GIntBig AtomicAddTotalUsed( GIntBig nIncrement )
+{
+#if defined(HAVE_GCC_ATOMIC_BUILTINS) || \
+    (defined(__GNUC__) && defined(__x86_64__))
+    return __sync_add_and_fetch( &nTotalUsed, nIncrement );
+#else
+    CPLMutexHolderD( &hTotalUsedMutex );
+    nTotalUsed += nIncrement;
+    return nTotalUsed;
 #endif
+}
+
+/************************************************************************/
+/*                            AddUsed()                                 */
+/*                                                                      */
+/*      Account for memory entering (or leaving, if nSize < 0) a        */
+/*      shard, whose lock must be held.                                 */
+/************************************************************************/
+
+static void AddUsed( GDALRBCacheShard* psShard, GIntBig nSize )
+{
+    psShard->nUsed += nSize;
+    AtomicAddTotalUsed( nSize );
+}
+
+/************************************************************************/
+/*                           GetTotalUsed()                             */
+/*                                                                      */
+/*      Sum of the memory used by all shards.                           */
+/************************************************************************/
+
+static GIntBig GetTotalUsed()
+{
+    return AtomicAddTotalUsed( 0 );
+}
 
 //#define ENABLE_DEBUG
 
@@ -136,13 +305,9 @@ void CPL_STDCALL GDALSetCacheMax64( GIntBig nNewSizeInBytes )
 /*      Flush blocks till we are under the new limit or till we         */
 /*      can't seem to flush anymore.                                    */
 /* -------------------------------------------------------------------- */
-    while( nCacheUsed > nCacheMax )
+    while( GetTotalUsed() > nCacheMax )
     {
-        GIntBig nOldCacheUsed = nCacheUsed;
-
-        GDALFlushCacheBlock();
-
-        if( nCacheUsed == nOldCacheUsed )
+        if( !GDALFlushCacheBlock() )
             break;
     }
 }
@@ -206,9 +371,7 @@ GIntBig CPL_STDCALL GDALGetCacheMax64()
 {
     if( !bCacheMaxInitialized )
     {
-        {
-            INITIALIZE_LOCK;
-        }
+        InitShards();
         const char* pszCacheMax = CPLGetConfigOption("GDAL_CACHEMAX",NULL);
         bCacheMaxInitialized = TRUE;
         if( pszCacheMax != NULL )
@@ -244,6 +407,7 @@ GIntBig CPL_STDCALL GDALGetCacheMax64()
 
 int CPL_STDCALL GDALGetCacheUsed()
 {
+    GIntBig nCacheUsed = GetTotalUsed();
     if (nCacheUsed > INT_MAX)
     {
         static int bHasWarned = FALSE;
@@ -274,7 +438,7 @@ int CPL_STDCALL GDALGetCacheUsed()
 
 GIntBig CPL_STDCALL GDALGetCacheUsed64()
 {
-    return nCacheUsed;
+    return GetTotalUsed();
 }
 
 /************************************************************************/
@@ -314,6 +478,21 @@ int CPL_STDCALL GDALFlushCacheBlock()
  * a least recently used (LRU) list and an upper cache limit (see
  * GDALSetCacheMax()) under which the cache size is normally kept. 
  *
+ * The LRU list may be split into several independent shards, each with its
+ * own lock and a fair share of the cache limit, by setting the
+ * GDAL_RB_CACHE_SHARDS configuration option to a number of shards (or
+ * ALL_CPUS). This reduces lock contention when many threads read
+ * different blocks. Eviction is then approximately, rather than strictly,
+ * least recently used across the whole cache.
+ *
+ * The GDAL_RB_CACHE_POLICY configuration option can be set to 2Q to use a
+ * scan resistant policy instead of the default LRU one: blocks that have
+ * been referenced only once are evicted before the ones that have been
+ * referenced several times. Reads done with the
+ * GDALRasterIOExtraArg::bSequentialScan hint (see SetSequentialScanHint())
+ * never promote blocks, so that bulk copies do not evict the blocks used
+ * by other, interactive, readers.
+ *
  * Some blocks in the cache may be modified relative to the state on disk
  * (they are marked "Dirty") and must be flushed to disk before they can
  * be discarded.  Other (Clean) blocks may just be discarded if their memory
@@ -353,22 +532,37 @@ int CPL_STDCALL GDALFlushCacheBlock()
 int GDALRasterBlock::FlushCacheBlock()
 
 {
-    GDALRasterBlock *poTarget;
+    GDALRasterBlock *poTarget = NULL;
 
+    InitShards();
+
+/* -------------------------------------------------------------------- */
+/*      With several shards, start with the one that uses the most      */
+/*      memory, which is an approximation of a global LRU.              */
+/* -------------------------------------------------------------------- */
+    int iFirstShard = 0;
+    for( int i = 1; i < nShards; i++ )
     {
-        INITIALIZE_LOCK;
-        poTarget = poOldest;
+        if( asShards[i].nUsed > asShards[iFirstShard].nUsed )
+            iFirstShard = i;
+    }
 
-        while( poTarget != NULL && poTarget->GetLockCount() > 0 ) 
-            poTarget = poTarget->poPrevious;
-        
-        if( poTarget == NULL )
-            return FALSE;
+    for( int i = 0; i < nShards && poTarget == NULL; i++ )
+    {
+        GDALRBCacheShard* psShard = &asShards[(iFirstShard + i) % nShards];
+        TAKE_LOCK(psShard);
+        poTarget = GetFlushCandidate_unlocked(psShard);
 
-        poTarget->Detach_unlocked();
-        poTarget->GetBand()->UnreferenceBlock(poTarget->GetXOff(),poTarget->GetYOff());
+        if( poTarget != NULL )
+        {
+            poTarget->Detach_unlocked();
+            poTarget->GetBand()->UnreferenceBlock(poTarget->GetXOff(),poTarget->GetYOff());
+        }
     }
 
+    if( poTarget == NULL )
+        return FALSE;
+
     /* Note: flushing dirty blocks to disk is not really safe */
     /* if the underlying dataset is being read/written by another thread */
     /* This issue has always existed and has no obvious fix */
@@ -388,6 +582,54 @@ int GDALRasterBlock::FlushCacheBlock()
     return TRUE;
 }
 
+/************************************************************************/
+/*                     GetFlushCandidate_unlocked()                     */
+/*                                                                      */
+/*      Return the unlocked block of the shard that should be evicted   */
+/*      first, or NULL if there is none. Must be called with the lock   */
+/*      of the shard held.                                              */
+/************************************************************************/
+
+GDALRasterBlock *
+GDALRasterBlock::GetFlushCandidate_unlocked( GDALRBCacheShard* psShard )
+
+{
+    GDALRasterBlock* apoTails[2];
+
+    apoTails[0] = psShard->poOldest;
+    apoTails[1] = psShard->poProtectedOldest;
+
+    /* Keep the blocks in probation while they use only a small part of */
+    /* the cache, so that newly read blocks get a chance to be referenced */
+    /* again */
+    if( apoTails[1] != NULL &&
+        psShard->nUsed - psShard->nProtectedUsed <=
+                            nCacheMax / nShards / RB_2Q_PROBATION_RATIO )
+    {
+        apoTails[0] = psShard->poProtectedOldest;
+        apoTails[1] = psShard->poOldest;
+    }
+
+    /* Dirty blocks might belong to a dataset that another thread is */
+    /* writing, so leave them alone if asked to */
+    int bSkipDirty = IsDirtyBlockFlushDisabled();
+
+    for( int i = 0; i < 2; i++ )
+    {
+        GDALRasterBlock* poTarget = apoTails[i];
+
+        while( poTarget != NULL &&
+               (poTarget->GetLockCount() > 0 ||
+                (bSkipDirty && poTarget->GetDirty())) ) 
+            poTarget = poTarget->poPrevious;
+
+        if( poTarget != NULL )
+            return poTarget;
+    }
+
+    return NULL;
+}
+
 /************************************************************************/
 /*                          GDALRasterBlock()                           */
 /************************************************************************/
@@ -422,6 +664,7 @@ GDALRasterBlock::GDALRasterBlock( GDALRasterBand *poBandIn,
     nLockCount = 0;
 
     poNext = poPrevious = NULL;
+    bProtected = FALSE;
 
     nXOff = nXOffIn;
     nYOff = nYOffIn;
@@ -473,19 +716,33 @@ void GDALRasterBlock::Detach()
 {
     if( bMustDetach )
     {
-        TAKE_LOCK;
+        TAKE_LOCK(GetShard(this));
         Detach_unlocked();
     }
 }
 
 void GDALRasterBlock::Detach_unlocked()
 {
-    if( poOldest == this )
-        poOldest = poPrevious;
+    GDALRBCacheShard* psShard = GetShard(this);
+    GDALRasterBlock **ppoOldest, **ppoNewest;
+
+    if( bProtected )
+    {
+        ppoOldest = &psShard->poProtectedOldest;
+        ppoNewest = &psShard->poProtectedNewest;
+    }
+    else
+    {
+        ppoOldest = &psShard->poOldest;
+        ppoNewest = &psShard->poNewest;
+    }
+
+    if( *ppoOldest == this )
+        *ppoOldest = poPrevious;
 
-    if( poNewest == this )
+    if( *ppoNewest == this )
     {
-        poNewest = poNext;
+        *ppoNewest = poNext;
     }
 
     if( poPrevious != NULL )
@@ -499,7 +756,12 @@ void GDALRasterBlock::Detach_unlocked()
     bMustDetach = FALSE;
 
     if( pData )
-        nCacheUsed -= GetBlockSize();
+    {
+        AddUsed( psShard, -(GIntBig)GetBlockSize() );
+        if( bProtected )
+            psShard->nProtectedUsed -= GetBlockSize();
+    }
+    bProtected = FALSE;
 
 #ifdef ENABLE_DEBUG
     Verify();
@@ -518,28 +780,44 @@ void GDALRasterBlock::Detach_unlocked()
 void GDALRasterBlock::Verify()
 
 {
-    TAKE_LOCK;
-
-    CPLAssert( (poNewest == NULL && poOldest == NULL)
-               || (poNewest != NULL && poOldest != NULL) );
-
-    if( poNewest != NULL )
+#ifdef DEBUG
+    for( int i = 0; i < nShards; i++ )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        CPLAssert( poOldest->poNext == NULL );
-        
-        GDALRasterBlock* poLast = NULL;
-        for( GDALRasterBlock *poBlock = poNewest; 
-             poBlock != NULL;
-             poBlock = poBlock->poNext )
+        GDALRBCacheShard* psShard = &asShards[i];
+        TAKE_LOCK(psShard);
+
+        for( int iList = 0; iList < 2; iList++ )
         {
-            CPLAssert( poBlock->poPrevious == poLast );
+            GDALRasterBlock* poNewest = (iList == 0) ? psShard->poNewest :
+                                                psShard->poProtectedNewest;
+            GDALRasterBlock* poOldest = (iList == 0) ? psShard->poOldest :
+                                                psShard->poProtectedOldest;
 
-            poLast = poBlock;
-        }
+            CPLAssert( (poNewest == NULL && poOldest == NULL)
+                    || (poNewest != NULL && poOldest != NULL) );
+
+            if( poNewest != NULL )
+            {
+                CPLAssert( poNewest->poPrevious == NULL );
+                CPLAssert( poOldest->poNext == NULL );
 
-        CPLAssert( poOldest == poLast );
+                GDALRasterBlock* poLast = NULL;
+                for( GDALRasterBlock *poBlock = poNewest; 
+                     poBlock != NULL;
+                     poBlock = poBlock->poNext )
+                {
+                    CPLAssert( poBlock->poPrevious == poLast );
+                    CPLAssert( GetShard(poBlock) == psShard );
+                    CPLAssert( poBlock->bProtected == (iList == 1) );
+
+                    poLast = poBlock;
+                }
+
+                CPLAssert( poOldest == poLast );
+            }
+        }
     }
+#endif
 }
 
 /************************************************************************/
@@ -587,15 +865,25 @@ CPLErr GDALRasterBlock::Write()
 void GDALRasterBlock::Touch()
 
 {
-    TAKE_LOCK;
+    TAKE_LOCK(GetShard(this));
     Touch_unlocked();
 }
 
 
-void GDALRasterBlock::Touch_unlocked()
+void GDALRasterBlock::Touch_unlocked( int bHit )
 
 {
-    if( poNewest == this )
+    GDALRBCacheShard* psShard = GetShard(this);
+
+    /* bHit is set when the block is fetched from the cache. It is needed */
+    /* to promote the newest block of the probation list, which could not */
+    /* be distinguished from a block that has just been inserted. */
+    int bPromotable = !bProtected && eCachePolicy == RB_POLICY_2Q &&
+                      !GetSequentialScanHint();
+
+    if( psShard->poProtectedNewest == this )
+        return;
+    if( psShard->poNewest == this && !(bHit && bPromotable) )
         return;
 
     // In theory, we shouldn't try to touch a block that has been detached
@@ -603,13 +891,32 @@ void GDALRasterBlock::Touch_unlocked()
     if( !bMustDetach )
     {
         if( pData )
-            nCacheUsed += GetBlockSize();
+            AddUsed( psShard, GetBlockSize() );
 
         bMustDetach = TRUE;
     }
 
-    if( poOldest == this )
-        poOldest = this->poPrevious;
+    GDALRasterBlock **ppoOldest, **ppoNewest;
+    if( bProtected )
+    {
+        ppoOldest = &psShard->poProtectedOldest;
+        ppoNewest = &psShard->poProtectedNewest;
+    }
+    else
+    {
+        ppoOldest = &psShard->poOldest;
+        ppoNewest = &psShard->poNewest;
+    }
+
+    /* As the block is not at the head of its list, having a previous */
+    /* block means it is already in the cache, so this is a new reference */
+    int bPromote = bPromotable && (poPrevious != NULL || bHit);
+
+    if( *ppoOldest == this )
+        *ppoOldest = this->poPrevious;
+
+    if( *ppoNewest == this )
+        *ppoNewest = this->poNext;
     
     if( poPrevious != NULL )
         poPrevious->poNext = poNext;
@@ -617,26 +924,134 @@ void GDALRasterBlock::Touch_unlocked()
     if( poNext != NULL )
         poNext->poPrevious = poPrevious;
 
+    if( bPromote )
+    {
+        bProtected = TRUE;
+        if( pData )
+            psShard->nProtectedUsed += GetBlockSize();
+        ppoOldest = &psShard->poProtectedOldest;
+        ppoNewest = &psShard->poProtectedNewest;
+    }
+
     poPrevious = NULL;
-    poNext = poNewest;
+    poNext = *ppoNewest;
 
-    if( poNewest != NULL )
+    if( *ppoNewest != NULL )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        poNewest->poPrevious = this;
+        CPLAssert( (*ppoNewest)->poPrevious == NULL );
+        (*ppoNewest)->poPrevious = this;
     }
-    poNewest = this;
+    *ppoNewest = this;
     
-    if( poOldest == NULL )
+    if( *ppoOldest == NULL )
     {
         CPLAssert( poPrevious == NULL && poNext == NULL );
-        poOldest = this;
+        *ppoOldest = this;
     }
 #ifdef ENABLE_DEBUG
     Verify();
 #endif
 }
 
+/************************************************************************/
+/*                       SetSequentialScanHint()                        */
+/************************************************************************/
+
+/**
+ * \brief Set if the current thread is doing a sequential scan.
+ *
+ * While this hint is set, the blocks referenced by the current thread are
+ * not promoted to the protected part of the cache when the 2Q policy is
+ * selected with the GDAL_RB_CACHE_POLICY configuration option. It is
+ * normally set by RasterIO() when GDALRasterIOExtraArg::bSequentialScan
+ * is set.
+ *
+ * @param bSequentialScan TRUE to set the hint, FALSE to unset it.
+ *
+ * @return the previous value of the hint.
+ *
+ * @since GDAL 2.0
+ */
+
+int GDALRasterBlock::SetSequentialScanHint( int bSequentialScan )
+
+{
+    int bOldValue = GetSequentialScanHint();
+    if( bOldValue != bSequentialScan )
+        CPLSetTLS( CTLS_RB_SEQUENTIAL_SCAN,
+                   bSequentialScan ? (void*) 1 : NULL, FALSE );
+    return bOldValue;
+}
+
+/************************************************************************/
+/*                       GetSequentialScanHint()                        */
+/************************************************************************/
+
+/**
+ * \brief Return if the current thread is doing a sequential scan.
+ *
+ * @see SetSequentialScanHint()
+ *
+ * @since GDAL 2.0
+ */
+
+int GDALRasterBlock::GetSequentialScanHint()
+
+{
+    return CPLGetTLS( CTLS_RB_SEQUENTIAL_SCAN ) != NULL;
+}
+
+/************************************************************************/
+/*                     SetDirtyBlockFlushDisabled()                     */
+/************************************************************************/
+
+/**
+ * \brief Set if the current thread may write dirty blocks when evicting.
+ *
+ * When the cache is full, the thread that needs room writes the dirty
+ * blocks it evicts. This is not safe if the dataset of those blocks is
+ * being written by another thread, so a thread that only reads (such as
+ * the reader thread of GDALDatasetCopyWholeRaster() in pipelined mode) can
+ * disable it, and will then only evict clean blocks. The cache may
+ * temporarily exceed its maximum size until the writing thread flushes
+ * its blocks.
+ *
+ * @param bDisabled TRUE to prevent the current thread from writing dirty
+ * blocks, FALSE to allow it again.
+ *
+ * @return the previous value.
+ *
+ * @since GDAL 2.0
+ */
+
+int GDALRasterBlock::SetDirtyBlockFlushDisabled( int bDisabled )
+
+{
+    int bOldValue = IsDirtyBlockFlushDisabled();
+    if( bOldValue != bDisabled )
+        CPLSetTLS( CTLS_RB_DIRTY_FLUSH_DISABLED,
+                   bDisabled ? (void*) 1 : NULL, FALSE );
+    return bOldValue;
+}
+
+/************************************************************************/
+/*                     IsDirtyBlockFlushDisabled()                      */
+/************************************************************************/
+
+/**
+ * \brief Return if the current thread is prevented from writing dirty blocks.
+ *
+ * @see SetDirtyBlockFlushDisabled()
+ *
+ * @since GDAL 2.0
+ */
+
+int GDALRasterBlock::IsDirtyBlockFlushDisabled()
+
+{
+    return CPLGetTLS( CTLS_RB_DIRTY_FLUSH_DISABLED ) != NULL;
+}
+
 /************************************************************************/
 /*                            Internalize()                             */
 /************************************************************************/
@@ -660,32 +1075,40 @@ CPLErr GDALRasterBlock::Internalize()
 
     CPLAssert( pData == NULL );
 
-    // This call will initialize the hRBLock mutex. Other call places can
-    // only be called if we have go through there.
+    // This call will initialize the shard locks. Other call places can
+    // only be called if we have go through there. This must not be left
+    // to GDALGetCacheMax64(), as it is a no-op if GDALSetCacheMax() has
+    // been called before.
+    InitShards();
+
     GIntBig     nCurCacheMax = GDALGetCacheMax64();
 
     /* No risk of overflow as it is checked in GDALRasterBand::InitBlockInfo() */
     nSizeInBytes = GetBlockSize();
 
+    /* Fair share of the cache of each shard. With a single shard, this */
+    /* is the whole cache */
+    GIntBig     nShardCacheMax = nCurCacheMax / nShards;
+
 /* -------------------------------------------------------------------- */
 /*      Flush old blocks if we are nearing our memory limit.            */
+/*      As long as the global limit is exceeded, we evict from our own  */
+/*      shard if it uses more than its fair share.                      */
 /* -------------------------------------------------------------------- */
     GDALRasterBlock* apoBlocksToFree[64];
     int nBlocksToFree = 0;
     {
-        TAKE_LOCK;
+        GDALRBCacheShard* psShard = GetShard(this);
+        TAKE_LOCK(psShard);
 
-        nCacheUsed += nSizeInBytes;
-        GDALRasterBlock *poTarget = poOldest;
-        while( nCacheUsed > nCurCacheMax )
+        AddUsed( psShard, nSizeInBytes );
+        while( GetTotalUsed() > nCurCacheMax &&
+               (nShards == 1 || psShard->nUsed > nShardCacheMax) )
         {
-            while( poTarget != NULL && poTarget->GetLockCount() > 0 ) 
-                poTarget = poTarget->poPrevious;
+            GDALRasterBlock *poTarget = GetFlushCandidate_unlocked(psShard);
 
             if( poTarget != NULL )
             {
-                GDALRasterBlock* _poPrevious = poTarget->poPrevious;
-
                 poTarget->Detach_unlocked();
                 poTarget->GetBand()->UnreferenceBlock(poTarget->GetXOff(),poTarget->GetYOff());
 
@@ -695,8 +1118,6 @@ CPLErr GDALRasterBlock::Internalize()
                     CPLDebug("GDAL", "More than 64 blocks are flagged to be flushed. Not trying more");
                     break;
                 }
-
-                poTarget = _poPrevious;
             }
             else
                 break;
@@ -708,6 +1129,45 @@ CPLErr GDALRasterBlock::Internalize()
         Touch_unlocked();
     }
 
+/* -------------------------------------------------------------------- */
+/*      If we are still above the global limit, it means that other     */
+/*      shards use more than their share. Take blocks from them, the    */
+/*      most loaded first.                                              */
+/* -------------------------------------------------------------------- */
+    for( int iIter = 1; iIter < nShards && nBlocksToFree < 64 &&
+                        GetTotalUsed() > nCurCacheMax; iIter++ )
+    {
+        GDALRBCacheShard* psShard = NULL;
+        for( int i = 0; i < nShards; i++ )
+        {
+            if( asShards[i].nUsed > nShardCacheMax &&
+                (psShard == NULL || asShards[i].nUsed > psShard->nUsed) )
+                psShard = &asShards[i];
+        }
+        if( psShard == NULL )
+            break;
+
+        TAKE_LOCK(psShard);
+
+        GDALRasterBlock *poTarget = NULL;
+        while( GetTotalUsed() > nCurCacheMax &&
+               psShard->nUsed > nShardCacheMax && nBlocksToFree < 64 )
+        {
+            poTarget = GetFlushCandidate_unlocked(psShard);
+            if( poTarget == NULL )
+                break;
+
+            poTarget->Detach_unlocked();
+            poTarget->GetBand()->UnreferenceBlock(poTarget->GetXOff(),poTarget->GetYOff());
+
+            apoBlocksToFree[nBlocksToFree++] = poTarget;
+        }
+
+        /* Only locked blocks left in that shard. Don't try it again */
+        if( poTarget == NULL )
+            break;
+    }
+
     /* Now free blocks we have detached and removed from their band */
     pNewData = NULL;
     for(int i=0;i<nBlocksToFree;i++)
@@ -801,9 +1261,10 @@ void GDALRasterBlock::MarkClean()
  * \brief Safely lock block.
  *
  * This method locks a GDALRasterBlock (and touches it) in a thread-safe
- * manner.  The global block cache mutex is held while locking the block,
- * in order to avoid race conditions with other threads that might be
- * trying to expire the block at the same time.  The block pointer may be
+ * manner.  The block cache mutex (of the cache shard to which the block
+ * belongs) is held while locking the block, in order to avoid race
+ * conditions with other threads that might be trying to expire the block
+ * at the same time.  The block pointer may be
  * safely NULL, in which case this method does nothing. 
  *
  * @param ppBlock Pointer to the block pointer to try and lock/touch.
@@ -814,17 +1275,25 @@ int GDALRasterBlock::SafeLockBlock( GDALRasterBlock ** ppBlock )
 {
     CPLAssert( NULL != ppBlock );
 
-    TAKE_LOCK;
-
-    if( *ppBlock != NULL )
+    /* The lock to take depends on the block itself, so we must check */
+    /* that the block has not been evicted (and maybe replaced) by */
+    /* another thread once we hold the lock */
+    while( true )
     {
-        (*ppBlock)->AddLock();
-        (*ppBlock)->Touch_unlocked();
-        
-        return TRUE;
+        GDALRasterBlock* poBlock = *((GDALRasterBlock* volatile *)ppBlock);
+        if( poBlock == NULL )
+            return FALSE;
+
+        TAKE_LOCK(GetShard(poBlock));
+
+        if( *ppBlock == poBlock )
+        {
+            poBlock->AddLock();
+            poBlock->Touch_unlocked( TRUE );
+
+            return TRUE;
+        }
     }
-    else
-        return FALSE;
 }
 
 /************************************************************************/
@@ -833,7 +1302,20 @@ int GDALRasterBlock::SafeLockBlock( GDALRasterBlock ** ppBlock )
 
 void GDALRasterBlock::DestroyRBMutex()
 {
-    if( hRBLock != NULL )
-        DESTROY_LOCK;
-    hRBLock = NULL;
+    for( int i = 0; i < RB_MAX_SHARDS; i++ )
+    {
+        if( asShards[i].hLock != NULL )
+            DESTROY_LOCK(&asShards[i]);
+        asShards[i].hLock = NULL;
+    }
+    bShardsInitialized = FALSE;
+    if( hRBInitMutex != NULL )
+        CPLDestroyMutex( hRBInitMutex );
+    hRBInitMutex = NULL;
+#if !defined(HAVE_GCC_ATOMIC_BUILTINS) && \
+    !(defined(__GNUC__) && defined(__x86_64__))
+    if( hTotalUsedMutex != NULL )
+        CPLDestroyMutex( hTotalUsedMutex );
+    hTotalUsedMutex = NULL;
+#endif
 }
@@ -2301,6 +2301,11 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
     int  nChunkYOff = 0;
     CPLErr eErr = CE_None;
 
+    /* The source is read only once, so don't let it evict hot blocks */
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+    sExtraArg.bSequentialScan = TRUE;
+
     for( nChunkYOff = 0; 
          nChunkYOff < nHeight && eErr == CE_None; 
          nChunkYOff += nFullResYChunk )
@@ -2329,11 +2334,11 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
         if (eErr == CE_None)
             eErr = poSrcBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried, 
                                 pChunk, nWidth, nChunkYSizeQueried, eType,
-                                0, 0, NULL );
+                                0, 0, &sExtraArg );
         if (eErr == CE_None && bUseNoDataMask)
             eErr = poMaskBand->RasterIO( GF_Read, 0, nChunkYOffQueried, nWidth, nChunkYSizeQueried, 
                                 pabyChunkNodataMask, nWidth, nChunkYSizeQueried, GDT_Byte,
-                                0, 0, NULL );
+                                0, 0, &sExtraArg );
 
         /* special case to promote 1bit data to 8bit 0/255 values */
         if( EQUAL(pszResampling,"AVERAGE_BIT2GRAYSCALE") )
@@ -2648,6 +2653,11 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
         pafNoDataValue[iBand] = (float) papoSrcBands[iBand]->GetNoDataValue(&pabHasNoData[iBand]);
     }
 
+    /* The source is read only once, so don't let it evict hot blocks */
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+    sExtraArg.bSequentialScan = TRUE;
+
     /* Second pass to do the real job ! */
     double dfCurPixelCount = 0;
     for(iOverview=0;iOverview<nOverviews && eErr == CE_None;iOverview++)
@@ -2799,7 +2809,7 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                                                 nChunkXSizeQueried, nChunkYSizeQueried, 
                                                 papaChunk[iBand],
                                                 nChunkXSizeQueried, nChunkYSizeQueried,
-                                                eWrkDataType, 0, 0, NULL );
+                                                eWrkDataType, 0, 0, &sExtraArg );
                 }
 
                 if (bUseNoDataMask && eErr == CE_None)
@@ -2814,7 +2824,7 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                                                                nChunkXSizeQueried, nChunkYSizeQueried, 
                                                                pabyChunkNoDataMask,
                                                                nChunkXSizeQueried, nChunkYSizeQueried,
-                                                               GDT_Byte, 0, 0, NULL );
+                                                               GDT_Byte, 0, 0, &sExtraArg );
                 }
 
                 /* Compute the resulting overview block */
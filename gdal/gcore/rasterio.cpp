@@ -51,6 +51,12 @@
 #define USE_NEW_COPYWORDS 1
 #endif
 
+// SSE2 is always available on x86_64, so no runtime check is needed
+#if defined(USE_NEW_COPYWORDS) && (defined(__x86_64) || defined(_M_X64))
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 CPL_CVSID("$Id$");
 
@@ -1433,9 +1439,9 @@ inline void CopyWord(const float fValueIn, unsigned int &nValueOut)
  */
 
 template <class Tin, class Tout>
-static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
-                           Tout* const pDstData, int nDstPixelStride,
-                           int nWordCount)
+static void GDALCopyWordsGenericT(const Tin* const pSrcData, int nSrcPixelStride,
+                                  Tout* const pDstData, int nDstPixelStride,
+                                  int nWordCount)
 {
     std::ptrdiff_t nDstOffset = 0;
 
@@ -1452,6 +1458,230 @@ static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
     }
 }
 
+template <class Tin, class Tout>
+static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
+                           Tout* const pDstData, int nDstPixelStride,
+                           int nWordCount)
+{
+    GDALCopyWordsGenericT(pSrcData, nSrcPixelStride,
+                          pDstData, nDstPixelStride, nWordCount);
+}
+
+#ifdef USE_SSE2
+
+/************************************************************************/
+/*                       GDALCopyWordsPackedT()                         */
+/************************************************************************/
+/**
+ * Use a SIMD kernel for the bulk of packed buffers, and the generic
+ * template for the remaining words or strided buffers. The kernels
+ * must give exactly the same results as CopyWord().
+ *
+ * @param pfnPackedKernel function converting packed words, that returns
+ *                        the number of words it has processed.
+ */
+
+template <class Tin, class Tout>
+inline void GDALCopyWordsPackedT(const Tin* const pSrcData, int nSrcPixelStride,
+                                 Tout* const pDstData, int nDstPixelStride,
+                                 int nWordCount,
+                                 int (*pfnPackedKernel)(const Tin*, Tout*, int))
+{
+    int nDone = 0;
+    if (nSrcPixelStride == static_cast<int>(sizeof(Tin)) &&
+        nDstPixelStride == static_cast<int>(sizeof(Tout)))
+    {
+        nDone = pfnPackedKernel(pSrcData, pDstData, nWordCount);
+    }
+    GDALCopyWordsGenericT(pSrcData + nDone, nSrcPixelStride,
+                          pDstData + nDone, nDstPixelStride,
+                          nWordCount - nDone);
+}
+
+/************************************************************************/
+/*                        SSE2 packed kernels                           */
+/************************************************************************/
+
+int GDALCopyByteToUInt16SSE2(const GByte* pSrc, GUInt16* pDst, int nWordCount)
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 15 < nWordCount; i += 16)
+    {
+        __m128i xmm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i),
+                         _mm_unpacklo_epi8(xmm, xmm_zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i + 8),
+                         _mm_unpackhi_epi8(xmm, xmm_zero));
+    }
+    return i;
+}
+
+int GDALCopyByteToInt16SSE2(const GByte* pSrc, GInt16* pDst, int nWordCount)
+{
+    return GDALCopyByteToUInt16SSE2(pSrc, reinterpret_cast<GUInt16*>(pDst),
+                                    nWordCount);
+}
+
+int GDALCopyByteToFloat32SSE2(const GByte* pSrc, float* pDst, int nWordCount)
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 15 < nWordCount; i += 16)
+    {
+        __m128i xmm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        __m128i xmm_lo = _mm_unpacklo_epi8(xmm, xmm_zero);
+        __m128i xmm_hi = _mm_unpackhi_epi8(xmm, xmm_zero);
+        _mm_storeu_ps(pDst + i,
+                      _mm_cvtepi32_ps(_mm_unpacklo_epi16(xmm_lo, xmm_zero)));
+        _mm_storeu_ps(pDst + i + 4,
+                      _mm_cvtepi32_ps(_mm_unpackhi_epi16(xmm_lo, xmm_zero)));
+        _mm_storeu_ps(pDst + i + 8,
+                      _mm_cvtepi32_ps(_mm_unpacklo_epi16(xmm_hi, xmm_zero)));
+        _mm_storeu_ps(pDst + i + 12,
+                      _mm_cvtepi32_ps(_mm_unpackhi_epi16(xmm_hi, xmm_zero)));
+    }
+    return i;
+}
+
+int GDALCopyUInt16ToByteSSE2(const GUInt16* pSrc, GByte* pDst, int nWordCount)
+{
+    const __m128i xmm_255 = _mm_set1_epi16(255);
+    int i = 0;
+    for (; i + 15 < nWordCount; i += 16)
+    {
+        __m128i xmm0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 8));
+        // min(x, 255) = x - max(x - 255, 0) with unsigned saturation, since
+        // _mm_packus_epi16() takes signed words
+        xmm0 = _mm_sub_epi16(xmm0, _mm_subs_epu16(xmm0, xmm_255));
+        xmm1 = _mm_sub_epi16(xmm1, _mm_subs_epu16(xmm1, xmm_255));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i),
+                         _mm_packus_epi16(xmm0, xmm1));
+    }
+    return i;
+}
+
+int GDALCopyInt16ToByteSSE2(const GInt16* pSrc, GByte* pDst, int nWordCount)
+{
+    int i = 0;
+    for (; i + 15 < nWordCount; i += 16)
+    {
+        __m128i xmm0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i),
+                         _mm_packus_epi16(xmm0, xmm1));
+    }
+    return i;
+}
+
+// Same as CopyWord(float, GByte&) : truncation of the value + 0.5 clamped
+// to [0,255]. _mm_max_ps() returns its second argument for NaN input.
+#define FLOAT_TO_BYTE_INT32(xmm) \
+    _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(xmm, xmm_half), \
+                                           xmm_zero), xmm_255))
+
+int GDALCopyFloat32ToByteSSE2(const float* pSrc, GByte* pDst, int nWordCount)
+{
+    const __m128 xmm_half = _mm_set1_ps(0.5f);
+    const __m128 xmm_zero = _mm_setzero_ps();
+    const __m128 xmm_255 = _mm_set1_ps(255.0f);
+    int i = 0;
+    for (; i + 15 < nWordCount; i += 16)
+    {
+        __m128i xmm0 = FLOAT_TO_BYTE_INT32(_mm_loadu_ps(pSrc + i));
+        __m128i xmm1 = FLOAT_TO_BYTE_INT32(_mm_loadu_ps(pSrc + i + 4));
+        __m128i xmm2 = FLOAT_TO_BYTE_INT32(_mm_loadu_ps(pSrc + i + 8));
+        __m128i xmm3 = FLOAT_TO_BYTE_INT32(_mm_loadu_ps(pSrc + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i),
+                         _mm_packus_epi16(_mm_packs_epi32(xmm0, xmm1),
+                                          _mm_packs_epi32(xmm2, xmm3)));
+    }
+    return i;
+}
+
+#undef FLOAT_TO_BYTE_INT32
+
+#define DOUBLE_TO_BYTE_INT32(xmm) \
+    _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(_mm_add_pd(xmm, xmm_half), \
+                                           xmm_zero), xmm_255))
+
+int GDALCopyFloat64ToByteSSE2(const double* pSrc, GByte* pDst, int nWordCount)
+{
+    const __m128d xmm_half = _mm_set1_pd(0.5);
+    const __m128d xmm_zero = _mm_setzero_pd();
+    const __m128d xmm_255 = _mm_set1_pd(255.0);
+    int i = 0;
+    for (; i + 7 < nWordCount; i += 8)
+    {
+        // _mm_cvttpd_epi32() sets the 2 converted values in the low half
+        __m128i xmm0 = _mm_unpacklo_epi64(
+            DOUBLE_TO_BYTE_INT32(_mm_loadu_pd(pSrc + i)),
+            DOUBLE_TO_BYTE_INT32(_mm_loadu_pd(pSrc + i + 2)));
+        __m128i xmm1 = _mm_unpacklo_epi64(
+            DOUBLE_TO_BYTE_INT32(_mm_loadu_pd(pSrc + i + 4)),
+            DOUBLE_TO_BYTE_INT32(_mm_loadu_pd(pSrc + i + 6)));
+        __m128i xmm = _mm_packus_epi16(_mm_packs_epi32(xmm0, xmm1), xmm0);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + i), xmm);
+    }
+    return i;
+}
+
+#undef DOUBLE_TO_BYTE_INT32
+
+int GDALCopyFloat32ToFloat64SSE2(const float* pSrc, double* pDst, int nWordCount)
+{
+    int i = 0;
+    for (; i + 3 < nWordCount; i += 4)
+    {
+        __m128 xmm = _mm_loadu_ps(pSrc + i);
+        _mm_storeu_pd(pDst + i, _mm_cvtps_pd(xmm));
+        _mm_storeu_pd(pDst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(xmm, xmm)));
+    }
+    return i;
+}
+
+int GDALCopyFloat64ToFloat32SSE2(const double* pSrc, float* pDst, int nWordCount)
+{
+    int i = 0;
+    for (; i + 3 < nWordCount; i += 4)
+    {
+        __m128 xmm0 = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i));
+        __m128 xmm1 = _mm_cvtpd_ps(_mm_loadu_pd(pSrc + i + 2));
+        _mm_storeu_ps(pDst + i, _mm_movelh_ps(xmm0, xmm1));
+    }
+    return i;
+}
+
+/************************************************************************/
+/*                  GDALCopyWordsT() specializations                    */
+/************************************************************************/
+
+#define SPECIALIZE_GDAL_COPY_WORDS(Tin, Tout, pfnPackedKernel) \
+template <> \
+void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride, \
+                    Tout* const pDstData, int nDstPixelStride, \
+                    int nWordCount) \
+{ \
+    GDALCopyWordsPackedT(pSrcData, nSrcPixelStride, \
+                         pDstData, nDstPixelStride, \
+                         nWordCount, pfnPackedKernel); \
+}
+
+SPECIALIZE_GDAL_COPY_WORDS(GByte, GUInt16, GDALCopyByteToUInt16SSE2)
+SPECIALIZE_GDAL_COPY_WORDS(GByte, GInt16, GDALCopyByteToInt16SSE2)
+SPECIALIZE_GDAL_COPY_WORDS(GByte, float, GDALCopyByteToFloat32SSE2)
+SPECIALIZE_GDAL_COPY_WORDS(GUInt16, GByte, GDALCopyUInt16ToByteSSE2)
+SPECIALIZE_GDAL_COPY_WORDS(GInt16, GByte, GDALCopyInt16ToByteSSE2)
+SPECIALIZE_GDAL_COPY_WORDS(float, GByte, GDALCopyFloat32ToByteSSE2)
+SPECIALIZE_GDAL_COPY_WORDS(double, GByte, GDALCopyFloat64ToByteSSE2)
+SPECIALIZE_GDAL_COPY_WORDS(float, double, GDALCopyFloat32ToFloat64SSE2)
+SPECIALIZE_GDAL_COPY_WORDS(double, float, GDALCopyFloat64ToFloat32SSE2)
+
+#undef SPECIALIZE_GDAL_COPY_WORDS
+
+#endif // USE_SSE2
+
 /************************************************************************/
 /*                   GDALCopyWordsComplexT()                            */
 /************************************************************************/
@@ -3490,6 +3720,417 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
     *pnSwathLines = nSwathLines;
 }
 
+/************************************************************************/
+/*                  Pipelined GDALDatasetCopyWholeRaster                */
+/*                                                                      */
+/*      The reading of the source swaths, their conversion to the       */
+/*      destination data type and their writing are done by three      */
+/*      stages that communicate through a ring of CWR_QUEUE_SIZE swath  */
+/*      buffers. The reader and converter stages run in their own       */
+/*      thread, the writer stage in the calling thread, so that the     */
+/*      progress callback is still called from there, and the           */
+/*      destination dataset is only accessed from a single thread.      */
+/*      The swaths are made smaller than in the sequential copy, so     */
+/*      that all the buffers of the ring fit in the same memory budget. */
+/************************************************************************/
+
+#define CWR_QUEUE_SIZE 3
+
+typedef struct
+{
+    GDALDataset  *poSrcDS;
+    int           nBandCount;
+    int           bInterleave;
+    int           nXSize;
+    int           nYSize;
+    int           nSwathCols;
+    int           nSwathLines;
+    int           nXSwaths;
+    int           nSwathsPerBand;
+    int           nTotalSwaths;
+
+    GDALDataType  eReadDT;
+    GDALDataType  eDT;
+    void         *apReadBuf[CWR_QUEUE_SIZE];
+    void         *apWriteBuf[CWR_QUEUE_SIZE];
+
+    /* Number of swaths that have completed each stage. Only modified */
+    /* with hMutex held */
+    int           nRead;
+    int           nConverted;
+    int           nWritten;
+    int           bStop;
+    CPLErr        eErr;
+
+    /* Error raised by the reader thread, to be emitted again from the */
+    /* calling thread */
+    int           nReaderErrNo;
+    char         *pszReaderErrMsg;
+
+    CPLMutex     *hMutex;
+    CPLCond      *hCond;
+} GDALCWRPipeline;
+
+/************************************************************************/
+/*                      GDALCWRPipelineGetSwath()                       */
+/************************************************************************/
+
+static void GDALCWRPipelineGetSwath( const GDALCWRPipeline* psPipeline,
+                                     int iSwath, int* pnBand,
+                                     int* pnXOff, int* pnYOff,
+                                     int* pnXSize, int* pnYSize )
+{
+    *pnBand = iSwath / psPipeline->nSwathsPerBand + 1;
+    iSwath %= psPipeline->nSwathsPerBand;
+    *pnXOff = (iSwath % psPipeline->nXSwaths) * psPipeline->nSwathCols;
+    *pnYOff = (iSwath / psPipeline->nXSwaths) * psPipeline->nSwathLines;
+    *pnXSize = MIN(psPipeline->nSwathCols, psPipeline->nXSize - *pnXOff);
+    *pnYSize = MIN(psPipeline->nSwathLines, psPipeline->nYSize - *pnYOff);
+}
+
+/************************************************************************/
+/*                     GDALCWRPipelineWaitFor()                         */
+/*                                                                      */
+/*      Wait until the stage counter pointed by pnCounter is greater    */
+/*      than nValue. Returns FALSE if the pipeline has been stopped.    */
+/************************************************************************/
+
+static int GDALCWRPipelineWaitFor( GDALCWRPipeline* psPipeline,
+                                   int* pnCounter, int nValue )
+{
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    while( !psPipeline->bStop && *pnCounter <= nValue )
+        CPLCondWait( psPipeline->hCond, psPipeline->hMutex );
+    int bRet = !psPipeline->bStop;
+    CPLReleaseMutex( psPipeline->hMutex );
+    return bRet;
+}
+
+/************************************************************************/
+/*                      GDALCWRPipelineSetDone()                        */
+/************************************************************************/
+
+static void GDALCWRPipelineSetDone( GDALCWRPipeline* psPipeline,
+                                    int* pnCounter, int nValue,
+                                    CPLErr eErr )
+{
+    CPLAcquireMutex( psPipeline->hMutex, 1000.0 );
+    if( eErr != CE_None )
+    {
+        psPipeline->eErr = eErr;
+        psPipeline->bStop = TRUE;
+    }
+    else
+    {
+        *pnCounter = nValue;
+        /* No conversion stage: swaths are ready to be written as soon */
+        /* as they are read */
+        if( pnCounter == &psPipeline->nRead &&
+            psPipeline->eReadDT == psPipeline->eDT )
+            psPipeline->nConverted = nValue;
+    }
+    CPLCondBroadcast( psPipeline->hCond );
+    CPLReleaseMutex( psPipeline->hMutex );
+}
+
+/************************************************************************/
+/*                    GDALCWRPipelineReaderThread()                     */
+/************************************************************************/
+
+static void GDALCWRPipelineReaderThread( void* pData )
+{
+    GDALCWRPipeline* psPipeline = (GDALCWRPipeline*) pData;
+
+    /* Blocks of the destination dataset might be dirty in the cache, and */
+    /* the writer thread is the only one allowed to flush them */
+    int bOldDisabled = GDALRasterBlock::SetDirtyBlockFlushDisabled(TRUE);
+
+    /* Errors of this thread would be lost for the caller: collect them */
+    /* instead, so that they are emitted again from the calling thread */
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+    sExtraArg.bSequentialScan = TRUE;
+
+    for( int iSwath = 0; iSwath < psPipeline->nTotalSwaths; iSwath++ )
+    {
+        /* Wait for the writer to release the buffer */
+        if( !GDALCWRPipelineWaitFor( psPipeline, &psPipeline->nWritten,
+                                     iSwath - CWR_QUEUE_SIZE ) )
+            break;
+
+        int nBand, nXOff, nYOff, nXSize, nYSize;
+        GDALCWRPipelineGetSwath( psPipeline, iSwath, &nBand,
+                                 &nXOff, &nYOff, &nXSize, &nYSize );
+
+        CPLErr eErr = psPipeline->poSrcDS->RasterIO( GF_Read,
+                                nXOff, nYOff, nXSize, nYSize,
+                                psPipeline->apReadBuf[iSwath % CWR_QUEUE_SIZE],
+                                nXSize, nYSize, psPipeline->eReadDT,
+                                psPipeline->bInterleave ? psPipeline->nBandCount : 1,
+                                psPipeline->bInterleave ? NULL : &nBand,
+                                0, 0, 0, &sExtraArg );
+
+        if( eErr != CE_None )
+        {
+            /* Only read by the calling thread once this one is joined */
+            psPipeline->nReaderErrNo = CPLGetLastErrorNo();
+            psPipeline->pszReaderErrMsg = CPLStrdup( CPLGetLastErrorMsg() );
+        }
+
+        GDALCWRPipelineSetDone( psPipeline, &psPipeline->nRead, iSwath + 1,
+                                eErr );
+        if( eErr != CE_None )
+            break;
+    }
+
+    CPLPopErrorHandler();
+
+    GDALRasterBlock::SetDirtyBlockFlushDisabled(bOldDisabled);
+}
+
+/************************************************************************/
+/*                   GDALCWRPipelineConverterThread()                   */
+/************************************************************************/
+
+static void GDALCWRPipelineConverterThread( void* pData )
+{
+    GDALCWRPipeline* psPipeline = (GDALCWRPipeline*) pData;
+    int nReadWordSize = GDALGetDataTypeSize(psPipeline->eReadDT) / 8;
+    int nWordSize = GDALGetDataTypeSize(psPipeline->eDT) / 8;
+
+    for( int iSwath = 0; iSwath < psPipeline->nTotalSwaths; iSwath++ )
+    {
+        if( !GDALCWRPipelineWaitFor( psPipeline, &psPipeline->nRead, iSwath ) )
+            break;
+
+        int nBand, nXOff, nYOff, nXSize, nYSize;
+        GDALCWRPipelineGetSwath( psPipeline, iSwath, &nBand,
+                                 &nXOff, &nYOff, &nXSize, &nYSize );
+
+        int nWords = nXSize * nYSize;
+        if( psPipeline->bInterleave )
+            nWords *= psPipeline->nBandCount;
+
+        GDALCopyWords( psPipeline->apReadBuf[iSwath % CWR_QUEUE_SIZE],
+                       psPipeline->eReadDT, nReadWordSize,
+                       psPipeline->apWriteBuf[iSwath % CWR_QUEUE_SIZE],
+                       psPipeline->eDT, nWordSize, nWords );
+
+        GDALCWRPipelineSetDone( psPipeline, &psPipeline->nConverted,
+                                iSwath + 1, CE_None );
+    }
+}
+
+/************************************************************************/
+/*                     GDALCWRPipelineGetReadDataType()                 */
+/*                                                                      */
+/*      The conversion to the destination data type is done in its own  */
+/*      stage only if all the source bands share the same data type,    */
+/*      as this is the type we read them into.                          */
+/************************************************************************/
+
+static GDALDataType GDALCWRPipelineGetReadDataType( GDALDataset* poSrcDS,
+                                                    GDALDataset* poDstDS )
+{
+    GDALDataType eDT = poDstDS->GetRasterBand(1)->GetRasterDataType();
+    GDALDataType eReadDT = poSrcDS->GetRasterBand(1)->GetRasterDataType();
+    for( int i = 1; i < poDstDS->GetRasterCount(); i++ )
+    {
+        if( poSrcDS->GetRasterBand(i+1)->GetRasterDataType() != eReadDT )
+            return eDT;
+    }
+    return eReadDT;
+}
+
+/************************************************************************/
+/*                    GDALCWRPipelineGetSwathLines()                    */
+/*                                                                      */
+/*      Return the height of the swaths of the pipelined copy, so that  */
+/*      its CWR_QUEUE_SIZE read (and conversion) buffers use no more    */
+/*      memory than the single buffer of the sequential copy, or 0 if   */
+/*      this cannot be achieved.                                        */
+/************************************************************************/
+
+static int GDALCWRPipelineGetSwathLines( GDALDataset* poSrcDS,
+                                         GDALDataset* poDstDS,
+                                         int bInterleave,
+                                         int bDstIsCompressed,
+                                         int nSwathCols, int nSwathLines )
+{
+    GDALDataType eDT = poDstDS->GetRasterBand(1)->GetRasterDataType();
+    GDALDataType eReadDT = GDALCWRPipelineGetReadDataType( poSrcDS, poDstDS );
+    int nPixelCount = (bInterleave) ? poDstDS->GetRasterCount() : 1;
+
+    GIntBig nBudget = (GIntBig)nSwathCols * nSwathLines * nPixelCount *
+                                        (GDALGetDataTypeSize(eDT) / 8);
+    GIntBig nBytesPerLine = (GIntBig)nSwathCols * nPixelCount *
+                                        (GDALGetDataTypeSize(eReadDT) / 8);
+    if( eReadDT != eDT )
+        nBytesPerLine += (GIntBig)nSwathCols * nPixelCount *
+                                        (GDALGetDataTypeSize(eDT) / 8);
+    nBytesPerLine *= CWR_QUEUE_SIZE;
+
+    int nLines = (int)(nBudget / nBytesPerLine);
+
+    /* Keep writing each block of a compressed destination only once */
+    if( bDstIsCompressed )
+    {
+        int nBlockXSize, nBlockYSize;
+        poDstDS->GetRasterBand(1)->GetBlockSize( &nBlockXSize, &nBlockYSize );
+        if( nLines < poDstDS->GetRasterYSize() )
+            nLines = ROUND_TO(nLines, nBlockYSize);
+    }
+
+    return MIN(nLines, nSwathLines);
+}
+
+/************************************************************************/
+/*                      GDALCWRPipelineFreeBuffers()                    */
+/************************************************************************/
+
+static void GDALCWRPipelineFreeBuffers( GDALCWRPipeline* psPipeline )
+{
+    for( int i = 0; i < CWR_QUEUE_SIZE; i++ )
+    {
+        if( psPipeline->apWriteBuf[i] != psPipeline->apReadBuf[i] )
+            CPLFree( psPipeline->apWriteBuf[i] );
+        CPLFree( psPipeline->apReadBuf[i] );
+    }
+}
+
+/************************************************************************/
+/*                 GDALDatasetCopyWholeRasterPipelined()                */
+/************************************************************************/
+
+static CPLErr GDALDatasetCopyWholeRasterPipelined(
+    GDALDataset* poSrcDS, GDALDataset* poDstDS,
+    int bInterleave, int nSwathCols, int nSwathLines,
+    GDALProgressFunc pfnProgress, void *pProgressData )
+{
+    GDALCWRPipeline sPipeline;
+    int i;
+
+    memset( &sPipeline, 0, sizeof(sPipeline) );
+    sPipeline.poSrcDS = poSrcDS;
+    sPipeline.nBandCount = poDstDS->GetRasterCount();
+    sPipeline.bInterleave = bInterleave;
+    sPipeline.nXSize = poDstDS->GetRasterXSize();
+    sPipeline.nYSize = poDstDS->GetRasterYSize();
+    sPipeline.nSwathCols = nSwathCols;
+    sPipeline.nSwathLines = nSwathLines;
+    sPipeline.nXSwaths = (sPipeline.nXSize + nSwathCols - 1) / nSwathCols;
+    sPipeline.nSwathsPerBand = sPipeline.nXSwaths *
+                        ((sPipeline.nYSize + nSwathLines - 1) / nSwathLines);
+    sPipeline.nTotalSwaths = sPipeline.nSwathsPerBand;
+    if( !bInterleave )
+        sPipeline.nTotalSwaths *= sPipeline.nBandCount;
+    sPipeline.eErr = CE_None;
+
+    sPipeline.eDT = poDstDS->GetRasterBand(1)->GetRasterDataType();
+    sPipeline.eReadDT = GDALCWRPipelineGetReadDataType( poSrcDS, poDstDS );
+    int bConvert = ( sPipeline.eReadDT != sPipeline.eDT );
+
+    int nPixelCount = (bInterleave) ? sPipeline.nBandCount : 1;
+    for( i = 0; i < CWR_QUEUE_SIZE; i++ )
+    {
+        sPipeline.apReadBuf[i] = VSIMalloc3( nSwathCols, nSwathLines,
+            nPixelCount * (GDALGetDataTypeSize(sPipeline.eReadDT) / 8) );
+        if( bConvert )
+            sPipeline.apWriteBuf[i] = VSIMalloc3( nSwathCols, nSwathLines,
+                nPixelCount * (GDALGetDataTypeSize(sPipeline.eDT) / 8) );
+        else
+            sPipeline.apWriteBuf[i] = sPipeline.apReadBuf[i];
+        if( sPipeline.apReadBuf[i] == NULL || sPipeline.apWriteBuf[i] == NULL )
+        {
+            CPLError( CE_Failure, CPLE_OutOfMemory,
+                      "Failed to allocate swath buffers in\n"
+                      "GDALDatasetCopyWholeRaster()" );
+            GDALCWRPipelineFreeBuffers( &sPipeline );
+            return CE_Failure;
+        }
+    }
+
+    sPipeline.hCond = CPLCreateCond();
+    sPipeline.hMutex = CPLCreateMutex();
+    CPLReleaseMutex( sPipeline.hMutex );
+
+    CPLDebug( "GDAL",
+              "GDALDatasetCopyWholeRaster(): pipelined copy of %d swaths, "
+              "conversion stage=%d",
+              sPipeline.nTotalSwaths, bConvert );
+
+    CPLJoinableThread* hReaderThread =
+        CPLCreateJoinableThread( GDALCWRPipelineReaderThread, &sPipeline );
+    CPLJoinableThread* hConverterThread = NULL;
+    if( bConvert )
+        hConverterThread =
+            CPLCreateJoinableThread( GDALCWRPipelineConverterThread,
+                                     &sPipeline );
+    if( hReaderThread == NULL || (bConvert && hConverterThread == NULL) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot create threads in GDALDatasetCopyWholeRaster()" );
+        GDALCWRPipelineSetDone( &sPipeline, &sPipeline.nWritten, 0,
+                                CE_Failure );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Writer stage.                                                   */
+/* -------------------------------------------------------------------- */
+    for( int iSwath = 0; iSwath < sPipeline.nTotalSwaths; iSwath++ )
+    {
+        if( !GDALCWRPipelineWaitFor( &sPipeline, &sPipeline.nConverted,
+                                     iSwath ) )
+            break;
+
+        int nBand, nXOff, nYOff, nXSize, nYSize;
+        GDALCWRPipelineGetSwath( &sPipeline, iSwath, &nBand,
+                                 &nXOff, &nYOff, &nXSize, &nYSize );
+
+        CPLErr eErr = poDstDS->RasterIO( GF_Write,
+                                nXOff, nYOff, nXSize, nYSize,
+                                sPipeline.apWriteBuf[iSwath % CWR_QUEUE_SIZE],
+                                nXSize, nYSize, sPipeline.eDT,
+                                bInterleave ? sPipeline.nBandCount : 1,
+                                bInterleave ? NULL : &nBand,
+                                0, 0, 0, NULL );
+
+        if( eErr == CE_None
+            && !pfnProgress( (iSwath + 1) / (double)sPipeline.nTotalSwaths,
+                             NULL, pProgressData ) )
+        {
+            eErr = CE_Failure;
+            CPLError( CE_Failure, CPLE_UserInterrupt,
+                      "User terminated CreateCopy()" );
+        }
+
+        GDALCWRPipelineSetDone( &sPipeline, &sPipeline.nWritten, iSwath + 1,
+                                eErr );
+        if( eErr != CE_None )
+            break;
+    }
+
+    if( hReaderThread != NULL )
+        CPLJoinThread( hReaderThread );
+    if( hConverterThread != NULL )
+        CPLJoinThread( hConverterThread );
+
+    if( sPipeline.pszReaderErrMsg != NULL )
+    {
+        CPLError( CE_Failure, sPipeline.nReaderErrNo, "%s",
+                  sPipeline.pszReaderErrMsg );
+        CPLFree( sPipeline.pszReaderErrMsg );
+    }
+
+    CPLDestroyCond( sPipeline.hCond );
+    CPLDestroyMutex( sPipeline.hMutex );
+    GDALCWRPipelineFreeBuffers( &sPipeline );
+
+    return sPipeline.eErr;
+}
+
 /************************************************************************/
 /*                     GDALDatasetCopyWholeRaster()                     */
 /************************************************************************/
@@ -3508,9 +4149,12 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
  * performing the transfer in a pixel interleaved fashion.
  *
  * Currently the only papszOptions value supported are : "INTERLEAVE=PIXEL"
- * to force pixel interleaved operation and "COMPRESSED=YES" to force alignment
- * on target dataset block sizes to achieve best compression.  More options may be supported in
- * the future.  
+ * to force pixel interleaved operation, "COMPRESSED=YES" to force alignment
+ * on target dataset block sizes to achieve best compression and
+ * "PIPELINE=YES" to read the source swaths, convert them to the destination
+ * data type and write them in separate threads (the default value can be
+ * set with the GDAL_COPY_WHOLE_RASTER_PIPELINE configuration option).
+ * More options may be supported in the future.  
  *
  * @param hSrcDS the source dataset
  * @param hDstDS the destination dataset
@@ -3616,6 +4260,44 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
                                     bDstIsCompressed, bInterleave,
                                     &nSwathCols, &nSwathLines);
 
+    CPLDebug( "GDAL", 
+            "GDALDatasetCopyWholeRaster(): %d*%d swaths, bInterleave=%d", 
+            nSwathCols, nSwathLines, bInterleave );
+
+    if( nSwathCols == nXSize && poSrcDS->GetDriver() != NULL &&
+        EQUAL(poSrcDS->GetDriver()->GetDescription(), "ECW") )
+    {
+        poSrcDS->AdviseRead(0, 0, nXSize, nYSize, nXSize, nYSize, eDT, nBandCount, NULL, NULL);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Use the pipelined copy if asked, if its swaths fit in the       */
+/*      memory budget and if there is more than one of them.            */
+/* -------------------------------------------------------------------- */
+    const char* pszPipeline = CSLFetchNameValueDef( papszOptions, "PIPELINE",
+                CPLGetConfigOption("GDAL_COPY_WHOLE_RASTER_PIPELINE", "NO") );
+    if( CSLTestBoolean(pszPipeline) )
+    {
+        int nPipelineSwathLines =
+            GDALCWRPipelineGetSwathLines( poSrcDS, poDstDS, bInterleave,
+                                          bDstIsCompressed,
+                                          nSwathCols, nSwathLines );
+        if( nPipelineSwathLines > 0 &&
+            (bInterleave ? 1 : nBandCount) *
+                ((nYSize + nPipelineSwathLines - 1) / nPipelineSwathLines) *
+                ((nXSize + nSwathCols - 1) / nSwathCols) > 1 )
+        {
+            return GDALDatasetCopyWholeRasterPipelined( poSrcDS, poDstDS,
+                                                        bInterleave,
+                                                        nSwathCols,
+                                                        nPipelineSwathLines,
+                                                        pfnProgress,
+                                                        pProgressData );
+        }
+        CPLDebug( "GDAL", "GDALDatasetCopyWholeRaster(): pipelined copy "
+                  "not used, as there are not enough swaths" );
+    }
+
     int nPixelSize = (GDALGetDataTypeSize(eDT) / 8);
     if( bInterleave)
         nPixelSize *= nBandCount;
@@ -3630,16 +4312,6 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
         return CE_Failure;
     }
 
-    CPLDebug( "GDAL", 
-            "GDALDatasetCopyWholeRaster(): %d*%d swaths, bInterleave=%d", 
-            nSwathCols, nSwathLines, bInterleave );
-
-    if( nSwathCols == nXSize && poSrcDS->GetDriver() != NULL &&
-        EQUAL(poSrcDS->GetDriver()->GetDescription(), "ECW") )
-    {
-        poSrcDS->AdviseRead(0, 0, nXSize, nYSize, nXSize, nYSize, eDT, nBandCount, NULL, NULL);
-    }
-
 /* ==================================================================== */
 /*      Band oriented (uninterleaved) case.                             */
 /* ==================================================================== */
@@ -3649,6 +4321,7 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
 
         GDALRasterIOExtraArg sExtraArg;
         INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+        sExtraArg.bSequentialScan = TRUE;
 
         int nTotalBlocks = nBandCount *
                            ((nYSize + nSwathLines - 1) / nSwathLines) *
@@ -3717,6 +4390,7 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
 
         GDALRasterIOExtraArg sExtraArg;
         INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+        sExtraArg.bSequentialScan = TRUE;
 
         int nTotalBlocks = ((nYSize + nSwathLines - 1) / nSwathLines) *
                            ((nXSize + nSwathCols - 1) / nSwathCols);
@@ -3890,6 +4564,10 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
 
     int iX, iY;
 
+    GDALRasterIOExtraArg sExtraArg;
+    INIT_RASTERIO_EXTRA_ARG(sExtraArg);
+    sExtraArg.bSequentialScan = TRUE;
+
     for( iY = 0; iY < nYSize && eErr == CE_None; iY += nSwathLines )
     {
         int nThisLines = nSwathLines;
@@ -3907,7 +4585,7 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
             eErr = poSrcBand->RasterIO( GF_Read,
                                     iX, iY, nThisCols, nThisLines,
                                     pSwathBuf, nThisCols, nThisLines,
-                                    eDT, 0, 0, NULL );
+                                    eDT, 0, 0, &sExtraArg );
 
             if( eErr == CE_None )
                 eErr = poDstBand->RasterIO( GF_Write,
@@ -3950,6 +4628,8 @@ void GDALCopyRasterIOExtraArg(GDALRasterIOExtraArg* psDestArg,
         psDestArg->pfnProgress = psSrcArg->pfnProgress;
         psDestArg->pProgressData = psSrcArg->pProgressData;
         psDestArg->bFloatingPointWindowValidity = psSrcArg->bFloatingPointWindowValidity;
+        if( psSrcArg->nVersion >= 2 )
+            psDestArg->bSequentialScan = psSrcArg->bSequentialScan;
         if( psSrcArg->bFloatingPointWindowValidity )
         {
             psDestArg->dfXOff = psSrcArg->dfXOff;
@@ -32,7 +32,10 @@
 #include "ogr_spatialref.h"
 #include "ogr_p.h"
 #include "cpl_csv.h"
+#include "cpl_multiproc.h"
 #include <vector>
+#include <map>
+#include <list>
 
 CPL_CVSID("$Id$");
 
@@ -2158,6 +2161,53 @@ OGRErr CPL_STDCALL OSRImportFromEPSG( OGRSpatialReferenceH hSRS, int nCode )
     return ((OGRSpatialReference *) hSRS)->importFromEPSG( nCode );
 }
 
+/************************************************************************/
+/*                         EPSG definition cache                        */
+/*                                                                      */
+/*      Process-wide cache of the definitions built by                  */
+/*      importFromEPSGA(), keyed by the gcs.csv path in use and the     */
+/*      code, so that repeated imports of the same code (typically      */
+/*      when opening many files with the same georeferencing) do not    */
+/*      go through the CSV lookups again.                               */
+/*                                                                      */
+/*      The least recently used definitions are dropped beyond          */
+/*      OSR_EPSG_CACHE_SIZE entries (256 by default).                   */
+/************************************************************************/
+
+typedef struct
+{
+    OGR_SRSNode                     *poRoot;
+    std::list<CPLString>::iterator   oLRUIter;
+} OSREPSGCacheEntry;
+
+static CPLMutex *hEPSGCacheMutex = NULL;
+static std::map<CPLString, OSREPSGCacheEntry> *poEPSGCache = NULL;
+static std::list<CPLString> *poEPSGCacheLRU = NULL;   /* most recent first */
+
+/************************************************************************/
+/*                        OSRCleanupEPSGCache()                         */
+/************************************************************************/
+
+void OSRCleanupEPSGCache()
+
+{
+    if( poEPSGCache != NULL )
+    {
+        std::map<CPLString, OSREPSGCacheEntry>::iterator oIter;
+        for( oIter = poEPSGCache->begin(); oIter != poEPSGCache->end(); ++oIter )
+            delete oIter->second.poRoot;
+        delete poEPSGCache;
+        poEPSGCache = NULL;
+        delete poEPSGCacheLRU;
+        poEPSGCacheLRU = NULL;
+    }
+    if( hEPSGCacheMutex != NULL )
+    {
+        CPLDestroyMutex( hEPSGCacheMutex );
+        hEPSGCacheMutex = NULL;
+    }
+}
+
 /************************************************************************/
 /*                          importFromEPSGA()                           */
 /************************************************************************/
@@ -2198,6 +2248,34 @@ OGRErr OGRSpatialReference::importFromEPSGA( int nCode )
         poRoot = NULL;
     }
 
+/* -------------------------------------------------------------------- */
+/*      Do we already have this definition in the cache?                */
+/*      OSR_EPSG_CACHE=NO can be used to bypass it.                     */
+/* -------------------------------------------------------------------- */
+    const int bUseCache =
+        CSLTestBoolean( CPLGetConfigOption( "OSR_EPSG_CACHE", "YES" ) );
+    CPLString osCacheKey;
+
+    if( bUseCache )
+    {
+        osCacheKey.Printf( "%s:%d", CSVFilename( "gcs.csv" ), nCode );
+
+        CPLMutexHolderD( &hEPSGCacheMutex );
+        if( poEPSGCache != NULL )
+        {
+            std::map<CPLString, OSREPSGCacheEntry>::iterator oIter =
+                poEPSGCache->find( osCacheKey );
+            if( oIter != poEPSGCache->end() )
+            {
+                poEPSGCacheLRU->splice( poEPSGCacheLRU->begin(),
+                                        *poEPSGCacheLRU,
+                                        oIter->second.oLRUIter );
+                SetRoot( oIter->second.poRoot->Clone() );
+                return OGRERR_NONE;
+            }
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Verify that we can find the required filename(s).               */
 /* -------------------------------------------------------------------- */
@@ -2296,6 +2374,36 @@ OGRErr OGRSpatialReference::importFromEPSGA( int nCode )
         eErr = FixupOrdering();
     }
 
+    if( eErr == OGRERR_NONE && bUseCache && GetRoot() != NULL )
+    {
+        const size_t nMaxEntries = (size_t) MAX( 1,
+            atoi( CPLGetConfigOption( "OSR_EPSG_CACHE_SIZE", "256" ) ) );
+
+        CPLMutexHolderD( &hEPSGCacheMutex );
+        if( poEPSGCache == NULL )
+        {
+            poEPSGCache = new std::map<CPLString, OSREPSGCacheEntry>();
+            poEPSGCacheLRU = new std::list<CPLString>();
+        }
+        if( poEPSGCache->find( osCacheKey ) == poEPSGCache->end() )
+        {
+            poEPSGCacheLRU->push_front( osCacheKey );
+            OSREPSGCacheEntry sEntry;
+            sEntry.poRoot = GetRoot()->Clone();
+            sEntry.oLRUIter = poEPSGCacheLRU->begin();
+            (*poEPSGCache)[osCacheKey] = sEntry;
+
+            while( poEPSGCache->size() > nMaxEntries )
+            {
+                std::map<CPLString, OSREPSGCacheEntry>::iterator oIter =
+                    poEPSGCache->find( poEPSGCacheLRU->back() );
+                delete oIter->second.poRoot;
+                poEPSGCache->erase( oIter );
+                poEPSGCacheLRU->pop_back();
+            }
+        }
+    }
+
     return eErr;
 }
 
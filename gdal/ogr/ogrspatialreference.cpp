@@ -7129,6 +7129,7 @@ OGRErr OGRSpatialReference::SetExtension( const char *pszTargetKey,
 CPL_C_START 
 void CleanupESRIDatumMappingTable();
 CPL_C_END
+void OSRCleanupEPSGCache();
 
 /**
  * \brief Cleanup cached SRS related memory.
@@ -7140,6 +7141,7 @@ void OSRCleanup( void )
 
 {
     CleanupESRIDatumMappingTable();
+    OSRCleanupEPSGCache();
     CSVDeaccess( NULL );
     OCTCleanupProjMutex();
 }
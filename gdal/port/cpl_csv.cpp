@@ -41,6 +41,32 @@ CPL_CVSID("$Id$");
 /*      or in-memory copy of the table, it could be changed to do so    */
 /*      in the future.                                                  */
 /* ==================================================================== */
+/* ==================================================================== */
+/*      The ingested content of a CSV file is read-only once built, so  */
+/*      it is shared between all the threads accessing the same file.   */
+/*      The per-thread CSVTable structures point into it. It is         */
+/*      identified by the filename, size and modification time of the   */
+/*      file, so that a file replaced in the meantime is ingested       */
+/*      again instead of being served from the stale content.           */
+/* ==================================================================== */
+typedef struct csd {
+    struct csd  *psNext;
+
+    char        *pszFilename;
+    GUIntBig    nFileSize;
+    GIntBig     nMTime;
+
+    int         nRefCount;
+
+    int         nLineCount;
+    char        **papszLines;
+    int         *panLineIndex;
+    char        *pszRawData;
+} CSVSharedData;
+
+static CPLMutex      *hCSVSharedMutex = NULL;
+static CSVSharedData *psCSVSharedList = NULL;
+
 typedef struct ctb {
     FILE        *fp;
 
@@ -56,13 +82,16 @@ typedef struct ctb {
 
     int         bNonUniqueKey;
 
-    /* Cache for whole file */
+    /* Cache for whole file (pointing into psShared) */
+    CSVSharedData *psShared;
     int         nLineCount;
     char        **papszLines;
     int         *panLineIndex;
     char        *pszRawData;
 } CSVTable;
 
+static void CSVReleaseShared( CSVSharedData *psShared );
+
 
 static void CSVDeaccessInternal( CSVTable **ppsCSVTableList, int bCanUseTLS, const char * pszFilename );
 
@@ -212,9 +241,8 @@ static void CSVDeaccessInternal( CSVTable **ppsCSVTableList, int bCanUseTLS, con
     CSLDestroy( psTable->papszFieldNames );
     CSLDestroy( psTable->papszRecFields );
     CPLFree( psTable->pszFilename );
-    CPLFree( psTable->panLineIndex );
-    CPLFree( psTable->pszRawData );
-    CPLFree( psTable->papszLines );
+    if( psTable->psShared != NULL )
+        CSVReleaseShared( psTable->psShared );
 
     CPLFree( psTable );
 
@@ -232,6 +260,23 @@ void CSVDeaccess( const char * pszFilename )
     ppsCSVTableList = (CSVTable **) CPLGetTLS( CTLS_CSVTABLEPTR );
 
     CSVDeaccessInternal(ppsCSVTableList, TRUE, pszFilename);
+
+/* -------------------------------------------------------------------- */
+/*      Deaccessing all the tables is what cleanup functions do         */
+/*      (OSRCleanup()...) : release the mutex of the shared content     */
+/*      once no thread holds any.                                       */
+/* -------------------------------------------------------------------- */
+    if( pszFilename == NULL && hCSVSharedMutex != NULL )
+    {
+        CPLAcquireMutex( hCSVSharedMutex, 1000.0 );
+        int bUnused = (psCSVSharedList == NULL);
+        CPLReleaseMutex( hCSVSharedMutex );
+        if( bUnused )
+        {
+            CPLDestroyMutex( hCSVSharedMutex );
+            hCSVSharedMutex = NULL;
+        }
+    }
 }
 
 /************************************************************************/
@@ -348,41 +393,73 @@ static char *CSVFindNextLine( char *pszThisLine )
 }
 
 /************************************************************************/
-/*                             CSVIngest()                              */
+/*                           CSVFreeShared()                            */
+/************************************************************************/
+
+static void CSVFreeShared( CSVSharedData *psShared )
+
+{
+    CPLFree( psShared->pszFilename );
+    CPLFree( psShared->panLineIndex );
+    CPLFree( psShared->pszRawData );
+    CPLFree( psShared->papszLines );
+    CPLFree( psShared );
+}
+
+/************************************************************************/
+/*                          CSVReleaseShared()                          */
+/************************************************************************/
+
+static void CSVReleaseShared( CSVSharedData *psShared )
+
+{
+    CPLMutexHolderD( &hCSVSharedMutex );
+
+    if( --psShared->nRefCount > 0 )
+        return;
+
+    CSVSharedData **ppsLink = &psCSVSharedList;
+    while( *ppsLink != NULL && *ppsLink != psShared )
+        ppsLink = &((*ppsLink)->psNext);
+    if( *ppsLink != NULL )
+        *ppsLink = psShared->psNext;
+
+    CSVFreeShared( psShared );
+}
+
+/************************************************************************/
+/*                           CSVIngestText()                            */
 /*                                                                      */
 /*      Load entire file into memory and setup index if possible.       */
 /************************************************************************/
 
-static void CSVIngest( const char *pszFilename )
+static CSVSharedData *CSVIngestText( FILE *fp, const char *pszFilename )
 
 {
-    CSVTable *psTable = CSVAccess( pszFilename );
     int       nFileLen, i, nMaxLineCount, iLine = 0;
     char *pszThisLine;
 
-    if( psTable->pszRawData != NULL )
-        return;
-
 /* -------------------------------------------------------------------- */
 /*      Ingest whole file.                                              */
 /* -------------------------------------------------------------------- */
-    VSIFSeek( psTable->fp, 0, SEEK_END );
-    nFileLen = VSIFTell( psTable->fp );
-    VSIRewind( psTable->fp );
+    VSIFSeek( fp, 0, SEEK_END );
+    nFileLen = VSIFTell( fp );
+    VSIRewind( fp );
+
+    CSVSharedData *psShared = (CSVSharedData *) CPLCalloc(sizeof(CSVSharedData),1);
+    psShared->pszFilename = CPLStrdup( pszFilename );
 
-    psTable->pszRawData = (char *) CPLMalloc(nFileLen+1);
-    if( (int) VSIFRead( psTable->pszRawData, 1, nFileLen, psTable->fp ) 
-        != nFileLen )
+    psShared->pszRawData = (char *) CPLMalloc(nFileLen+1);
+    if( (int) VSIFRead( psShared->pszRawData, 1, nFileLen, fp ) != nFileLen )
     {
-        CPLFree( psTable->pszRawData );
-        psTable->pszRawData = NULL;
+        CSVFreeShared( psShared );
 
         CPLError( CE_Failure, CPLE_FileIO, "Read of file %s failed.", 
-                  psTable->pszFilename );
-        return;
+                  pszFilename );
+        return NULL;
     }
 
-    psTable->pszRawData[nFileLen] = '\0';
+    psShared->pszRawData[nFileLen] = '\0';
 
 /* -------------------------------------------------------------------- */
 /*      Get count of newlines so we can allocate line array.            */
@@ -390,11 +467,11 @@ static void CSVIngest( const char *pszFilename )
     nMaxLineCount = 0;
     for( i = 0; i < nFileLen; i++ )
     {
-        if( psTable->pszRawData[i] == 10 )
+        if( psShared->pszRawData[i] == 10 )
             nMaxLineCount++;
     }
 
-    psTable->papszLines = (char **) CPLCalloc(sizeof(char*),nMaxLineCount);
+    psShared->papszLines = (char **) CPLCalloc(sizeof(char*),nMaxLineCount);
     
 /* -------------------------------------------------------------------- */
 /*      Build a list of record pointers into the raw data buffer        */
@@ -402,34 +479,239 @@ static void CSVIngest( const char *pszFilename )
 /*      strings.                                                        */
 /* -------------------------------------------------------------------- */
     /* skip header line */
-    pszThisLine = CSVFindNextLine( psTable->pszRawData );
+    pszThisLine = CSVFindNextLine( psShared->pszRawData );
 
     while( pszThisLine != NULL && iLine < nMaxLineCount )
     {
-        psTable->papszLines[iLine++] = pszThisLine;
+        psShared->papszLines[iLine++] = pszThisLine;
         pszThisLine = CSVFindNextLine( pszThisLine );
     }
 
-    psTable->nLineCount = iLine;
+    psShared->nLineCount = iLine;
 
 /* -------------------------------------------------------------------- */
 /*      Allocate and populate index array.  Ensure they are in          */
 /*      ascending order so that binary searches can be done on the      */
 /*      array.                                                          */
 /* -------------------------------------------------------------------- */
-    psTable->panLineIndex = (int *) CPLMalloc(sizeof(int)*psTable->nLineCount);
-    for( i = 0; i < psTable->nLineCount; i++ )
+    psShared->panLineIndex = (int *) CPLMalloc(sizeof(int)*psShared->nLineCount);
+    for( i = 0; i < psShared->nLineCount; i++ )
     {
-        psTable->panLineIndex[i] = atoi(psTable->papszLines[i]);
+        psShared->panLineIndex[i] = atoi(psShared->papszLines[i]);
 
-        if( i > 0 && psTable->panLineIndex[i] < psTable->panLineIndex[i-1] )
+        if( i > 0 && psShared->panLineIndex[i] < psShared->panLineIndex[i-1] )
         {
-            CPLFree( psTable->panLineIndex );
-            psTable->panLineIndex = NULL;
+            CPLFree( psShared->panLineIndex );
+            psShared->panLineIndex = NULL;
             break;
         }
     }
 
+    return psShared;
+}
+
+/* ==================================================================== */
+/*      Compiled CSV files.                                             */
+/*                                                                      */
+/*      A compiled file (.csvb) holds the ingested form of a CSV file   */
+/*      so that it can be loaded with a single read, without scanning   */
+/*      for lines or building the key index. All values are little      */
+/*      endian and offsets are relative to the start of the raw data,   */
+/*      so the layout is position independent.                          */
+/*                                                                      */
+/*      Header (32 bytes):                                              */
+/*        char[8]  "GDALCSVB"                                           */
+/*        uint32   version (1)                                          */
+/*        uint32   number of lines (header line excluded)               */
+/*        uint32   flags (1 = integer key index present)                */
+/*        uint32   size of the raw data                                 */
+/*        uint64   size of the source CSV file                          */
+/*      uint32[nLines]  offset of each line in the raw data             */
+/*      int32[nLines]   integer key of each line, if flag 1 is set      */
+/*      raw data: the CSV content with line terminators replaced by     */
+/*                nul characters.                                       */
+/* ==================================================================== */
+
+#define CSV_COMPILED_SIGNATURE      "GDALCSVB"
+#define CSV_COMPILED_VERSION        1
+#define CSV_COMPILED_HEADER_SIZE    32
+#define CSV_COMPILED_FLAG_INDEX     1
+
+/************************************************************************/
+/*                        CSVCompiledFilename()                         */
+/************************************************************************/
+
+static CPLString CSVCompiledFilename( const char *pszFilename )
+
+{
+    return CPLString(pszFilename) + "b";
+}
+
+/************************************************************************/
+/*                         CSVIngestCompiled()                          */
+/*                                                                      */
+/*      Load the compiled companion of a CSV file, if it exists and     */
+/*      is up to date.                                                  */
+/************************************************************************/
+
+static CSVSharedData *CSVIngestCompiled( const char *pszFilename )
+
+{
+    CPLString osCompiled = CSVCompiledFilename( pszFilename );
+    VSIStatBufL sStatCSV, sStatCompiled;
+
+    if( VSIStatL( osCompiled, &sStatCompiled ) != 0
+        || VSIStatL( pszFilename, &sStatCSV ) != 0
+        || sStatCompiled.st_mtime < sStatCSV.st_mtime )
+        return NULL;
+
+    VSILFILE *fp = VSIFOpenL( osCompiled, "rb" );
+    if( fp == NULL )
+        return NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Read and check the header.                                      */
+/* -------------------------------------------------------------------- */
+    GByte abyHeader[CSV_COMPILED_HEADER_SIZE];
+    GUInt32 nVersion, nLineCount, nFlags, nRawSize;
+    GUIntBig nSourceSize;
+
+    if( VSIFReadL( abyHeader, 1, sizeof(abyHeader), fp ) != sizeof(abyHeader)
+        || memcmp( abyHeader, CSV_COMPILED_SIGNATURE, 8 ) != 0 )
+    {
+        VSIFCloseL( fp );
+        return NULL;
+    }
+
+    memcpy( &nVersion, abyHeader + 8, 4 );
+    CPL_LSBPTR32( &nVersion );
+    memcpy( &nLineCount, abyHeader + 12, 4 );
+    CPL_LSBPTR32( &nLineCount );
+    memcpy( &nFlags, abyHeader + 16, 4 );
+    CPL_LSBPTR32( &nFlags );
+    memcpy( &nRawSize, abyHeader + 20, 4 );
+    CPL_LSBPTR32( &nRawSize );
+    memcpy( &nSourceSize, abyHeader + 24, 8 );
+    CPL_LSBPTR64( &nSourceSize );
+
+    const int nIndexCount = (nFlags & CSV_COMPILED_FLAG_INDEX) ? 1 : 0;
+    if( nVersion != CSV_COMPILED_VERSION
+        || nSourceSize != (GUIntBig) sStatCSV.st_size
+        || (GUIntBig) nRawSize != nSourceSize + 1
+        || nLineCount >= nRawSize
+        || (GUIntBig) sStatCompiled.st_size !=
+               CSV_COMPILED_HEADER_SIZE
+               + (GUIntBig) nLineCount * 4 * (1 + nIndexCount) + nRawSize )
+    {
+        CPLDebug( "CPL_CSV", "Ignoring invalid or stale %s",
+                  osCompiled.c_str() );
+        VSIFCloseL( fp );
+        return NULL;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Read the tables and the raw data.                               */
+/* -------------------------------------------------------------------- */
+    CSVSharedData *psShared = (CSVSharedData *) CPLCalloc(sizeof(CSVSharedData),1);
+    psShared->pszFilename = CPLStrdup( pszFilename );
+    psShared->nLineCount = (int) nLineCount;
+    psShared->papszLines = (char **) CPLCalloc(sizeof(char*), nLineCount + 1);
+    if( nIndexCount )
+        psShared->panLineIndex = (int *) CPLMalloc(sizeof(int) * (nLineCount + 1));
+    psShared->pszRawData = (char *) CPLMalloc( nRawSize );
+
+    GUInt32 *panOffsets = (GUInt32 *) CPLMalloc( sizeof(GUInt32) * (nLineCount + 1) );
+    int bOK =
+        VSIFReadL( panOffsets, 4, nLineCount, fp ) == nLineCount
+        && (!nIndexCount ||
+            VSIFReadL( psShared->panLineIndex, 4, nLineCount, fp ) == nLineCount)
+        && VSIFReadL( psShared->pszRawData, 1, nRawSize, fp ) == nRawSize
+        && psShared->pszRawData[nRawSize-1] == '\0';
+    VSIFCloseL( fp );
+
+    for( GUInt32 i = 0; bOK && i < nLineCount; i++ )
+    {
+        CPL_LSBPTR32( panOffsets + i );
+        if( panOffsets[i] >= nRawSize )
+            bOK = FALSE;
+        else
+            psShared->papszLines[i] = psShared->pszRawData + panOffsets[i];
+        if( nIndexCount )
+        {
+            CPL_LSBPTR32( psShared->panLineIndex + i );
+        }
+    }
+    CPLFree( panOffsets );
+
+    if( !bOK )
+    {
+        CPLDebug( "CPL_CSV", "Ignoring corrupted %s", osCompiled.c_str() );
+        CSVFreeShared( psShared );
+        return NULL;
+    }
+
+    return psShared;
+}
+
+/************************************************************************/
+/*                             CSVIngest()                              */
+/*                                                                      */
+/*      Attach the ingested content of the file to the table, loading   */
+/*      it if no other thread did it yet.                               */
+/************************************************************************/
+
+static void CSVIngest( const char *pszFilename )
+
+{
+    CSVTable *psTable = CSVAccess( pszFilename );
+    CSVSharedData *psShared;
+
+    if( psTable->pszRawData != NULL )
+        return;
+
+    VSIFSeek( psTable->fp, 0, SEEK_END );
+    const GUIntBig nFileSize = (GUIntBig) VSIFTell( psTable->fp );
+    VSIStatBufL sStat;
+    const GIntBig nMTime = ( VSIStatL( psTable->pszFilename, &sStat ) == 0 ) ?
+                                                (GIntBig) sStat.st_mtime : 0;
+
+    {
+        CPLMutexHolderD( &hCSVSharedMutex );
+
+        for( psShared = psCSVSharedList;
+             psShared != NULL;
+             psShared = psShared->psNext )
+        {
+            if( EQUAL(psShared->pszFilename, psTable->pszFilename)
+                && psShared->nFileSize == nFileSize
+                && psShared->nMTime == nMTime )
+                break;
+        }
+
+        if( psShared == NULL )
+        {
+            if( CSLTestBoolean( CPLGetConfigOption( "CPL_CSV_COMPILED", "YES" ) ) )
+                psShared = CSVIngestCompiled( psTable->pszFilename );
+            if( psShared == NULL )
+                psShared = CSVIngestText( psTable->fp, psTable->pszFilename );
+            if( psShared == NULL )
+                return;
+
+            psShared->nFileSize = nFileSize;
+            psShared->nMTime = nMTime;
+            psShared->psNext = psCSVSharedList;
+            psCSVSharedList = psShared;
+        }
+
+        psShared->nRefCount ++;
+    }
+
+    psTable->psShared = psShared;
+    psTable->nLineCount = psShared->nLineCount;
+    psTable->papszLines = psShared->papszLines;
+    psTable->panLineIndex = psShared->panLineIndex;
+    psTable->pszRawData = psShared->pszRawData;
+
     psTable->iLastLine = -1;
 
 /* -------------------------------------------------------------------- */
@@ -439,6 +721,116 @@ static void CSVIngest( const char *pszFilename )
     psTable->fp = NULL;
 }
 
+/************************************************************************/
+/*                             CSVCompile()                             */
+/************************************************************************/
+
+/**
+ * Write the compiled form of a CSV file.
+ *
+ * The compiled file holds the CSV content already split into lines, and
+ * the index of the integer keys of the first column, so that the CSV
+ * lookup functions can load it without parsing the text. It is used
+ * in place of the CSV file when it is found next to it with the same
+ * name and a .csvb extension, is not older than it, and matches its
+ * size. This can be disabled with the CPL_CSV_COMPILED configuration
+ * option set to NO.
+ *
+ * @param pszCSVFilename the CSV file to compile.
+ * @param pszCompiledFilename the file to write, or NULL for the default
+ * companion name (pszCSVFilename with a .csvb extension).
+ *
+ * @return TRUE on success.
+ */
+
+int CSVCompile( const char *pszCSVFilename, const char *pszCompiledFilename )
+
+{
+    CPLString osCompiled = pszCompiledFilename != NULL
+        ? CPLString(pszCompiledFilename) : CSVCompiledFilename( pszCSVFilename );
+
+    FILE *fpCSV = VSIFOpen( pszCSVFilename, "rb" );
+    if( fpCSV == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OpenFailed, "Cannot open %s.",
+                  pszCSVFilename );
+        return FALSE;
+    }
+    VSIFSeek( fpCSV, 0, SEEK_END );
+    GUIntBig nSourceSize = (GUIntBig) VSIFTell( fpCSV );
+    CSVSharedData *psShared = CSVIngestText( fpCSV, pszCSVFilename );
+    VSIFClose( fpCSV );
+    if( psShared == NULL )
+        return FALSE;
+
+    VSILFILE *fp = VSIFOpenL( osCompiled, "wb" );
+    if( fp == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OpenFailed, "Cannot create %s.",
+                  osCompiled.c_str() );
+        CSVFreeShared( psShared );
+        return FALSE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Write header.                                                   */
+/* -------------------------------------------------------------------- */
+    GByte abyHeader[CSV_COMPILED_HEADER_SIZE];
+    GUInt32 nVal;
+    const GUInt32 nRawSize = (GUInt32) nSourceSize + 1;
+
+    memcpy( abyHeader, CSV_COMPILED_SIGNATURE, 8 );
+    nVal = CSV_COMPILED_VERSION;
+    CPL_LSBPTR32( &nVal );
+    memcpy( abyHeader + 8, &nVal, 4 );
+    nVal = (GUInt32) psShared->nLineCount;
+    CPL_LSBPTR32( &nVal );
+    memcpy( abyHeader + 12, &nVal, 4 );
+    nVal = psShared->panLineIndex != NULL ? CSV_COMPILED_FLAG_INDEX : 0;
+    CPL_LSBPTR32( &nVal );
+    memcpy( abyHeader + 16, &nVal, 4 );
+    nVal = nRawSize;
+    CPL_LSBPTR32( &nVal );
+    memcpy( abyHeader + 20, &nVal, 4 );
+    CPL_LSBPTR64( &nSourceSize );
+    memcpy( abyHeader + 24, &nSourceSize, 8 );
+
+    int bOK = VSIFWriteL( abyHeader, 1, sizeof(abyHeader), fp ) == sizeof(abyHeader);
+
+/* -------------------------------------------------------------------- */
+/*      Write line offsets, key index and raw data.                     */
+/* -------------------------------------------------------------------- */
+    int i;
+    for( i = 0; bOK && i < psShared->nLineCount; i++ )
+    {
+        nVal = (GUInt32) (psShared->papszLines[i] - psShared->pszRawData);
+        CPL_LSBPTR32( &nVal );
+        bOK = VSIFWriteL( &nVal, 4, 1, fp ) == 1;
+    }
+    for( i = 0; bOK && psShared->panLineIndex != NULL
+                && i < psShared->nLineCount; i++ )
+    {
+        GInt32 nKey = psShared->panLineIndex[i];
+        CPL_LSBPTR32( &nKey );
+        bOK = VSIFWriteL( &nKey, 4, 1, fp ) == 1;
+    }
+    if( bOK )
+        bOK = VSIFWriteL( psShared->pszRawData, 1, nRawSize, fp ) == nRawSize;
+
+    if( VSIFCloseL( fp ) != 0 )
+        bOK = FALSE;
+    CSVFreeShared( psShared );
+
+    if( !bOK )
+    {
+        CPLError( CE_Failure, CPLE_FileIO, "Write of %s failed.",
+                  osCompiled.c_str() );
+        VSIUnlink( osCompiled );
+    }
+
+    return bOK;
+}
+
 /************************************************************************/
 /*                        CSVDetectSeperator()                          */
 /************************************************************************/
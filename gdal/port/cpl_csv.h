@@ -60,6 +60,9 @@ int CPL_DLL CSVGetFileFieldId( const char *, const char * );
 
 void CPL_DLL CSVDeaccess( const char * );
 
+int CPL_DLL CSVCompile( const char *pszCSVFilename,
+                        const char *pszCompiledFilename );
+
 const char CPL_DLL *CSVGetField( const char *, const char *, const char *,
                                  CSVCompareCriteria, const char * );
 
@@ -43,7 +43,9 @@
 #include "cpl_error.h"
 #include "cpl_conv.h"
 #include "cpl_string.h"
+#include "cpl_multiproc.h"
 #include <ctype.h>
+#include <map>
 
 CPL_CVSID("$Id$");
 
@@ -76,13 +78,54 @@ typedef struct {
     size_t     nTokenMaxSize;
     size_t     nTokenSize;
 
+    int        bFailed;
+
+    /* Names of the currently opened elements, stored one after the */
+    /* other in pszNames. */
     int        nStackMaxSize;
     int        nStackSize;
+    size_t     *panNameOffsets;
+    char       *pszNames;
+    size_t     nNamesMaxSize;
+    size_t     nNamesSize;
+} ParseContext;
+
+struct _CPLXMLReader
+{
+    ParseContext    sContext;
+    CPLXMLEventType eEvent;
+    const char     *pszName;
+    const char     *pszValue;
+    char           *pszAttrName;
+    size_t          nAttrNameMaxSize;
+};
+
+/* Blocks of the allocation arena of trees returned by */
+/* CPLParseXMLStringArena() */
+typedef struct _CPLXMLArenaBlock
+{
+    struct _CPLXMLArenaBlock *psNext;
+} CPLXMLArenaBlock;
+
+typedef struct
+{
+    CPLXMLArenaBlock *psFirstBlock;
+    CPLXMLArenaBlock *psLastBlock;
+    GByte            *pabyCur;
+    size_t            nAvail;
+    size_t            nNextBlockSize;
+} CPLXMLArena;
+
+typedef struct {
+    int           nStackMaxSize;
+    int           nStackSize;
     StackContext *papsStack;
 
-    CPLXMLNode *psFirstNode;
-    CPLXMLNode *psLastNode;
-} ParseContext;
+    CPLXMLNode   *psFirstNode;
+    CPLXMLNode   *psLastNode;
+
+    CPLXMLArena  *psArena;
+} TreeBuilder;
 
 static CPLXMLNode *_CPLCreateXMLNode( CPLXMLNode *poParent, CPLXMLNodeType eType, 
                                       const char *pszText );
@@ -106,29 +149,6 @@ static CPL_INLINE char ReadChar( ParseContext *psContext )
     return chReturn;
 }
 
-/************************************************************************/
-/*                             UnreadChar()                             */
-/************************************************************************/
-
-static CPL_INLINE void UnreadChar( ParseContext *psContext, char chToUnread )
-
-{
-    if( chToUnread == '\0' )
-    {
-        /* do nothing */
-    }
-    else
-    {
-        CPLAssert( chToUnread 
-                   == psContext->pszInput[psContext->nInputOffset-1] );
-
-        psContext->nInputOffset--;
-
-        if( chToUnread == 10 )
-            psContext->nInputLine--;
-    }
-}
-
 /************************************************************************/
 /*                           ReallocToken()                             */
 /************************************************************************/
@@ -179,6 +199,40 @@ static CPL_INLINE int _AddToToken( ParseContext *psContext, char chNewChar )
 
 #define AddToToken(psContext, chNewChar) if (!_AddToToken(psContext, chNewChar)) goto fail;
 
+/************************************************************************/
+/*                          AddSpanToToken()                            */
+/*                                                                      */
+/*      Append the next nLen characters of the input to the token,      */
+/*      and skip them.                                                  */
+/************************************************************************/
+
+static int AddSpanToToken( ParseContext *psContext, size_t nLen )
+
+{
+    const char *pszSpan = psContext->pszInput + psContext->nInputOffset;
+
+    while( psContext->nTokenSize + nLen + 2 > psContext->nTokenMaxSize )
+    {
+        if (!ReallocToken(psContext))
+            return FALSE;
+    }
+
+    memcpy( psContext->pszToken + psContext->nTokenSize, pszSpan, nLen );
+    psContext->nTokenSize += nLen;
+    psContext->pszToken[psContext->nTokenSize] = '\0';
+
+    const char *pszLF = (const char *) memchr( pszSpan, 10, nLen );
+    while( pszLF != NULL )
+    {
+        psContext->nInputLine++;
+        pszLF = (const char *) memchr( pszLF + 1, 10,
+                                       nLen - (pszLF + 1 - pszSpan) );
+    }
+
+    psContext->nInputOffset += (int) nLen;
+    return TRUE;
+}
+
 /************************************************************************/
 /*                             ReadToken()                              */
 /************************************************************************/
@@ -198,7 +252,8 @@ static XMLTokenType ReadToken( ParseContext *psContext )
 /* -------------------------------------------------------------------- */
 /*      Handle comments.                                                */
 /* -------------------------------------------------------------------- */
-    if( chNext == '<' 
+    if( chNext == '<'
+        && psContext->pszInput[psContext->nInputOffset] == '!'
         && EQUALN(psContext->pszInput+psContext->nInputOffset,"!--",3) )
     {
         psContext->eTokenType = TComment;
@@ -220,7 +275,8 @@ static XMLTokenType ReadToken( ParseContext *psContext )
 /* -------------------------------------------------------------------- */
 /*      Handle DOCTYPE.                                                 */
 /* -------------------------------------------------------------------- */
-    else if( chNext == '<' 
+    else if( chNext == '<'
+          && psContext->pszInput[psContext->nInputOffset] == '!'
           && EQUALN(psContext->pszInput+psContext->nInputOffset,"!DOCTYPE",8) )
     {
         int   bInQuotes = FALSE;
@@ -235,7 +291,7 @@ static XMLTokenType ReadToken( ParseContext *psContext )
                           "Parse error in DOCTYPE on or before line %d, "
                           "reached end of file without '>'.", 
                           psContext->nInputLine );
-                
+                psContext->bFailed = TRUE;
                 break;
             }
             
@@ -266,6 +322,7 @@ static XMLTokenType ReadToken( ParseContext *psContext )
                           "Parse error in DOCTYPE on or before line %d, "
                           "reached end of file without ']'.", 
                           psContext->nInputLine );
+                    psContext->bFailed = TRUE;
                     break;
                 }
 
@@ -295,7 +352,8 @@ static XMLTokenType ReadToken( ParseContext *psContext )
 /* -------------------------------------------------------------------- */
 /*      Handle CDATA.                                                   */
 /* -------------------------------------------------------------------- */
-    else if( chNext == '<' 
+    else if( chNext == '<'
+          && psContext->pszInput[psContext->nInputOffset] == '!'
           && EQUALN(psContext->pszInput+psContext->nInputOffset,"![CDATA[",8) )
     {
         psContext->eTokenType = TString;
@@ -373,13 +431,17 @@ static XMLTokenType ReadToken( ParseContext *psContext )
     {
         psContext->eTokenType = TString;
 
-        while( (chNext = ReadChar(psContext)) != '"' 
-               && chNext != '\0' )
-            AddToToken( psContext, chNext );
+        const char *pszStart = psContext->pszInput + psContext->nInputOffset;
+        const char *pszEnd = strchr( pszStart, '"' );
+        if( !AddSpanToToken( psContext, pszEnd != NULL ? (size_t)(pszEnd - pszStart)
+                                                       : strlen(pszStart) ) )
+            goto fail;
+        chNext = ReadChar(psContext);
         
         if( chNext != '"' )
         {
             psContext->eTokenType = TNone;
+            psContext->bFailed = TRUE;
             CPLError( CE_Failure, CPLE_AppDefined, 
                   "Parse error on line %d, reached EOF before closing quote.", 
                       psContext->nInputLine );
@@ -401,13 +463,17 @@ static XMLTokenType ReadToken( ParseContext *psContext )
     {
         psContext->eTokenType = TString;
 
-        while( (chNext = ReadChar(psContext)) != '\'' 
-               && chNext != '\0' )
-            AddToToken( psContext, chNext );
+        const char *pszStart = psContext->pszInput + psContext->nInputOffset;
+        const char *pszEnd = strchr( pszStart, '\'' );
+        if( !AddSpanToToken( psContext, pszEnd != NULL ? (size_t)(pszEnd - pszStart)
+                                                       : strlen(pszStart) ) )
+            goto fail;
+        chNext = ReadChar(psContext);
         
         if( chNext != '\'' )
         {
             psContext->eTokenType = TNone;
+            psContext->bFailed = TRUE;
             CPLError( CE_Failure, CPLE_AppDefined, 
                   "Parse error on line %d, reached EOF before closing quote.", 
                       psContext->nInputLine );
@@ -434,10 +500,9 @@ static XMLTokenType ReadToken( ParseContext *psContext )
         psContext->eTokenType = TString;
 
         AddToToken( psContext, chNext );
-        while( (chNext = ReadChar(psContext)) != '<' 
-               && chNext != '\0' )
-            AddToToken( psContext, chNext );
-        UnreadChar( psContext, chNext );
+        if( !AddSpanToToken( psContext,
+                 strcspn( psContext->pszInput + psContext->nInputOffset, "<" ) ) )
+            goto fail;
 
         /* Do we need to unescape it? */
         if( strchr(psContext->pszToken,'&') != NULL )
@@ -462,7 +527,9 @@ static XMLTokenType ReadToken( ParseContext *psContext )
         /* add the first character to the token regardless of what it is */
         AddToToken( psContext, chNext );
 
-        for( chNext = ReadChar(psContext); 
+        const char *pszStart = psContext->pszInput + psContext->nInputOffset;
+        const char *pszEnd = pszStart;
+        for( chNext = *pszEnd;
              (chNext >= 'A' && chNext <= 'Z')
                  || (chNext >= 'a' && chNext <= 'z')
                  || chNext == '-'
@@ -470,60 +537,792 @@ static XMLTokenType ReadToken( ParseContext *psContext )
                  || chNext == '.'
                  || chNext == ':'
                  || (chNext >= '0' && chNext <= '9');
-             chNext = ReadChar(psContext) ) 
-        {
-            AddToToken( psContext, chNext );
-        }
+             chNext = *(++pszEnd) ) {}
 
-        UnreadChar(psContext, chNext);
+        if( !AddSpanToToken( psContext, (size_t)(pszEnd - pszStart) ) )
+            goto fail;
     }
     
     return psContext->eTokenType;
 
 fail:
     psContext->eTokenType = TNone;
+    psContext->bFailed = TRUE;
     return TNone;
 }
 
 /************************************************************************/
-/*                              PushNode()                              */
+/*                              PushName()                              */
 /************************************************************************/
 
-static int PushNode( ParseContext *psContext, CPLXMLNode *psNode )
+static int PushName( ParseContext *psContext, const char *pszName,
+                     size_t nNameLen )
 
 {
     if( psContext->nStackMaxSize <= psContext->nStackSize )
     {
         psContext->nStackMaxSize += 10;
 
-        if (psContext->nStackMaxSize >= (int)(INT_MAX / sizeof(StackContext)))
+        if (psContext->nStackMaxSize >= (int)(INT_MAX / sizeof(size_t)))
+        {
+            CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Out of memory allocating %d*%d bytes", (int)sizeof(size_t), psContext->nStackMaxSize);
+            return FALSE;
+        }
+        size_t* panNameOffsets;
+        panNameOffsets = (size_t *)VSIRealloc(psContext->panNameOffsets,
+                    sizeof(size_t) * psContext->nStackMaxSize);
+        if (panNameOffsets == NULL)
+        {
+            CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Out of memory allocating %d bytes", (int)(sizeof(size_t) * psContext->nStackMaxSize));
+            return FALSE;
+        }
+        psContext->panNameOffsets = panNameOffsets;
+    }
+
+    if( psContext->nNamesSize + nNameLen + 1 > psContext->nNamesMaxSize )
+    {
+        size_t nNewMaxSize = MAX(psContext->nNamesMaxSize * 2,
+                                 psContext->nNamesSize + nNameLen + 256);
+        char* pszNames = (char *) VSIRealloc(psContext->pszNames, nNewMaxSize);
+        if (pszNames == NULL)
         {
             CPLError(CE_Failure, CPLE_OutOfMemory,
-                 "Out of memory allocating %d*%d bytes", (int)sizeof(StackContext), psContext->nStackMaxSize);
-            VSIFree(psContext->papsStack);
-            psContext->papsStack = NULL;
+                 "Out of memory allocating %d bytes", (int)nNewMaxSize);
+            return FALSE;
+        }
+        psContext->pszNames = pszNames;
+        psContext->nNamesMaxSize = nNewMaxSize;
+    }
+
+    memcpy( psContext->pszNames + psContext->nNamesSize, pszName, nNameLen + 1 );
+    psContext->panNameOffsets[psContext->nStackSize] = psContext->nNamesSize;
+    psContext->nNamesSize += nNameLen + 1;
+    psContext->nStackSize ++;
+    return TRUE;
+}
+
+/************************************************************************/
+/*                              PopName()                               */
+/*                                                                      */
+/*      Returns the name of the popped element.  It remains valid       */
+/*      until the next PushName() call.                                 */
+/************************************************************************/
+
+static const char *PopName( ParseContext *psContext )
+
+{
+    psContext->nStackSize --;
+    psContext->nNamesSize = psContext->panNameOffsets[psContext->nStackSize];
+    return psContext->pszNames + psContext->nNamesSize;
+}
+
+/************************************************************************/
+/*                              TopName()                               */
+/************************************************************************/
+
+static const char *TopName( ParseContext *psContext )
+
+{
+    return psContext->pszNames
+        + psContext->panNameOffsets[psContext->nStackSize-1];
+}
+
+/************************************************************************/
+/*                         CPLXMLReaderCreate()                         */
+/************************************************************************/
+
+/**
+ * \brief Create a pull parser on an XML document.
+ *
+ * The reader returns the content of the document as a sequence of events
+ * fetched with CPLXMLReaderNext(), without building a CPLXMLNode tree.
+ * This is the fastest and least memory hungry way of extracting a few
+ * values from a big document.  The well-formedness checks are the same
+ * as those of CPLParseXMLString().
+ *
+ * The passed document is not copied and must remain valid until
+ * CPLXMLReaderDestroy() is called.
+ *
+ * @param pszString the document to parse.
+ *
+ * @return a new reader, or NULL on error.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLXMLReader *CPLXMLReaderCreate( const char *pszString )
+
+{
+    CPLXMLReader *psReader;
+
+    if( pszString == NULL )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "CPLXMLReaderCreate() called with NULL pointer." );
+        return NULL;
+    }
+
+    psReader = (CPLXMLReader *) VSICalloc(sizeof(CPLXMLReader), 1);
+    if( psReader == NULL )
+    {
+        CPLError(CE_Failure, CPLE_OutOfMemory, "Cannot allocate CPLXMLReader");
+        return NULL;
+    }
+
+    ParseContext *psContext = &(psReader->sContext);
+
+    psContext->pszInput = pszString;
+    psContext->nInputOffset = 0;
+    psContext->nInputLine = 0;
+    psContext->bInElement = FALSE;
+    psContext->nTokenMaxSize = 10;
+    psContext->pszToken = (char *) VSIMalloc(psContext->nTokenMaxSize);
+    if (psContext->pszToken == NULL)
+    {
+        CPLError(CE_Failure, CPLE_OutOfMemory, "Cannot allocate token buffer");
+        VSIFree( psReader );
+        return NULL;
+    }
+    psContext->pszToken[0] = '\0';
+    psContext->nTokenSize = 0;
+    psContext->eTokenType = TNone;
+    psContext->bFailed = FALSE;
+    psContext->nStackMaxSize = 0;
+    psContext->nStackSize = 0;
+    psContext->panNameOffsets = NULL;
+    psContext->pszNames = NULL;
+    psContext->nNamesMaxSize = 0;
+    psContext->nNamesSize = 0;
+
+    psReader->eEvent = CXE_StartDocument;
+
+    return psReader;
+}
+
+/************************************************************************/
+/*                        CPLXMLReaderDestroy()                         */
+/************************************************************************/
+
+/**
+ * \brief Destroy a reader created with CPLXMLReaderCreate().
+ *
+ * @param psReader the reader to destroy. May be NULL.
+ *
+ * @since GDAL 2.0
+ */
+
+void CPLXMLReaderDestroy( CPLXMLReader *psReader )
+
+{
+    if( psReader == NULL )
+        return;
+
+    CPLFree( psReader->sContext.pszToken );
+    CPLFree( psReader->sContext.panNameOffsets );
+    CPLFree( psReader->sContext.pszNames );
+    CPLFree( psReader->pszAttrName );
+    CPLFree( psReader );
+}
+
+/************************************************************************/
+/*                          ReaderFailure()                             */
+/************************************************************************/
+
+static CPLXMLEventType ReaderFailure( CPLXMLReader *psReader )
+
+{
+    psReader->sContext.bFailed = TRUE;
+    psReader->eEvent = CXE_Error;
+    psReader->pszName = NULL;
+    psReader->pszValue = NULL;
+    return CXE_Error;
+}
+
+/************************************************************************/
+/*                          CPLXMLReaderNext()                          */
+/************************************************************************/
+
+/**
+ * \brief Fetch the next event of the document.
+ *
+ * The following events are returned, with the values then available
+ * through CPLXMLReaderGetName() and CPLXMLReaderGetValue() :
+ * <ul>
+ * <li>CXE_StartElement: start of an element. The name is the element name.
+ * It is followed by one CXE_Attribute event per attribute of the element.
+ * </li>
+ * <li>CXE_Attribute: the name and value of an attribute of the last started
+ * element.</li>
+ * <li>CXE_EndElement: end of an element, including elements closed with
+ * "/>" and "?>". The name is the element name.</li>
+ * <li>CXE_Text: the value is the unescaped text.</li>
+ * <li>CXE_Comment: the value is the comment text.</li>
+ * <li>CXE_Literal: the value is the literal text (like DOCTYPE).</li>
+ * <li>CXE_EndDocument: the whole document has been read.</li>
+ * <li>CXE_Error: the document is not well formed. The error has been
+ * reported with CPLError().</li>
+ * </ul>
+ *
+ * Once CXE_EndDocument or CXE_Error has been returned, all following calls
+ * return the same value.
+ *
+ * @param psReader the reader.
+ *
+ * @return the type of the event.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLXMLEventType CPLXMLReaderNext( CPLXMLReader *psReader )
+
+{
+    ParseContext *psContext = &(psReader->sContext);
+
+    if( psReader->eEvent == CXE_EndDocument || psReader->eEvent == CXE_Error )
+        return psReader->eEvent;
+
+    psReader->pszName = NULL;
+    psReader->pszValue = NULL;
+
+    while( TRUE )
+    {
+        ReadToken( psContext );
+        if( psContext->bFailed )
+            return ReaderFailure( psReader );
+
+/* -------------------------------------------------------------------- */
+/*      End of input. Did we pop all the way out of our stack?          */
+/* -------------------------------------------------------------------- */
+        if( psContext->eTokenType == TNone )
+        {
+            if( psContext->nStackSize != 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Parse error at EOF, not all elements have been closed,\n"
+                          "starting with %.500s\n",
+                          TopName(psContext) );
+                return ReaderFailure( psReader );
+            }
+
+            psReader->eEvent = CXE_EndDocument;
+            return CXE_EndDocument;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Start or end of an element.                                     */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TOpen )
+        {
+            if( ReadToken(psContext) != TToken )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Didn't find element token after open angle bracket.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+
+            if( psContext->pszToken[0] != '/' )
+            {
+                if( !PushName( psContext, psContext->pszToken,
+                               psContext->nTokenSize ) )
+                    return ReaderFailure( psReader );
+
+                psReader->pszName = TopName( psContext );
+                psReader->eEvent = CXE_StartElement;
+                return CXE_StartElement;
+            }
+
+            if( psContext->nStackSize == 0
+                || !EQUAL(psContext->pszToken+1, TopName(psContext)) )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: <%.500s> doesn't have matching <%.500s>.",
+                          psContext->nInputLine,
+                          psContext->pszToken, psContext->pszToken+1 );
+                return ReaderFailure( psReader );
+            }
+
+            if (strcmp(psContext->pszToken+1, TopName(psContext)) != 0)
+            {
+                /* TODO: at some point we could just error out like any other */
+                /* sane XML parser would do */
+                CPLError( CE_Warning, CPLE_AppDefined,
+                        "Line %d: <%.500s> matches <%.500s>, but the case isn't the same. "
+                        "Going on, but this is invalid XML that might be rejected in "
+                        "future versions.",
+                        psContext->nInputLine,
+                        TopName(psContext),
+                        psContext->pszToken );
+            }
+
+            if( ReadToken(psContext) != TClose )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Missing close angle bracket after <%.500s.",
+                          psContext->nInputLine,
+                          psContext->pszToken );
+                return ReaderFailure( psReader );
+            }
+
+            /* pop element off stack */
+            psReader->pszName = PopName( psContext );
+            psReader->eEvent = CXE_EndElement;
+            return CXE_EndElement;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Attribute of the current element.                               */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TToken )
+        {
+            if( psContext->nTokenSize + 1 > psReader->nAttrNameMaxSize )
+            {
+                size_t nNewMaxSize = psContext->nTokenSize + 32;
+                char* pszAttrName = (char *)
+                    VSIRealloc( psReader->pszAttrName, nNewMaxSize );
+                if( pszAttrName == NULL )
+                {
+                    CPLError(CE_Failure, CPLE_OutOfMemory,
+                             "Out of memory allocating %d bytes", (int)nNewMaxSize);
+                    return ReaderFailure( psReader );
+                }
+                psReader->pszAttrName = pszAttrName;
+                psReader->nAttrNameMaxSize = nNewMaxSize;
+            }
+            memcpy( psReader->pszAttrName, psContext->pszToken,
+                    psContext->nTokenSize + 1 );
+
+            if( ReadToken(psContext) != TEqual )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Didn't find expected '=' for value of attribute '%.500s'.",
+                          psContext->nInputLine, psReader->pszAttrName );
+                return ReaderFailure( psReader );
+            }
+
+            if( ReadToken(psContext) == TToken )
+            {
+                /* TODO: at some point we could just error out like any other */
+                /* sane XML parser would do */
+                CPLError( CE_Warning, CPLE_AppDefined,
+                          "Line %d: Attribute value should be single or double quoted. "
+                          "Going on, but this is invalid XML that might be rejected in "
+                          "future versions.",
+                          psContext->nInputLine );
+            }
+            else if( psContext->eTokenType != TString )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Didn't find expected attribute value.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+
+            psReader->pszName = psReader->pszAttrName;
+            psReader->pszValue = psContext->pszToken;
+            psReader->eEvent = CXE_Attribute;
+            return CXE_Attribute;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Close the start section of an element.                          */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TClose )
+        {
+            if( psContext->nStackSize == 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Found unbalanced '>'.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Close the start section of an element, and pop it               */
+/*      immediately.                                                    */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TSlashClose )
+        {
+            if( psContext->nStackSize == 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Found unbalanced '/>'.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+
+            psReader->pszName = PopName( psContext );
+            psReader->eEvent = CXE_EndElement;
+            return CXE_EndElement;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Close the start section of a <?...?> element, and pop it        */
+/*      immediately.                                                    */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TQuestionClose )
+        {
+            if( psContext->nStackSize == 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Found unbalanced '?>'.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+            else if( TopName(psContext)[0] != '?' )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Line %d: Found '?>' without matching '<?'.",
+                          psContext->nInputLine );
+                return ReaderFailure( psReader );
+            }
+
+            psReader->pszName = PopName( psContext );
+            psReader->eEvent = CXE_EndElement;
+            return CXE_EndElement;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Handle comments.  They are returned as a whole token with the     */
+/*      prefix and postfix omitted.  No processing of white space       */
+/*      will be done.                                                   */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TComment )
+        {
+            psReader->pszValue = psContext->pszToken;
+            psReader->eEvent = CXE_Comment;
+            return CXE_Comment;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Handle literals.  They are returned without processing.         */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TLiteral )
+        {
+            psReader->pszValue = psContext->pszToken;
+            psReader->eEvent = CXE_Literal;
+            return CXE_Literal;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Text value of the current element.                              */
+/* -------------------------------------------------------------------- */
+        else if( psContext->eTokenType == TString && !psContext->bInElement )
+        {
+            psReader->pszValue = psContext->pszToken;
+            psReader->eEvent = CXE_Text;
+            return CXE_Text;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Anything else is an error.                                      */
+/* -------------------------------------------------------------------- */
+        else
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Parse error at line %d, unexpected token:%.500s\n",
+                      psContext->nInputLine, psContext->pszToken );
+            return ReaderFailure( psReader );
+        }
+    }
+}
+
+/************************************************************************/
+/*                        CPLXMLReaderGetName()                         */
+/************************************************************************/
+
+/**
+ * \brief Return the name of the element or attribute of the current event.
+ *
+ * @param psReader the reader.
+ *
+ * @return the element name for CXE_StartElement and CXE_EndElement, the
+ * attribute name for CXE_Attribute, NULL otherwise.  The string is owned by
+ * the reader and is only valid until the next call to CPLXMLReaderNext().
+ *
+ * @since GDAL 2.0
+ */
+
+const char *CPLXMLReaderGetName( CPLXMLReader *psReader )
+
+{
+    return psReader->pszName;
+}
+
+/************************************************************************/
+/*                        CPLXMLReaderGetValue()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the value of the current event.
+ *
+ * @param psReader the reader.
+ *
+ * @return the attribute value for CXE_Attribute, the text for CXE_Text,
+ * CXE_Comment and CXE_Literal, NULL otherwise.  The string is owned by
+ * the reader and is only valid until the next call to CPLXMLReaderNext().
+ *
+ * @since GDAL 2.0
+ */
+
+const char *CPLXMLReaderGetValue( CPLXMLReader *psReader )
+
+{
+    return psReader->pszValue;
+}
+
+/************************************************************************/
+/*                        CPLXMLReaderGetDepth()                        */
+/************************************************************************/
+
+/**
+ * \brief Return the number of currently opened elements.
+ *
+ * After a CXE_StartElement event, the count includes the element that has
+ * just been started.  After a CXE_EndElement event, it does not include the
+ * element that has just been ended.
+ *
+ * @param psReader the reader.
+ *
+ * @return the depth in the document.
+ *
+ * @since GDAL 2.0
+ */
+
+int CPLXMLReaderGetDepth( CPLXMLReader *psReader )
+
+{
+    return psReader->sContext.nStackSize;
+}
+
+/************************************************************************/
+/*                          CPLXMLArenaAlloc()                          */
+/************************************************************************/
+
+#define ARENA_ALIGNMENT         sizeof(void*)
+#define ARENA_ALIGN(n)          (((n) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ALIGN(sizeof(CPLXMLArenaBlock))
+#define ARENA_HEADER_SIZE       ARENA_ALIGN(sizeof(CPLXMLArena))
+#define ARENA_MAX_BLOCK_SIZE    (16 * 1024 * 1024)
+
+static void *CPLXMLArenaAlloc( CPLXMLArena *psArena, size_t nSize,
+                               int bAligned )
+
+{
+    if( bAligned )
+    {
+        size_t nPad = ARENA_ALIGN((size_t)psArena->pabyCur)
+                                                - (size_t)psArena->pabyCur;
+        if( nPad > psArena->nAvail )
+            nPad = psArena->nAvail;
+        psArena->pabyCur += nPad;
+        psArena->nAvail -= nPad;
+    }
+
+    if( nSize > psArena->nAvail )
+    {
+        size_t nBlockSize = MAX(psArena->nNextBlockSize,
+                                ARENA_BLOCK_HEADER_SIZE + nSize);
+        CPLXMLArenaBlock *psBlock = (CPLXMLArenaBlock *) VSIMalloc(nBlockSize);
+        if( psBlock == NULL )
+        {
+            CPLError(CE_Failure, CPLE_OutOfMemory,
+                     "Out of memory allocating %lu bytes",
+                     (unsigned long)nBlockSize);
+            return NULL;
+        }
+        psBlock->psNext = NULL;
+        psArena->psLastBlock->psNext = psBlock;
+        psArena->psLastBlock = psBlock;
+        psArena->pabyCur = ((GByte *) psBlock) + ARENA_BLOCK_HEADER_SIZE;
+        psArena->nAvail = nBlockSize - ARENA_BLOCK_HEADER_SIZE;
+        psArena->nNextBlockSize = MIN(psArena->nNextBlockSize * 2,
+                                      ARENA_MAX_BLOCK_SIZE);
+    }
+
+    void *pRet = psArena->pabyCur;
+    psArena->pabyCur += nSize;
+    psArena->nAvail -= nSize;
+    return pRet;
+}
+
+/************************************************************************/
+/*                         CPLXMLArenaCreate()                          */
+/*                                                                      */
+/*      The arena descriptor is stored at the start of its first        */
+/*      block.                                                          */
+/************************************************************************/
+
+static CPLXMLArena *CPLXMLArenaCreate( size_t nInputSize )
+
+{
+    size_t nBlockSize = MIN(nInputSize, (size_t)ARENA_MAX_BLOCK_SIZE) + 4096;
+    CPLXMLArenaBlock *psBlock = (CPLXMLArenaBlock *) VSIMalloc(nBlockSize);
+    if( psBlock == NULL )
+    {
+        CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Out of memory allocating %lu bytes",
+                 (unsigned long)nBlockSize);
+        return NULL;
+    }
+    psBlock->psNext = NULL;
+
+    CPLXMLArena *psArena = (CPLXMLArena *)
+        (((GByte *) psBlock) + ARENA_BLOCK_HEADER_SIZE);
+    psArena->psFirstBlock = psBlock;
+    psArena->psLastBlock = psBlock;
+    psArena->pabyCur = ((GByte *) psArena) + ARENA_HEADER_SIZE;
+    psArena->nAvail = nBlockSize - ARENA_BLOCK_HEADER_SIZE - ARENA_HEADER_SIZE;
+    psArena->nNextBlockSize = MAX(nBlockSize, 65536);
+
+    return psArena;
+}
+
+/************************************************************************/
+/*                         CPLXMLArenaDestroy()                         */
+/************************************************************************/
+
+static void CPLXMLArenaDestroy( CPLXMLArena *psArena )
+
+{
+    CPLXMLArenaBlock *psBlock = psArena->psFirstBlock;
+
+    while( psBlock != NULL )
+    {
+        CPLXMLArenaBlock *psNext = psBlock->psNext;
+        VSIFree( psBlock );
+        psBlock = psNext;
+    }
+}
+
+/************************************************************************/
+/*                       Registry of arena trees                        */
+/*                                                                      */
+/*      The arena of each tree returned by CPLParseXMLStringArena()     */
+/*      is recorded by the address of the root node, so that            */
+/*      CPLDestroyXMLArenaTree() can check that it is passed such a     */
+/*      tree without looking at memory it might not own.                */
+/************************************************************************/
+
+static CPLMutex *hArenaTreesMutex = NULL;
+static std::map<CPLXMLNode*, CPLXMLArena*> *poArenaTrees = NULL;
+
+static void CPLXMLArenaRegister( CPLXMLNode *psRoot, CPLXMLArena *psArena )
+
+{
+    CPLMutexHolderD( &hArenaTreesMutex );
+    if( poArenaTrees == NULL )
+        poArenaTrees = new std::map<CPLXMLNode*, CPLXMLArena*>();
+    (*poArenaTrees)[psRoot] = psArena;
+}
+
+static CPLXMLArena *CPLXMLArenaUnregister( CPLXMLNode *psRoot )
+
+{
+    CPLMutexHolderD( &hArenaTreesMutex );
+    if( poArenaTrees == NULL )
+        return NULL;
+
+    std::map<CPLXMLNode*, CPLXMLArena*>::iterator oIter =
+        poArenaTrees->find( psRoot );
+    if( oIter == poArenaTrees->end() )
+        return NULL;
+
+    CPLXMLArena *psArena = oIter->second;
+    poArenaTrees->erase( oIter );
+    if( poArenaTrees->empty() )
+    {
+        delete poArenaTrees;
+        poArenaTrees = NULL;
+    }
+    return psArena;
+}
+
+/************************************************************************/
+/*                       CPLCleanupXMLArenaMutex()                      */
+/************************************************************************/
+
+void CPLCleanupXMLArenaMutex()
+
+{
+    if( hArenaTreesMutex != NULL )
+    {
+        CPLDestroyMutex( hArenaTreesMutex );
+        hArenaTreesMutex = NULL;
+    }
+}
+
+/************************************************************************/
+/*                             CreateNode()                             */
+/************************************************************************/
+
+static CPLXMLNode *CreateNode( TreeBuilder *psBuilder, CPLXMLNodeType eType,
+                               const char *pszText )
+
+{
+    if( psBuilder->psArena == NULL )
+        return _CPLCreateXMLNode( NULL, eType, pszText );
+
+    size_t nLen = strlen(pszText);
+    CPLXMLNode *psNode = (CPLXMLNode *)
+        CPLXMLArenaAlloc( psBuilder->psArena, sizeof(CPLXMLNode), TRUE );
+    if( psNode == NULL )
+        return NULL;
+    psNode->pszValue = (char *)
+        CPLXMLArenaAlloc( psBuilder->psArena, nLen + 1, FALSE );
+    if( psNode->pszValue == NULL )
+        return NULL;
+
+    psNode->eType = eType;
+    memcpy( psNode->pszValue, pszText, nLen + 1 );
+    psNode->psNext = NULL;
+    psNode->psChild = NULL;
+
+    return psNode;
+}
+
+/************************************************************************/
+/*                              PushNode()                              */
+/************************************************************************/
+
+static int PushNode( TreeBuilder *psBuilder, CPLXMLNode *psNode )
+
+{
+    if( psBuilder->nStackMaxSize <= psBuilder->nStackSize )
+    {
+        psBuilder->nStackMaxSize += 10;
+
+        if (psBuilder->nStackMaxSize >= (int)(INT_MAX / sizeof(StackContext)))
+        {
+            CPLError(CE_Failure, CPLE_OutOfMemory,
+                 "Out of memory allocating %d*%d bytes", (int)sizeof(StackContext), psBuilder->nStackMaxSize);
+            VSIFree(psBuilder->papsStack);
+            psBuilder->papsStack = NULL;
             return FALSE;
         }
         StackContext* papsStack;
-        papsStack = (StackContext *)VSIRealloc(psContext->papsStack, 
-                    sizeof(StackContext) * psContext->nStackMaxSize);
+        papsStack = (StackContext *)VSIRealloc(psBuilder->papsStack,
+                    sizeof(StackContext) * psBuilder->nStackMaxSize);
         if (papsStack == NULL)
         {
             CPLError(CE_Failure, CPLE_OutOfMemory,
-                 "Out of memory allocating %d bytes", (int)(sizeof(StackContext) * psContext->nStackMaxSize));
-            VSIFree(psContext->papsStack);
-            psContext->papsStack = NULL;
+                 "Out of memory allocating %d bytes", (int)(sizeof(StackContext) * psBuilder->nStackMaxSize));
+            VSIFree(psBuilder->papsStack);
+            psBuilder->papsStack = NULL;
             return FALSE;
         }
-        psContext->papsStack = papsStack;
+        psBuilder->papsStack = papsStack;
     }
 
-    psContext->papsStack[psContext->nStackSize].psFirstNode = psNode;
-    psContext->papsStack[psContext->nStackSize].psLastChild = NULL;
-    psContext->nStackSize ++;
+    psBuilder->papsStack[psBuilder->nStackSize].psFirstNode = psNode;
+    psBuilder->papsStack[psBuilder->nStackSize].psLastChild = NULL;
+    psBuilder->nStackSize ++;
     return TRUE;
 }
-    
+
 /************************************************************************/
 /*                             AttachNode()                             */
 /*                                                                      */
@@ -532,333 +1331,262 @@ static int PushNode( ParseContext *psContext, CPLXMLNode *psNode )
 /*      there is nothing on the stack.                                  */
 /************************************************************************/
 
-static void AttachNode( ParseContext *psContext, CPLXMLNode *psNode )
+static void AttachNode( TreeBuilder *psBuilder, CPLXMLNode *psNode )
 
 {
-    if( psContext->psFirstNode == NULL )
+    if( psBuilder->psFirstNode == NULL )
     {
-        psContext->psFirstNode = psNode;
-        psContext->psLastNode = psNode;
+        psBuilder->psFirstNode = psNode;
+        psBuilder->psLastNode = psNode;
     }
-    else if( psContext->nStackSize == 0 )
+    else if( psBuilder->nStackSize == 0 )
     {
-        psContext->psLastNode->psNext = psNode;
-        psContext->psLastNode = psNode;
+        psBuilder->psLastNode->psNext = psNode;
+        psBuilder->psLastNode = psNode;
     }
-    else if( psContext->papsStack[psContext->nStackSize-1].psFirstNode->psChild == NULL )
+    else if( psBuilder->papsStack[psBuilder->nStackSize-1].psFirstNode->psChild == NULL )
     {
-        psContext->papsStack[psContext->nStackSize-1].psFirstNode->psChild = psNode;
-        psContext->papsStack[psContext->nStackSize-1].psLastChild = psNode;
+        psBuilder->papsStack[psBuilder->nStackSize-1].psFirstNode->psChild = psNode;
+        psBuilder->papsStack[psBuilder->nStackSize-1].psLastChild = psNode;
     }
     else
     {
-        psContext->papsStack[psContext->nStackSize-1].psLastChild->psNext = psNode;
-        psContext->papsStack[psContext->nStackSize-1].psLastChild = psNode;
+        psBuilder->papsStack[psBuilder->nStackSize-1].psLastChild->psNext = psNode;
+        psBuilder->papsStack[psBuilder->nStackSize-1].psLastChild = psNode;
     }
 }
 
 /************************************************************************/
-/*                         CPLParseXMLString()                          */
+/*                        CPLParseXMLStringEx()                         */
 /************************************************************************/
 
-/**
- * \brief Parse an XML string into tree form.
- *
- * The passed document is parsed into a CPLXMLNode tree representation. 
- * If the document is not well formed XML then NULL is returned, and errors
- * are reported via CPLError().  No validation beyond wellformedness is
- * done.  The CPLParseXMLFile() convenience function can be used to parse
- * from a file. 
- *
- * The returned document tree is is owned by the caller and should be freed
- * with CPLDestroyXMLNode() when no longer needed.
- *
- * If the document has more than one "root level" element then those after the 
- * first will be attached to the first as siblings (via the psNext pointers)
- * even though there is no common parent.  A document with no XML structure
- * (no angle brackets for instance) would be considered well formed, and 
- * returned as a single CXT_Text node.  
- * 
- * @param pszString the document to parse. 
- *
- * @return parsed tree or NULL on error. 
- */
-
-CPLXMLNode *CPLParseXMLString( const char *pszString )
+static CPLXMLNode *CPLParseXMLStringEx( const char *pszString, int bArena )
 
 {
-    ParseContext sContext;
+    TreeBuilder    sBuilder;
+    CPLXMLReader  *psReader;
 
     CPLErrorReset();
 
     if( pszString == NULL )
     {
-        CPLError( CE_Failure, CPLE_AppDefined, 
+        CPLError( CE_Failure, CPLE_AppDefined,
                   "CPLParseXMLString() called with NULL pointer." );
         return NULL;
     }
 
-/* -------------------------------------------------------------------- */
-/*      Initialize parse context.                                       */
-/* -------------------------------------------------------------------- */
-    sContext.pszInput = pszString;
-    sContext.nInputOffset = 0;
-    sContext.nInputLine = 0;
-    sContext.bInElement = FALSE;
-    sContext.nTokenMaxSize = 10;
-    sContext.pszToken = (char *) VSIMalloc(sContext.nTokenMaxSize);
-    if (sContext.pszToken == NULL)
+    psReader = CPLXMLReaderCreate( pszString );
+    if( psReader == NULL )
         return NULL;
-    sContext.nTokenSize = 0;
-    sContext.eTokenType = TNone;
-    sContext.nStackMaxSize = 0;
-    sContext.nStackSize = 0;
-    sContext.papsStack = NULL;
-    sContext.psFirstNode = NULL;
-    sContext.psLastNode = NULL;
+
+    sBuilder.nStackMaxSize = 0;
+    sBuilder.nStackSize = 0;
+    sBuilder.papsStack = NULL;
+    sBuilder.psFirstNode = NULL;
+    sBuilder.psLastNode = NULL;
+    sBuilder.psArena = NULL;
+
+    if( bArena )
+    {
+        sBuilder.psArena = CPLXMLArenaCreate( strlen(pszString) );
+        if( sBuilder.psArena == NULL )
+        {
+            CPLXMLReaderDestroy( psReader );
+            return NULL;
+        }
+    }
 
 /* ==================================================================== */
-/*      Loop reading tokens.                                            */
+/*      Loop reading events.                                            */
 /* ==================================================================== */
-    while( ReadToken( &sContext ) != TNone )
+    CPLXMLEventType eEvent;
+
+    while( (eEvent = CPLXMLReaderNext( psReader )) != CXE_EndDocument
+           && eEvent != CXE_Error )
     {
 /* -------------------------------------------------------------------- */
 /*      Create a new element.                                           */
 /* -------------------------------------------------------------------- */
-        if( sContext.eTokenType == TOpen )
+        if( eEvent == CXE_StartElement )
         {
             CPLXMLNode *psElement;
 
-            if( ReadToken(&sContext) != TToken )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Didn't find element token after open angle bracket.",
-                          sContext.nInputLine );
+            psElement = CreateNode( &sBuilder, CXT_Element,
+                                    CPLXMLReaderGetName(psReader) );
+            if (!psElement) break;
+            AttachNode( &sBuilder, psElement );
+            if (!PushNode( &sBuilder, psElement ))
                 break;
-            }
-
-            if( sContext.pszToken[0] != '/' )
-            {
-                psElement = _CPLCreateXMLNode( NULL, CXT_Element,
-                                              sContext.pszToken );
-                if (!psElement) break;
-                AttachNode( &sContext, psElement );
-                if (!PushNode( &sContext, psElement ))
-                    break;
-            }
-            else 
-            {
-                if( sContext.nStackSize == 0
-                    || !EQUAL(sContext.pszToken+1,
-                         sContext.papsStack[sContext.nStackSize-1].psFirstNode->pszValue) )
-                {
-                    CPLError( CE_Failure, CPLE_AppDefined, 
-                              "Line %d: <%.500s> doesn't have matching <%.500s>.",
-                              sContext.nInputLine,
-                              sContext.pszToken, sContext.pszToken+1 );
-                    break;
-                }
-                else
-                {
-                    if (strcmp(sContext.pszToken+1,
-                         sContext.papsStack[sContext.nStackSize-1].psFirstNode->pszValue) != 0)
-                    {
-                        /* TODO: at some point we could just error out like any other */
-                        /* sane XML parser would do */
-                        CPLError( CE_Warning, CPLE_AppDefined,
-                                "Line %d: <%.500s> matches <%.500s>, but the case isn't the same. "
-                                "Going on, but this is invalid XML that might be rejected in "
-                                "future versions.",
-                                sContext.nInputLine,
-                                sContext.papsStack[sContext.nStackSize-1].psFirstNode->pszValue,
-                                sContext.pszToken );
-                    }
-
-                    if( ReadToken(&sContext) != TClose )
-                    {
-                        CPLError( CE_Failure, CPLE_AppDefined, 
-                                  "Line %d: Missing close angle bracket after <%.500s.",
-                                  sContext.nInputLine,
-                                  sContext.pszToken );
-                        break;
-                    }
-
-                    /* pop element off stack */
-                    sContext.nStackSize--;
-                }
-            }
         }
 
 /* -------------------------------------------------------------------- */
-/*      Add an attribute to a token.                                    */
+/*      Add an attribute to the current element.                        */
 /* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TToken )
+        else if( eEvent == CXE_Attribute )
         {
             CPLXMLNode *psAttr;
 
-            psAttr = _CPLCreateXMLNode(NULL, CXT_Attribute, sContext.pszToken);
+            psAttr = CreateNode( &sBuilder, CXT_Attribute,
+                                 CPLXMLReaderGetName(psReader) );
             if (!psAttr) break;
-            AttachNode( &sContext, psAttr );
-            
-            if( ReadToken(&sContext) != TEqual )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Didn't find expected '=' for value of attribute '%.500s'.",
-                          sContext.nInputLine, psAttr->pszValue );
-                break;
-            }
-
-            if( ReadToken(&sContext) == TToken )
-            {
-                /* TODO: at some point we could just error out like any other */
-                /* sane XML parser would do */
-                CPLError( CE_Warning, CPLE_AppDefined,
-                          "Line %d: Attribute value should be single or double quoted. "
-                          "Going on, but this is invalid XML that might be rejected in "
-                          "future versions.",
-                          sContext.nInputLine );
-            }
-            else if( sContext.eTokenType != TString )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Didn't find expected attribute value.",
-                          sContext.nInputLine );
-                break;
-            }
-
-            if (!_CPLCreateXMLNode( psAttr, CXT_Text, sContext.pszToken )) break;
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Close the start section of an element.                          */
-/* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TClose )
-        {
-            if( sContext.nStackSize == 0 )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Found unbalanced '>'.",
-                          sContext.nInputLine );
-                break;
-            }
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Close the start section of an element, and pop it               */
-/*      immediately.                                                    */
-/* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TSlashClose )
-        {
-            if( sContext.nStackSize == 0 )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Found unbalanced '/>'.",
-                          sContext.nInputLine );
-                break;
-            }
+            AttachNode( &sBuilder, psAttr );
 
-            sContext.nStackSize--;
+            psAttr->psChild = CreateNode( &sBuilder, CXT_Text,
+                                          CPLXMLReaderGetValue(psReader) );
+            if (!psAttr->psChild) break;
         }
 
 /* -------------------------------------------------------------------- */
-/*      Close the start section of a <?...?> element, and pop it        */
-/*      immediately.                                                    */
+/*      Pop the current element.                                        */
 /* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TQuestionClose )
+        else if( eEvent == CXE_EndElement )
         {
-            if( sContext.nStackSize == 0 )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Found unbalanced '?>'.",
-                          sContext.nInputLine );
-                break;
-            }
-            else if( sContext.papsStack[sContext.nStackSize-1].psFirstNode->pszValue[0] != '?' )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "Line %d: Found '?>' without matching '<?'.",
-                          sContext.nInputLine );
-                break;
-            }
-
-            sContext.nStackSize--;
+            sBuilder.nStackSize--;
         }
 
 /* -------------------------------------------------------------------- */
-/*      Handle comments.  They are returned as a whole token with the     */
-/*      prefix and postfix omitted.  No processing of white space       */
-/*      will be done.                                                   */
+/*      Add a text value, comment or literal node as a child of the     */
+/*      current element.                                                */
 /* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TComment )
+        else
         {
             CPLXMLNode *psValue;
+            CPLXMLNodeType eType = CXT_Text;
 
-            psValue = _CPLCreateXMLNode(NULL, CXT_Comment, sContext.pszToken);
-            if (!psValue) break;
-            AttachNode( &sContext, psValue );
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Handle literals.  They are returned without processing.         */
-/* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TLiteral )
-        {
-            CPLXMLNode *psValue;
+            if( eEvent == CXE_Comment )
+                eType = CXT_Comment;
+            else if( eEvent == CXE_Literal )
+                eType = CXT_Literal;
 
-            psValue = _CPLCreateXMLNode(NULL, CXT_Literal, sContext.pszToken);
+            psValue = CreateNode( &sBuilder, eType,
+                                  CPLXMLReaderGetValue(psReader) );
             if (!psValue) break;
-            AttachNode( &sContext, psValue );
+            AttachNode( &sBuilder, psValue );
         }
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Add a text value node as a child of the current element.        */
+/*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
-        else if( sContext.eTokenType == TString && !sContext.bInElement )
-        {
-            CPLXMLNode *psValue;
+    CPLXMLReaderDestroy( psReader );
+    if( sBuilder.papsStack != NULL )
+        CPLFree( sBuilder.papsStack );
 
-            psValue = _CPLCreateXMLNode(NULL, CXT_Text, sContext.pszToken);
-            if (!psValue) break;
-            AttachNode( &sContext, psValue );
-        }
-/* -------------------------------------------------------------------- */
-/*      Anything else is an error.                                      */
-/* -------------------------------------------------------------------- */
+    if( CPLGetLastErrorType() == CE_Failure )
+    {
+        if( sBuilder.psArena != NULL )
+            CPLXMLArenaDestroy( sBuilder.psArena );
         else
-        {
-            CPLError( CE_Failure, CPLE_AppDefined, 
-                      "Parse error at line %d, unexpected token:%.500s\n", 
-                      sContext.nInputLine, sContext.pszToken );
-            break;
-        }
+            CPLDestroyXMLNode( sBuilder.psFirstNode );
+        return NULL;
     }
 
-/* -------------------------------------------------------------------- */
-/*      Did we pop all the way out of our stack?                        */
-/* -------------------------------------------------------------------- */
-    if( CPLGetLastErrorType() != CE_Failure && sContext.nStackSize != 0 )
+    if( sBuilder.psArena != NULL )
     {
-        CPLError( CE_Failure, CPLE_AppDefined, 
-                  "Parse error at EOF, not all elements have been closed,\n"
-                  "starting with %.500s\n", 
-                  sContext.papsStack[sContext.nStackSize-1].psFirstNode->pszValue );
+        if( sBuilder.psFirstNode == NULL )
+            CPLXMLArenaDestroy( sBuilder.psArena );
+        else
+            CPLXMLArenaRegister( sBuilder.psFirstNode, sBuilder.psArena );
     }
 
-/* -------------------------------------------------------------------- */
-/*      Cleanup                                                         */
-/* -------------------------------------------------------------------- */
-    CPLFree( sContext.pszToken );
-    if( sContext.papsStack != NULL )
-        CPLFree( sContext.papsStack );
+    return sBuilder.psFirstNode;
+}
 
-    if( CPLGetLastErrorType() == CE_Failure )
+/************************************************************************/
+/*                         CPLParseXMLString()                          */
+/************************************************************************/
+
+/**
+ * \brief Parse an XML string into tree form.
+ *
+ * The passed document is parsed into a CPLXMLNode tree representation.
+ * If the document is not well formed XML then NULL is returned, and errors
+ * are reported via CPLError().  No validation beyond wellformedness is
+ * done.  The CPLParseXMLFile() convenience function can be used to parse
+ * from a file.
+ *
+ * The returned document tree is is owned by the caller and should be freed
+ * with CPLDestroyXMLNode() when no longer needed.
+ *
+ * If the document has more than one "root level" element then those after the
+ * first will be attached to the first as siblings (via the psNext pointers)
+ * even though there is no common parent.  A document with no XML structure
+ * (no angle brackets for instance) would be considered well formed, and
+ * returned as a single CXT_Text node.
+ *
+ * @param pszString the document to parse.
+ *
+ * @return parsed tree or NULL on error.
+ */
+
+CPLXMLNode *CPLParseXMLString( const char *pszString )
+
+{
+    return CPLParseXMLStringEx( pszString, FALSE );
+}
+
+/************************************************************************/
+/*                       CPLParseXMLStringArena()                       */
+/************************************************************************/
+
+/**
+ * \brief Parse an XML string into a read-only tree.
+ *
+ * Same as CPLParseXMLString(), except that all the nodes and values of
+ * the tree are allocated from a few big memory blocks, which is much
+ * faster and more compact for big documents.
+ *
+ * The returned tree must be freed with CPLDestroyXMLArenaTree(), and must
+ * not be modified: nodes of the tree must not be passed to
+ * CPLDestroyXMLNode(), CPLSetXMLValue(), CPLRemoveXMLChild() or
+ * CPLAddXMLChild().  CPLCloneXMLTree() can be used to get a regular copy
+ * of a subtree.
+ *
+ * @param pszString the document to parse.
+ *
+ * @return parsed tree or NULL on error.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLXMLNode *CPLParseXMLStringArena( const char *pszString )
+
+{
+    return CPLParseXMLStringEx( pszString, TRUE );
+}
+
+/************************************************************************/
+/*                       CPLDestroyXMLArenaTree()                       */
+/************************************************************************/
+
+/**
+ * \brief Destroy a tree returned by CPLParseXMLStringArena().
+ *
+ * @param psTree the tree to free, as returned by CPLParseXMLStringArena()
+ * or CPLParseXMLFileArena().  May be NULL.
+ *
+ * Any other pointer, like the root of a tree returned by CPLParseXMLString()
+ * or a node inside an arena tree, is reported as an error and not freed.
+ *
+ * @since GDAL 2.0
+ */
+
+void CPLDestroyXMLArenaTree( CPLXMLNode *psTree )
+
+{
+    if( psTree == NULL )
+        return;
+
+    CPLXMLArena *psArena = CPLXMLArenaUnregister( psTree );
+    if( psArena == NULL )
     {
-        CPLDestroyXMLNode( sContext.psFirstNode );
-        sContext.psFirstNode = NULL;
-        sContext.psLastNode = NULL;
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "CPLDestroyXMLArenaTree() called on a tree not returned "
+                  "by CPLParseXMLStringArena()." );
+        return;
     }
 
-    return sContext.psFirstNode;
+    CPLXMLArenaDestroy( psArena );
 }
 
 /************************************************************************/
@@ -876,6 +1604,29 @@ static void _GrowBuffer( size_t nNeeded,
     }
 }
 
+/************************************************************************/
+/*                           NeedsEscaping()                            */
+/*                                                                      */
+/*      Whether CPLEscapeString() with the CPLES_XML schemes would      */
+/*      alter the string.  Most values do not need it, which saves      */
+/*      an allocation and a copy per node when serializing.             */
+/************************************************************************/
+
+static int NeedsEscaping( const char *pszText, int bEscapeQuotes )
+
+{
+    for( const GByte *pabyIter = (const GByte *) pszText;
+         *pabyIter != '\0'; pabyIter++ )
+    {
+        GByte ch = *pabyIter;
+        if( ch == '<' || ch == '>' || ch == '&' || ch == 0xEF
+            || (ch == '"' && bEscapeQuotes)
+            || (ch < 0x20 && ch != 0x9 && ch != 0xA && ch != 0xD) )
+            return TRUE;
+    }
+    return FALSE;
+}
+
 /************************************************************************/
 /*                        CPLSerializeXMLNode()                         */
 /************************************************************************/
@@ -902,16 +1653,23 @@ CPLSerializeXMLNode( const CPLXMLNode *psNode, int nIndent,
 /* -------------------------------------------------------------------- */
     if( psNode->eType == CXT_Text )
     {
-        char *pszEscaped = CPLEscapeString( psNode->pszValue, -1, CPLES_XML_BUT_QUOTES );
-
         CPLAssert( psNode->psChild == NULL );
 
-        /* Escaped text might be bigger than expected. */
-        _GrowBuffer( strlen(pszEscaped) + *pnLength,
-                     ppszText, pnMaxLength );
-        strcat( *ppszText + *pnLength, pszEscaped );
+        if( !NeedsEscaping( psNode->pszValue, FALSE ) )
+        {
+            strcpy( *ppszText + *pnLength, psNode->pszValue );
+        }
+        else
+        {
+            char *pszEscaped = CPLEscapeString( psNode->pszValue, -1, CPLES_XML_BUT_QUOTES );
+
+            /* Escaped text might be bigger than expected. */
+            _GrowBuffer( strlen(pszEscaped) + *pnLength,
+                         ppszText, pnMaxLength );
+            strcat( *ppszText + *pnLength, pszEscaped );
 
-        CPLFree( pszEscaped );
+            CPLFree( pszEscaped );
+        }
     }
 
 /* -------------------------------------------------------------------- */
@@ -925,13 +1683,22 @@ CPLSerializeXMLNode( const CPLXMLNode *psNode, int nIndent,
         sprintf( *ppszText + *pnLength, " %s=\"", psNode->pszValue );
         *pnLength += strlen(*ppszText + *pnLength);
 
-        char *pszEscaped = CPLEscapeString( psNode->psChild->pszValue, -1, CPLES_XML );
+        if( !NeedsEscaping( psNode->psChild->pszValue, TRUE ) )
+        {
+            _GrowBuffer( strlen(psNode->psChild->pszValue) + *pnLength,
+                         ppszText, pnMaxLength );
+            strcpy( *ppszText + *pnLength, psNode->psChild->pszValue );
+        }
+        else
+        {
+            char *pszEscaped = CPLEscapeString( psNode->psChild->pszValue, -1, CPLES_XML );
 
-        _GrowBuffer( strlen(pszEscaped) + *pnLength,
-                     ppszText, pnMaxLength );
-        strcat( *ppszText + *pnLength, pszEscaped );
+            _GrowBuffer( strlen(pszEscaped) + *pnLength,
+                         ppszText, pnMaxLength );
+            strcat( *ppszText + *pnLength, pszEscaped );
 
-        CPLFree( pszEscaped );
+            CPLFree( pszEscaped );
+        }
 
         *pnLength += strlen(*ppszText + *pnLength);
         _GrowBuffer( 3 + *pnLength, ppszText, pnMaxLength );
@@ -1946,6 +2713,40 @@ CPLXMLNode *CPLParseXMLFile( const char *pszFilename )
     return psTree;
 }
 
+/************************************************************************/
+/*                        CPLParseXMLFileArena()                        */
+/************************************************************************/
+
+/**
+ * \brief Parse XML file into a read-only tree.
+ *
+ * Same as CPLParseXMLFile(), but the tree is built with
+ * CPLParseXMLStringArena() and must be freed with CPLDestroyXMLArenaTree().
+ *
+ * @param pszFilename the file to open.
+ *
+ * @return NULL on failure, or the document tree on success.
+ *
+ * @since GDAL 2.0
+ */
+
+CPLXMLNode *CPLParseXMLFileArena( const char *pszFilename )
+
+{
+    GByte           *pabyOut = NULL;
+    char            *pszDoc;
+    CPLXMLNode      *psTree;
+
+    if( !VSIIngestFile( NULL, pszFilename, &pabyOut, NULL, -1 ) )
+        return NULL;
+    pszDoc = (char*) pabyOut;
+
+    psTree = CPLParseXMLStringArena( pszDoc );
+    CPLFree( pszDoc );
+
+    return psTree;
+}
+
 /************************************************************************/
 /*                     CPLSerializeXMLTreeToFile()                      */
 /************************************************************************/
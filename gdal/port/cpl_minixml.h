@@ -155,6 +155,38 @@ CPLXMLNode CPL_DLL *CPLParseXMLFile( const char *pszFilename );
 int        CPL_DLL CPLSerializeXMLTreeToFile( const CPLXMLNode *psTree,
                                               const char *pszFilename );
 
+CPLXMLNode CPL_DLL *CPLParseXMLStringArena( const char * );
+CPLXMLNode CPL_DLL *CPLParseXMLFileArena( const char *pszFilename );
+void       CPL_DLL  CPLDestroyXMLArenaTree( CPLXMLNode * );
+void                CPLCleanupXMLArenaMutex( void );
+
+/* -------------------------------------------------------------------- */
+/*      Pull parser.                                                    */
+/* -------------------------------------------------------------------- */
+
+typedef enum
+{
+    /*! Document not well formed */     CXE_Error = -1,
+    /*! Nothing read yet */             CXE_StartDocument = 0,
+    /*! Start of an element */          CXE_StartElement = 1,
+    /*! Attribute of an element */      CXE_Attribute = 2,
+    /*! End of an element */            CXE_EndElement = 3,
+    /*! Raw text value */               CXE_Text = 4,
+    /*! XML comment */                  CXE_Comment = 5,
+    /*! Special literal */              CXE_Literal = 6,
+    /*! End of the document */          CXE_EndDocument = 7
+} CPLXMLEventType;
+
+/** Opaque type of the pull parser returned by CPLXMLReaderCreate() */
+typedef struct _CPLXMLReader CPLXMLReader;
+
+CPLXMLReader    CPL_DLL *CPLXMLReaderCreate( const char *pszString );
+CPLXMLEventType CPL_DLL  CPLXMLReaderNext( CPLXMLReader *psReader );
+const char      CPL_DLL *CPLXMLReaderGetName( CPLXMLReader *psReader );
+const char      CPL_DLL *CPLXMLReaderGetValue( CPLXMLReader *psReader );
+int             CPL_DLL  CPLXMLReaderGetDepth( CPLXMLReader *psReader );
+void            CPL_DLL  CPLXMLReaderDestroy( CPLXMLReader *psReader );
+
 CPL_C_END
 
 #endif /* _CPL_MINIXML_H_INCLUDED */
@@ -846,6 +846,7 @@ extern int ZEXPORT cpl_zipOpenNewFileInZip3 (
 
     zi->ci.stream.avail_in = (uInt)0;
     zi->ci.stream.avail_out = (uInt)Z_BUFSIZE;
+    zi->ci.stream.data_type = Z_BINARY;
     zi->ci.stream.next_out = zi->ci.buffered_data;
     zi->ci.stream.total_in = 0;
     zi->ci.stream.total_out = 0;
@@ -1212,13 +1213,49 @@ extern int ZEXPORT cpl_zipClose (
 /************************************************************************/
 
 #include "cpl_minizip_unzip.h"
+#include "cpl_vsi_virtual.h"
 
 typedef struct
 {
     zipFile   hZip;
     char    **papszFilenames;
+
+    /* Set when the current file is compressed by several threads */
+    VSIVirtualHandle *poDeflateHandle;
+    uLong     nCRC;
+    uLong     nUncompressedSize;
 } CPLZip;
 
+/************************************************************************/
+/*                          VSIZipRawWriteHandle                        */
+/*                                                                      */
+/*      Writes an already compressed stream in the current file of a   */
+/*      ZIP, opened in raw mode.                                        */
+/************************************************************************/
+
+class VSIZipRawWriteHandle : public VSIVirtualHandle
+{
+    zipFile   hZip;
+
+  public:
+    VSIZipRawWriteHandle( zipFile hZipIn ) : hZip(hZipIn) {}
+
+    virtual int       Seek( CPL_UNUSED vsi_l_offset nOffset,
+                            CPL_UNUSED int nWhence ) { return -1; }
+    virtual vsi_l_offset Tell() { return 0; }
+    virtual size_t    Read( CPL_UNUSED void *pBuffer, CPL_UNUSED size_t nSize,
+                            CPL_UNUSED size_t nMemb ) { return 0; }
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb )
+    {
+        if( cpl_zipWriteInFileInZip( hZip, pBuffer,
+                                     (unsigned int)(nSize * nMemb) ) != ZIP_OK )
+            return 0;
+        return nMemb;
+    }
+    virtual int       Eof() { return 0; }
+    virtual int       Close() { return 0; }
+};
+
 /************************************************************************/
 /*                            CPLCreateZip()                            */
 /************************************************************************/
@@ -1263,6 +1300,9 @@ void *CPLCreateZip( const char *pszZipFilename, char **papszOptions )
     CPLZip* psZip = (CPLZip*)CPLMalloc(sizeof(CPLZip));
     psZip->hZip = hZip;
     psZip->papszFilenames = papszFilenames;
+    psZip->poDeflateHandle = NULL;
+    psZip->nCRC = 0;
+    psZip->nUncompressedSize = 0;
     return psZip;
 }
 
@@ -1291,9 +1331,25 @@ CPLErr CPLCreateFileInZip( void *hZip, const char *pszFilename,
 
     int bCompressed = CSLTestBoolean(CSLFetchNameValueDef(papszOptions, "COMPRESSED", "TRUE"));
 
-    nErr = cpl_zipOpenNewFileInZip( psZip->hZip, pszFilename, NULL, 
-                                    NULL, 0, NULL, 0, "", 
-                                    bCompressed ? Z_DEFLATED : 0, bCompressed ? Z_DEFAULT_COMPRESSION : 0 );
+/* -------------------------------------------------------------------- */
+/*      With several threads, we deflate ourselves and let minizip     */
+/*      store the result as is.                                         */
+/* -------------------------------------------------------------------- */
+    int bMultiThreaded = bCompressed && VSIGetDeflateThreadCount() > 1;
+
+    nErr = cpl_zipOpenNewFileInZip2( psZip->hZip, pszFilename, NULL, 
+                                     NULL, 0, NULL, 0, "", 
+                                     bCompressed ? Z_DEFLATED : 0, bCompressed ? Z_DEFAULT_COMPRESSION : 0,
+                                     bMultiThreaded );
+
+    if( nErr == ZIP_OK && bMultiThreaded )
+    {
+        psZip->poDeflateHandle = VSICreateGZipWritableMT(
+            new VSIZipRawWriteHandle(psZip->hZip),
+            CPL_DEFLATE_TYPE_RAW_DEFLATE, TRUE );
+        psZip->nCRC = crc32(0L, Z_NULL, 0);
+        psZip->nUncompressedSize = 0;
+    }
 
     if( nErr != ZIP_OK )
         return CE_Failure;
@@ -1317,6 +1373,17 @@ CPLErr CPLWriteFileInZip( void *hZip, const void *pBuffer, int nBufferSize )
     if( psZip == NULL )
         return CE_Failure;
 
+    if( psZip->poDeflateHandle != NULL )
+    {
+        psZip->nCRC = crc32(psZip->nCRC, (const Bytef*) pBuffer,
+                            (uInt) nBufferSize);
+        psZip->nUncompressedSize += nBufferSize;
+        if( psZip->poDeflateHandle->Write( pBuffer, 1, nBufferSize )
+                                                    != (size_t) nBufferSize )
+            return CE_Failure;
+        return CE_None;
+    }
+
     nErr = cpl_zipWriteInFileInZip( psZip->hZip, pBuffer, 
                                     (unsigned int) nBufferSize );
 
@@ -1339,7 +1406,19 @@ CPLErr CPLCloseFileInZip( void *hZip )
     if( psZip == NULL )
         return CE_Failure;
 
-    nErr = cpl_zipCloseFileInZip( psZip->hZip );
+    if( psZip->poDeflateHandle != NULL )
+    {
+        int bOK = (psZip->poDeflateHandle->Close() == 0);
+        delete psZip->poDeflateHandle;
+        psZip->poDeflateHandle = NULL;
+
+        nErr = cpl_zipCloseFileInZipRaw( psZip->hZip, psZip->nUncompressedSize,
+                                         psZip->nCRC );
+        if( !bOK )
+            return CE_Failure;
+    }
+    else
+        nErr = cpl_zipCloseFileInZip( psZip->hZip );
 
     if( nErr != ZIP_OK )
         return CE_Failure;
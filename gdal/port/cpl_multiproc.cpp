@@ -489,6 +489,16 @@ void  CPLCondWait( CPL_UNUSED CPLCond *hCond, CPL_UNUSED CPLMutex* hMutex )
 {
 }
 
+/************************************************************************/
+/*                          CPLCondTimedWait()                          */
+/************************************************************************/
+
+int   CPLCondTimedWait( CPL_UNUSED CPLCond *hCond, CPL_UNUSED CPLMutex* hMutex,
+                        CPL_UNUSED double dfWaitInSeconds )
+{
+    return TRUE;
+}
+
 /************************************************************************/
 /*                            CPLCondSignal()                           */
 /************************************************************************/
@@ -918,6 +928,75 @@ void  CPLCondWait( CPLCond *hCond, CPLMutex* hClientMutex )
     CPLAcquireMutex(hClientMutex, 1000.0);
 }
 
+/************************************************************************/
+/*                          CPLCondTimedWait()                          */
+/************************************************************************/
+
+int   CPLCondTimedWait( CPLCond *hCond, CPLMutex* hClientMutex,
+                        double dfWaitInSeconds )
+{
+    Win32Cond* psCond = (Win32Cond*) hCond;
+
+    HANDLE hEvent = (HANDLE) CPLGetTLS(CTLS_WIN32_COND);
+    if (hEvent == NULL)
+    {
+        hEvent = CreateEvent(NULL, /* security attributes */
+                             0,    /* manual reset = no */
+                             0,    /* initial state = unsignaled */
+                             NULL  /* no name */);
+        CPLAssert(hEvent != NULL);
+
+        CPLSetTLSWithFreeFunc(CTLS_WIN32_COND, hEvent, CPLTLSFreeEvent);
+    }
+
+    /* Insert the waiter into the waiter list of the condition */
+    CPLAcquireMutex(psCond->hInternalMutex, 1000.0);
+
+    WaiterItem* psItem = (WaiterItem*)malloc(sizeof(WaiterItem));
+    CPLAssert(psItem != NULL);
+
+    psItem->hEvent = hEvent;
+    psItem->psNext = psCond->psWaiterList;
+
+    psCond->psWaiterList = psItem;
+
+    CPLReleaseMutex(psCond->hInternalMutex);
+
+    /* Release the client mutex before waiting for the event being signaled */
+    CPLReleaseMutex(hClientMutex);
+
+    int bSignaled = 
+        WaitForSingleObject(hEvent, (DWORD)(dfWaitInSeconds * 1000.0))
+                                                            == WAIT_OBJECT_0;
+    if( !bSignaled )
+    {
+        /* Remove ourselves from the waiter list, unless a signal has */
+        /* removed us in the meantime, in which case the event must be */
+        /* consumed so that it does not wake up our next wait */
+        CPLAcquireMutex(psCond->hInternalMutex, 1000.0);
+        WaiterItem** ppsIter = &(psCond->psWaiterList);
+        while( *ppsIter != NULL && (*ppsIter)->hEvent != hEvent )
+            ppsIter = &((*ppsIter)->psNext);
+        if( *ppsIter != NULL )
+        {
+            WaiterItem* psFound = *ppsIter;
+            *ppsIter = psFound->psNext;
+            free(psFound);
+        }
+        else
+        {
+            WaitForSingleObject(hEvent, INFINITE);
+            bSignaled = TRUE;
+        }
+        CPLReleaseMutex(psCond->hInternalMutex);
+    }
+
+    /* Reacquire the client mutex */
+    CPLAcquireMutex(hClientMutex, 1000.0);
+
+    return bSignaled;
+}
+
 /************************************************************************/
 /*                            CPLCondSignal()                           */
 /************************************************************************/
@@ -1221,6 +1300,8 @@ void CPLCleanupTLS()
 #include <pthread.h>
 #include <time.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
 
   /************************************************************************/
   /* ==================================================================== */
@@ -1507,6 +1588,30 @@ void  CPLCondWait( CPLCond *hCond, CPLMutex* hMutex )
     pthread_cond_wait(pCond,  pMutex);
 }
 
+/************************************************************************/
+/*                          CPLCondTimedWait()                          */
+/************************************************************************/
+
+int   CPLCondTimedWait( CPLCond *hCond, CPLMutex* hMutex,
+                        double dfWaitInSeconds )
+{
+    pthread_cond_t* pCond = (pthread_cond_t* )hCond;
+    MutexLinkedElt* psItem = (MutexLinkedElt *) hMutex;
+    pthread_mutex_t * pMutex = &(psItem->sMutex);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    double dfAbsTime = tv.tv_sec + tv.tv_usec * 1e-6 + dfWaitInSeconds;
+
+    struct timespec ts;
+    ts.tv_sec = (time_t) dfAbsTime;
+    ts.tv_nsec = (long) ((dfAbsTime - ts.tv_sec) * 1e9);
+    if( ts.tv_nsec >= 1000000000 )
+        ts.tv_nsec = 999999999;
+
+    return pthread_cond_timedwait(pCond, pMutex, &ts) != ETIMEDOUT;
+}
+
 /************************************************************************/
 /*                            CPLCondSignal()                           */
 /************************************************************************/
@@ -84,6 +84,8 @@ void  CPL_DLL CPLCleanupMasterMutex( void );
 
 CPLCond  CPL_DLL *CPLCreateCond( void );
 void  CPL_DLL  CPLCondWait( CPLCond *hCond, CPLMutex* hMutex );
+int   CPL_DLL  CPLCondTimedWait( CPLCond *hCond, CPLMutex* hMutex,
+                                 double dfWaitInSeconds );
 void  CPL_DLL  CPLCondSignal( CPLCond *hCond );
 void  CPL_DLL  CPLCondBroadcast( CPLCond *hCond );
 void  CPL_DLL  CPLDestroyCond( CPLCond *hCond );
@@ -202,8 +204,8 @@ class CPL_DLL CPLLockHolder
 #define CTLS_ERRORCONTEXT               5         /* cpl_error.cpp */
 #define CTLS_GDALDATASET_REC_PROTECT_MAP 6        /* gdaldataset.cpp */
 #define CTLS_PATHBUF                    7         /* cpl_path.cpp */
-#define CTLS_UNUSED3                    8
-#define CTLS_UNUSED4                    9
+#define CTLS_RB_SEQUENTIAL_SCAN         8         /* gdalrasterblock.cpp */
+#define CTLS_RB_DIRTY_FLUSH_DISABLED    9         /* gdalrasterblock.cpp */
 #define CTLS_CPLSPRINTF                10         /* cpl_string.h */
 #define CTLS_RESPONSIBLEPID            11         /* gdaldataset.cpp */
 #define CTLS_VERSIONINFO               12         /* gdal_misc.cpp */
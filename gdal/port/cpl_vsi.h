@@ -173,6 +173,8 @@ int CPL_DLL     VSIStatExL( const char * pszFilename, VSIStatBufL * psStatBuf, i
 int CPL_DLL     VSIIsCaseSensitiveFS( const char * pszFilename );
 
 void CPL_DLL   *VSIFGetNativeFileDescriptorL( VSILFILE* );
+const void CPL_DLL *VSIFGetMappedAddressL( VSILFILE*, vsi_l_offset nOffset,
+                                           size_t nSize );
 
 /* ==================================================================== */
 /*      Memory allocation                                               */
@@ -64,6 +64,8 @@ class CPL_DLL VSIVirtualHandle {
     virtual int       Close() = 0;
     virtual int       Truncate( CPL_UNUSED vsi_l_offset nNewSize ) { return -1; }
     virtual void     *GetNativeFileDescriptor() { return NULL; }
+    virtual const void *GetMappedAddress( CPL_UNUSED vsi_l_offset nOffset,
+                                          CPL_UNUSED size_t nSize ) { return NULL; }
     virtual           ~VSIVirtualHandle() { }
 };
 
@@ -144,8 +146,14 @@ typedef struct
 {
     int nEntries;
     VSIArchiveEntry* entries;
+    std::map<CPLString, int> oMapEntryIndex; /* fileName -> index in entries */
 } VSIArchiveContent;
 
+void VSIArchiveAddEntry( VSIArchiveContent* content, char* pszFileName,
+                         vsi_l_offset nUncompressedSize,
+                         VSIArchiveEntryFileOffset* poFilePos,
+                         int bIsDir, GIntBig nModifiedTime );
+
 class VSIArchiveReader
 {
     public:
@@ -173,6 +181,11 @@ protected:
     virtual std::vector<CPLString> GetExtensions() = 0;
     virtual VSIArchiveReader* CreateReader(const char* pszArchiveFileName) = 0;
 
+    /* Optional persistent index of the content of an archive */
+    virtual VSIArchiveContent* LoadContentIndex(CPL_UNUSED const char* pszArchiveFileName) { return NULL; }
+    virtual void SaveContentIndex(CPL_UNUSED const char* pszArchiveFileName,
+                                  CPL_UNUSED const VSIArchiveContent* content) {}
+
 public:
     VSIArchiveFilesystemHandler();
     virtual ~VSIArchiveFilesystemHandler();
@@ -194,7 +207,21 @@ VSIVirtualHandle CPL_DLL *VSICreateBufferedReaderHandle(VSIVirtualHandle* poBase
 VSIVirtualHandle* VSICreateBufferedReaderHandle(VSIVirtualHandle* poBaseHandle,
                                                 const GByte* pabyBeginningContent,
                                                 vsi_l_offset nSheatFileSize);
-VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, size_t nChunkSize = 32768, size_t nCacheSize = 0 );
+VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, size_t nChunkSize = 32768, size_t nCacheSize = 0,
+                                       const char* pszFilename = NULL );
+void VSIInvalidatePageCache( const char* pszFilename );
+void VSICleanupPageCache();
 VSIVirtualHandle CPL_DLL *VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle, int bRegularZLibIn, int bAutoCloseBaseHandle );
 
+#define CPL_DEFLATE_TYPE_GZIP         0
+#define CPL_DEFLATE_TYPE_RAW_DEFLATE  1
+
+int CPL_DLL VSIGetDeflateThreadCount();
+VSIVirtualHandle CPL_DLL *VSICreateGZipWritableMT( VSIVirtualHandle* poBaseHandle,
+                                                   int nDeflateType,
+                                                   int bAutoCloseBaseHandle,
+                                                   int nThreads = 0,
+                                                   size_t nChunkSize = 0,
+                                                   const char* pszFilename = NULL );
+
 #endif /* ndef CPL_VSI_VIRTUAL_H_INCLUDED */
@@ -1038,6 +1038,38 @@ void *VSIFGetNativeFileDescriptorL( VSILFILE* fp )
     return poFileHandle->GetNativeFileDescriptor();
 }
 
+/************************************************************************/
+/*                        VSIFGetMappedAddressL()                       */
+/************************************************************************/
+
+/**
+ * \brief Returns a direct pointer to a range of a file, if it is mapped.
+ *
+ * This will only return a non-NULL value for handles backed by a memory
+ * mapping of the whole range, currently local files opened in read-only
+ * mode with the CPL_VSIL_LOCAL_MMAP configuration option set to YES.
+ * Callers must be prepared to fall back to VSIFSeekL() / VSIFReadL().
+ *
+ * The file position is not modified. The returned pointer is read-only,
+ * and remains valid until the handle is closed.
+ *
+ * @param fp file handle opened with VSIFOpenL().
+ * @param nOffset offset of the start of the range in the file.
+ * @param nSize size of the range in bytes.
+ *
+ * @return a pointer to the data at nOffset, or NULL.
+ *
+ * @since GDAL 2.0
+ */
+
+const void *VSIFGetMappedAddressL( VSILFILE* fp, vsi_l_offset nOffset,
+                                   size_t nSize )
+{
+    VSIVirtualHandle *poFileHandle = (VSIVirtualHandle *) fp;
+
+    return poFileHandle->GetMappedAddress( nOffset, nSize );
+}
+
 
 /************************************************************************/
 /* ==================================================================== */
@@ -1207,6 +1239,8 @@ void VSICleanupFileManager()
         CPLDestroyMutex(hVSIFileManagerMutex);
         hVSIFileManagerMutex = NULL;
     }
+
+    VSICleanupPageCache();
 }
 
 /************************************************************************/
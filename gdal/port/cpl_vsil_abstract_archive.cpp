@@ -31,7 +31,6 @@
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
 #include <map>
-#include <set>
 
 #define ENABLE_DEBUG 0
 
@@ -89,6 +88,41 @@ VSIArchiveFilesystemHandler::~VSIArchiveFilesystemHandler()
     hMutex = NULL;
 }
 
+/************************************************************************/
+/*                         VSIArchiveAddEntry()                         */
+/*                                                                      */
+/*      Append an entry to the content of an archive. Takes ownership  */
+/*      of pszFileName and poFilePos.                                   */
+/************************************************************************/
+
+void VSIArchiveAddEntry( VSIArchiveContent* content, char* pszFileName,
+                         vsi_l_offset nUncompressedSize,
+                         VSIArchiveEntryFileOffset* poFilePos,
+                         int bIsDir, GIntBig nModifiedTime )
+{
+    /* Grow the array by powers of 2, to avoid quadratic reallocations */
+    /* on archives with many entries */
+    int nEntries = content->nEntries;
+    if (nEntries == 0 || (nEntries & (nEntries - 1)) == 0)
+    {
+        content->entries = (VSIArchiveEntry*)CPLRealloc(content->entries,
+                                sizeof(VSIArchiveEntry) * MAX(1, 2 * nEntries));
+    }
+
+    VSIArchiveEntry* psEntry = &content->entries[nEntries];
+    psEntry->fileName = pszFileName;
+    psEntry->uncompressed_size = nUncompressedSize;
+    psEntry->file_pos = poFilePos;
+    psEntry->bIsDir = bIsDir;
+    psEntry->nModifiedTime = nModifiedTime;
+    if (ENABLE_DEBUG)
+        CPLDebug("VSIArchive", "[%d] %s : " CPL_FRMT_GUIB " bytes", nEntries+1,
+                 psEntry->fileName, psEntry->uncompressed_size);
+
+    content->oMapEntryIndex[pszFileName] = nEntries;
+    content->nEntries++;
+}
+
 /************************************************************************/
 /*                       GetContentOfArchive()                          */
 /************************************************************************/
@@ -98,9 +132,18 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
 {
     CPLMutexHolder oHolder( &hMutex );
 
-    if (oFileList.find(archiveFilename) != oFileList.end() )
+    std::map<CPLString,VSIArchiveContent*>::const_iterator oIter =
+        oFileList.find(archiveFilename);
+    if (oIter != oFileList.end() )
     {
-        return oFileList[archiveFilename];
+        return oIter->second;
+    }
+
+    VSIArchiveContent* content = LoadContentIndex(archiveFilename);
+    if (content != NULL)
+    {
+        oFileList[archiveFilename] = content;
+        return content;
     }
 
     int bMustClose = (poReader == NULL);
@@ -118,13 +161,11 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
         return NULL;
     }
 
-    VSIArchiveContent* content = new VSIArchiveContent;
+    content = new VSIArchiveContent;
     content->nEntries = 0;
     content->entries = NULL;
     oFileList[archiveFilename] = content;
 
-    std::set<CPLString> oSet;
-
     do
     {
         CPLString osFileName = poReader->GetFileName();
@@ -154,10 +195,9 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
             pszStrippedFileName[strlen(fileName)-1] = 0;
         }
 
-        if (oSet.find(pszStrippedFileName) == oSet.end())
+        if (content->oMapEntryIndex.find(pszStrippedFileName) ==
+                                            content->oMapEntryIndex.end())
         {
-            oSet.insert(pszStrippedFileName);
-
             /* Add intermediate directory structure */
             for(pszIter = pszStrippedFileName;*pszIter;pszIter++)
             {
@@ -165,22 +205,12 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
                 {
                     char* pszStrippedFileName2 = CPLStrdup(pszStrippedFileName);
                     pszStrippedFileName2[pszIter - pszStrippedFileName] = 0;
-                    if (oSet.find(pszStrippedFileName2) == oSet.end())
+                    if (content->oMapEntryIndex.find(pszStrippedFileName2) ==
+                                            content->oMapEntryIndex.end())
                     {
-                        oSet.insert(pszStrippedFileName2);
-
-                        content->entries = (VSIArchiveEntry*)CPLRealloc(content->entries,
-                                sizeof(VSIArchiveEntry) * (content->nEntries + 1));
-                        content->entries[content->nEntries].fileName = pszStrippedFileName2;
-                        content->entries[content->nEntries].nModifiedTime = poReader->GetModifiedTime();
-                        content->entries[content->nEntries].uncompressed_size = 0;
-                        content->entries[content->nEntries].bIsDir = TRUE;
-                        content->entries[content->nEntries].file_pos = NULL;
-                        if (ENABLE_DEBUG)
-                            CPLDebug("VSIArchive", "[%d] %s : " CPL_FRMT_GUIB " bytes", content->nEntries+1,
-                                content->entries[content->nEntries].fileName,
-                                content->entries[content->nEntries].uncompressed_size);
-                        content->nEntries++;
+                        VSIArchiveAddEntry(content, pszStrippedFileName2, 0,
+                                           NULL, TRUE,
+                                           poReader->GetModifiedTime());
                     }
                     else
                     {
@@ -189,18 +219,10 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
                 }
             }
 
-            content->entries = (VSIArchiveEntry*)CPLRealloc(content->entries,
-                                sizeof(VSIArchiveEntry) * (content->nEntries + 1));
-            content->entries[content->nEntries].fileName = pszStrippedFileName;
-            content->entries[content->nEntries].nModifiedTime = poReader->GetModifiedTime();
-            content->entries[content->nEntries].uncompressed_size = poReader->GetFileSize();
-            content->entries[content->nEntries].bIsDir = bIsDir;
-            content->entries[content->nEntries].file_pos = poReader->GetFileOffset();
-            if (ENABLE_DEBUG)
-                CPLDebug("VSIArchive", "[%d] %s : " CPL_FRMT_GUIB " bytes", content->nEntries+1,
-                    content->entries[content->nEntries].fileName,
-                    content->entries[content->nEntries].uncompressed_size);
-            content->nEntries++;
+            VSIArchiveAddEntry(content, pszStrippedFileName,
+                               poReader->GetFileSize(),
+                               poReader->GetFileOffset(), bIsDir,
+                               poReader->GetModifiedTime());
         }
         else
         {
@@ -211,6 +233,8 @@ const VSIArchiveContent* VSIArchiveFilesystemHandler::GetContentOfArchive
     if (bMustClose)
         delete(poReader);
 
+    SaveContentIndex(archiveFilename, content);
+
     return content;
 }
 
@@ -228,15 +252,13 @@ int VSIArchiveFilesystemHandler::FindFileInArchive(const char* archiveFilename,
     const VSIArchiveContent* content = GetContentOfArchive(archiveFilename);
     if (content)
     {
-        int i;
-        for(i=0;i<content->nEntries;i++)
+        std::map<CPLString, int>::const_iterator oIter =
+            content->oMapEntryIndex.find(fileInArchiveName);
+        if (oIter != content->oMapEntryIndex.end())
         {
-            if (strcmp(fileInArchiveName, content->entries[i].fileName) == 0)
-            {
-                if (archiveEntry)
-                    *archiveEntry = &content->entries[i];
-                return TRUE;
-            }
+            if (archiveEntry)
+                *archiveEntry = &content->entries[oIter->second];
+            return TRUE;
         }
     }
     return FALSE;
@@ -29,6 +29,8 @@
  ****************************************************************************/
 
 #include "cpl_vsi_virtual.h"
+#include "cpl_multiproc.h"
+#include <map>
 
 CPL_CVSID("$Id$");
 
@@ -505,13 +507,570 @@ int VSICachedFile::Flush()
     return 0;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                             VSIPageCache                             */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Process-wide cache of file pages, shared by all the handles opened */
+/* on the same file. Pages are identified by the absolute filename, the */
+/* file size and modification time (so that pages of a file that has  */
+/* been rewritten are not used), the page size and the page index.    */
+/* As the modification time has a one second resolution, the local    */
+/* filesystem handlers also invalidate the pages of a file when it is */
+/* opened for writing and when it is closed. */
+
+class VSIPageCacheKey
+{
+public:
+    CPLString     osFilename;
+    vsi_l_offset  nFileSize;
+    GIntBig       nMTime;
+    size_t        nPageSize;
+    vsi_l_offset  iPage;
+
+    bool operator< (const VSIPageCacheKey& other) const
+    {
+        if( iPage != other.iPage )
+            return iPage < other.iPage;
+        if( nFileSize != other.nFileSize )
+            return nFileSize < other.nFileSize;
+        if( nMTime != other.nMTime )
+            return nMTime < other.nMTime;
+        if( nPageSize != other.nPageSize )
+            return nPageSize < other.nPageSize;
+        return osFilename < other.osFilename;
+    }
+};
+
+class VSIPageCachePage
+{
+public:
+    VSIPageCacheKey   oKey;
+    VSIPageCachePage *poLRUPrev;
+    VSIPageCachePage *poLRUNext;
+    size_t            nDataFilled;
+    GByte            *pabyData;
+};
+
+class VSIPageCache
+{
+    CPLMutex       *hMutex;
+    std::map<VSIPageCacheKey, VSIPageCachePage*> oMapPages;
+    VSIPageCachePage *poLRUStart;   /* least recently used */
+    VSIPageCachePage *poLRUEnd;     /* most recently used */
+    GUIntBig        nCacheUsed;
+    GUIntBig        nCacheMax;
+
+    void            Unlink( VSIPageCachePage* poPage );
+    void            LinkAsMRU( VSIPageCachePage* poPage );
+
+public:
+                    VSIPageCache();
+                   ~VSIPageCache();
+
+    int             Get( const VSIPageCacheKey& oKey, size_t nOffsetInPage,
+                         size_t nSize, void* pDest, size_t* pnCopied );
+    int             Contains( const VSIPageCacheKey& oKey );
+    void            Put( const VSIPageCacheKey& oKey, const GByte* pabyData,
+                         size_t nDataFilled );
+    void            Invalidate( const CPLString& osFilename );
+};
+
+static VSIPageCache* poPageCache = NULL;
+static CPLMutex* hPageCacheMutex = NULL;
+
+/************************************************************************/
+/*                           VSIGetPageCache()                          */
+/************************************************************************/
+
+static VSIPageCache* VSIGetPageCache()
+{
+    CPLMutexHolderD( &hPageCacheMutex );
+    if( poPageCache == NULL )
+        poPageCache = new VSIPageCache();
+    return poPageCache;
+}
+
+/************************************************************************/
+/*                      VSIPageCacheGetFilename()                       */
+/*                                                                      */
+/*      Name under which the pages of a file are cached : relative      */
+/*      local filenames are made absolute, so that a change of current  */
+/*      directory does not make another file match.                     */
+/************************************************************************/
+
+static CPLString VSIPageCacheGetFilename( const char* pszFilename )
+{
+    CPLString osFilename( pszFilename );
+    if( !EQUALN(pszFilename, "/vsi", 4) && CPLIsFilenameRelative(pszFilename) )
+    {
+        char* pszCurDir = CPLGetCurrentDir();
+        if( pszCurDir != NULL )
+            osFilename = CPLFormFilename( pszCurDir, pszFilename, NULL );
+        CPLFree( pszCurDir );
+    }
+    return osFilename;
+}
+
+/************************************************************************/
+/*                       VSIInvalidatePageCache()                       */
+/*                                                                      */
+/*      Drop the cached pages of a file that is being written.          */
+/************************************************************************/
+
+void VSIInvalidatePageCache( const char* pszFilename )
+{
+    CPLMutexHolderD( &hPageCacheMutex );
+    if( poPageCache != NULL )
+        poPageCache->Invalidate( VSIPageCacheGetFilename( pszFilename ) );
+}
+
+/************************************************************************/
+/*                         VSICleanupPageCache()                        */
+/************************************************************************/
+
+void VSICleanupPageCache()
+{
+    delete poPageCache;
+    poPageCache = NULL;
+
+    if( hPageCacheMutex != NULL )
+        CPLDestroyMutex( hPageCacheMutex );
+    hPageCacheMutex = NULL;
+}
+
+/************************************************************************/
+/*                            VSIPageCache()                            */
+/************************************************************************/
+
+VSIPageCache::VSIPageCache()
+{
+    hMutex = NULL;
+    poLRUStart = NULL;
+    poLRUEnd = NULL;
+    nCacheUsed = 0;
+    nCacheMax = CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_SHARED_SIZE", "67108864" ), 40 );
+}
+
+/************************************************************************/
+/*                           ~VSIPageCache()                            */
+/************************************************************************/
+
+VSIPageCache::~VSIPageCache()
+{
+    std::map<VSIPageCacheKey, VSIPageCachePage*>::iterator oIter;
+    for( oIter = oMapPages.begin(); oIter != oMapPages.end(); ++oIter )
+    {
+        VSIFree( oIter->second->pabyData );
+        delete oIter->second;
+    }
+    if( hMutex != NULL )
+        CPLDestroyMutex( hMutex );
+}
+
+/************************************************************************/
+/*                               Unlink()                               */
+/************************************************************************/
+
+void VSIPageCache::Unlink( VSIPageCachePage* poPage )
+{
+    if( poPage->poLRUPrev != NULL )
+        poPage->poLRUPrev->poLRUNext = poPage->poLRUNext;
+    else
+        poLRUStart = poPage->poLRUNext;
+    if( poPage->poLRUNext != NULL )
+        poPage->poLRUNext->poLRUPrev = poPage->poLRUPrev;
+    else
+        poLRUEnd = poPage->poLRUPrev;
+    poPage->poLRUPrev = poPage->poLRUNext = NULL;
+}
+
+/************************************************************************/
+/*                             LinkAsMRU()                              */
+/************************************************************************/
+
+void VSIPageCache::LinkAsMRU( VSIPageCachePage* poPage )
+{
+    poPage->poLRUPrev = poLRUEnd;
+    poPage->poLRUNext = NULL;
+    if( poLRUEnd != NULL )
+        poLRUEnd->poLRUNext = poPage;
+    poLRUEnd = poPage;
+    if( poLRUStart == NULL )
+        poLRUStart = poPage;
+}
+
+/************************************************************************/
+/*                                Get()                                 */
+/*                                                                      */
+/*      Copy up to nSize bytes of a cached page, starting at            */
+/*      nOffsetInPage. Returns FALSE if the page is not cached.         */
+/************************************************************************/
+
+int VSIPageCache::Get( const VSIPageCacheKey& oKey, size_t nOffsetInPage,
+                       size_t nSize, void* pDest, size_t* pnCopied )
+{
+    CPLMutexHolderD( &hMutex );
+
+    std::map<VSIPageCacheKey, VSIPageCachePage*>::iterator oIter =
+        oMapPages.find( oKey );
+    if( oIter == oMapPages.end() )
+        return FALSE;
+
+    VSIPageCachePage* poPage = oIter->second;
+    Unlink( poPage );
+    LinkAsMRU( poPage );
+
+    size_t nCopy = 0;
+    if( nOffsetInPage < poPage->nDataFilled )
+    {
+        nCopy = MIN( nSize, poPage->nDataFilled - nOffsetInPage );
+        memcpy( pDest, poPage->pabyData + nOffsetInPage, nCopy );
+    }
+    *pnCopied = nCopy;
+    return TRUE;
+}
+
+/************************************************************************/
+/*                              Contains()                              */
+/************************************************************************/
+
+int VSIPageCache::Contains( const VSIPageCacheKey& oKey )
+{
+    CPLMutexHolderD( &hMutex );
+    return oMapPages.find( oKey ) != oMapPages.end();
+}
+
+/************************************************************************/
+/*                                Put()                                 */
+/************************************************************************/
+
+void VSIPageCache::Put( const VSIPageCacheKey& oKey, const GByte* pabyData,
+                        size_t nDataFilled )
+{
+    GByte* pabyCopy = (GByte*) VSIMalloc( MAX(1, nDataFilled) );
+    if( pabyCopy == NULL )
+        return;
+    memcpy( pabyCopy, pabyData, nDataFilled );
+
+    CPLMutexHolderD( &hMutex );
+
+    /* Another handle may have loaded it meanwhile */
+    if( oMapPages.find( oKey ) != oMapPages.end() )
+    {
+        VSIFree( pabyCopy );
+        return;
+    }
+
+    VSIPageCachePage* poPage = new VSIPageCachePage();
+    poPage->oKey = oKey;
+    poPage->nDataFilled = nDataFilled;
+    poPage->pabyData = pabyCopy;
+    oMapPages[oKey] = poPage;
+    LinkAsMRU( poPage );
+    nCacheUsed += oKey.nPageSize;
+
+    while( nCacheUsed > nCacheMax && poLRUStart != poPage )
+    {
+        VSIPageCachePage* poVictim = poLRUStart;
+        Unlink( poVictim );
+        oMapPages.erase( poVictim->oKey );
+        nCacheUsed -= poVictim->oKey.nPageSize;
+        VSIFree( poVictim->pabyData );
+        delete poVictim;
+    }
+}
+
+/************************************************************************/
+/*                             Invalidate()                             */
+/************************************************************************/
+
+void VSIPageCache::Invalidate( const CPLString& osFilename )
+{
+    CPLMutexHolderD( &hMutex );
+
+    /* Pages are sorted by page index first, so scan them all. This only */
+    /* happens when a cached file is written */
+    std::map<VSIPageCacheKey, VSIPageCachePage*>::iterator oIter =
+        oMapPages.begin();
+    while( oIter != oMapPages.end() )
+    {
+        VSIPageCachePage* poPage = oIter->second;
+        if( poPage->oKey.osFilename != osFilename )
+        {
+            ++oIter;
+            continue;
+        }
+        oMapPages.erase( oIter++ );
+        Unlink( poPage );
+        nCacheUsed -= poPage->oKey.nPageSize;
+        VSIFree( poPage->pabyData );
+        delete poPage;
+    }
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          VSISharedCachedFile                         */
+/* ==================================================================== */
+/************************************************************************/
+
+class VSISharedCachedFile : public VSIVirtualHandle
+{
+    VSIVirtualHandle *poBase;
+    VSIPageCacheKey   oKey;
+    vsi_l_offset      nOffset;
+    int               bEOF;
+
+    /* Readahead : number of pages read at once on a cache miss. */
+    /* Doubled on each sequential read, up to nMaxReadAheadPages. */
+    vsi_l_offset      nLastReadEnd;
+    size_t            nReadAheadPages;
+    size_t            nMaxReadAheadPages;
+
+    int               LoadPages( vsi_l_offset iPage, vsi_l_offset iLastPage );
+
+  public:
+    VSISharedCachedFile( VSIVirtualHandle *poBaseHandle, const char* pszFilename,
+                         size_t nPageSize );
+    ~VSISharedCachedFile() { Close(); }
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Close();
+    virtual void     *GetNativeFileDescriptor() { return poBase ? poBase->GetNativeFileDescriptor() : NULL; }
+};
+
+/************************************************************************/
+/*                        VSISharedCachedFile()                         */
+/************************************************************************/
+
+VSISharedCachedFile::VSISharedCachedFile( VSIVirtualHandle *poBaseHandle,
+                                          const char* pszFilename,
+                                          size_t nPageSize )
+{
+    poBase = poBaseHandle;
+
+    poBase->Seek( 0, SEEK_END );
+    oKey.osFilename = VSIPageCacheGetFilename( pszFilename );
+    oKey.nFileSize = poBase->Tell();
+    VSIStatBufL sStat;
+    oKey.nMTime = ( VSIStatL( pszFilename, &sStat ) == 0 ) ?
+                                            (GIntBig)sStat.st_mtime : 0;
+    oKey.nPageSize = nPageSize;
+    oKey.iPage = 0;
+
+    nOffset = 0;
+    bEOF = FALSE;
+    nLastReadEnd = 0;
+    nReadAheadPages = 1;
+    nMaxReadAheadPages = MAX(1, (size_t) CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_MAX_READAHEAD", "2097152" ), 40 ) / nPageSize);
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSISharedCachedFile::Close()
+{
+    if( poBase )
+    {
+        poBase->Close();
+        delete poBase;
+        poBase = NULL;
+    }
+    return 0;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSISharedCachedFile::Seek( vsi_l_offset nReqOffset, int nWhence )
+{
+    bEOF = FALSE;
+
+    if( nWhence == SEEK_CUR )
+        nReqOffset += nOffset;
+    else if( nWhence == SEEK_END )
+        nReqOffset += oKey.nFileSize;
+
+    nOffset = nReqOffset;
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSISharedCachedFile::Tell()
+{
+    return nOffset;
+}
+
+/************************************************************************/
+/*                             LoadPages()                              */
+/*                                                                      */
+/*      Read pages iPage to iLastPage with a single request, skipping   */
+/*      the end of the range that is already cached.                    */
+/************************************************************************/
+
+int VSISharedCachedFile::LoadPages( vsi_l_offset iPage, vsi_l_offset iLastPage )
+{
+    VSIPageCache* poCache = VSIGetPageCache();
+    const size_t nPageSize = oKey.nPageSize;
+
+    VSIPageCacheKey oPageKey( oKey );
+    vsi_l_offset iEnd = iPage + 1;
+    for( ; iEnd <= iLastPage; iEnd++ )
+    {
+        oPageKey.iPage = iEnd;
+        if( poCache->Contains( oPageKey ) )
+            break;
+    }
+
+    size_t nToRead = (size_t)(iEnd - iPage) * nPageSize;
+    GByte* pabyBuffer = (GByte*) VSIMalloc( nToRead );
+    if( pabyBuffer == NULL )
+        return FALSE;
+
+    size_t nRead = 0;
+    if( poBase->Seek( iPage * nPageSize, SEEK_SET ) == 0 )
+        nRead = poBase->Read( pabyBuffer, 1, nToRead );
+
+    for( vsi_l_offset i = iPage; i < iEnd; i++ )
+    {
+        size_t nStart = (size_t)(i - iPage) * nPageSize;
+        if( nStart >= nRead && i != iPage )
+            break;
+        oPageKey.iPage = i;
+        poCache->Put( oPageKey, pabyBuffer + nStart,
+                      nStart >= nRead ? 0 : MIN(nPageSize, nRead - nStart) );
+    }
+
+    VSIFree( pabyBuffer );
+    return TRUE;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSISharedCachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
+{
+    if( nOffset >= oKey.nFileSize )
+    {
+        bEOF = TRUE;
+        return 0;
+    }
+    if( nSize * nCount == 0 )
+        return 0;
+
+/* -------------------------------------------------------------------- */
+/*      Sequential reads make the readahead grow.                       */
+/* -------------------------------------------------------------------- */
+    if( nOffset == nLastReadEnd && nOffset != 0 )
+        nReadAheadPages = MIN(nReadAheadPages * 2, nMaxReadAheadPages);
+    else
+        nReadAheadPages = 1;
+
+    VSIPageCache* poCache = VSIGetPageCache();
+    const size_t nPageSize = oKey.nPageSize;
+    const size_t nToRead = nSize * nCount;
+    const vsi_l_offset iLastFilePage = (oKey.nFileSize - 1) / nPageSize;
+    VSIPageCacheKey oPageKey( oKey );
+
+    size_t nAmountCopied = 0;
+    int bLoaded = FALSE;
+    while( nAmountCopied < nToRead )
+    {
+        vsi_l_offset nCurOffset = nOffset + nAmountCopied;
+        oPageKey.iPage = nCurOffset / nPageSize;
+        size_t nOffsetInPage = (size_t)(nCurOffset - oPageKey.iPage * nPageSize);
+        size_t nCopied = 0;
+
+        if( !poCache->Get( oPageKey, nOffsetInPage, nToRead - nAmountCopied,
+                           ((GByte*)pBuffer) + nAmountCopied, &nCopied ) )
+        {
+            /* The cache is too small to hold what we have just loaded : */
+            /* read the rest of the request directly */
+            if( bLoaded )
+            {
+                if( poBase->Seek( nCurOffset, SEEK_SET ) == 0 )
+                    nAmountCopied += poBase->Read( ((GByte*)pBuffer) + nAmountCopied,
+                                                   1, nToRead - nAmountCopied );
+                break;
+            }
+
+            vsi_l_offset iEndRequest = (nOffset + nToRead - 1) / nPageSize;
+            vsi_l_offset iLastPage = MAX(iEndRequest,
+                                         oPageKey.iPage + nReadAheadPages - 1);
+            iLastPage = MIN(iLastPage, iLastFilePage);
+            if( !LoadPages( oPageKey.iPage, iLastPage ) )
+                break;
+            bLoaded = TRUE;
+            continue;
+        }
+        bLoaded = FALSE;
+
+        if( nCopied == 0 )
+            break;
+        nAmountCopied += nCopied;
+    }
+
+    nOffset += nAmountCopied;
+    nLastReadEnd = nOffset;
+
+    size_t nRet = nAmountCopied / nSize;
+    if( nRet != nCount )
+        bEOF = TRUE;
+    return nRet;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSISharedCachedFile::Write( CPL_UNUSED const void * pBuffer,
+                                   CPL_UNUSED size_t nSize,
+                                   CPL_UNUSED size_t nCount )
+{
+    return 0;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSISharedCachedFile::Eof()
+{
+    return bEOF;
+}
+
 /************************************************************************/
 /*                        VSICreateCachedFile()                         */
+/*                                                                      */
+/*      If pszFilename is provided and VSI_CACHE_SHARED is set, the     */
+/*      pages are cached in the process-wide page cache, so that they   */
+/*      are shared by all the handles opened on the same file.          */
 /************************************************************************/
 
 VSIVirtualHandle *
-VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize, size_t nCacheSize )
+VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
+                     size_t nCacheSize, const char* pszFilename )
 
 {
+    if( pszFilename != NULL && nCacheSize == 0 &&
+        CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE_SHARED", "FALSE" ) ) )
+        return new VSISharedCachedFile( poBaseHandle, pszFilename, nChunkSize );
+
     return new VSICachedFile( poBaseHandle, nChunkSize, nCacheSize );
 }
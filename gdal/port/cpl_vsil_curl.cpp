@@ -73,13 +73,34 @@ void CPLHTTPSetOptions(CURL *http_handle, char** papszOptions);
 void VSICurlSetOptions(CURL* hCurlHandle, const char* pszURL);
 
 #include <map>
+#include <vector>
+#include <algorithm>
+
+#ifdef WIN32
+#include <sys/utime.h>
+#include <process.h>
+#define VSICURL_UTIME _utime
+#define VSICURL_GETPID _getpid
+#else
+#include <utime.h>
+#include <unistd.h>
+#define VSICURL_UTIME utime
+#define VSICURL_GETPID getpid
+#endif
 
 #define ENABLE_DEBUG 1
 
-#define N_MAX_REGIONS       1000
-
 #define DOWNLOAD_CHUNCK_SIZE    16384
 
+/* Default size of the in-memory region cache, in MB */
+#define DEFAULT_CACHE_SIZE_MB   64
+
+/* Default size of the on-disk chunk cache, in MB */
+#define DEFAULT_CACHE_DIR_SIZE_MB   512
+
+/* Signature of the chunk files of the on-disk cache */
+#define CACHE_DISK_MAGIC        "GDALVCC1"
+
 typedef enum
 {
     EXIST_UNKNOWN = -1,
@@ -102,18 +123,87 @@ typedef struct
     char**          papszFileList; /* only file name without path */
 } CachedDirList;
 
-typedef struct
+typedef struct _CachedRegion
 {
     unsigned long   pszURLHash;
     vsi_l_offset    nFileOffsetStart;
     size_t          nSize;
     char           *pData;
+
+    /* Links in the LRU list, most recently used first */
+    struct _CachedRegion *psPrev;
+    struct _CachedRegion *psNext;
 } CachedRegion;
 
+typedef struct
+{
+    unsigned long   pszURLHash;
+    vsi_l_offset    nFileOffsetStart;
+} CachedRegionKey;
+
+struct CachedRegionKeyLess
+{
+    bool operator()( const CachedRegionKey& a, const CachedRegionKey& b ) const
+    {
+        if( a.pszURLHash != b.pszURLHash )
+            return a.pszURLHash < b.pszURLHash;
+        return a.nFileOffsetStart < b.nFileOffsetStart;
+    }
+};
+
+
+/************************************************************************/
+/*                         VSICurlHashKey()                             */
+/*                                                                      */
+/*      64 bit FNV-1a hash, used to name the files of the on-disk      */
+/*      cache. The full key is stored in the files, so collisions are  */
+/*      detected.                                                       */
+/************************************************************************/
+
+static GUIntBig VSICurlHashKey(const char* pszKey)
+{
+    GUIntBig nHash = (((GUIntBig)0xCBF29CE4U) << 32) | 0x84222325U;
+    const GUIntBig nPrime = (((GUIntBig)0x100U) << 32) | 0x000001B3U;
+    for( ; *pszKey != '\0'; pszKey++ )
+    {
+        nHash ^= (GByte)*pszKey;
+        nHash *= nPrime;
+    }
+    return nHash;
+}
 
-static const char* VSICurlGetCacheFileName()
+/************************************************************************/
+/*                  VSICurlGetValidatorFromHeaders()                    */
+/*                                                                      */
+/*      Return the ETag, or failing that the Last-Modified date, found  */
+/*      in HTTP response headers. Empty if there is none.              */
+/************************************************************************/
+
+static CPLString VSICurlGetValidatorFromHeaders(const char* pszHeaders)
 {
-    return "gdal_vsicurl_cache.bin";
+    CPLString osETag, osLastModified;
+    char** papszLines = CSLTokenizeString2( pszHeaders, "\r\n", 0 );
+    for( int i = 0; papszLines != NULL && papszLines[i] != NULL; i++ )
+    {
+        const char* pszLine = papszLines[i];
+        /* Only keep the headers of the last response, after redirections */
+        if( EQUALN(pszLine, "HTTP/", 5) )
+        {
+            osETag = "";
+            osLastModified = "";
+        }
+        else if( EQUALN(pszLine, "ETag:", 5) )
+            osETag = CPLString(pszLine + 5).Trim();
+        else if( EQUALN(pszLine, "Last-Modified:", 14) )
+            osLastModified = CPLString(pszLine + 14).Trim();
+    }
+    CSLDestroy(papszLines);
+
+    if( !osETag.empty() )
+        return "ETag: " + osETag;
+    if( !osLastModified.empty() )
+        return "Last-Modified: " + osLastModified;
+    return "";
 }
 
 /************************************************************************/
@@ -199,17 +289,45 @@ class VSICurlFilesystemHandler : public VSIFilesystemHandler
 {
     CPLMutex       *hMutex;
 
-    CachedRegion  **papsRegions;
-    int             nRegions;
+    /* Regions indexed by (URL hash, offset), and chained in LRU order */
+    std::map<CachedRegionKey, CachedRegion*, CachedRegionKeyLess> oMapRegions;
+    CachedRegion   *psRegionMRU;
+    CachedRegion   *psRegionLRU;
+    GIntBig         nRegionsBytes;
+
+    void                UnlinkRegion(CachedRegion* psRegion);
+    void                LinkRegionAsMRU(CachedRegion* psRegion);
 
     std::map<CPLString, CachedFileProp*>   cacheFileSize;
     std::map<CPLString, CachedDirList*>        cacheDirList;
 
+    /* On-disk chunk cache */
     int             bUseCacheDisk;
+    CPLString       osCacheDir;
+    GIntBig         nMaxCacheDirBytes;
+    GIntBig         nCacheDirBytes;     /* estimate, -1 if not scanned yet */
+    GIntBig         nCacheDirBytesWritten; /* since the last scan */
+    int             bCacheDirCreated;
+
+    void                ReadCacheDiskSettings();
+    std::map<CPLString, CPLString> oMapValidators;
+
+    CPLString           GetCacheDiskFilename(const char* pszURL,
+                                             vsi_l_offset nFileOffsetStart,
+                                             CPLString& osKey);
+    void                PruneCacheDir();
+    CachedRegion*       AddRegionInMemory(const char*     pszURL,
+                                          vsi_l_offset    nFileOffsetStart,
+                                          size_t          nSize,
+                                          const char     *pData);
 
     /* Per-thread Curl connection cache */
     std::map<GIntBig, CachedConnection*> mapConnections;
 
+    /* Per-thread Curl multi handle, whose connection cache keeps the */
+    /* connections of parallel range requests alive between calls */
+    std::map<GIntBig, CURLM*> mapMultiConnections;
+
     char** GetFileList(const char *pszFilename, int* pbGotFileList);
 
     char**              ParseHTMLFileList(const char* pszFilename,
@@ -238,13 +356,21 @@ public:
                                   size_t          nSize,
                                   const char     *pData);
 
+    int                 GetMaxRegionCount();
+
     CachedFileProp*     GetCachedFileProp(const char*     pszURL);
 
-    void                AddRegionToCacheDisk(CachedRegion* psRegion);
+    void                AddRegionToCacheDisk(const char*     pszURL,
+                                             vsi_l_offset    nFileOffsetStart,
+                                             size_t          nSize,
+                                             const char     *pData);
     const CachedRegion* GetRegionFromCacheDisk(const char*     pszURL,
                                                vsi_l_offset nFileOffsetStart);
+    void                SetCacheValidator(const char* pszURL,
+                                          const char* pszHeaders);
 
     CURL               *GetCurlHandleFor(CPLString osURL);
+    CURLM              *GetCurlMultiHandle();
 };
 
 /************************************************************************/
@@ -271,6 +397,11 @@ class VSICurlHandle : public VSIVirtualHandle
 
     int             DownloadRegion(vsi_l_offset startOffset, int nBlocks);
 
+    int             ReadMultiRangeParallel( int nRanges, void ** ppData,
+                                            const vsi_l_offset* panOffsets,
+                                            const size_t* panSizes,
+                                            int nMaxConnections );
+
     VSICurlReadCbkFunc  pfnReadCbk;
     void               *pReadCbkUserData;
     int                 bStopOnInterrruptUntilUninstall;
@@ -738,6 +869,11 @@ vsi_l_offset VSICurlHandle::GetFileSize()
                     pszURL, fileSize, (int)response_code);
     }
 
+    /* Headers end up in the data buffer in the HEAD case */
+    if (eExists == EXIST_YES && strncmp(pszURL, "http", 4) == 0)
+        poFS->SetCacheValidator(pszURL, (sWriteFuncHeaderData.pBuffer) ?
+                                sWriteFuncHeaderData.pBuffer : sWriteFuncData.pBuffer);
+
     CPLFree(sWriteFuncData.pBuffer);
     CPLFree(sWriteFuncHeaderData.pBuffer);
 
@@ -868,6 +1004,10 @@ int VSICurlHandle::DownloadRegion(vsi_l_offset startOffset, int nBlocks)
         return FALSE;
     }
 
+    /* Before the parsing below, that truncates the headers */
+    if (sWriteFuncHeaderData.bIsHTTP)
+        poFS->SetCacheValidator(pszURL, sWriteFuncHeaderData.pBuffer);
+
     if (!bHastComputedFileSize && sWriteFuncHeaderData.pBuffer)
     {
         /* Try to retrieve the filesize from the HTTP headers */
@@ -1008,8 +1148,9 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
                 }
             }
 
-            if( nBlocksToDownload > N_MAX_REGIONS )
-                nBlocksToDownload = N_MAX_REGIONS;
+            /* Do not download more than what the cache can hold */
+            if( nBlocksToDownload > poFS->GetMaxRegionCount() )
+                nBlocksToDownload = poFS->GetMaxRegionCount();
 
             if (DownloadRegion(nOffsetToDownload, nBlocksToDownload) == FALSE)
             {
@@ -1064,6 +1205,11 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
     if (cachedFileProp->eExists == EXIST_NO)
         return -1;
 
+    int nMaxConnections = atoi(CPLGetConfigOption("CPL_VSIL_CURL_MAX_CONNECTIONS", "1"));
+    if (nMaxConnections > 1 && nRanges > 1)
+        return ReadMultiRangeParallel(nRanges, ppData, panOffsets, panSizes,
+                                      MIN(nMaxConnections, 100));
+
     CPLString osRanges, osFirstRange, osLastRange;
     int i;
     int nMergedRanges = 0;
@@ -1396,6 +1542,264 @@ end:
     return nRet;
 }
 
+/************************************************************************/
+/*                        VSICurlRangeOffsetLess                        */
+/************************************************************************/
+
+struct VSICurlRangeOffsetLess
+{
+    const vsi_l_offset* panOffsets;
+
+    VSICurlRangeOffsetLess(const vsi_l_offset* panOffsetsIn) : panOffsets(panOffsetsIn) {}
+
+    bool operator()(int i, int j) const
+    {
+        return panOffsets[i] < panOffsets[j];
+    }
+};
+
+typedef struct
+{
+    vsi_l_offset     nStart;
+    vsi_l_offset     nEnd;          /* inclusive */
+    std::vector<int> anRanges;      /* indices of the requested ranges */
+
+    CURL            *hCurlHandle;
+    WriteFuncStruct  sWriteFuncData;
+    WriteFuncStruct  sWriteFuncHeaderData;
+    char             szCurlErrBuf[CURL_ERROR_SIZE+1];
+    CPLString        osRange;
+} VSICurlMergedRange;
+
+/************************************************************************/
+/*                          VSICurlMultiWait()                          */
+/*                                                                      */
+/*      Wait for activity on the transfers of a multi handle, for at    */
+/*      most 100 ms.                                                    */
+/************************************************************************/
+
+static void VSICurlMultiWait( CURLM* hCurlMultiHandle )
+{
+#if LIBCURL_VERSION_NUM >= 0x071C00
+    int nNumFds = 0;
+    curl_multi_wait(hCurlMultiHandle, NULL, 0, 100, &nNumFds);
+#else
+    struct timeval timeout;
+    fd_set fdread, fdwrite, fdexcep;
+    int maxfd;
+    FD_ZERO(&fdread);
+    FD_ZERO(&fdwrite);
+    FD_ZERO(&fdexcep);
+    curl_multi_fdset(hCurlMultiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+    if( maxfd >= 0 )
+    {
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &timeout);
+    }
+    else
+    {
+        /* No socket to wait on yet (e.g. name resolution in progress): */
+        /* wait a bit rather than spinning, as advised by curl */
+        CPLSleep(0.1);
+    }
+#endif
+}
+
+/************************************************************************/
+/*                       ReadMultiRangeParallel()                       */
+/*                                                                      */
+/*      Download the ranges with concurrent single range requests,     */
+/*      after having merged the ranges separated by at most            */
+/*      CPL_VSIL_CURL_MERGE_GAP bytes. The downloaded data is also     */
+/*      stored in the region cache.                                     */
+/************************************************************************/
+
+int VSICurlHandle::ReadMultiRangeParallel( int nRanges, void ** ppData,
+                                           const vsi_l_offset* panOffsets,
+                                           const size_t* panSizes,
+                                           int nMaxConnections )
+{
+    CURLM* hCurlMultiHandle = poFS->GetCurlMultiHandle();
+    if (hCurlMultiHandle == NULL)
+        return -1;
+
+    int nMaxGap = atoi(CPLGetConfigOption("CPL_VSIL_CURL_MERGE_GAP", "16384"));
+    if (nMaxGap < 0)
+        nMaxGap = 0;
+
+/* -------------------------------------------------------------------- */
+/*      Merge the ranges, in increasing offset order.                   */
+/* -------------------------------------------------------------------- */
+    std::vector<int> anOrder;
+    int i;
+    for(i=0;i<nRanges;i++)
+    {
+        if (panSizes[i] != 0)
+            anOrder.push_back(i);
+    }
+    std::sort(anOrder.begin(), anOrder.end(), VSICurlRangeOffsetLess(panOffsets));
+
+    std::vector<VSICurlMergedRange> asMerged;
+    for(i=0;i<(int)anOrder.size();i++)
+    {
+        int iRange = anOrder[i];
+        vsi_l_offset nStart = panOffsets[iRange];
+        vsi_l_offset nEnd = nStart + panSizes[iRange] - 1;
+        if (asMerged.empty() || nStart > asMerged.back().nEnd + 1 + nMaxGap)
+        {
+            asMerged.resize(asMerged.size() + 1);
+            asMerged.back().nStart = nStart;
+            asMerged.back().nEnd = nEnd;
+        }
+        else if (nEnd > asMerged.back().nEnd)
+            asMerged.back().nEnd = nEnd;
+        asMerged.back().anRanges.push_back(iRange);
+    }
+
+    int nRequests = (int)asMerged.size();
+    if (nRequests == 0)
+        return 0;
+
+/* -------------------------------------------------------------------- */
+/*      Prepare one request per merged range.                           */
+/* -------------------------------------------------------------------- */
+    for(i=0;i<nRequests;i++)
+    {
+        VSICurlMergedRange* psMerged = &asMerged[i];
+
+        psMerged->hCurlHandle = curl_easy_init();
+        VSICurlSetOptions(psMerged->hCurlHandle, pszURL);
+
+        VSICURLInitWriteFuncStruct(&psMerged->sWriteFuncData, (VSILFILE*)this, pfnReadCbk, pReadCbkUserData);
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_WRITEDATA, &psMerged->sWriteFuncData);
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_WRITEFUNCTION, VSICurlHandleWriteFunc);
+
+        VSICURLInitWriteFuncStruct(&psMerged->sWriteFuncHeaderData, NULL, NULL, NULL);
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_HEADERDATA, &psMerged->sWriteFuncHeaderData);
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_HEADERFUNCTION, VSICurlHandleWriteFunc);
+        psMerged->sWriteFuncHeaderData.bIsHTTP = strncmp(pszURL, "http", 4) == 0;
+        psMerged->sWriteFuncHeaderData.nStartOffset = psMerged->nStart;
+        psMerged->sWriteFuncHeaderData.nEndOffset = psMerged->nEnd;
+
+        psMerged->osRange.Printf(CPL_FRMT_GUIB "-" CPL_FRMT_GUIB,
+                                 psMerged->nStart, psMerged->nEnd);
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_RANGE, psMerged->osRange.c_str());
+
+        psMerged->szCurlErrBuf[0] = '\0';
+        curl_easy_setopt(psMerged->hCurlHandle, CURLOPT_ERRORBUFFER, psMerged->szCurlErrBuf );
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Downloading %d ranges with %d parallel requests (%s)...",
+                 nRanges, nRequests, pszURL);
+
+/* -------------------------------------------------------------------- */
+/*      Run at most nMaxConnections requests at a time.                 */
+/* -------------------------------------------------------------------- */
+    int nStarted = 0;
+    int nStillRunning = 0;
+    for( ; nStarted < MIN(nRequests, nMaxConnections); nStarted++ )
+        curl_multi_add_handle(hCurlMultiHandle, asMerged[nStarted].hCurlHandle);
+
+    while (curl_multi_perform(hCurlMultiHandle, &nStillRunning) == CURLM_CALL_MULTI_PERFORM);
+    while (nStillRunning || nStarted != nRequests)
+    {
+        CURLMsg *psMsg;
+        int nMsgsInQueue;
+        do
+        {
+            psMsg = curl_multi_info_read(hCurlMultiHandle, &nMsgsInQueue);
+            if (psMsg != NULL && psMsg->msg == CURLMSG_DONE)
+            {
+                curl_multi_remove_handle(hCurlMultiHandle, psMsg->easy_handle);
+                if (nStarted < nRequests)
+                {
+                    curl_multi_add_handle(hCurlMultiHandle, asMerged[nStarted].hCurlHandle);
+                    nStarted ++;
+                }
+            }
+        } while (psMsg != NULL);
+
+        VSICurlMultiWait(hCurlMultiHandle);
+        while (curl_multi_perform(hCurlMultiHandle, &nStillRunning) == CURLM_CALL_MULTI_PERFORM);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Check the responses, and dispatch their content.                */
+/* -------------------------------------------------------------------- */
+    int nRet = 0;
+    for(i=0;i<nRequests;i++)
+    {
+        VSICurlMergedRange* psMerged = &asMerged[i];
+        size_t nRequestSize = (size_t)(psMerged->nEnd - psMerged->nStart + 1);
+
+        /* Removing an already removed handle is harmless */
+        curl_multi_remove_handle(hCurlMultiHandle, psMerged->hCurlHandle);
+
+        long response_code = 0;
+        curl_easy_getinfo(psMerged->hCurlHandle, CURLINFO_HTTP_CODE, &response_code);
+
+        if (psMerged->sWriteFuncData.bInterrupted)
+        {
+            bInterrupted = TRUE;
+            nRet = -1;
+        }
+        else if (nRet == 0 &&
+                 ((response_code != 200 && response_code != 206 &&
+                   response_code != 225 && response_code != 226 && response_code != 426) ||
+                  psMerged->sWriteFuncHeaderData.bError ||
+                  psMerged->sWriteFuncData.nSize < nRequestSize))
+        {
+            if (response_code >= 400 && psMerged->szCurlErrBuf[0] != '\0')
+                CPLError(CE_Failure, CPLE_AppDefined, "%d: %s",
+                         (int)response_code, psMerged->szCurlErrBuf);
+            else if (!psMerged->sWriteFuncHeaderData.bError)
+                CPLError(CE_Failure, CPLE_AppDefined,
+                         "Could not download range %s of %s",
+                         psMerged->osRange.c_str(), pszURL);
+            nRet = -1;
+        }
+        else if (nRet == 0)
+        {
+            if (psMerged->sWriteFuncHeaderData.bIsHTTP)
+                poFS->SetCacheValidator(pszURL, psMerged->sWriteFuncHeaderData.pBuffer);
+
+            char* pBuffer = psMerged->sWriteFuncData.pBuffer;
+            for(size_t j=0;j<psMerged->anRanges.size();j++)
+            {
+                int iRange = psMerged->anRanges[j];
+                memcpy(ppData[iRange],
+                       pBuffer + (panOffsets[iRange] - psMerged->nStart),
+                       panSizes[iRange]);
+            }
+
+            /* Cache the download chunks that have been entirely received */
+            vsi_l_offset nChunkStart =
+                ((psMerged->nStart + DOWNLOAD_CHUNCK_SIZE - 1) / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+            for( ; nChunkStart <= psMerged->nEnd; nChunkStart += DOWNLOAD_CHUNCK_SIZE )
+            {
+                size_t nChunkSize = DOWNLOAD_CHUNCK_SIZE;
+                if (nChunkStart + DOWNLOAD_CHUNCK_SIZE - 1 > psMerged->nEnd)
+                {
+                    /* Partial chunk only allowed at end of file */
+                    if (!bHastComputedFileSize || psMerged->nEnd + 1 != fileSize)
+                        break;
+                    nChunkSize = (size_t)(fileSize - nChunkStart);
+                }
+                poFS->AddRegion(pszURL, nChunkStart, nChunkSize,
+                                pBuffer + (nChunkStart - psMerged->nStart));
+            }
+        }
+
+        curl_easy_cleanup(psMerged->hCurlHandle);
+        CPLFree(psMerged->sWriteFuncData.pBuffer);
+        CPLFree(psMerged->sWriteFuncHeaderData.pBuffer);
+    }
+
+    return nRet;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -1445,9 +1849,15 @@ int       VSICurlHandle::Close()
 VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 {
     hMutex = NULL;
-    papsRegions = NULL;
-    nRegions = 0;
-    bUseCacheDisk = CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_CURL_USE_CACHE", "NO"));
+    psRegionMRU = NULL;
+    psRegionLRU = NULL;
+    nRegionsBytes = 0;
+    bUseCacheDisk = FALSE;
+    nMaxCacheDirBytes = 0;
+    nCacheDirBytes = -1;
+    nCacheDirBytesWritten = 0;
+    bCacheDirCreated = FALSE;
+    ReadCacheDiskSettings();
 }
 
 /************************************************************************/
@@ -1456,13 +1866,14 @@ VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 
 VSICurlFilesystemHandler::~VSICurlFilesystemHandler()
 {
-    int i;
-    for(i=0;i<nRegions;i++)
+    CachedRegion* psRegion = psRegionMRU;
+    while( psRegion != NULL )
     {
-        CPLFree(papsRegions[i]->pData);
-        CPLFree(papsRegions[i]);
+        CachedRegion* psNext = psRegion->psNext;
+        CPLFree(psRegion->pData);
+        CPLFree(psRegion);
+        psRegion = psNext;
     }
-    CPLFree(papsRegions);
 
     std::map<CPLString, CachedFileProp*>::const_iterator iterCacheFileSize;
 
@@ -1486,6 +1897,12 @@ VSICurlFilesystemHandler::~VSICurlFilesystemHandler()
         delete iterConnections->second;
     }
 
+    std::map<GIntBig, CURLM*>::const_iterator iterMultiConnections;
+    for( iterMultiConnections = mapMultiConnections.begin(); iterMultiConnections != mapMultiConnections.end(); iterMultiConnections++ )
+    {
+        curl_multi_cleanup(iterMultiConnections->second);
+    }
+
     if( hMutex != NULL )
         CPLDestroyMutex( hMutex );
     hMutex = NULL;
@@ -1539,6 +1956,108 @@ CURL* VSICurlFilesystemHandler::GetCurlHandleFor(CPLString osURL)
 }
 
 
+/************************************************************************/
+/*                        GetCurlMultiHandle()                          */
+/************************************************************************/
+
+CURLM* VSICurlFilesystemHandler::GetCurlMultiHandle()
+{
+    CPLMutexHolder oHolder( &hMutex );
+
+    std::map<GIntBig, CURLM*>::const_iterator iterMultiConnections =
+        mapMultiConnections.find(CPLGetPID());
+    if (iterMultiConnections != mapMultiConnections.end())
+        return iterMultiConnections->second;
+
+    CURLM* hCurlMultiHandle = curl_multi_init();
+    if (hCurlMultiHandle != NULL)
+        mapMultiConnections[CPLGetPID()] = hCurlMultiHandle;
+    return hCurlMultiHandle;
+}
+
+
+/************************************************************************/
+/*                       ReadCacheDiskSettings()                        */
+/*                                                                      */
+/*      Read the configuration options of the on-disk cache. This is   */
+/*      done when files are opened, so that they can be changed in a   */
+/*      running process.                                                */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::ReadCacheDiskSettings()
+{
+    CPLString osNewCacheDir = CPLGetConfigOption("CPL_VSIL_CURL_CACHE_DIR", "");
+    int bNewUseCacheDisk = !osNewCacheDir.empty() ||
+        CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_CURL_USE_CACHE", "NO"));
+    if (bNewUseCacheDisk && osNewCacheDir.empty())
+        osNewCacheDir = "gdal_vsicurl_cache";
+    const char* pszCacheDirSize =
+        CPLGetConfigOption("CPL_VSIL_CURL_CACHE_DIR_SIZE_MB", NULL);
+    GIntBig nNewMaxCacheDirBytes = (GIntBig)
+        ((pszCacheDirSize) ? atoi(pszCacheDirSize) : DEFAULT_CACHE_DIR_SIZE_MB) * 1024 * 1024;
+
+    CPLMutexHolder oHolder( &hMutex );
+
+    bUseCacheDisk = bNewUseCacheDisk;
+    nMaxCacheDirBytes = nNewMaxCacheDirBytes;
+    if (osNewCacheDir != osCacheDir)
+    {
+        osCacheDir = osNewCacheDir;
+        nCacheDirBytes = -1;
+        nCacheDirBytesWritten = 0;
+        bCacheDirCreated = FALSE;
+    }
+}
+
+/************************************************************************/
+/*                       GetCacheDiskFilename()                         */
+/*                                                                      */
+/*      Name of the file of the on-disk cache holding a chunk, and      */
+/*      the key stored in it. The key is made of the URL and of the     */
+/*      ETag or Last-Modified date returned by the server, so that a   */
+/*      modified remote file does not hit stale chunks. Returns an     */
+/*      empty string if the server has not returned any of them.       */
+/************************************************************************/
+
+CPLString VSICurlFilesystemHandler::GetCacheDiskFilename(const char* pszURL,
+                                                         vsi_l_offset nFileOffsetStart,
+                                                         CPLString& osKey)
+{
+    CPLMutexHolder oHolder( &hMutex );
+
+    std::map<CPLString, CPLString>::const_iterator oIter =
+        oMapValidators.find(pszURL);
+    if (oIter == oMapValidators.end() || oIter->second.empty())
+        return "";
+
+    osKey = pszURL;
+    osKey += "\n";
+    osKey += oIter->second;
+
+    GUIntBig nHash = VSICurlHashKey(osKey);
+    CPLString osBasename;
+    osBasename.Printf("%08X%08X_" CPL_FRMT_GUIB,
+                      (unsigned int)(nHash >> 32), (unsigned int)(nHash & 0xFFFFFFFFU),
+                      (GUIntBig)nFileOffsetStart);
+    return CPLFormFilename(osCacheDir, osBasename, "bin");
+}
+
+/************************************************************************/
+/*                         SetCacheValidator()                          */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::SetCacheValidator(const char* pszURL,
+                                                 const char* pszHeaders)
+{
+    if (!bUseCacheDisk || pszHeaders == NULL)
+        return;
+
+    CPLString osValidator = VSICurlGetValidatorFromHeaders(pszHeaders);
+
+    CPLMutexHolder oHolder( &hMutex );
+    oMapValidators[pszURL] = osValidator;
+}
+
 /************************************************************************/
 /*                   GetRegionFromCacheDisk()                           */
 /************************************************************************/
@@ -1548,100 +2067,259 @@ VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
                                                  vsi_l_offset nFileOffsetStart)
 {
     nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
-    VSILFILE* fp = VSIFOpenL(VSICurlGetCacheFileName(), "rb");
-    if (fp)
-    {
-        unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
-        unsigned long   pszURLHashCached;
-        vsi_l_offset    nFileOffsetStartCached;
-        size_t          nSizeCached;
-        while(TRUE)
+
+    CPLString osKey;
+    CPLString osFilename = GetCacheDiskFilename(pszURL, nFileOffsetStart, osKey);
+    if (osFilename.empty())
+        return NULL;
+
+    VSILFILE* fp = VSIFOpenL(osFilename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Check the header: it must be for the same key and offset.       */
+/* -------------------------------------------------------------------- */
+    char        szMagic[8];
+    GUInt32     nKeyLen = 0;
+    GUIntBig    nFileOffsetStartCached = 0;
+    GUInt32     nSizeCached = 0;
+    int         bOK = FALSE;
+    char*       pBuffer = NULL;
+
+    if (VSIFReadL(szMagic, 1, 8, fp) == 8 &&
+        memcmp(szMagic, CACHE_DISK_MAGIC, 8) == 0 &&
+        VSIFReadL(&nKeyLen, 1, 4, fp) == 4)
+    {
+        CPL_LSBPTR32(&nKeyLen);
+        if (nKeyLen == osKey.size())
         {
-            if (VSIFReadL(&pszURLHashCached, 1, sizeof(unsigned long), fp) == 0)
-                break;
-            VSIFReadL(&nFileOffsetStartCached, 1, sizeof(vsi_l_offset), fp);
-            VSIFReadL(&nSizeCached, 1, sizeof(size_t), fp);
-            if (pszURLHash == pszURLHashCached &&
-                nFileOffsetStart == nFileOffsetStartCached)
+            char* pszKeyCached = (char*) CPLMalloc(nKeyLen + 1);
+            pszKeyCached[nKeyLen] = '\0';
+            if (VSIFReadL(pszKeyCached, 1, nKeyLen, fp) == nKeyLen &&
+                osKey == pszKeyCached &&
+                VSIFReadL(&nFileOffsetStartCached, 1, 8, fp) == 8 &&
+                VSIFReadL(&nSizeCached, 1, 4, fp) == 4)
             {
-                if (ENABLE_DEBUG)
-                    CPLDebug("VSICURL", "Got data at offset " CPL_FRMT_GUIB " from disk" , nFileOffsetStart);
-                if (nSizeCached)
-                {
-                    char* pBuffer = (char*) CPLMalloc(nSizeCached);
-                    VSIFReadL(pBuffer, 1, nSizeCached, fp);
-                    AddRegion(pszURL, nFileOffsetStart, nSizeCached, pBuffer);
-                    CPLFree(pBuffer);
-                }
-                else
+                CPL_LSBPTR64(&nFileOffsetStartCached);
+                CPL_LSBPTR32(&nSizeCached);
+                if (nFileOffsetStartCached == nFileOffsetStart &&
+                    nSizeCached > 0 && nSizeCached <= DOWNLOAD_CHUNCK_SIZE)
                 {
-                    AddRegion(pszURL, nFileOffsetStart, 0, NULL);
+                    pBuffer = (char*) CPLMalloc(nSizeCached);
+                    bOK = VSIFReadL(pBuffer, 1, nSizeCached, fp) == nSizeCached;
                 }
-                VSIFCloseL(fp);
-                return GetRegion(pszURL, nFileOffsetStart);
-            }
-            else
-            {
-                VSIFSeekL(fp, nSizeCached, SEEK_CUR);
             }
+            CPLFree(pszKeyCached);
         }
-        VSIFCloseL(fp);
     }
-    return NULL;
+    VSIFCloseL(fp);
+
+    if (!bOK)
+    {
+        /* Chunks are renamed once complete, so this one is corrupted. */
+        /* Remove it so that it can be written again */
+        CPLDebug("VSICURL", "Removing invalid cache file %s", osFilename.c_str());
+        VSIUnlink(osFilename);
+        CPLFree(pBuffer);
+        return NULL;
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Got data at offset " CPL_FRMT_GUIB " from disk" , nFileOffsetStart);
+
+    /* Mark the file as recently used for the eviction of PruneCacheDir() */
+    if (strncmp(osFilename, "/vsi", 4) != 0)
+        VSICURL_UTIME(osFilename, NULL);
+
+    AddRegionInMemory(pszURL, nFileOffsetStart, nSizeCached, pBuffer);
+    CPLFree(pBuffer);
+
+    return GetRegion(pszURL, nFileOffsetStart);
 }
 
 
 /************************************************************************/
 /*                  AddRegionToCacheDisk()                                */
+/*                                                                      */
+/*      The chunk is written in a temporary file that is then renamed, */
+/*      so that other processes sharing the cache directory never see */
+/*      partially written chunks.                                       */
 /************************************************************************/
 
-void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
+void VSICurlFilesystemHandler::AddRegionToCacheDisk(const char*     pszURL,
+                                                    vsi_l_offset    nFileOffsetStart,
+                                                    size_t          nSize,
+                                                    const char     *pData)
 {
-    VSILFILE* fp = VSIFOpenL(VSICurlGetCacheFileName(), "r+b");
-    if (fp)
+    CPLString osKey;
+    CPLString osFilename = GetCacheDiskFilename(pszURL, nFileOffsetStart, osKey);
+    if (osFilename.empty())
+        return;
+
+    VSIStatBufL sStat;
+    if (VSIStatL(osFilename, &sStat) == 0)
+        return;
+
     {
-        unsigned long   pszURLHashCached;
-        vsi_l_offset    nFileOffsetStartCached;
-        size_t          nSizeCached;
-        while(TRUE)
+        CPLMutexHolder oHolder( &hMutex );
+        if (!bCacheDirCreated)
         {
-            if (VSIFReadL(&pszURLHashCached, 1, sizeof(unsigned long), fp) == 0)
-                break;
-            VSIFReadL(&nFileOffsetStartCached, 1, sizeof(vsi_l_offset), fp);
-            VSIFReadL(&nSizeCached, 1, sizeof(size_t), fp);
-            if (psRegion->pszURLHash == pszURLHashCached &&
-                psRegion->nFileOffsetStart == nFileOffsetStartCached)
-            {
-                CPLAssert(psRegion->nSize == nSizeCached);
-                VSIFCloseL(fp);
-                return;
-            }
-            else
-            {
-                VSIFSeekL(fp, nSizeCached, SEEK_CUR);
-            }
+            VSIMkdir(osCacheDir, 0755);
+            bCacheDirCreated = TRUE;
         }
     }
-    else
+
+    CPLString osTmpFilename;
+    osTmpFilename.Printf("%s.%d." CPL_FRMT_GIB ".tmp", osFilename.c_str(),
+                         (int)VSICURL_GETPID(), CPLGetPID());
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if (fp == NULL)
+        return;
+
+    GUInt32  nKeyLen = (GUInt32)osKey.size();
+    GUIntBig nFileOffsetStartCached = nFileOffsetStart;
+    GUInt32  nSizeCached = (GUInt32)nSize;
+    CPL_LSBPTR32(&nKeyLen);
+    CPL_LSBPTR64(&nFileOffsetStartCached);
+    CPL_LSBPTR32(&nSizeCached);
+
+    int bOK =
+        VSIFWriteL(CACHE_DISK_MAGIC, 1, 8, fp) == 8 &&
+        VSIFWriteL(&nKeyLen, 1, 4, fp) == 4 &&
+        VSIFWriteL(osKey.c_str(), 1, osKey.size(), fp) == osKey.size() &&
+        VSIFWriteL(&nFileOffsetStartCached, 1, 8, fp) == 8 &&
+        VSIFWriteL(&nSizeCached, 1, 4, fp) == 4 &&
+        VSIFWriteL(pData, 1, nSize, fp) == nSize;
+    if (VSIFCloseL(fp) != 0)
+        bOK = FALSE;
+
+    if (!bOK || VSIRename(osTmpFilename, osFilename) != 0)
+    {
+        VSIUnlink(osTmpFilename);
+        return;
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk" , nFileOffsetStart);
+
+/* -------------------------------------------------------------------- */
+/*      The directory is only scanned once this process has written    */
+/*      a tenth of the budget since the last scan, or when the size    */
+/*      known from that scan exceeds the budget.                        */
+/* -------------------------------------------------------------------- */
+    int bPrune;
+    {
+        CPLMutexHolder oHolder( &hMutex );
+        GIntBig nWritten = 8 + 4 + osKey.size() + 8 + 4 + nSize;
+        nCacheDirBytesWritten += nWritten;
+        if (nCacheDirBytes >= 0)
+            nCacheDirBytes += nWritten;
+        bPrune = nCacheDirBytes > nMaxCacheDirBytes ||
+                 nCacheDirBytesWritten > nMaxCacheDirBytes / 10;
+    }
+    if (bPrune)
+        PruneCacheDir();
+}
+
+/************************************************************************/
+/*                           PruneCacheDir()                            */
+/*                                                                      */
+/*      Compute the size of the on-disk cache, and if it exceeds its   */
+/*      budget, remove the least recently used chunks until it is      */
+/*      below 80% of the budget. The cache directory may be shared by  */
+/*      several processes, so the size is recomputed from the          */
+/*      directory each time, which AddRegionToCacheDisk() only         */
+/*      triggers from time to time.                                     */
+/************************************************************************/
+
+typedef struct
+{
+    time_t          mTime;
+    vsi_l_offset    nSize;
+    CPLString       osFilename;
+} VSICurlCacheDirEntry;
+
+static bool VSICurlCacheDirEntryOlder(const VSICurlCacheDirEntry& a,
+                                      const VSICurlCacheDirEntry& b)
+{
+    return a.mTime < b.mTime;
+}
+
+void VSICurlFilesystemHandler::PruneCacheDir()
+{
+    std::vector<VSICurlCacheDirEntry> asEntries;
+    GIntBig nTotalBytes = 0;
+    CPLString osDir;
+    GIntBig nMaxBytes;
+
     {
-        fp = VSIFOpenL(VSICurlGetCacheFileName(), "wb");
+        CPLMutexHolder oHolder( &hMutex );
+        osDir = osCacheDir;
+        nMaxBytes = nMaxCacheDirBytes;
+        nCacheDirBytesWritten = 0;
     }
-    if (fp)
+
+    char** papszFiles = VSIReadDir(osDir);
+    for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
     {
-        if (ENABLE_DEBUG)
-             CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk" , psRegion->nFileOffsetStart);
-        VSIFWriteL(&psRegion->pszURLHash, 1, sizeof(unsigned long), fp);
-        VSIFWriteL(&psRegion->nFileOffsetStart, 1, sizeof(vsi_l_offset), fp);
-        VSIFWriteL(&psRegion->nSize, 1, sizeof(size_t), fp);
-        if (psRegion->nSize)
-            VSIFWriteL(psRegion->pData, 1, psRegion->nSize, fp);
+        if (!EQUAL(CPLGetExtension(papszFiles[i]), "bin"))
+            continue;
 
-        VSIFCloseL(fp);
+        VSICurlCacheDirEntry sEntry;
+        sEntry.osFilename = CPLFormFilename(osDir, papszFiles[i], NULL);
+
+        VSIStatBufL sStat;
+        if (VSIStatL(sEntry.osFilename, &sStat) != 0)
+            continue;
+        sEntry.mTime = sStat.st_mtime;
+        sEntry.nSize = sStat.st_size;
+        nTotalBytes += sEntry.nSize;
+        asEntries.push_back(sEntry);
     }
-    return;
+    CSLDestroy(papszFiles);
+
+    if (nTotalBytes > nMaxBytes)
+    {
+        std::sort(asEntries.begin(), asEntries.end(), VSICurlCacheDirEntryOlder);
+
+        GIntBig nTargetBytes = nMaxBytes / 10 * 8;
+        for( size_t i = 0; i < asEntries.size() && nTotalBytes > nTargetBytes; i++ )
+        {
+            /* Another process may have removed it already */
+            VSIUnlink(asEntries[i].osFilename);
+            nTotalBytes -= asEntries[i].nSize;
+        }
+
+        if (ENABLE_DEBUG)
+            CPLDebug("VSICURL", "Pruned %s to " CPL_FRMT_GIB " bytes",
+                     osDir.c_str(), nTotalBytes);
+    }
+
+    CPLMutexHolder oHolder( &hMutex );
+    if (osDir == osCacheDir)
+        nCacheDirBytes = nTotalBytes;
 }
 
 
+/************************************************************************/
+/*                     VSICurlGetMaxRegionsBytes()                      */
+/*                                                                      */
+/*      Size of the region cache. The configuration option is read     */
+/*      each time, so that it can be changed while files are open.    */
+/************************************************************************/
+
+static GIntBig VSICurlGetMaxRegionsBytes()
+{
+    const char* pszCacheSize =
+        CPLGetConfigOption("CPL_VSIL_CURL_CACHE_SIZE_MB", NULL);
+    GIntBig nMaxRegionsBytes = (GIntBig)
+        ((pszCacheSize) ? atoi(pszCacheSize) : DEFAULT_CACHE_SIZE_MB) * 1024 * 1024;
+    if( nMaxRegionsBytes < DOWNLOAD_CHUNCK_SIZE )
+        nMaxRegionsBytes = DOWNLOAD_CHUNCK_SIZE;
+    return nMaxRegionsBytes;
+}
+
 /************************************************************************/
 /*                          GetRegion()                                 */
 /************************************************************************/
@@ -1649,23 +2327,32 @@ void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
 const CachedRegion* VSICurlFilesystemHandler::GetRegion(const char* pszURL,
                                                         vsi_l_offset nFileOffsetStart)
 {
-    CPLMutexHolder oHolder( &hMutex );
+    {
+        CPLMutexHolder oHolder( &hMutex );
 
-    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+        unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
 
-    nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
-    int i;
-    for(i=0;i<nRegions;i++)
-    {
-        CachedRegion* psRegion = papsRegions[i];
-        if (psRegion->pszURLHash == pszURLHash &&
-            nFileOffsetStart == psRegion->nFileOffsetStart)
+        nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+
+        CachedRegionKey sKey;
+        sKey.pszURLHash = pszURLHash;
+        sKey.nFileOffsetStart = nFileOffsetStart;
+
+        std::map<CachedRegionKey, CachedRegion*, CachedRegionKeyLess>::iterator oIter =
+            oMapRegions.find(sKey);
+        if (oIter != oMapRegions.end())
         {
-            memmove(papsRegions + 1, papsRegions, i * sizeof(CachedRegion*));
-            papsRegions[0] = psRegion;
+            CachedRegion* psRegion = oIter->second;
+            if (psRegion != psRegionMRU)
+            {
+                UnlinkRegion(psRegion);
+                LinkRegionAsMRU(psRegion);
+            }
             return psRegion;
         }
     }
+
+    /* Disk accesses are done without holding the mutex */
     if (bUseCacheDisk)
         return GetRegionFromCacheDisk(pszURL, nFileOffsetStart);
     return NULL;
@@ -1679,28 +2366,73 @@ void  VSICurlFilesystemHandler::AddRegion(const char* pszURL,
                                           vsi_l_offset    nFileOffsetStart,
                                           size_t          nSize,
                                           const char     *pData)
+{
+    AddRegionInMemory(pszURL, nFileOffsetStart, nSize, pData);
+
+    if (bUseCacheDisk && nSize != 0)
+        AddRegionToCacheDisk(pszURL, nFileOffsetStart, nSize, pData);
+}
+
+/************************************************************************/
+/*                         AddRegionInMemory()                          */
+/************************************************************************/
+
+CachedRegion* VSICurlFilesystemHandler::AddRegionInMemory(const char* pszURL,
+                                                          vsi_l_offset    nFileOffsetStart,
+                                                          size_t          nSize,
+                                                          const char     *pData)
 {
     CPLMutexHolder oHolder( &hMutex );
 
     unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
 
+    CachedRegionKey sKey;
+    sKey.pszURLHash = pszURLHash;
+    sKey.nFileOffsetStart = nFileOffsetStart;
+
+/* -------------------------------------------------------------------- */
+/*      Replace any previous region at that offset.                     */
+/* -------------------------------------------------------------------- */
+    std::map<CachedRegionKey, CachedRegion*, CachedRegionKeyLess>::iterator oIter =
+        oMapRegions.find(sKey);
     CachedRegion* psRegion;
-    if (nRegions == N_MAX_REGIONS)
+    if (oIter != oMapRegions.end())
     {
-        psRegion = papsRegions[N_MAX_REGIONS-1];
-        memmove(papsRegions + 1, papsRegions, (N_MAX_REGIONS-1) * sizeof(CachedRegion*));
-        papsRegions[0] = psRegion;
+        psRegion = oIter->second;
+        UnlinkRegion(psRegion);
+        nRegionsBytes -= (psRegion->nSize) ? psRegion->nSize : DOWNLOAD_CHUNCK_SIZE;
         CPLFree(psRegion->pData);
     }
     else
     {
-        papsRegions = (CachedRegion**) CPLRealloc(papsRegions, (nRegions + 1) * sizeof(CachedRegion*));
-        if (nRegions)
-            memmove(papsRegions + 1, papsRegions, nRegions * sizeof(CachedRegion*));
-        nRegions ++;
-        papsRegions[0] = psRegion = (CachedRegion*) CPLMalloc(sizeof(CachedRegion));
+        psRegion = (CachedRegion*) CPLMalloc(sizeof(CachedRegion));
+        oMapRegions[sKey] = psRegion;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Evict least recently used regions to stay within the budget.   */
+/*      Empty regions (beyond end of file) are accounted as a chunk.   */
+/* -------------------------------------------------------------------- */
+    GIntBig nMaxRegionsBytes = VSICurlGetMaxRegionsBytes();
+    while (psRegionLRU != NULL &&
+           nRegionsBytes + DOWNLOAD_CHUNCK_SIZE > nMaxRegionsBytes)
+    {
+        CachedRegion* psLRU = psRegionLRU;
+        UnlinkRegion(psLRU);
+        nRegionsBytes -= (psLRU->nSize) ? psLRU->nSize : DOWNLOAD_CHUNCK_SIZE;
+
+        CachedRegionKey sLRUKey;
+        sLRUKey.pszURLHash = psLRU->pszURLHash;
+        sLRUKey.nFileOffsetStart = psLRU->nFileOffsetStart;
+        oMapRegions.erase(sLRUKey);
+
+        CPLFree(psLRU->pData);
+        CPLFree(psLRU);
     }
 
+    LinkRegionAsMRU(psRegion);
+    nRegionsBytes += (nSize) ? nSize : DOWNLOAD_CHUNCK_SIZE;
+
     psRegion->pszURLHash = pszURLHash;
     psRegion->nFileOffsetStart = nFileOffsetStart;
     psRegion->nSize = nSize;
@@ -1708,8 +2440,57 @@ void  VSICurlFilesystemHandler::AddRegion(const char* pszURL,
     if (nSize)
         memcpy(psRegion->pData, pData, nSize);
 
-    if (bUseCacheDisk)
-        AddRegionToCacheDisk(psRegion);
+
+    return psRegion;
+}
+
+/************************************************************************/
+/*                          UnlinkRegion()                              */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::UnlinkRegion(CachedRegion* psRegion)
+{
+    if (psRegion->psPrev != NULL)
+        psRegion->psPrev->psNext = psRegion->psNext;
+    else
+        psRegionMRU = psRegion->psNext;
+
+    if (psRegion->psNext != NULL)
+        psRegion->psNext->psPrev = psRegion->psPrev;
+    else
+        psRegionLRU = psRegion->psPrev;
+
+    psRegion->psPrev = NULL;
+    psRegion->psNext = NULL;
+}
+
+/************************************************************************/
+/*                         LinkRegionAsMRU()                            */
+/************************************************************************/
+
+void VSICurlFilesystemHandler::LinkRegionAsMRU(CachedRegion* psRegion)
+{
+    psRegion->psPrev = NULL;
+    psRegion->psNext = psRegionMRU;
+    if (psRegionMRU != NULL)
+        psRegionMRU->psPrev = psRegion;
+    psRegionMRU = psRegion;
+    if (psRegionLRU == NULL)
+        psRegionLRU = psRegion;
+}
+
+/************************************************************************/
+/*                         GetMaxRegionCount()                          */
+/*                                                                      */
+/*      Number of full download chunks that fit in the region cache.    */
+/************************************************************************/
+
+int VSICurlFilesystemHandler::GetMaxRegionCount()
+{
+    GIntBig nCount = VSICurlGetMaxRegionsBytes() / DOWNLOAD_CHUNCK_SIZE;
+    if (nCount > INT_MAX)
+        nCount = INT_MAX;
+    return (int) nCount;
 }
 
 /************************************************************************/
@@ -1768,6 +2549,8 @@ VSIVirtualHandle* VSICurlFilesystemHandler::Open( const char *pszFilename,
         }
     }
 
+    ReadCacheDiskSettings();
+
     VSICurlHandle* poHandle = new VSICurlHandle( this, osFilename + strlen("/vsicurl/"));
     if (!bGotFileList)
     {
@@ -1780,7 +2563,7 @@ VSIVirtualHandle* VSICurlFilesystemHandler::Open( const char *pszFilename,
     }
 
     if( CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     else
         return poHandle;
 }
@@ -2667,9 +3450,34 @@ char** VSICurlFilesystemHandler::ReadDir( const char *pszDirname )
  * used to define a proxy server. The syntax to use is the one of Curl CURLOPT_PROXY,
  * CURLOPT_PROXYUSERPWD and CURLOPT_PROXYAUTH options.
  *
+ * Downloaded chunks are kept in a least-recently-used cache shared by all
+ * /vsicurl/ files, whose size defaults to 64 MB and can be modified by setting
+ * the configuration option CPL_VSIL_CURL_CACHE_SIZE_MB (in MB).
+ *
+ * Reads of multiple ranges (used by some drivers, such as GTiff, to fetch
+ * several blocks at once) are issued by default as a single multi-range request.
+ * If the configuration option CPL_VSIL_CURL_MAX_CONNECTIONS is set to a value
+ * greater than 1, they are instead issued as that many concurrent single range
+ * requests, on connections kept alive between reads. Ranges separated by at
+ * most CPL_VSIL_CURL_MERGE_GAP bytes (16384 by default) are then merged in a
+ * single request.
+ *
+ * Downloaded chunks can also be kept in a persistent cache directory, shared by
+ * processes, by setting the configuration option CPL_VSIL_CURL_CACHE_DIR to its
+ * path (or CPL_VSIL_CURL_USE_CACHE to YES to use gdal_vsicurl_cache in the current
+ * directory). Chunks are keyed by URL and by the ETag or Last-Modified header
+ * returned by the server, so that they are not used once the remote file has
+ * changed; files from servers that return neither are not cached on disk. The
+ * least recently used chunks are removed when the cache exceeds
+ * CPL_VSIL_CURL_CACHE_DIR_SIZE_MB (512 MB by default). The size of the
+ * directory is checked each time a process has written a tenth of that budget.
+ * Those options are read when files are opened.
+ *
  * Starting with GDAL 1.10, the file can be cached in RAM by setting the configuration option
  * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
- * the configuration option VSI_CACHE_SIZE (in bytes).
+ * the configuration option VSI_CACHE_SIZE (in bytes). If VSI_CACHE_SHARED is also set
+ * to TRUE, a process-wide cache of VSI_CACHE_SHARED_SIZE bytes (64 MB by default),
+ * shared by all the handles opened on the same file, is used instead.
  *
  * VSIStatL() will return the size in st_size member and file
  * nature- file or directory - in st_mode member (the later only reliable with FTP
@@ -1398,7 +1398,7 @@ VSIVirtualHandle* VSICurlStreamingFSHandler::Open( const char *pszFilename,
     }
 
     if( CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     else
         return poHandle;
 }
@@ -1452,7 +1452,9 @@ int VSICurlStreamingFSHandler::Stat( const char *pszFilename,
  *
  * The file can be cached in RAM by setting the configuration option
  * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
- * the configuration option VSI_CACHE_SIZE (in bytes).
+ * the configuration option VSI_CACHE_SIZE (in bytes). If VSI_CACHE_SHARED is also set
+ * to TRUE, a process-wide cache of VSI_CACHE_SHARED_SIZE bytes (64 MB by default),
+ * shared by all the handles opened on the same file, is used instead.
  *
  * VSIStatL() will return the size in st_size member and file
  * nature- file or directory - in st_mode member (the later only reliable with FTP
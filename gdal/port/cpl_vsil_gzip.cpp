@@ -70,6 +70,27 @@
    a .gz.properties file, so that we don't need to seek at the end of the file
    each time a Stat() is done.
 
+   For .gz files, a persistent random access index can also be used, similar to
+   the one of the zran.c example of zlib. It is made of "checkpoints" taken at
+   deflate block boundaries every CPL_VSIL_GZIP_INDEX_SPACING uncompressed bytes,
+   that record the compressed and uncompressed offsets, the bit offset in the
+   compressed byte and the 32 KB of uncompressed data that precede them (stored
+   compressed). Decompression can restart from any checkpoint, so a random seek
+   only needs to uncompress data since the closest one. The index is stored in a
+   .gz.gzidx file next to the .gz file, or in the CPL_VSIL_GZIP_INDEX_DIR
+   directory, and is built on the first long seek when CPL_VSIL_GZIP_INDEX=YES.
+
+   When CPL_VSIL_DEFLATE_NUM_THREADS is set to a value greater than 1 (or to
+   ALL_CPUS), data written to /vsigzip/ and /vsizip/ is compressed in parallel,
+   in the way of pigz : the stream is cut into chunks of
+   CPL_VSIL_DEFLATE_CHUNK_SIZE bytes that are deflated independently, with the
+   last 32 KB of the previous chunk as dictionary, and that are terminated by a
+   sync flush so that they can just be concatenated into a valid deflate stream.
+   The chunks are compressed by the global worker thread pool, shared with the
+   other users of CPLGetGlobalWorkerThreadPool().
+   For .gz files, the chunk boundaries are also written as a .gz.gzidx index when
+   CPL_VSIL_GZIP_INDEX=YES.
+
    For .zip and .gz, both reading and writing are supported, but just one mode at a time
    (read-only or write-only)
 */
@@ -78,7 +99,11 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_hash_set.h"
+#include "cpl_worker_thread_pool.h"
 #include <map>
+#include <deque>
+#include <vector>
 
 #include <zlib.h>
 #include "cpl_minizip_unzip.h"
@@ -105,6 +130,11 @@ static int const gz_magic[2] = {0x1f, 0x8b}; /* gzip magic header */
 
 #define ENABLE_DEBUG 0
 
+#define GZIP_INDEX_MAGIC            "GDALGZIX"
+#define GZIP_INDEX_VERSION          1
+#define GZIP_INDEX_WINDOW_SIZE      32768   /* maximum deflate distance */
+#define DEFAULT_GZIP_INDEX_SPACING  (4 * 1024 * 1024)
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIGZipHandle                                  */
@@ -121,6 +151,29 @@ typedef struct
     vsi_l_offset  out;
 } GZipSnapshot;
 
+/* Checkpoint of a random access index */
+typedef struct
+{
+    vsi_l_offset  in;       /* offset of the first compressed byte in the file */
+    vsi_l_offset  out;      /* uncompressed offset */
+    int           bits;     /* bits of the previous compressed byte to use */
+    GUInt32       crc;      /* crc32 of uncompressed data up to out */
+    GUInt32       nWindowSize;
+    GUInt32       nCompressedWindowSize;
+    Byte         *pabyCompressedWindow;
+} GZipIndexPoint;
+
+/* Random access index, shared by duplicated handles */
+typedef struct
+{
+    int             nRefCount;
+    vsi_l_offset    uncompressed_size;  /* 0 if unknown */
+    std::vector<GZipIndexPoint> asPoints;
+} GZipIndex;
+
+static void VSIGZipReleaseIndex(GZipIndex* psIndex);
+static vsi_l_offset VSIGZipGetIndexSpacing();
+
 class VSIGZipHandle : public VSIVirtualHandle
 {
     VSIVirtualHandle* poBaseHandle;
@@ -148,12 +201,20 @@ class VSIGZipHandle : public VSIVirtualHandle
     GZipSnapshot* snapshots;
     vsi_l_offset snapshot_byte_interval; /* number of compressed bytes at which we create a "snapshot" */
 
+    GZipIndex*    psIndex;
+    int           bIndexLoadAttempted;
+    int           bIndexBuildAttempted;
+
     void check_header();
     int get_byte();
     int gzseek( vsi_l_offset nOffset, int nWhence );
     int gzrewind ();
     uLong getLong ();
 
+    int           CanUseIndex();
+    GZipIndex*    BuildIndex();
+    int           SeekToIndexPoint( const GZipIndexPoint* psPoint );
+
   public:
 
     VSIGZipHandle(VSIVirtualHandle* poBaseHandle,
@@ -176,6 +237,8 @@ class VSIGZipHandle : public VSIVirtualHandle
     VSIGZipHandle*    Duplicate();
     void              CloseBaseHandle();
 
+    int               LoadOrBuildIndex( int bAllowBuild );
+
     vsi_l_offset      GetLastReadOffset() { return nLastReadOffset; }
     const char*       GetBaseFileName() { return pszBaseFileName; }
 
@@ -238,6 +301,12 @@ VSIGZipHandle* VSIGZipHandle::Duplicate()
 
     poHandle->nLastReadOffset = nLastReadOffset;
 
+    poHandle->bIndexLoadAttempted = bIndexLoadAttempted;
+    poHandle->bIndexBuildAttempted = bIndexBuildAttempted;
+    poHandle->psIndex = psIndex;
+    if (psIndex)
+        psIndex->nRefCount ++;
+
     /* Most important : duplicate the snapshots ! */
 
     unsigned int i;
@@ -331,6 +400,10 @@ VSIGZipHandle::VSIGZipHandle(VSIVirtualHandle* poBaseHandle,
     if (offset == 0) check_header(); /* skip the .gz header */
     startOff = VSIFTellL((VSILFILE*)poBaseHandle) - stream.avail_in;
 
+    psIndex = NULL;
+    bIndexLoadAttempted = FALSE;
+    bIndexBuildAttempted = FALSE;
+
     if (transparent == 0)
     {
         snapshot_byte_interval = MAX(Z_BUFSIZE, compressed_size / 100);
@@ -390,6 +463,8 @@ VSIGZipHandle::~VSIGZipHandle()
         }
         CPLFree(snapshots);
     }
+    if (psIndex)
+        VSIGZipReleaseIndex(psIndex);
     CPLFree(pszBaseFileName);
 
     if (poBaseHandle)
@@ -608,6 +683,16 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
             return 1;
         }
 
+        /* Building the index requires a full decompression, but it will */
+        /* also make later seeks cheap */
+        if (offset == 0 && CanUseIndex() && LoadOrBuildIndex(TRUE) &&
+            psIndex->uncompressed_size != 0)
+        {
+            uncompressed_size = psIndex->uncompressed_size;
+            out = uncompressed_size;
+            return 1;
+        }
+
         /* We don't know the uncompressed size. This is unfortunate. Let's do the slow version... */
         static int firstWarning = 1;
         if (compressed_size > 10 * 1024 * 1024 && firstWarning)
@@ -673,6 +758,33 @@ int VSIGZipHandle::gzseek( vsi_l_offset offset, int whence )
         }
     }
 
+    /* Jump to the closest checkpoint of the random access index, if it */
+    /* saves some decompression */
+    if (offset > 0 && CanUseIndex() &&
+        LoadOrBuildIndex(offset > VSIGZipGetIndexSpacing()))
+    {
+        const GZipIndexPoint* psBest = NULL;
+        for(size_t iPoint = 0; iPoint < psIndex->asPoints.size(); iPoint++)
+        {
+            if (psIndex->asPoints[iPoint].out > out + offset)
+                break;
+            psBest = &(psIndex->asPoints[iPoint]);
+        }
+        if (psBest != NULL && psBest->out > out)
+        {
+            vsi_l_offset target = out + offset;
+            if (ENABLE_DEBUG)
+                CPLDebug("GZIP", "using index point at in=" CPL_FRMT_GUIB " out=" CPL_FRMT_GUIB,
+                         psBest->in, psBest->out);
+            if (!SeekToIndexPoint(psBest))
+            {
+                CPL_VSIL_GZ_RETURN(-1);
+                return -1L;
+            }
+            offset = target - out;
+        }
+    }
+
     /* offset is now the number of bytes to skip. */
 
     if (offset != 0 && outbuf == Z_NULL) {
@@ -944,6 +1056,467 @@ uLong VSIGZipHandle::getLong ()
     return x;
 }
 
+/************************************************************************/
+/*                      VSIGZipGetIndexSpacing()                        */
+/************************************************************************/
+
+static vsi_l_offset VSIGZipGetIndexSpacing()
+{
+    vsi_l_offset nSpacing = (vsi_l_offset) CPLScanUIntBig(
+        CPLGetConfigOption("CPL_VSIL_GZIP_INDEX_SPACING",
+                           CPLSPrintf("%d", DEFAULT_GZIP_INDEX_SPACING)), 32);
+    return MAX(nSpacing, (vsi_l_offset)Z_BUFSIZE);
+}
+
+/************************************************************************/
+/*                      VSIGZipGetIndexFilename()                       */
+/************************************************************************/
+
+static CPLString VSIGZipGetIndexFilename(const char* pszBaseFileName)
+{
+    const char* pszIndexDir = CPLGetConfigOption("CPL_VSIL_GZIP_INDEX_DIR", NULL);
+    if (pszIndexDir == NULL || pszIndexDir[0] == '\0')
+        return CPLString(pszBaseFileName) + ".gzidx";
+
+    /* Prefix with a hash of the full path, to avoid clashes between */
+    /* files of the same name in different directories */
+    CPLString osBasename;
+    osBasename.Printf("%08X_%s", (unsigned int)CPLHashSetHashStr(pszBaseFileName),
+                      CPLGetFilename(pszBaseFileName));
+    return CPLFormFilename(pszIndexDir, osBasename, "gzidx");
+}
+
+/************************************************************************/
+/*                        VSIGZipReleaseIndex()                         */
+/************************************************************************/
+
+static void VSIGZipReleaseIndex(GZipIndex* psIndex)
+{
+    if (--psIndex->nRefCount > 0)
+        return;
+    for(size_t i = 0; i < psIndex->asPoints.size(); i++)
+        CPLFree(psIndex->asPoints[i].pabyCompressedWindow);
+    delete psIndex;
+}
+
+/************************************************************************/
+/*                   Little-endian index I/O helpers                    */
+/************************************************************************/
+
+static int VSIGZipWriteUInt32(VSILFILE* fp, GUInt32 nVal)
+{
+    CPL_LSBPTR32(&nVal);
+    return VSIFWriteL(&nVal, 1, 4, fp) == 4;
+}
+
+static int VSIGZipWriteUInt64(VSILFILE* fp, GUIntBig nVal)
+{
+    CPL_LSBPTR64(&nVal);
+    return VSIFWriteL(&nVal, 1, 8, fp) == 8;
+}
+
+static int VSIGZipReadUInt32(VSILFILE* fp, GUInt32* pnVal)
+{
+    if (VSIFReadL(pnVal, 1, 4, fp) != 4)
+        return FALSE;
+    CPL_LSBPTR32(pnVal);
+    return TRUE;
+}
+
+static int VSIGZipReadUInt64(VSILFILE* fp, GUIntBig* pnVal)
+{
+    if (VSIFReadL(pnVal, 1, 8, fp) != 8)
+        return FALSE;
+    CPL_LSBPTR64(pnVal);
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          VSIGZipReadIndex()                          */
+/*                                                                      */
+/*      Read an index file. Returns NULL if it does not exist, is       */
+/*      corrupted, or is not for this version of the .gz file.          */
+/************************************************************************/
+
+static GZipIndex* VSIGZipReadIndex(const char* pszIndexFilename,
+                                   GUIntBig nFileSize, GUIntBig nMTime)
+{
+    VSILFILE* fp = VSIFOpenL(pszIndexFilename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    char        szMagic[8];
+    GUInt32     nVersion = 0, nPoints = 0;
+    GUIntBig    nFileSizeIndex = 0, nMTimeIndex = 0, nUncompressedSize = 0, nSpacing = 0;
+
+    if (VSIFReadL(szMagic, 1, 8, fp) != 8 ||
+        memcmp(szMagic, GZIP_INDEX_MAGIC, 8) != 0 ||
+        !VSIGZipReadUInt32(fp, &nVersion) || nVersion != GZIP_INDEX_VERSION ||
+        !VSIGZipReadUInt64(fp, &nFileSizeIndex) || nFileSizeIndex != nFileSize ||
+        !VSIGZipReadUInt64(fp, &nMTimeIndex) || nMTimeIndex != nMTime ||
+        !VSIGZipReadUInt64(fp, &nUncompressedSize) ||
+        !VSIGZipReadUInt64(fp, &nSpacing) ||
+        !VSIGZipReadUInt32(fp, &nPoints))
+    {
+        VSIFCloseL(fp);
+        return NULL;
+    }
+
+    GZipIndex* psIndex = new GZipIndex;
+    psIndex->nRefCount = 1;
+    psIndex->uncompressed_size = nUncompressedSize;
+
+    int bOK = TRUE;
+    for(GUInt32 i = 0; i < nPoints && bOK; i++)
+    {
+        GZipIndexPoint sPoint;
+        GUIntBig nIn = 0, nOut = 0;
+        GUInt32 nBits = 0;
+        sPoint.pabyCompressedWindow = NULL;
+
+        bOK = VSIGZipReadUInt64(fp, &nIn) &&
+              VSIGZipReadUInt64(fp, &nOut) &&
+              VSIGZipReadUInt32(fp, &nBits) && nBits < 8 &&
+              VSIGZipReadUInt32(fp, &sPoint.crc) &&
+              VSIGZipReadUInt32(fp, &sPoint.nWindowSize) &&
+              sPoint.nWindowSize <= GZIP_INDEX_WINDOW_SIZE &&
+              VSIGZipReadUInt32(fp, &sPoint.nCompressedWindowSize) &&
+              sPoint.nCompressedWindowSize <= 2 * GZIP_INDEX_WINDOW_SIZE &&
+              (i == 0 || nOut > psIndex->asPoints.back().out);
+        if (bOK && sPoint.nCompressedWindowSize)
+        {
+            sPoint.pabyCompressedWindow = (Byte*) CPLMalloc(sPoint.nCompressedWindowSize);
+            bOK = VSIFReadL(sPoint.pabyCompressedWindow, 1,
+                            sPoint.nCompressedWindowSize, fp) == sPoint.nCompressedWindowSize;
+        }
+        sPoint.in = nIn;
+        sPoint.out = nOut;
+        sPoint.bits = (int)nBits;
+        if (bOK)
+            psIndex->asPoints.push_back(sPoint);
+        else
+            CPLFree(sPoint.pabyCompressedWindow);
+    }
+    VSIFCloseL(fp);
+
+    if (!bOK)
+    {
+        CPLDebug("GZIP", "%s is corrupted. Ignoring it", pszIndexFilename);
+        VSIGZipReleaseIndex(psIndex);
+        return NULL;
+    }
+
+    CPLDebug("GZIP", "Using %s (%d checkpoints)", pszIndexFilename, (int)nPoints);
+    return psIndex;
+}
+
+/************************************************************************/
+/*                         VSIGZipWriteIndex()                          */
+/*                                                                      */
+/*      The index is written in a temporary file that is then renamed,  */
+/*      so that concurrent readers never see a partial index.           */
+/************************************************************************/
+
+static void VSIGZipWriteIndex(const char* pszIndexFilename,
+                              const GZipIndex* psIndex,
+                              GUIntBig nFileSize, GUIntBig nMTime)
+{
+    CPLString osTmpFilename(pszIndexFilename);
+    osTmpFilename += CPLSPrintf(".tmp" CPL_FRMT_GIB, CPLGetPID());
+
+    VSILFILE* fp = VSIFOpenL(osTmpFilename, "wb");
+    if (fp == NULL)
+    {
+        CPLDebug("GZIP", "Cannot create %s", pszIndexFilename);
+        return;
+    }
+
+    int bOK =
+        VSIFWriteL(GZIP_INDEX_MAGIC, 1, 8, fp) == 8 &&
+        VSIGZipWriteUInt32(fp, GZIP_INDEX_VERSION) &&
+        VSIGZipWriteUInt64(fp, nFileSize) &&
+        VSIGZipWriteUInt64(fp, nMTime) &&
+        VSIGZipWriteUInt64(fp, psIndex->uncompressed_size) &&
+        VSIGZipWriteUInt64(fp, VSIGZipGetIndexSpacing()) &&
+        VSIGZipWriteUInt32(fp, (GUInt32)psIndex->asPoints.size());
+    for(size_t i = 0; i < psIndex->asPoints.size() && bOK; i++)
+    {
+        const GZipIndexPoint* psPoint = &(psIndex->asPoints[i]);
+        bOK = VSIGZipWriteUInt64(fp, psPoint->in) &&
+              VSIGZipWriteUInt64(fp, psPoint->out) &&
+              VSIGZipWriteUInt32(fp, (GUInt32)psPoint->bits) &&
+              VSIGZipWriteUInt32(fp, psPoint->crc) &&
+              VSIGZipWriteUInt32(fp, psPoint->nWindowSize) &&
+              VSIGZipWriteUInt32(fp, psPoint->nCompressedWindowSize) &&
+              VSIFWriteL(psPoint->pabyCompressedWindow, 1,
+                         psPoint->nCompressedWindowSize, fp) == psPoint->nCompressedWindowSize;
+    }
+    if (VSIFCloseL(fp) != 0)
+        bOK = FALSE;
+
+    if (!bOK || VSIRename(osTmpFilename, pszIndexFilename) != 0)
+    {
+        CPLDebug("GZIP", "Cannot write %s", pszIndexFilename);
+        VSIUnlink(osTmpFilename);
+    }
+}
+
+/************************************************************************/
+/*                            CanUseIndex()                             */
+/************************************************************************/
+
+int VSIGZipHandle::CanUseIndex()
+{
+    /* Only for standalone .gz files, not for .zip members */
+    if (offset != 0 || pszBaseFileName == NULL || expected_crc != 0 ||
+        transparent)
+        return FALSE;
+
+    const char* pszIndex = CPLGetConfigOption("CPL_VSIL_GZIP_INDEX", NULL);
+    return pszIndex == NULL || CSLTestBoolean(pszIndex);
+}
+
+/************************************************************************/
+/*                          LoadOrBuildIndex()                          */
+/*                                                                      */
+/*      Load the index of the file if it exists. Otherwise, if         */
+/*      bAllowBuild is set and CPL_VSIL_GZIP_INDEX=YES, build it and   */
+/*      save it.                                                        */
+/************************************************************************/
+
+int VSIGZipHandle::LoadOrBuildIndex( int bAllowBuild )
+{
+    if (psIndex != NULL)
+        return TRUE;
+    if (bIndexLoadAttempted &&
+        (!bAllowBuild || bIndexBuildAttempted))
+        return FALSE;
+
+    VSIStatBufL sStat;
+    if (VSIStatL(pszBaseFileName, &sStat) != 0)
+        return FALSE;
+    CPLString osIndexFilename = VSIGZipGetIndexFilename(pszBaseFileName);
+
+    if (!bIndexLoadAttempted)
+    {
+        bIndexLoadAttempted = TRUE;
+        psIndex = VSIGZipReadIndex(osIndexFilename, sStat.st_size, sStat.st_mtime);
+        if (psIndex != NULL)
+            return TRUE;
+    }
+
+    if (!bAllowBuild || bIndexBuildAttempted ||
+        !CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_GZIP_INDEX", "NO")))
+        return FALSE;
+
+    bIndexBuildAttempted = TRUE;
+    psIndex = BuildIndex();
+    if (psIndex == NULL)
+        return FALSE;
+
+    VSIGZipWriteIndex(osIndexFilename, psIndex, sStat.st_size, sStat.st_mtime);
+    return TRUE;
+}
+
+/************************************************************************/
+/*                             BuildIndex()                             */
+/*                                                                      */
+/*      Decompress the whole (first member of the) file to create      */
+/*      checkpoints at deflate block boundaries. The state of the      */
+/*      handle is left unchanged.                                       */
+/************************************************************************/
+
+GZipIndex* VSIGZipHandle::BuildIndex()
+{
+    vsi_l_offset nSpacing = VSIGZipGetIndexSpacing();
+    vsi_l_offset nSavedPos = VSIFTellL((VSILFILE*)poBaseHandle);
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    if (inflateInit2(&sStream, -MAX_WBITS) != Z_OK)
+        return NULL;
+
+    Byte* pabyIn = (Byte*) VSIMalloc(Z_BUFSIZE);
+    Byte* pabyWindow = (Byte*) VSIMalloc(GZIP_INDEX_WINDOW_SIZE);
+    Byte* pabyDict = (Byte*) VSIMalloc(GZIP_INDEX_WINDOW_SIZE);
+    uLong nCompressBound = compressBound(GZIP_INDEX_WINDOW_SIZE);
+    Byte* pabyCompressed = (Byte*) VSIMalloc(nCompressBound);
+
+    GZipIndex* psNewIndex = new GZipIndex;
+    psNewIndex->nRefCount = 1;
+    psNewIndex->uncompressed_size = 0;
+
+    int bOK = (pabyIn != NULL && pabyWindow != NULL && pabyDict != NULL &&
+               pabyCompressed != NULL);
+    int ret = Z_OK;
+    vsi_l_offset nTotIn = 0, nTotOut = 0, nLast = 0;
+    uLong nCRC = crc32(0L, Z_NULL, 0);
+
+    VSIFSeekL((VSILFILE*)poBaseHandle, startOff, SEEK_SET);
+
+    while (bOK && ret != Z_STREAM_END)
+    {
+        if (sStream.avail_in == 0)
+        {
+            vsi_l_offset nRemaining = offsetEndCompressedData - (startOff + nTotIn);
+            sStream.avail_in = (uInt)VSIFReadL(pabyIn, 1,
+                                               (size_t)MIN((vsi_l_offset)Z_BUFSIZE, nRemaining),
+                                               (VSILFILE*)poBaseHandle);
+            if (sStream.avail_in == 0)
+            {
+                bOK = FALSE;
+                break;
+            }
+            sStream.next_in = pabyIn;
+        }
+
+        do
+        {
+            if (sStream.avail_out == 0)
+            {
+                sStream.avail_out = GZIP_INDEX_WINDOW_SIZE;
+                sStream.next_out = pabyWindow;
+            }
+
+            Byte* pabyOutStart = sStream.next_out;
+            nTotIn += sStream.avail_in;
+            nTotOut += sStream.avail_out;
+            ret = inflate(&sStream, Z_BLOCK);
+            nTotIn -= sStream.avail_in;
+            nTotOut -= sStream.avail_out;
+            nCRC = crc32(nCRC, pabyOutStart, (uInt)(sStream.next_out - pabyOutStart));
+
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR ||
+                ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR)
+            {
+                bOK = FALSE;
+                break;
+            }
+            if (ret == Z_STREAM_END)
+                break;
+
+/* -------------------------------------------------------------------- */
+/*      At the end of a block that is not the last one, add a           */
+/*      checkpoint with the last 32 KB of output as dictionary.         */
+/* -------------------------------------------------------------------- */
+            if ((sStream.data_type & 128) && !(sStream.data_type & 64) &&
+                (nTotOut == 0 || nTotOut - nLast >= nSpacing))
+            {
+                GZipIndexPoint sPoint;
+                sPoint.in = startOff + nTotIn;
+                sPoint.out = nTotOut;
+                sPoint.bits = sStream.data_type & 7;
+                sPoint.crc = (GUInt32)nCRC;
+                sPoint.nWindowSize = (GUInt32)MIN(nTotOut, (vsi_l_offset)GZIP_INDEX_WINDOW_SIZE);
+                sPoint.nCompressedWindowSize = 0;
+                sPoint.pabyCompressedWindow = NULL;
+
+                if (sPoint.nWindowSize)
+                {
+                    /* The window is a circular buffer whose next write */
+                    /* position is GZIP_INDEX_WINDOW_SIZE - avail_out */
+                    uInt nLeft = sStream.avail_out;
+                    if (nTotOut >= GZIP_INDEX_WINDOW_SIZE)
+                    {
+                        memcpy(pabyDict, pabyWindow + GZIP_INDEX_WINDOW_SIZE - nLeft, nLeft);
+                        memcpy(pabyDict + nLeft, pabyWindow, GZIP_INDEX_WINDOW_SIZE - nLeft);
+                    }
+                    else
+                        memcpy(pabyDict, pabyWindow, sPoint.nWindowSize);
+
+                    uLongf nCompressedSize = nCompressBound;
+                    if (compress2(pabyCompressed, &nCompressedSize, pabyDict,
+                                  sPoint.nWindowSize, Z_BEST_SPEED) != Z_OK)
+                    {
+                        bOK = FALSE;
+                        break;
+                    }
+                    sPoint.nCompressedWindowSize = (GUInt32)nCompressedSize;
+                    sPoint.pabyCompressedWindow = (Byte*) CPLMalloc(nCompressedSize);
+                    memcpy(sPoint.pabyCompressedWindow, pabyCompressed, nCompressedSize);
+                }
+
+                psNewIndex->asPoints.push_back(sPoint);
+                nLast = nTotOut;
+            }
+        } while (sStream.avail_in != 0);
+    }
+
+    /* The uncompressed size is known if there is a single member, */
+    /* i.e. if only the 8 byte trailer follows */
+    if (bOK && startOff + nTotIn + 8 == offsetEndCompressedData)
+        psNewIndex->uncompressed_size = nTotOut;
+
+    inflateEnd(&sStream);
+    VSIFree(pabyIn);
+    VSIFree(pabyWindow);
+    VSIFree(pabyDict);
+    VSIFree(pabyCompressed);
+
+    VSIFSeekL((VSILFILE*)poBaseHandle, nSavedPos, SEEK_SET);
+
+    if (!bOK)
+    {
+        CPLDebug("GZIP", "Cannot build index of %s", pszBaseFileName);
+        VSIGZipReleaseIndex(psNewIndex);
+        return NULL;
+    }
+
+    CPLDebug("GZIP", "Built index of %s with %d checkpoints",
+             pszBaseFileName, (int)psNewIndex->asPoints.size());
+    return psNewIndex;
+}
+
+/************************************************************************/
+/*                          SeekToIndexPoint()                          */
+/*                                                                      */
+/*      Restart decompression at a checkpoint of the index.             */
+/************************************************************************/
+
+int VSIGZipHandle::SeekToIndexPoint( const GZipIndexPoint* psPoint )
+{
+    Byte* pabyWindow = NULL;
+    if (psPoint->nWindowSize)
+    {
+        uLongf nWindowSize = psPoint->nWindowSize;
+        pabyWindow = (Byte*) VSIMalloc(nWindowSize);
+        if (pabyWindow == NULL ||
+            uncompress(pabyWindow, &nWindowSize, psPoint->pabyCompressedWindow,
+                       psPoint->nCompressedWindowSize) != Z_OK ||
+            nWindowSize != psPoint->nWindowSize)
+        {
+            VSIFree(pabyWindow);
+            return FALSE;
+        }
+    }
+
+    inflateReset(&stream);
+    z_err = Z_OK;
+    z_eof = 0;
+    stream.avail_in = 0;
+    stream.next_in = inbuf;
+
+    VSIFSeekL((VSILFILE*)poBaseHandle, psPoint->in - (psPoint->bits ? 1 : 0), SEEK_SET);
+    if (psPoint->bits)
+    {
+        int c = get_byte();
+        if (c == EOF)
+        {
+            VSIFree(pabyWindow);
+            return FALSE;
+        }
+        inflatePrime(&stream, psPoint->bits, c >> (8 - psPoint->bits));
+    }
+    if (pabyWindow != NULL)
+        inflateSetDictionary(&stream, pabyWindow, psPoint->nWindowSize);
+    VSIFree(pabyWindow);
+
+    crc = psPoint->crc;
+    in = psPoint->in - startOff;
+    out = psPoint->out;
+    return TRUE;
+}
+
 /************************************************************************/
 /*                              Write()                                 */
 /************************************************************************/
@@ -1255,6 +1828,619 @@ vsi_l_offset VSIGZipWriteHandle::Tell()
 }
 
 
+/************************************************************************/
+/* ==================================================================== */
+/*                      VSIGZipWriteHandleMT                            */
+/* ==================================================================== */
+/************************************************************************/
+
+class VSIGZipWriteHandleMT;
+
+/* A chunk of uncompressed data, and once the job is done its compressed */
+/* counterpart */
+typedef struct
+{
+    VSIGZipWriteHandleMT* poParent;
+
+    Byte           *pabyIn;
+    size_t          nInSize;
+    Byte            abyDict[GZIP_INDEX_WINDOW_SIZE];
+    uInt            nDictSize;
+    vsi_l_offset    nUncompressedOffset;
+    int             bFinal;
+
+    Byte           *pabyOut;
+    size_t          nOutSize;
+    uLong           nCRC;
+
+    /* Set if a checkpoint of the index must be recorded at the start */
+    /* of this chunk */
+    int             bIndexPoint;
+    Byte           *pabyCompressedDict;
+    uLongf          nCompressedDictSize;
+
+    int             bOK;
+    int             bFinished;
+} VSIDeflateJob;
+
+class VSIGZipWriteHandleMT : public VSIVirtualHandle
+{
+    VSIVirtualHandle*  poBaseHandle;
+    int                nDeflateType;
+    int                bAutoCloseBaseHandle;
+    int                nThreads;
+    size_t             nChunkSize;
+    CPLString          osFilename;
+    CPLString          osIndexFilename;
+
+    CPLWorkerThreadPool* poPool;               /* global pool, not owned */
+    int                nPendingJobs;
+    CPLMutex          *hJobMutex;
+    std::deque<VSIDeflateJob*> apoJobs;     /* in stream order */
+
+    VSIDeflateJob     *psCurJob;
+    Byte               abyLastWindow[GZIP_INDEX_WINDOW_SIZE];
+    uInt               nLastWindowSize;
+
+    vsi_l_offset       nCurOffset;
+    vsi_l_offset       nCompressedOffset;
+    vsi_l_offset       nLastIndexOffset;
+    vsi_l_offset       nIndexSpacing;
+    uLong              nCRC;
+    int                bError;
+    int                bClosed;
+    GZipIndex         *psWrittenIndex;
+
+    static void        DeflateJob( void* pData );
+    int                SubmitCurJob( int bFinal );
+    int                WriteFinishedJobs( size_t nMaxRemainingJobs );
+
+  public:
+
+    VSIGZipWriteHandleMT( VSIVirtualHandle* poBaseHandle, int nDeflateType,
+                          int bAutoCloseBaseHandle, int nThreads,
+                          size_t nChunkSize, const char* pszFilename );
+    ~VSIGZipWriteHandleMT();
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Close();
+};
+
+/************************************************************************/
+/*                        VSIGetDeflateThreadCount()                    */
+/*                                                                      */
+/*      Number of compression threads requested with the               */
+/*      CPL_VSIL_DEFLATE_NUM_THREADS configuration option.             */
+/************************************************************************/
+
+int VSIGetDeflateThreadCount()
+{
+    const char* pszValue = CPLGetConfigOption("CPL_VSIL_DEFLATE_NUM_THREADS", NULL);
+    if( pszValue == NULL )
+        return 1;
+
+    int nThreads;
+    if( EQUAL(pszValue, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszValue);
+    return MAX(1, MIN(nThreads, 128));
+}
+
+/************************************************************************/
+/*                      VSICreateGZipWritableMT()                       */
+/************************************************************************/
+
+/**
+ * \brief Create a handle that compresses in parallel what is written to it.
+ *
+ * @param poBaseHandle handle to which the compressed stream is written.
+ * @param nDeflateType CPL_DEFLATE_TYPE_GZIP to write a .gz file, or
+ *                     CPL_DEFLATE_TYPE_RAW_DEFLATE to write a raw deflate
+ *                     stream (as in .zip files).
+ * @param bAutoCloseBaseHandle whether poBaseHandle must be closed and
+ *                     destroyed when the returned handle is closed.
+ * @param nThreads number of compression threads, or 0 to use the value of
+ *                     the CPL_VSIL_DEFLATE_NUM_THREADS configuration option.
+ * @param nChunkSize size of the independently compressed chunks, or 0 to
+ *                     use the value of CPL_VSIL_DEFLATE_CHUNK_SIZE (1 MB
+ *                     by default).
+ * @param pszFilename name of the .gz file, to write its random access index
+ *                     if CPL_VSIL_GZIP_INDEX=YES, or NULL.
+ */
+
+VSIVirtualHandle* VSICreateGZipWritableMT( VSIVirtualHandle* poBaseHandle,
+                                           int nDeflateType,
+                                           int bAutoCloseBaseHandle,
+                                           int nThreads,
+                                           size_t nChunkSize,
+                                           const char* pszFilename )
+{
+    if( nThreads <= 0 )
+        nThreads = VSIGetDeflateThreadCount();
+    if( nChunkSize == 0 )
+        nChunkSize = (size_t) CPLScanUIntBig(
+            CPLGetConfigOption("CPL_VSIL_DEFLATE_CHUNK_SIZE", "1048576"), 32);
+    nChunkSize = MAX(nChunkSize, (size_t)GZIP_INDEX_WINDOW_SIZE);
+
+    return new VSIGZipWriteHandleMT( poBaseHandle, nDeflateType,
+                                     bAutoCloseBaseHandle, nThreads,
+                                     nChunkSize, pszFilename );
+}
+
+/************************************************************************/
+/*                        VSIGZipWriteHandleMT()                        */
+/************************************************************************/
+
+VSIGZipWriteHandleMT::VSIGZipWriteHandleMT( VSIVirtualHandle* poBaseHandle,
+                                            int nDeflateType,
+                                            int bAutoCloseBaseHandle,
+                                            int nThreads,
+                                            size_t nChunkSize,
+                                            const char* pszFilename )
+{
+    this->poBaseHandle = poBaseHandle;
+    this->nDeflateType = nDeflateType;
+    this->bAutoCloseBaseHandle = bAutoCloseBaseHandle;
+    this->nThreads = nThreads;
+    this->nChunkSize = nChunkSize;
+
+    poPool = NULL;
+    nPendingJobs = 0;
+    hJobMutex = NULL;
+    psCurJob = NULL;
+    nLastWindowSize = 0;
+    nCurOffset = 0;
+    nCompressedOffset = 0;
+    nLastIndexOffset = 0;
+    nIndexSpacing = 0;
+    nCRC = crc32(0L, Z_NULL, 0);
+    bError = FALSE;
+    bClosed = FALSE;
+    psWrittenIndex = NULL;
+
+    if( nDeflateType == CPL_DEFLATE_TYPE_GZIP )
+    {
+        if( pszFilename != NULL &&
+            CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_GZIP_INDEX", "NO")) )
+        {
+            osFilename = pszFilename;
+            osIndexFilename = VSIGZipGetIndexFilename(pszFilename);
+            nIndexSpacing = VSIGZipGetIndexSpacing();
+            psWrittenIndex = new GZipIndex;
+            psWrittenIndex->nRefCount = 1;
+            psWrittenIndex->uncompressed_size = 0;
+        }
+
+        char header[11];
+
+        /* Write a very simple .gz header, as VSIGZipWriteHandle does */
+        sprintf( header, "%c%c%c%c%c%c%c%c%c%c", gz_magic[0], gz_magic[1],
+                 Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/,
+                 0x03 );
+        if( poBaseHandle->Write( header, 1, 10 ) != 10 )
+            bError = TRUE;
+        nCompressedOffset = 10;
+    }
+}
+
+/************************************************************************/
+/*                       ~VSIGZipWriteHandleMT()                        */
+/************************************************************************/
+
+VSIGZipWriteHandleMT::~VSIGZipWriteHandleMT()
+{
+    if( !bClosed )
+        Close();
+
+    /* Jobs left over by a failed Close() must not outlive their buffers */
+    if( poPool != NULL )
+        poPool->WaitGroupCompletion( &nPendingJobs );
+    if( hJobMutex != NULL )
+        CPLDestroyMutex( hJobMutex );
+    if( psWrittenIndex != NULL )
+        VSIGZipReleaseIndex( psWrittenIndex );
+}
+
+/************************************************************************/
+/*                             DeflateJob()                             */
+/*                                                                      */
+/*      Run in a worker thread: compress a chunk as a sequence of       */
+/*      deflate blocks ending on a byte boundary.                       */
+/************************************************************************/
+
+void VSIGZipWriteHandleMT::DeflateJob( void* pData )
+{
+    VSIDeflateJob* psJob = (VSIDeflateJob*) pData;
+
+    psJob->nCRC = crc32(0L, Z_NULL, 0);
+    psJob->nCRC = crc32(psJob->nCRC, psJob->pabyIn, (uInt)psJob->nInSize);
+
+    z_stream sStream;
+    memset(&sStream, 0, sizeof(sStream));
+    psJob->bOK = (deflateInit2( &sStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) == Z_OK);
+    if( psJob->bOK )
+    {
+        if( psJob->nDictSize )
+            deflateSetDictionary( &sStream, psJob->abyDict, psJob->nDictSize );
+
+        /* Room for the worst case, plus the empty stored block */
+        /* of the sync flush */
+        size_t nOutAlloc = deflateBound( &sStream, (uLong)psJob->nInSize ) + 16;
+        psJob->pabyOut = (Byte*) VSIMalloc( nOutAlloc );
+        if( psJob->pabyOut == NULL )
+            psJob->bOK = FALSE;
+        else
+        {
+            const int nFlush = psJob->bFinal ? Z_FINISH : Z_SYNC_FLUSH;
+            sStream.next_in = psJob->pabyIn;
+            sStream.avail_in = (uInt)psJob->nInSize;
+            sStream.next_out = psJob->pabyOut;
+            sStream.avail_out = (uInt)nOutAlloc;
+            while( TRUE )
+            {
+                int nRet = deflate( &sStream, nFlush );
+                if( nRet == Z_STREAM_END ||
+                    (nRet == Z_OK && nFlush == Z_SYNC_FLUSH &&
+                     sStream.avail_in == 0 && sStream.avail_out > 0) )
+                    break;
+
+                /* A flush is only complete if it left some room in the */
+                /* output buffer. Otherwise deflate() must be called again */
+                /* with more room */
+                if( (nRet != Z_OK && nRet != Z_BUF_ERROR) ||
+                    sStream.avail_out > 0 )
+                {
+                    psJob->bOK = FALSE;
+                    break;
+                }
+                size_t nUsed = nOutAlloc - sStream.avail_out;
+                Byte* pabyNewOut = (Byte*)
+                    VSIRealloc( psJob->pabyOut, 2 * nOutAlloc );
+                if( pabyNewOut == NULL )
+                {
+                    psJob->bOK = FALSE;
+                    break;
+                }
+                psJob->pabyOut = pabyNewOut;
+                nOutAlloc *= 2;
+                sStream.next_out = psJob->pabyOut + nUsed;
+                sStream.avail_out = (uInt)(nOutAlloc - nUsed);
+            }
+            psJob->nOutSize = nOutAlloc - sStream.avail_out;
+        }
+        deflateEnd( &sStream );
+    }
+
+    if( psJob->bOK && psJob->bIndexPoint && psJob->nDictSize )
+    {
+        psJob->nCompressedDictSize = compressBound( psJob->nDictSize );
+        psJob->pabyCompressedDict = (Byte*) CPLMalloc( psJob->nCompressedDictSize );
+        if( compress2( psJob->pabyCompressedDict, &psJob->nCompressedDictSize,
+                       psJob->abyDict, psJob->nDictSize, Z_BEST_SPEED ) != Z_OK )
+        {
+            /* Not fatal : just no checkpoint */
+            CPLFree( psJob->pabyCompressedDict );
+            psJob->pabyCompressedDict = NULL;
+            psJob->bIndexPoint = FALSE;
+        }
+    }
+
+    if( psJob->poParent->hJobMutex == NULL )
+    {
+        /* Compressed in the writing thread */
+        psJob->bFinished = TRUE;
+        return;
+    }
+
+    CPLMutexHolderD( &(psJob->poParent->hJobMutex) );
+    psJob->bFinished = TRUE;
+}
+
+/************************************************************************/
+/*                            SubmitCurJob()                            */
+/************************************************************************/
+
+int VSIGZipWriteHandleMT::SubmitCurJob( int bFinal )
+{
+    if( psCurJob == NULL )
+    {
+        /* Final empty chunk, to terminate the deflate stream */
+        psCurJob = (VSIDeflateJob*) CPLCalloc( 1, sizeof(VSIDeflateJob) );
+        psCurJob->poParent = this;
+        psCurJob->nUncompressedOffset = nCurOffset;
+    }
+    VSIDeflateJob* psJob = psCurJob;
+    psCurJob = NULL;
+
+    psJob->bFinal = bFinal;
+    memcpy( psJob->abyDict, abyLastWindow, nLastWindowSize );
+    psJob->nDictSize = nLastWindowSize;
+
+    if( psWrittenIndex != NULL && psJob->nUncompressedOffset > 0 &&
+        psJob->nInSize > 0 &&
+        psJob->nUncompressedOffset - nLastIndexOffset >= nIndexSpacing )
+    {
+        psJob->bIndexPoint = TRUE;
+        nLastIndexOffset = psJob->nUncompressedOffset;
+    }
+
+    /* Keep the end of the chunk as the dictionary of the next one */
+    if( psJob->nInSize >= GZIP_INDEX_WINDOW_SIZE )
+    {
+        nLastWindowSize = GZIP_INDEX_WINDOW_SIZE;
+        memcpy( abyLastWindow,
+                psJob->pabyIn + psJob->nInSize - GZIP_INDEX_WINDOW_SIZE,
+                GZIP_INDEX_WINDOW_SIZE );
+    }
+    else if( psJob->nInSize > 0 )
+    {
+        /* Only the last chunk can be smaller than the window */
+        nLastWindowSize = (uInt)psJob->nInSize;
+        memcpy( abyLastWindow, psJob->pabyIn, nLastWindowSize );
+    }
+
+    if( bFinal && apoJobs.empty() )
+    {
+        /* Nothing else pending : no need for a worker thread. This avoids */
+        /* creating threads for small files */
+        DeflateJob( psJob );
+        apoJobs.push_back( psJob );
+        return WriteFinishedJobs( 0 );
+    }
+
+    if( poPool == NULL )
+    {
+        poPool = CPLGetGlobalWorkerThreadPool( nThreads );
+        if( poPool == NULL )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Cannot create compression threads" );
+            bError = TRUE;
+            CPLFree( psJob->pabyIn );
+            CPLFree( psJob );
+            return FALSE;
+        }
+        hJobMutex = CPLCreateMutex();
+        CPLReleaseMutex( hJobMutex );
+    }
+
+    apoJobs.push_back( psJob );
+    if( !poPool->SubmitJob( DeflateJob, psJob, &nPendingJobs ) )
+        DeflateJob( psJob );
+
+    /* Bound the memory used by chunks waiting to be written */
+    return WriteFinishedJobs( bFinal ? 0 : 2 * nThreads );
+}
+
+/************************************************************************/
+/*                         WriteFinishedJobs()                          */
+/*                                                                      */
+/*      Write the compressed chunks in stream order, waiting until at   */
+/*      most nMaxRemainingJobs chunks are pending.                      */
+/************************************************************************/
+
+int VSIGZipWriteHandleMT::WriteFinishedJobs( size_t nMaxRemainingJobs )
+{
+    while( !apoJobs.empty() )
+    {
+        VSIDeflateJob* psJob = apoJobs.front();
+
+        if( hJobMutex != NULL )
+        {
+            CPLAcquireMutex( hJobMutex, 1000.0 );
+            int bFinished = psJob->bFinished;
+            CPLReleaseMutex( hJobMutex );
+            if( !bFinished )
+            {
+                if( apoJobs.size() <= nMaxRemainingJobs )
+                    return !bError;
+
+                /* Wait for our whole group. The calling thread then runs */
+                /* our queued jobs instead of waiting for the threads of */
+                /* the pool, which might be busy with other work */
+                poPool->WaitGroupCompletion( &nPendingJobs );
+            }
+        }
+        apoJobs.pop_front();
+
+        if( !psJob->bOK )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined, "Compression failed" );
+            bError = TRUE;
+        }
+
+        if( !bError && psJob->bIndexPoint )
+        {
+            GZipIndexPoint sPoint;
+            sPoint.in = nCompressedOffset;
+            sPoint.out = psJob->nUncompressedOffset;
+            sPoint.bits = 0;
+            sPoint.crc = (GUInt32)nCRC;
+            sPoint.nWindowSize = psJob->nDictSize;
+            sPoint.nCompressedWindowSize = (GUInt32)psJob->nCompressedDictSize;
+            sPoint.pabyCompressedWindow = psJob->pabyCompressedDict;
+            psJob->pabyCompressedDict = NULL;
+            psWrittenIndex->asPoints.push_back( sPoint );
+        }
+
+        if( !bError )
+        {
+            if( poBaseHandle->Write( psJob->pabyOut, 1, psJob->nOutSize )
+                                                        != psJob->nOutSize )
+                bError = TRUE;
+            nCompressedOffset += psJob->nOutSize;
+            nCRC = crc32_combine( nCRC, psJob->nCRC, (z_off_t)psJob->nInSize );
+        }
+
+        CPLFree( psJob->pabyIn );
+        VSIFree( psJob->pabyOut );
+        CPLFree( psJob->pabyCompressedDict );
+        CPLFree( psJob );
+    }
+
+    return !bError;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIGZipWriteHandleMT::Write( const void *pBuffer,
+                                    size_t nSize, size_t nMemb )
+{
+    if( bError || bClosed )
+        return 0;
+
+    const Byte* pabyBuffer = (const Byte*) pBuffer;
+    size_t nBytesToWrite = nSize * nMemb;
+
+    while( nBytesToWrite > 0 )
+    {
+        if( psCurJob == NULL )
+        {
+            psCurJob = (VSIDeflateJob*) VSICalloc( 1, sizeof(VSIDeflateJob) );
+            if( psCurJob != NULL )
+                psCurJob->pabyIn = (Byte*) VSIMalloc( nChunkSize );
+            if( psCurJob == NULL || psCurJob->pabyIn == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Cannot allocate compression buffer" );
+                CPLFree( psCurJob );
+                psCurJob = NULL;
+                bError = TRUE;
+                return 0;
+            }
+            psCurJob->poParent = this;
+            psCurJob->nUncompressedOffset = nCurOffset;
+        }
+
+        size_t nToCopy = MIN(nBytesToWrite, nChunkSize - psCurJob->nInSize);
+        memcpy( psCurJob->pabyIn + psCurJob->nInSize, pabyBuffer, nToCopy );
+        psCurJob->nInSize += nToCopy;
+        pabyBuffer += nToCopy;
+        nBytesToWrite -= nToCopy;
+        nCurOffset += nToCopy;
+
+        if( psCurJob->nInSize == nChunkSize && !SubmitCurJob( FALSE ) )
+            return 0;
+    }
+
+    return nMemb;
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIGZipWriteHandleMT::Close()
+{
+    if( bClosed )
+        return 0;
+    bClosed = TRUE;
+
+    if( !bError )
+        SubmitCurJob( TRUE );
+    else
+    {
+        WriteFinishedJobs( 0 );
+        if( psCurJob != NULL )
+        {
+            CPLFree( psCurJob->pabyIn );
+            CPLFree( psCurJob );
+            psCurJob = NULL;
+        }
+    }
+
+    if( !bError && nDeflateType == CPL_DEFLATE_TYPE_GZIP )
+    {
+        GUInt32 anTrailer[2];
+
+        anTrailer[0] = CPL_LSBWORD32( (GUInt32) nCRC );
+        anTrailer[1] = CPL_LSBWORD32( (GUInt32) nCurOffset );
+
+        if( poBaseHandle->Write( anTrailer, 1, 8 ) != 8 )
+            bError = TRUE;
+    }
+
+    if( bAutoCloseBaseHandle )
+    {
+        if( poBaseHandle->Close() != 0 )
+            bError = TRUE;
+        delete poBaseHandle;
+        poBaseHandle = NULL;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      The index can only be validated against the final file.        */
+/* -------------------------------------------------------------------- */
+    VSIStatBufL sStat;
+    if( !bError && psWrittenIndex != NULL && poBaseHandle == NULL &&
+        !psWrittenIndex->asPoints.empty() &&
+        VSIStatL( osFilename, &sStat ) == 0 )
+    {
+        psWrittenIndex->uncompressed_size = nCurOffset;
+        VSIGZipWriteIndex( osIndexFilename, psWrittenIndex,
+                           sStat.st_size, sStat.st_mtime );
+    }
+
+    return bError ? EOF : 0;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIGZipWriteHandleMT::Read( CPL_UNUSED void *pBuffer,
+                                   CPL_UNUSED size_t nSize,
+                                   CPL_UNUSED size_t nMemb )
+{
+    CPLError(CE_Failure, CPLE_NotSupported, "VSIFReadL is not supported on GZip write streams\n");
+    return 0;
+}
+
+/************************************************************************/
+/*                                Eof()                                 */
+/************************************************************************/
+
+int VSIGZipWriteHandleMT::Eof()
+{
+    return 1;
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIGZipWriteHandleMT::Seek( vsi_l_offset nOffset, int nWhence )
+{
+    if( nOffset == 0 && (nWhence == SEEK_END || nWhence == SEEK_CUR) )
+        return 0;
+    else if( nWhence == SEEK_SET && nOffset == nCurOffset )
+        return 0;
+    else
+    {
+        CPLError(CE_Failure, CPLE_NotSupported,
+                 "Seeking on writable compressed data streams not supported." );
+        return -1;
+    }
+}
+
+/************************************************************************/
+/*                                Tell()                                */
+/************************************************************************/
+
+vsi_l_offset VSIGZipWriteHandleMT::Tell()
+{
+    return nCurOffset;
+}
+
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIGZipFilesystemHandler                       */
@@ -1358,6 +2544,10 @@ VSIVirtualHandle* VSIGZipFilesystemHandler::Open( const char *pszFilename,
         if (poVirtualHandle == NULL)
             return NULL;
 
+        else if (strchr(pszAccess, 'z') == NULL && VSIGetDeflateThreadCount() > 1)
+            return VSICreateGZipWritableMT( poVirtualHandle, CPL_DEFLATE_TYPE_GZIP, TRUE,
+                                            0, 0, pszFilename + strlen("/vsigzip/") );
+
         else
             return new VSIGZipWriteHandle( poVirtualHandle, strchr(pszAccess, 'z') != NULL, TRUE );
     }
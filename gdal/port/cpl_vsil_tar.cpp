@@ -195,6 +195,10 @@ public:
     virtual std::vector<CPLString> GetExtensions();
     virtual VSIArchiveReader* CreateReader(const char* pszTarFileName);
 
+    virtual VSIArchiveContent* LoadContentIndex(const char* pszTarFileName);
+    virtual void SaveContentIndex(const char* pszTarFileName,
+                                  const VSIArchiveContent* content);
+
     virtual VSIVirtualHandle *Open( const char *pszFilename, 
                                     const char *pszAccess);
 };
@@ -246,6 +250,143 @@ VSIArchiveReader* VSITarFilesystemHandler::CreateReader(const char* pszTarFileNa
     return poReader;
 }
 
+/************************************************************************/
+/*                          LoadContentIndex()                          */
+/*                                                                      */
+/*      Read the .taridx file saved next to the archive, if it is      */
+/*      still up to date. This avoids scanning the whole archive,      */
+/*      which requires decompressing everything for a .tgz.             */
+/************************************************************************/
+
+VSIArchiveContent* VSITarFilesystemHandler::LoadContentIndex(const char* pszTarFileName)
+{
+    const char* pszIndex = CPLGetConfigOption("CPL_VSIL_TAR_INDEX", NULL);
+    if (pszIndex != NULL && !CSLTestBoolean(pszIndex))
+        return NULL;
+
+    VSIStatBufL sStat;
+    if (VSIStatL(pszTarFileName, &sStat) != 0)
+        return NULL;
+
+    CPLString osIndexFilename = CPLString(pszTarFileName) + ".taridx";
+    VSILFILE* fp = VSIFOpenL(osIndexFilename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    const char* pszLine = CPLReadLineL(fp);
+    if (pszLine == NULL || strcmp(pszLine, "GDAL_TAR_INDEX 1") != 0 ||
+        (pszLine = CPLReadLineL(fp)) == NULL ||
+        CPLScanUIntBig(pszLine, 32) != (GUIntBig)sStat.st_size ||
+        (pszLine = CPLReadLineL(fp)) == NULL ||
+        CPLAtoGIntBig(pszLine) != (GIntBig)sStat.st_mtime)
+    {
+        VSIFCloseL(fp);
+        return NULL;
+    }
+
+    VSIArchiveContent* content = new VSIArchiveContent;
+    content->nEntries = 0;
+    content->entries = NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Each line is "offset size mtime is_dir name", with an offset    */
+/*      of -1 for the directories that are not in the archive.          */
+/* -------------------------------------------------------------------- */
+    int bOK = TRUE;
+    while ((pszLine = CPLReadLineL(fp)) != NULL)
+    {
+        char** papszTokens = CSLTokenizeString2(pszLine, " ", 0);
+        const char* pszName = strchr(pszLine, ' ');
+        for(int i = 1; i < 4 && pszName != NULL; i++)
+            pszName = strchr(pszName + 1, ' ');
+        if (CSLCount(papszTokens) < 5 || pszName == NULL)
+        {
+            CSLDestroy(papszTokens);
+            bOK = FALSE;
+            break;
+        }
+
+        VSITarEntryFileOffset* poOffset = NULL;
+        if (strcmp(papszTokens[0], "-1") != 0)
+            poOffset = new VSITarEntryFileOffset(CPLScanUIntBig(papszTokens[0], 32));
+        VSIArchiveAddEntry(content, CPLStrdup(pszName + 1),
+                           CPLScanUIntBig(papszTokens[1], 32), poOffset,
+                           atoi(papszTokens[3]), CPLAtoGIntBig(papszTokens[2]));
+        CSLDestroy(papszTokens);
+    }
+    VSIFCloseL(fp);
+
+    if (!bOK || content->nEntries == 0)
+    {
+        for(int i=0;i<content->nEntries;i++)
+        {
+            delete content->entries[i].file_pos;
+            CPLFree(content->entries[i].fileName);
+        }
+        CPLFree(content->entries);
+        delete content;
+        return NULL;
+    }
+
+    CPLDebug("VSITAR", "Using %s", osIndexFilename.c_str());
+    return content;
+}
+
+/************************************************************************/
+/*                          SaveContentIndex()                          */
+/************************************************************************/
+
+void VSITarFilesystemHandler::SaveContentIndex(const char* pszTarFileName,
+                                               const VSIArchiveContent* content)
+{
+    if (!CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_TAR_INDEX", "NO")))
+        return;
+
+    VSIStatBufL sStat;
+    if (VSIStatL(pszTarFileName, &sStat) != 0)
+        return;
+
+    int i;
+    for(i=0;i<content->nEntries;i++)
+    {
+        /* The format is line based */
+        if (strchr(content->entries[i].fileName, '\n') != NULL ||
+            strchr(content->entries[i].fileName, '\r') != NULL)
+            return;
+    }
+
+    CPLString osIndexFilename = CPLString(pszTarFileName) + ".taridx";
+    VSILFILE* fp = VSIFOpenL(osIndexFilename, "wb");
+    if (fp == NULL)
+    {
+        CPLDebug("VSITAR", "Cannot create %s", osIndexFilename.c_str());
+        return;
+    }
+
+    int bOK = VSIFPrintfL(fp, "GDAL_TAR_INDEX 1\n" CPL_FRMT_GUIB "\n" CPL_FRMT_GIB "\n",
+                          (GUIntBig)sStat.st_size, (GIntBig)sStat.st_mtime) > 0;
+    for(i=0;i<content->nEntries && bOK;i++)
+    {
+        const VSIArchiveEntry* psEntry = &content->entries[i];
+        CPLString osOffset("-1");
+        if (psEntry->file_pos != NULL)
+            osOffset.Printf(CPL_FRMT_GUIB,
+                            ((VSITarEntryFileOffset*)psEntry->file_pos)->nOffset);
+        bOK = VSIFPrintfL(fp, "%s " CPL_FRMT_GUIB " " CPL_FRMT_GIB " %d %s\n",
+                          osOffset.c_str(), (GUIntBig)psEntry->uncompressed_size,
+                          psEntry->nModifiedTime, psEntry->bIsDir,
+                          psEntry->fileName) > 0;
+    }
+    if (VSIFCloseL(fp) != 0)
+        bOK = FALSE;
+
+    if (!bOK)
+    {
+        CPLDebug("VSITAR", "Cannot write %s", osIndexFilename.c_str());
+        VSIUnlink(osIndexFilename);
+    }
+}
+
 /************************************************************************/
 /*                                 Open()                               */
 /************************************************************************/
@@ -268,20 +409,42 @@ VSIVirtualHandle* VSITarFilesystemHandler::Open( const char *pszFilename,
     if (tarFilename == NULL)
         return NULL;
 
-    VSIArchiveReader* poReader = OpenArchiveFile(tarFilename, osTarInFileName);
-    if (poReader == NULL)
+    GUIntBig nOffset, nSize;
+    if (osTarInFileName.size() != 0)
     {
-        CPLFree(tarFilename);
-        return NULL;
+        /* The offset and size are in the (cached) content of the archive */
+        /* so there is no need to read the header of the file */
+        const VSIArchiveEntry* archiveEntry = NULL;
+        if (!FindFileInArchive(tarFilename, osTarInFileName, &archiveEntry) ||
+            archiveEntry->bIsDir || archiveEntry->file_pos == NULL)
+        {
+            CPLFree(tarFilename);
+            return NULL;
+        }
+        nOffset = ((VSITarEntryFileOffset*)archiveEntry->file_pos)->nOffset;
+        nSize = archiveEntry->uncompressed_size;
+    }
+    else
+    {
+        VSIArchiveReader* poReader = OpenArchiveFile(tarFilename, osTarInFileName);
+        if (poReader == NULL)
+        {
+            CPLFree(tarFilename);
+            return NULL;
+        }
+
+        VSITarEntryFileOffset* pOffset = (VSITarEntryFileOffset*) poReader->GetFileOffset();
+        nOffset = pOffset->nOffset;
+        nSize = poReader->GetFileSize();
+        delete pOffset;
+        delete(poReader);
     }
 
     CPLString osSubFileName("/vsisubfile/");
-    VSITarEntryFileOffset* pOffset = (VSITarEntryFileOffset*) poReader->GetFileOffset();
-    osSubFileName += CPLString().Printf(CPL_FRMT_GUIB, pOffset->nOffset);
+    osSubFileName += CPLString().Printf(CPL_FRMT_GUIB, nOffset);
     osSubFileName += "_";
-    osSubFileName += CPLString().Printf(CPL_FRMT_GUIB, poReader->GetFileSize());
+    osSubFileName += CPLString().Printf(CPL_FRMT_GUIB, nSize);
     osSubFileName += ",";
-    delete pOffset;
     
     if (VSIIsTGZ(tarFilename))
     {
@@ -291,8 +454,6 @@ VSIVirtualHandle* VSITarFilesystemHandler::Open( const char *pszFilename,
     else
         osSubFileName += tarFilename;
 
-    delete(poReader);
-
     CPLFree(tarFilename);
     tarFilename = NULL;
 
@@ -328,6 +489,13 @@ VSIVirtualHandle* VSITarFilesystemHandler::Open( const char *pszFilename,
  *
  * Directory listing is available through VSIReadDir().
  *
+ * Listing the content of a .tar.gz/.tgz archive requires decompressing it
+ * entirely. If the CPL_VSIL_TAR_INDEX configuration option is set to YES,
+ * the list of files, with their offsets, is saved in a .taridx file next to
+ * the archive, and used by later opens as long as the size and modification
+ * time of the archive are unchanged. Setting it to NO disables the use of
+ * existing .taridx files.
+ *
  * @since GDAL 1.8.0
  */
 
@@ -45,13 +45,20 @@
 #include "cpl_vsi_virtual.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
+#include "cpl_worker_thread_pool.h"
 
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <errno.h>
 
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
 CPL_CVSID("$Id$");
 
 #if defined(UNIX_STDIO_64)
@@ -74,6 +81,12 @@ CPL_CVSID("$Id$");
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate64
 #endif
+#if !defined(VSI_PREAD64) && defined(HAVE_PREAD64)
+#define VSI_PREAD64 pread64
+#endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread
+#endif
 
 #else /* not UNIX_STDIO_64 */
 
@@ -95,9 +108,304 @@ CPL_CVSID("$Id$");
 #ifndef VSI_FTRUNCATE64
 #define VSI_FTRUNCATE64 ftruncate
 #endif
+#ifndef VSI_PREAD64
+#define VSI_PREAD64 pread
+#endif
 
 #endif /* ndef UNIX_STDIO_64 */
 
+/* Size of the submission queue of the io_uring used by ReadMultiRange() */
+#define VSI_IO_URING_QUEUE_DEPTH 64
+
+/************************************************************************/
+/*                           VSIPReadFully()                            */
+/*                                                                      */
+/*      Read nSize bytes at nOffset, without changing the file          */
+/*      position, retrying on short reads and interrupts. Returns       */
+/*      the number of bytes actually read.                              */
+/************************************************************************/
+
+static size_t VSIPReadFully( int fd, void* pBuffer, size_t nSize,
+                             vsi_l_offset nOffset )
+{
+    size_t nDone = 0;
+    while( nDone < nSize )
+    {
+        ssize_t nRet = VSI_PREAD64( fd, (GByte*)pBuffer + nDone,
+                                    nSize - nDone, nOffset + nDone );
+        if( nRet < 0 && errno == EINTR )
+            continue;
+        if( nRet <= 0 )
+            break;
+        nDone += (size_t)nRet;
+    }
+    return nDone;
+}
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+/************************************************************************/
+/* ==================================================================== */
+/*                             VSIIOURing                               */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Minimal io_uring wrapper issuing the raw system calls, so that we do */
+/* not depend on liburing. Only used for batches of positioned reads.   */
+
+class VSIIOURing
+{
+    int                  fdRing;
+    unsigned             nEntries;
+
+    void                *pSQRing;
+    size_t               nSQRingSize;
+    void                *pCQRing;
+    size_t               nCQRingSize;
+    struct io_uring_sqe *pasSQE;
+    size_t               nSQESize;
+
+    unsigned            *pnSQHead;
+    unsigned            *pnSQTail;
+    unsigned            *pnSQMask;
+    unsigned            *panSQArray;
+    unsigned            *pnCQHead;
+    unsigned            *pnCQTail;
+    unsigned            *pnCQMask;
+    struct io_uring_cqe *pasCQE;
+
+    void                 Release();
+
+  public:
+                         VSIIOURing();
+                        ~VSIIOURing();
+
+    int                  Init( unsigned nQueueDepth );
+    int                  ReadRanges( int fd, int nRanges, void ** ppData,
+                                     const vsi_l_offset* panOffsets,
+                                     const size_t* panSizes,
+                                     ssize_t* panResults );
+};
+
+/************************************************************************/
+/*                             VSIIOURing()                             */
+/************************************************************************/
+
+VSIIOURing::VSIIOURing() :
+    fdRing(-1), nEntries(0),
+    pSQRing(NULL), nSQRingSize(0), pCQRing(NULL), nCQRingSize(0),
+    pasSQE(NULL), nSQESize(0),
+    pnSQHead(NULL), pnSQTail(NULL), pnSQMask(NULL), panSQArray(NULL),
+    pnCQHead(NULL), pnCQTail(NULL), pnCQMask(NULL), pasCQE(NULL)
+{
+}
+
+/************************************************************************/
+/*                            ~VSIIOURing()                             */
+/************************************************************************/
+
+VSIIOURing::~VSIIOURing()
+{
+    Release();
+}
+
+/************************************************************************/
+/*                              Release()                               */
+/************************************************************************/
+
+void VSIIOURing::Release()
+{
+    if( pasSQE != NULL )
+        munmap( pasSQE, nSQESize );
+    if( pCQRing != NULL && pCQRing != pSQRing )
+        munmap( pCQRing, nCQRingSize );
+    if( pSQRing != NULL )
+        munmap( pSQRing, nSQRingSize );
+    if( fdRing >= 0 )
+        close( fdRing );
+    fdRing = -1;
+    pasSQE = NULL;
+    pSQRing = NULL;
+    pCQRing = NULL;
+}
+
+/************************************************************************/
+/*                                Init()                                */
+/************************************************************************/
+
+int VSIIOURing::Init( unsigned nQueueDepth )
+{
+    struct io_uring_params sParams;
+    memset( &sParams, 0, sizeof(sParams) );
+
+    fdRing = (int) syscall( __NR_io_uring_setup, nQueueDepth, &sParams );
+    if( fdRing < 0 )
+    {
+        CPLDebug( "VSI", "io_uring_setup() failed: %s",
+                  VSIStrerror(errno) );
+        return FALSE;
+    }
+
+    nEntries = sParams.sq_entries;
+    nSQRingSize = sParams.sq_off.array + sParams.sq_entries * sizeof(unsigned);
+    nCQRingSize = sParams.cq_off.cqes +
+                  sParams.cq_entries * sizeof(struct io_uring_cqe);
+    if( sParams.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        if( nCQRingSize > nSQRingSize )
+            nSQRingSize = nCQRingSize;
+        nCQRingSize = nSQRingSize;
+    }
+
+    pSQRing = mmap( NULL, nSQRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fdRing, IORING_OFF_SQ_RING );
+    if( pSQRing == MAP_FAILED )
+    {
+        pSQRing = NULL;
+        Release();
+        return FALSE;
+    }
+
+    if( sParams.features & IORING_FEAT_SINGLE_MMAP )
+        pCQRing = pSQRing;
+    else
+    {
+        pCQRing = mmap( NULL, nCQRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fdRing, IORING_OFF_CQ_RING );
+        if( pCQRing == MAP_FAILED )
+        {
+            pCQRing = NULL;
+            Release();
+            return FALSE;
+        }
+    }
+
+    nSQESize = sParams.sq_entries * sizeof(struct io_uring_sqe);
+    pasSQE = (struct io_uring_sqe*)
+        mmap( NULL, nSQESize, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fdRing, IORING_OFF_SQES );
+    if( pasSQE == MAP_FAILED )
+    {
+        pasSQE = NULL;
+        Release();
+        return FALSE;
+    }
+
+    GByte* pabySQ = (GByte*) pSQRing;
+    pnSQHead = (unsigned*) (pabySQ + sParams.sq_off.head);
+    pnSQTail = (unsigned*) (pabySQ + sParams.sq_off.tail);
+    pnSQMask = (unsigned*) (pabySQ + sParams.sq_off.ring_mask);
+    panSQArray = (unsigned*) (pabySQ + sParams.sq_off.array);
+
+    GByte* pabyCQ = (GByte*) pCQRing;
+    pnCQHead = (unsigned*) (pabyCQ + sParams.cq_off.head);
+    pnCQTail = (unsigned*) (pabyCQ + sParams.cq_off.tail);
+    pnCQMask = (unsigned*) (pabyCQ + sParams.cq_off.ring_mask);
+    pasCQE = (struct io_uring_cqe*) (pabyCQ + sParams.cq_off.cqes);
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                             ReadRanges()                             */
+/*                                                                      */
+/*      Submit all the reads, keeping up to nEntries of them in         */
+/*      flight. panResults[i] receives the result of the read of        */
+/*      range i (number of bytes read, or -errno). Returns FALSE if     */
+/*      the ring is unusable, in which case panResults[] of ranges      */
+/*      not processed are left untouched. In all cases, no read is in   */
+/*      flight anymore when this returns.                               */
+/************************************************************************/
+
+int VSIIOURing::ReadRanges( int fd, int nRanges, void ** ppData,
+                            const vsi_l_offset* panOffsets,
+                            const size_t* panSizes,
+                            ssize_t* panResults )
+{
+    int iNext = 0;
+    int nInFlight = 0;
+    int bOK = TRUE;
+
+    while( iNext < nRanges || nInFlight > 0 )
+    {
+/* -------------------------------------------------------------------- */
+/*      Queue new submissions while there is room in the ring.          */
+/* -------------------------------------------------------------------- */
+        unsigned nTail = *pnSQTail;
+        while( bOK && iNext < nRanges && (unsigned)nInFlight < nEntries )
+        {
+            const unsigned nIdx = nTail & *pnSQMask;
+            struct io_uring_sqe* psSQE = &pasSQE[nIdx];
+            memset( psSQE, 0, sizeof(*psSQE) );
+            psSQE->opcode = IORING_OP_READ;
+            psSQE->fd = fd;
+            psSQE->addr = (GUIntBig)(size_t) ppData[iNext];
+            /* Larger reads are completed by the caller as short reads */
+            psSQE->len = (unsigned) MIN(panSizes[iNext], (size_t)0x40000000);
+            psSQE->off = panOffsets[iNext];
+            psSQE->user_data = (GUIntBig) iNext;
+            panSQArray[nIdx] = nIdx;
+            nTail ++;
+            iNext ++;
+            nInFlight ++;
+        }
+        __atomic_store_n( pnSQTail, nTail, __ATOMIC_RELEASE );
+
+/* -------------------------------------------------------------------- */
+/*      Submit what the kernel has not consumed yet, and wait for at    */
+/*      least one completion.                                           */
+/* -------------------------------------------------------------------- */
+        const unsigned nToSubmit = bOK ?
+            nTail - __atomic_load_n( pnSQHead, __ATOMIC_ACQUIRE ) : 0;
+        int nRet = (int) syscall( __NR_io_uring_enter, fdRing, nToSubmit,
+                                  1, IORING_ENTER_GETEVENTS, NULL, 0 );
+        if( nRet < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY )
+        {
+            if( bOK )
+            {
+                CPLDebug( "VSI", "io_uring_enter() failed: %s",
+                          VSIStrerror(errno) );
+
+                /* Stop submitting, and withdraw the entries not consumed */
+                /* by the kernel. The reads it has consumed must complete */
+                /* before their buffers are handed back and the ring is */
+                /* destroyed. */
+                bOK = FALSE;
+                const unsigned nSQHead =
+                    __atomic_load_n( pnSQHead, __ATOMIC_ACQUIRE );
+                nInFlight -= (int)(nTail - nSQHead);
+                __atomic_store_n( pnSQTail, nSQHead, __ATOMIC_RELEASE );
+                iNext = nRanges;
+            }
+            else
+            {
+                /* Cannot wait in the kernel: poll the completion queue */
+                CPLSleep( 0.001 );
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Reap completions.                                               */
+/* -------------------------------------------------------------------- */
+        unsigned nHead = *pnCQHead;
+        const unsigned nCQTail = __atomic_load_n( pnCQTail, __ATOMIC_ACQUIRE );
+        while( nHead != nCQTail )
+        {
+            const struct io_uring_cqe* psCQE = &pasCQE[nHead & *pnCQMask];
+            const int iRange = (int) psCQE->user_data;
+            if( iRange >= 0 && iRange < nRanges )
+                panResults[iRange] = psCQE->res;
+            nHead ++;
+            nInFlight --;
+        }
+        __atomic_store_n( pnCQHead, nHead, __ATOMIC_RELEASE );
+    }
+
+    return bOK;
+}
+
+#endif /* HAVE_LINUX_IO_URING_H */
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
@@ -111,11 +419,27 @@ class VSIUnixStdioFilesystemHandler : public VSIFilesystemHandler
     CPLMutex     *hMutex;
 #endif
 
+#ifdef HAVE_LINUX_IO_URING_H
+    /* io_uring instances of ReadMultiRange(), lazily created. Each */
+    /* caller uses its own, so that concurrent batches are not */
+    /* serialized. */
+    CPLMutex     *hIOURingMutex;
+    std::vector<VSIIOURing*> apoFreeIOURings;
+    int           bIOURingUnavailable;
+
+    int           IOURingReadRanges( int fd, int nRanges, void ** ppData,
+                                     const vsi_l_offset* panOffsets,
+                                     const size_t* panSizes,
+                                     ssize_t* panResults );
+#endif
+    int           ThreadPoolReadRanges( int fd, int nRanges, void ** ppData,
+                                        const vsi_l_offset* panOffsets,
+                                        const size_t* panSizes,
+                                        ssize_t* panResults );
+
 public:
                               VSIUnixStdioFilesystemHandler();
-#ifdef VSI_COUNT_BYTES_READ
     virtual                  ~VSIUnixStdioFilesystemHandler();
-#endif
 
     virtual VSIVirtualHandle *Open( const char *pszFilename, 
                                     const char *pszAccess);
@@ -126,6 +450,10 @@ public:
     virtual int      Rmdir( const char *pszDirname );
     virtual char   **ReadDir( const char *pszDirname );
 
+    int              ReadMultiRange( int fd, int nRanges, void ** ppData,
+                                     const vsi_l_offset* panOffsets,
+                                     const size_t* panSizes );
+
 #ifdef VSI_COUNT_BYTES_READ
     void             AddToTotal(vsi_l_offset nBytes);
 #endif
@@ -145,17 +473,22 @@ class VSIUnixStdioHandle : public VSIVirtualHandle
     int           bLastOpWrite;
     int           bLastOpRead;
     int           bAtEOF;
+    VSIUnixStdioFilesystemHandler *poFS;
+    CPLString     osFilename;   /* only set for writable handles */
 #ifdef VSI_COUNT_BYTES_READ
     vsi_l_offset  nTotalBytesRead;
-    VSIUnixStdioFilesystemHandler *poFS;
 #endif
   public:
                       VSIUnixStdioHandle(VSIUnixStdioFilesystemHandler *poFSIn,
-                                         FILE* fpIn, int bReadOnlyIn);
+                                         FILE* fpIn, int bReadOnlyIn,
+                                         const char* pszFilename = NULL);
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
     virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       ReadMultiRange( int nRanges, void ** ppData,
+                                      const vsi_l_offset* panOffsets,
+                                      const size_t* panSizes );
     virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
     virtual int       Eof();
     virtual int       Flush();
@@ -169,17 +502,17 @@ class VSIUnixStdioHandle : public VSIVirtualHandle
 /*                       VSIUnixStdioHandle()                           */
 /************************************************************************/
 
-VSIUnixStdioHandle::VSIUnixStdioHandle(
-#ifndef VSI_COUNT_BYTES_READ
-CPL_UNUSED
-#endif
-                                       VSIUnixStdioFilesystemHandler *poFSIn,
-                                       FILE* fpIn, int bReadOnlyIn) :
-    fp(fpIn), nOffset(0), bReadOnly(bReadOnlyIn), bLastOpWrite(FALSE), bLastOpRead(FALSE), bAtEOF(FALSE)
+VSIUnixStdioHandle::VSIUnixStdioHandle( VSIUnixStdioFilesystemHandler *poFSIn,
+                                        FILE* fpIn, int bReadOnlyIn,
+                                        const char* pszFilename ) :
+    fp(fpIn), nOffset(0), bReadOnly(bReadOnlyIn), bLastOpWrite(FALSE), bLastOpRead(FALSE), bAtEOF(FALSE),
+    poFS(poFSIn)
 #ifdef VSI_COUNT_BYTES_READ
-    , nTotalBytesRead(0), poFS(poFSIn)
+    , nTotalBytesRead(0)
 #endif
 {
+    if( !bReadOnly && pszFilename != NULL )
+        osFilename = pszFilename;
 }
 
 /************************************************************************/
@@ -195,7 +528,13 @@ int VSIUnixStdioHandle::Close()
     poFS->AddToTotal(nTotalBytesRead);
 #endif
 
-    return fclose( fp );
+    int nRet = fclose( fp );
+
+    /* Pages of the shared VSI_CACHE read while we were writing are stale */
+    if( !bReadOnly && osFilename.size() )
+        VSIInvalidatePageCache( osFilename );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -365,6 +704,38 @@ size_t VSIUnixStdioHandle::Read( void * pBuffer, size_t nSize, size_t nCount )
     return nResult;
 }
 
+/************************************************************************/
+/*                           ReadMultiRange()                           */
+/************************************************************************/
+
+int VSIUnixStdioHandle::ReadMultiRange( int nRanges, void ** ppData,
+                                        const vsi_l_offset* panOffsets,
+                                        const size_t* panSizes )
+{
+    if( !CSLTestBoolean(
+            CPLGetConfigOption( "CPL_VSIL_LOCAL_ASYNC_IO", "NO" ) ) )
+        return VSIVirtualHandle::ReadMultiRange( nRanges, ppData,
+                                                 panOffsets, panSizes );
+
+/* -------------------------------------------------------------------- */
+/*      The positioned reads bypass the stdio buffer, so pending        */
+/*      writes must reach the file first. The file position is not      */
+/*      affected.                                                       */
+/* -------------------------------------------------------------------- */
+    if( bLastOpWrite )
+        fflush( fp );
+
+    int nRet = poFS->ReadMultiRange( fileno(fp), nRanges, ppData,
+                                     panOffsets, panSizes );
+
+#ifdef VSI_COUNT_BYTES_READ
+    for( int i = 0; i < nRanges; i++ )
+        nTotalBytesRead += panSizes[i];
+#endif
+
+    return nRet;
+}
+
 /************************************************************************/
 /*                               Write()                                */
 /************************************************************************/
@@ -429,6 +800,267 @@ int VSIUnixStdioHandle::Truncate( vsi_l_offset nNewSize )
 }
 
 
+/************************************************************************/
+/* ==================================================================== */
+/*                      VSIUnixStdioMMapHandle                          */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Number of consecutive reads needed to switch the madvise() hint */
+#define VSI_MMAP_PATTERN_THRESHOLD  4
+/* Reads larger than this are prefetched with MADV_WILLNEED */
+#define VSI_MMAP_WILLNEED_THRESHOLD (256 * 1024)
+
+/* Read-only handle on a local file mapped in memory as a whole. Reads */
+/* are plain memcpy() from the mapping, and GetMappedAddress() lets    */
+/* callers use the data in place.                                      */
+
+class VSIUnixStdioMMapHandle : public VSIVirtualHandle
+{
+    FILE          *fp;
+    GByte         *pabyMap;
+    size_t         nMapSize;
+    vsi_l_offset   nOffset;
+    int            bAtEOF;
+
+    /* Access pattern tracking for madvise() hints */
+    vsi_l_offset   nLastReadEnd;
+    int            nSequentialReads;
+    int            nRandomReads;
+    int            nAdvice;
+
+    void           Advise( int nNewAdvice, vsi_l_offset nStart, size_t nSize );
+    void           TrackAccess( vsi_l_offset nStart, size_t nSize );
+
+  public:
+                      VSIUnixStdioMMapHandle( FILE* fpIn, GByte* pabyMapIn,
+                                              size_t nMapSizeIn );
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell() { return nOffset; }
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       ReadMultiRange( int nRanges, void ** ppData,
+                                      const vsi_l_offset* panOffsets,
+                                      const size_t* panSizes );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof() { return bAtEOF; }
+    virtual int       Close();
+    virtual void     *GetNativeFileDescriptor() { return (void*) (size_t) fileno(fp); }
+    virtual const void *GetMappedAddress( vsi_l_offset nOffset, size_t nSize );
+
+    static VSIVirtualHandle *Create( FILE* fp );
+};
+
+/************************************************************************/
+/*                      VSIUnixStdioMMapHandle()                        */
+/************************************************************************/
+
+VSIUnixStdioMMapHandle::VSIUnixStdioMMapHandle( FILE* fpIn, GByte* pabyMapIn,
+                                                size_t nMapSizeIn ) :
+    fp(fpIn), pabyMap(pabyMapIn), nMapSize(nMapSizeIn), nOffset(0),
+    bAtEOF(FALSE), nLastReadEnd(0), nSequentialReads(0), nRandomReads(0),
+    nAdvice(MADV_NORMAL)
+{
+}
+
+/************************************************************************/
+/*                               Create()                               */
+/*                                                                      */
+/*      Map the file opened as fp. Returns NULL, leaving fp open, if    */
+/*      the file cannot be mapped (empty, too large for the address     */
+/*      space, special file...).                                        */
+/************************************************************************/
+
+VSIVirtualHandle *VSIUnixStdioMMapHandle::Create( FILE* fp )
+{
+    struct stat sStat;
+    if( fstat( fileno(fp), &sStat ) != 0 || !S_ISREG(sStat.st_mode) )
+        return NULL;
+
+    GUIntBig nFileSize = (GUIntBig) sStat.st_size;
+    if( nFileSize == 0 || nFileSize != (GUIntBig)(size_t)nFileSize )
+        return NULL;
+
+    void* pMap = mmap( NULL, (size_t)nFileSize, PROT_READ, MAP_SHARED,
+                       fileno(fp), 0 );
+    if( pMap == MAP_FAILED )
+    {
+        CPLDebug( "VSI", "mmap() failed: %s", VSIStrerror(errno) );
+        return NULL;
+    }
+
+    return new VSIUnixStdioMMapHandle( fp, (GByte*) pMap, (size_t)nFileSize );
+}
+
+/************************************************************************/
+/*                               Close()                                */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::Close()
+{
+    munmap( pabyMap, nMapSize );
+    pabyMap = NULL;
+    return fclose( fp );
+}
+
+/************************************************************************/
+/*                               Advise()                               */
+/************************************************************************/
+
+void VSIUnixStdioMMapHandle::Advise( int nNewAdvice, vsi_l_offset nStart,
+                                     size_t nSize )
+{
+    /* madvise() wants a page aligned start address */
+    const size_t nPageSize = (size_t) sysconf( _SC_PAGESIZE );
+    const size_t nAlignedStart = (size_t)nStart - ((size_t)nStart % nPageSize);
+    madvise( pabyMap + nAlignedStart, nSize + ((size_t)nStart - nAlignedStart),
+             nNewAdvice );
+}
+
+/************************************************************************/
+/*                             TrackAccess()                            */
+/*                                                                      */
+/*      Switch the whole mapping to MADV_SEQUENTIAL or MADV_RANDOM      */
+/*      once a run of reads shows a clear pattern, and ask for large    */
+/*      ranges to be prefetched.                                        */
+/************************************************************************/
+
+void VSIUnixStdioMMapHandle::TrackAccess( vsi_l_offset nStart, size_t nSize )
+{
+    if( nStart == nLastReadEnd )
+    {
+        nSequentialReads ++;
+        nRandomReads = 0;
+    }
+    else
+    {
+        nRandomReads ++;
+        nSequentialReads = 0;
+    }
+    nLastReadEnd = nStart + nSize;
+
+    if( nSequentialReads >= VSI_MMAP_PATTERN_THRESHOLD
+        && nAdvice != MADV_SEQUENTIAL )
+    {
+        nAdvice = MADV_SEQUENTIAL;
+        Advise( nAdvice, 0, nMapSize );
+    }
+    else if( nRandomReads >= VSI_MMAP_PATTERN_THRESHOLD
+             && nAdvice != MADV_RANDOM )
+    {
+        nAdvice = MADV_RANDOM;
+        Advise( nAdvice, 0, nMapSize );
+    }
+
+    if( nSize >= VSI_MMAP_WILLNEED_THRESHOLD && nAdvice != MADV_SEQUENTIAL )
+        Advise( MADV_WILLNEED, nStart, nSize );
+}
+
+/************************************************************************/
+/*                                Seek()                                */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::Seek( vsi_l_offset nNewOffset, int nWhence )
+{
+    bAtEOF = FALSE;
+
+    if( nWhence == SEEK_SET )
+        nOffset = nNewOffset;
+    else if( nWhence == SEEK_CUR )
+        nOffset += nNewOffset;
+    else if( nWhence == SEEK_END )
+        nOffset = nMapSize + nNewOffset;
+    else
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                                Read()                                */
+/************************************************************************/
+
+size_t VSIUnixStdioMMapHandle::Read( void * pBuffer, size_t nSize,
+                                     size_t nCount )
+{
+    if( nSize == 0 || nCount == 0 )
+        return 0;
+
+    size_t nBytesToRead = nSize * nCount;
+    if( nOffset >= nMapSize )
+    {
+        bAtEOF = TRUE;
+        return 0;
+    }
+    if( nBytesToRead > nMapSize - nOffset )
+    {
+        nBytesToRead = (size_t)(nMapSize - nOffset);
+        nBytesToRead -= nBytesToRead % nSize;
+        bAtEOF = TRUE;
+    }
+
+    TrackAccess( nOffset, nBytesToRead );
+    memcpy( pBuffer, pabyMap + nOffset, nBytesToRead );
+    nOffset += nBytesToRead;
+
+    return nBytesToRead / nSize;
+}
+
+/************************************************************************/
+/*                           ReadMultiRange()                           */
+/************************************************************************/
+
+int VSIUnixStdioMMapHandle::ReadMultiRange( int nRanges, void ** ppData,
+                                            const vsi_l_offset* panOffsets,
+                                            const size_t* panSizes )
+{
+    int i;
+
+    for( i = 0; i < nRanges; i++ )
+    {
+        if( panOffsets[i] > nMapSize || panSizes[i] > nMapSize - panOffsets[i] )
+            return -1;
+    }
+
+    /* Let the kernel page in all the ranges concurrently before copying */
+    for( i = 0; i < nRanges; i++ )
+        Advise( MADV_WILLNEED, panOffsets[i], panSizes[i] );
+
+    for( i = 0; i < nRanges; i++ )
+        memcpy( ppData[i], pabyMap + panOffsets[i], panSizes[i] );
+
+    return 0;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+size_t VSIUnixStdioMMapHandle::Write( CPL_UNUSED const void * pBuffer,
+                                      CPL_UNUSED size_t nSize,
+                                      CPL_UNUSED size_t nCount )
+{
+    errno = EBADF;
+    return 0;
+}
+
+/************************************************************************/
+/*                          GetMappedAddress()                          */
+/************************************************************************/
+
+const void *VSIUnixStdioMMapHandle::GetMappedAddress( vsi_l_offset nStart,
+                                                      size_t nSize )
+{
+    if( nStart > nMapSize || nSize > nMapSize - nStart )
+        return NULL;
+
+    TrackAccess( nStart, nSize );
+    return pabyMap + nStart;
+}
+
 /************************************************************************/
 /* ==================================================================== */
 /*                       VSIUnixStdioFilesystemHandler                  */
@@ -444,15 +1076,19 @@ VSIUnixStdioFilesystemHandler::VSIUnixStdioFilesystemHandler()
      : nTotalBytesRead(0), hMutex(NULL)
 #endif
 {
+#ifdef HAVE_LINUX_IO_URING_H
+    hIOURingMutex = NULL;
+    bIOURingUnavailable = FALSE;
+#endif
 }
 
-#ifdef VSI_COUNT_BYTES_READ
 /************************************************************************/
 /*                     ~VSIUnixStdioFilesystemHandler()                 */
 /************************************************************************/
 
 VSIUnixStdioFilesystemHandler::~VSIUnixStdioFilesystemHandler()
 {
+#ifdef VSI_COUNT_BYTES_READ
     CPLDebug( "VSI",
               "~VSIUnixStdioFilesystemHandler() : nTotalBytesRead = " CPL_FRMT_GUIB,
               nTotalBytesRead );
@@ -460,9 +1096,176 @@ VSIUnixStdioFilesystemHandler::~VSIUnixStdioFilesystemHandler()
     if( hMutex != NULL )
         CPLDestroyMutex( hMutex );
     hMutex = NULL;
+#endif
+
+#ifdef HAVE_LINUX_IO_URING_H
+    for( size_t i = 0; i < apoFreeIOURings.size(); i++ )
+        delete apoFreeIOURings[i];
+    if( hIOURingMutex != NULL )
+        CPLDestroyMutex( hIOURingMutex );
+#endif
+}
+
+/************************************************************************/
+/*                           ReadMultiRange()                           */
+/*                                                                      */
+/*      Read a batch of ranges with positioned reads, so that they      */
+/*      can be in flight concurrently. CPL_VSIL_LOCAL_ASYNC_IO selects  */
+/*      the backend: YES or AUTO (io_uring if available, else a thread  */
+/*      pool), IO_URING, THREADS, or PREAD (sequential positioned       */
+/*      reads). It defaults to NO, which does not reach this method.    */
+/************************************************************************/
+
+int VSIUnixStdioFilesystemHandler::ReadMultiRange( int fd, int nRanges,
+                                                   void ** ppData,
+                                                   const vsi_l_offset* panOffsets,
+                                                   const size_t* panSizes )
+{
+    if( nRanges <= 0 )
+        return 0;
+
+    const char* pszMode = CPLGetConfigOption( "CPL_VSIL_LOCAL_ASYNC_IO", "NO" );
+    const int bAuto = !EQUAL(pszMode, "IO_URING") && !EQUAL(pszMode, "THREADS")
+                      && !EQUAL(pszMode, "PREAD");
+
+    std::vector<ssize_t> anResults( nRanges, -1 );
+    int bDone = FALSE;
+
+    if( nRanges > 1 )
+    {
+#ifdef HAVE_LINUX_IO_URING_H
+        if( bAuto || EQUAL(pszMode, "IO_URING") )
+            bDone = IOURingReadRanges( fd, nRanges, ppData, panOffsets,
+                                       panSizes, &anResults[0] );
+#endif
+        if( !bDone && (bAuto || EQUAL(pszMode, "THREADS")) )
+            bDone = ThreadPoolReadRanges( fd, nRanges, ppData, panOffsets,
+                                          panSizes, &anResults[0] );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Complete short or failed reads, or do everything here if no     */
+/*      concurrent backend was used.                                    */
+/* -------------------------------------------------------------------- */
+    int nRet = 0;
+    for( int i = 0; i < nRanges; i++ )
+    {
+        size_t nRead = anResults[i] > 0 ? (size_t)anResults[i] : 0;
+        if( nRead < panSizes[i] )
+            nRead += VSIPReadFully( fd, (GByte*)ppData[i] + nRead,
+                                    panSizes[i] - nRead,
+                                    panOffsets[i] + nRead );
+        if( nRead != panSizes[i] )
+            nRet = -1;
+    }
+
+    return nRet;
+}
+
+#ifdef HAVE_LINUX_IO_URING_H
+/************************************************************************/
+/*                         IOURingReadRanges()                          */
+/************************************************************************/
+
+int VSIUnixStdioFilesystemHandler::IOURingReadRanges( int fd, int nRanges,
+                                                      void ** ppData,
+                                                      const vsi_l_offset* panOffsets,
+                                                      const size_t* panSizes,
+                                                      ssize_t* panResults )
+{
+/* -------------------------------------------------------------------- */
+/*      Take a free ring, or create a new one if all are in use by      */
+/*      concurrent callers.                                             */
+/* -------------------------------------------------------------------- */
+    VSIIOURing* poIOURing = NULL;
+    {
+        CPLMutexHolder oHolder( &hIOURingMutex );
+        if( bIOURingUnavailable )
+            return FALSE;
+        if( !apoFreeIOURings.empty() )
+        {
+            poIOURing = apoFreeIOURings.back();
+            apoFreeIOURings.pop_back();
+        }
+    }
+    if( poIOURing == NULL )
+    {
+        poIOURing = new VSIIOURing();
+        if( !poIOURing->Init( VSI_IO_URING_QUEUE_DEPTH ) )
+        {
+            delete poIOURing;
+            CPLMutexHolder oHolder( &hIOURingMutex );
+            bIOURingUnavailable = TRUE;
+            return FALSE;
+        }
+    }
+
+    if( !poIOURing->ReadRanges( fd, nRanges, ppData, panOffsets, panSizes,
+                                panResults ) )
+    {
+        delete poIOURing;
+        return FALSE;
+    }
+
+    CPLMutexHolder oHolder( &hIOURingMutex );
+    apoFreeIOURings.push_back( poIOURing );
+    return TRUE;
 }
 #endif
 
+/************************************************************************/
+/*                        ThreadPoolReadRanges()                        */
+/************************************************************************/
+
+typedef struct
+{
+    int           fd;
+    void         *pBuffer;
+    vsi_l_offset  nOffset;
+    size_t        nSize;
+    ssize_t      *pnResult;
+} VSIPReadJob;
+
+static void VSIPReadJobFunc( void* pData )
+{
+    VSIPReadJob* psJob = (VSIPReadJob*) pData;
+    *(psJob->pnResult) = (ssize_t) VSIPReadFully( psJob->fd, psJob->pBuffer,
+                                                  psJob->nSize, psJob->nOffset );
+}
+
+int VSIUnixStdioFilesystemHandler::ThreadPoolReadRanges( int fd, int nRanges,
+                                                         void ** ppData,
+                                                         const vsi_l_offset* panOffsets,
+                                                         const size_t* panSizes,
+                                                         ssize_t* panResults )
+{
+    const int nThreads = atoi(
+        CPLGetConfigOption( "CPL_VSIL_LOCAL_ASYNC_IO_THREADS", "4" ) );
+    if( nThreads <= 1 )
+        return FALSE;
+
+    CPLWorkerThreadPool* poPool =
+        CPLGetGlobalWorkerThreadPool( MIN(nThreads, 64) );
+    if( poPool == NULL )
+        return FALSE;
+
+    int nPendingJobs = 0;
+    std::vector<VSIPReadJob> asJobs( nRanges );
+    for( int i = 0; i < nRanges; i++ )
+    {
+        asJobs[i].fd = fd;
+        asJobs[i].pBuffer = ppData[i];
+        asJobs[i].nOffset = panOffsets[i];
+        asJobs[i].nSize = panSizes[i];
+        asJobs[i].pnResult = &panResults[i];
+        if( !poPool->SubmitJob( VSIPReadJobFunc, &asJobs[i], &nPendingJobs ) )
+            VSIPReadJobFunc( &asJobs[i] );
+    }
+    poPool->WaitGroupCompletion( &nPendingJobs );
+
+    return TRUE;
+}
+
 /************************************************************************/
 /*                                Open()                                */
 /************************************************************************/
@@ -485,7 +1288,28 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
     }
 
     int bReadOnly = strcmp(pszAccess, "rb") == 0 || strcmp(pszAccess, "r") == 0;
-    VSIUnixStdioHandle *poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly );
+
+/* -------------------------------------------------------------------- */
+/*      If CPL_VSIL_LOCAL_MMAP is set, read-only files are mapped in    */
+/*      memory. Note that the process gets a SIGBUS if the file is      */
+/*      truncated by someone else while mapped.                         */
+/* -------------------------------------------------------------------- */
+    if( bReadOnly
+        && CSLTestBoolean( CPLGetConfigOption( "CPL_VSIL_LOCAL_MMAP", "NO" ) ) )
+    {
+        VSIVirtualHandle* poMMapHandle = VSIUnixStdioMMapHandle::Create( fp );
+        if( poMMapHandle != NULL )
+        {
+            errno = nError;
+            return poMMapHandle;
+        }
+    }
+
+    if( !bReadOnly )
+        VSIInvalidatePageCache( pszFilename );
+
+    VSIUnixStdioHandle *poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly,
+                                                          pszFilename );
 
     errno = nError;
 
@@ -496,7 +1320,7 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
     if( bReadOnly
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     }
     else
     {
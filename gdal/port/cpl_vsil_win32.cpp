@@ -85,6 +85,7 @@ class VSIWin32Handle : public VSIVirtualHandle
   public:
     HANDLE       hFile;
     int          bEOF;
+    CPLString    osFilename;   /* only set for writable handles */
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
@@ -189,7 +190,13 @@ static int ErrnoFromGetLastError()
 int VSIWin32Handle::Close()
 
 {
-    return CloseHandle( hFile ) ? 0 : -1;
+    int nRet = CloseHandle( hFile ) ? 0 : -1;
+
+    /* Pages of the shared VSI_CACHE read while we were writing are stale */
+    if( osFilename.size() )
+        VSIInvalidatePageCache( osFilename );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -437,6 +444,11 @@ VSIVirtualHandle *VSIWin32FilesystemHandler::Open( const char *pszFilename,
     
     poHandle->hFile = hFile;
     poHandle->bEOF = FALSE;
+    if( dwDesiredAccess != GENERIC_READ )
+    {
+        VSIInvalidatePageCache( pszFilename );
+        poHandle->osFilename = pszFilename;
+    }
     
     if (strchr(pszAccess, 'a') != 0)
         poHandle->Seek(0, SEEK_END);
@@ -448,7 +460,7 @@ VSIVirtualHandle *VSIWin32FilesystemHandler::Open( const char *pszFilename,
     if( (EQUAL(pszAccess,"r") || EQUAL(pszAccess,"rb"))
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     }
     else
     {
@@ -0,0 +1,398 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  CPL worker thread pool
+ *
+ **********************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_worker_thread_pool.h"
+#include "cpl_conv.h"
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                         CPLWorkerThreadPool()                        */
+/************************************************************************/
+
+/** Instanciate a new pool of worker threads.
+ *
+ * The pool is in an uninitialized state after this call. The Setup() method
+ * must be called.
+ */
+CPLWorkerThreadPool::CPLWorkerThreadPool()
+{
+    hMutex = NULL;
+    hCondJob = NULL;
+    hCondDone = NULL;
+    nPendingJobs = 0;
+    bStop = FALSE;
+}
+
+/************************************************************************/
+/*                          ~CPLWorkerThreadPool()                      */
+/************************************************************************/
+
+/** Destroy a pool of worker threads.
+ *
+ * Any pending job will be completed before the destructor returns.
+ */
+CPLWorkerThreadPool::~CPLWorkerThreadPool()
+{
+    if( hMutex != NULL )
+    {
+        WaitCompletion();
+
+        CPLAcquireMutex( hMutex, 1000.0 );
+        bStop = TRUE;
+        CPLCondBroadcast( hCondJob );
+        CPLReleaseMutex( hMutex );
+
+        for( size_t i = 0; i < ahThreads.size(); i++ )
+            CPLJoinThread( ahThreads[i] );
+
+        CPLDestroyCond( hCondJob );
+        CPLDestroyCond( hCondDone );
+        CPLDestroyMutex( hMutex );
+    }
+}
+
+/************************************************************************/
+/*                        WorkerThreadFunction()                        */
+/************************************************************************/
+
+void CPLWorkerThreadPool::WorkerThreadFunction( void* pData )
+{
+    CPLWorkerThreadPool* poPool = (CPLWorkerThreadPool*) pData;
+
+    CPLAcquireMutex( poPool->hMutex, 1000.0 );
+    while( TRUE )
+    {
+        while( poPool->asJobQueue.empty() && !poPool->bStop )
+            CPLCondWait( poPool->hCondJob, poPool->hMutex );
+        if( poPool->asJobQueue.empty() )
+            break;
+
+        CPLWorkerThreadJob sJob = poPool->asJobQueue.front();
+        poPool->asJobQueue.pop_front();
+        CPLReleaseMutex( poPool->hMutex );
+
+        sJob.pfnFunc( sJob.pData );
+
+        CPLAcquireMutex( poPool->hMutex, 1000.0 );
+        poPool->nPendingJobs --;
+        if( sJob.pnGroupPendingJobs != NULL )
+            (*sJob.pnGroupPendingJobs) --;
+        CPLCondBroadcast( poPool->hCondDone );
+    }
+    CPLReleaseMutex( poPool->hMutex );
+}
+
+/************************************************************************/
+/*                               Setup()                                */
+/************************************************************************/
+
+/** Setup the pool.
+ *
+ * Setup() may be called again on an initialized pool to grow it.  It must
+ * not be called concurrently with another Setup() call, but the pool can
+ * be used by other threads while it is grown.
+ *
+ * @param nThreads Number of threads of the pool.
+ * @return TRUE if the pool was correctly initialized, FALSE otherwise (in
+ * which case it should not be used).
+ */
+int CPLWorkerThreadPool::Setup( int nThreads )
+{
+    CPLAssert( nThreads >= 1 );
+
+    if( hMutex != NULL )
+        return LaunchThreads( nThreads );
+
+    hCondJob = CPLCreateCond();
+    hCondDone = CPLCreateCond();
+    hMutex = CPLCreateMutex();
+    if( hMutex == NULL || hCondJob == NULL || hCondDone == NULL )
+    {
+        if( hCondJob != NULL )
+            CPLDestroyCond( hCondJob );
+        if( hCondDone != NULL )
+            CPLDestroyCond( hCondDone );
+        if( hMutex != NULL )
+        {
+            CPLReleaseMutex( hMutex );
+            CPLDestroyMutex( hMutex );
+        }
+        hMutex = NULL;
+        hCondJob = NULL;
+        hCondDone = NULL;
+        return FALSE;
+    }
+    CPLReleaseMutex( hMutex );
+
+    return LaunchThreads( nThreads );
+}
+
+/************************************************************************/
+/*                           LaunchThreads()                            */
+/************************************************************************/
+
+int CPLWorkerThreadPool::LaunchThreads( int nThreads )
+{
+    for( int i = GetThreadCount(); i < nThreads; i++ )
+    {
+        CPLJoinableThread* hThread =
+            CPLCreateJoinableThread( WorkerThreadFunction, this );
+        if( hThread == NULL )
+            break;
+        CPLAcquireMutex( hMutex, 1000.0 );
+        ahThreads.push_back( hThread );
+        CPLReleaseMutex( hMutex );
+    }
+
+    /* The destructor will stop the threads that could be launched */
+    return GetThreadCount() >= nThreads;
+}
+
+/************************************************************************/
+/*                           GetThreadCount()                           */
+/************************************************************************/
+
+/** Return the number of threads of the pool.
+ *
+ * May be called while another thread grows the pool with Setup().
+ */
+int CPLWorkerThreadPool::GetThreadCount() const
+{
+    if( hMutex == NULL )
+        return 0;
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    int nThreads = (int)ahThreads.size();
+    CPLReleaseMutex( hMutex );
+
+    return nThreads;
+}
+
+/************************************************************************/
+/*                             SubmitJob()                              */
+/************************************************************************/
+
+/** Queue a new job.
+ *
+ * Jobs are started in the order they are submitted, by the first available
+ * thread.
+ *
+ * @param pfnFunc Function to run for the job.
+ * @param pData User data to pass to the job function.
+ * @param pnGroupPendingJobs Counter of the pending jobs of the group the job
+ *                           belongs to, or NULL.  It is incremented by this
+ *                           call, and decremented when the job is done.  It
+ *                           must be initialized to 0 before the first job of
+ *                           the group is submitted, and only be read through
+ *                           WaitGroupCompletion().
+ * @return TRUE in case of success.
+ */
+int CPLWorkerThreadPool::SubmitJob( CPLThreadFunc pfnFunc, void* pData,
+                                    int* pnGroupPendingJobs )
+{
+    if( hMutex == NULL )
+        return FALSE;
+
+    CPLWorkerThreadJob sJob;
+    sJob.pfnFunc = pfnFunc;
+    sJob.pData = pData;
+    sJob.pnGroupPendingJobs = pnGroupPendingJobs;
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    if( ahThreads.empty() )
+    {
+        CPLReleaseMutex( hMutex );
+        return FALSE;
+    }
+    asJobQueue.push_back( sJob );
+    nPendingJobs ++;
+    if( pnGroupPendingJobs != NULL )
+        (*pnGroupPendingJobs) ++;
+    CPLCondSignal( hCondJob );
+    CPLReleaseMutex( hMutex );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                            WaitCompletion()                          */
+/************************************************************************/
+
+/** Wait for completion of part or whole jobs.
+ *
+ * @param nMaxRemainingJobs Maximum number of pendings jobs that are allowed
+ *                          in the queue after this method has completed. Might
+ *                          be 0 to wait for all jobs.
+ */
+void CPLWorkerThreadPool::WaitCompletion( int nMaxRemainingJobs )
+{
+    if( hMutex == NULL )
+        return;
+
+    if( nMaxRemainingJobs < 0 )
+        nMaxRemainingJobs = 0;
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    while( nPendingJobs > nMaxRemainingJobs )
+        CPLCondWait( hCondDone, hMutex );
+    CPLReleaseMutex( hMutex );
+}
+
+/************************************************************************/
+/*                         WaitGroupCompletion()                        */
+/************************************************************************/
+
+/** Wait for completion of the jobs of a group.
+ *
+ * Jobs of the group that have not been started by a worker thread yet are
+ * run by the calling thread.  This saves waiting for a worker to become
+ * available, and prevents dead-locks when the calling thread is itself a
+ * worker of the pool.
+ *
+ * With a non-negative dfMaxWaitInSeconds, the method returns as soon as
+ * it has run one job of the group, or waited that long for a job of the
+ * group to be done, so that the caller can report progress in between.
+ *
+ * With a positive nMaxRemainingJobs, the method returns once the group has
+ * no more than that many pending jobs.  Waiting so before each SubmitJob()
+ * bounds the number of jobs a user has in flight, whatever the number of
+ * threads of the (shared) pool.
+ *
+ * @param pnGroupPendingJobs Counter of the group, as passed to SubmitJob().
+ * @param dfMaxWaitInSeconds Maximum time to wait for a job of the group, or
+ *                           negative to wait for all of them.
+ * @param nMaxRemainingJobs Maximum number of pending jobs of the group that
+ *                          are allowed after this method has completed.
+ * @return TRUE if no more than nMaxRemainingJobs jobs of the group are
+ *         pending.
+ */
+int CPLWorkerThreadPool::WaitGroupCompletion( int* pnGroupPendingJobs,
+                                              double dfMaxWaitInSeconds,
+                                              int nMaxRemainingJobs )
+{
+    if( hMutex == NULL )
+        return TRUE;
+
+    if( nMaxRemainingJobs < 0 )
+        nMaxRemainingJobs = 0;
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+    while( *pnGroupPendingJobs > nMaxRemainingJobs )
+    {
+        std::deque<CPLWorkerThreadJob>::iterator oIter = asJobQueue.begin();
+        while( oIter != asJobQueue.end()
+               && oIter->pnGroupPendingJobs != pnGroupPendingJobs )
+            ++oIter;
+
+        if( oIter == asJobQueue.end() )
+        {
+            if( dfMaxWaitInSeconds < 0 )
+            {
+                CPLCondWait( hCondDone, hMutex );
+                continue;
+            }
+            CPLCondTimedWait( hCondDone, hMutex, dfMaxWaitInSeconds );
+            break;
+        }
+
+        CPLWorkerThreadJob sJob = *oIter;
+        asJobQueue.erase( oIter );
+        CPLReleaseMutex( hMutex );
+
+        sJob.pfnFunc( sJob.pData );
+
+        CPLAcquireMutex( hMutex, 1000.0 );
+        nPendingJobs --;
+        (*pnGroupPendingJobs) --;
+        CPLCondBroadcast( hCondDone );
+
+        if( dfMaxWaitInSeconds >= 0 )
+            break;
+    }
+    int bDone = (*pnGroupPendingJobs <= nMaxRemainingJobs);
+    CPLReleaseMutex( hMutex );
+
+    return bDone;
+}
+
+/************************************************************************/
+/*                    CPLGetGlobalWorkerThreadPool()                    */
+/************************************************************************/
+
+static CPLMutex            *hGlobalPoolMutex = NULL;
+static CPLWorkerThreadPool *poGlobalPool = NULL;
+
+/** Return the process-wide pool of worker threads.
+ *
+ * The pool is created on the first call, and grown when more threads than
+ * it currently has are requested.  Its threads are kept alive between uses,
+ * which avoids thread creation costs for short lived jobs.  Users should
+ * submit their jobs as a group (see SubmitJob()) and wait for them with
+ * WaitGroupCompletion().
+ *
+ * @param nThreads Minimum number of threads of the pool.
+ * @return the pool, or NULL if it could not be set up.
+ */
+CPLWorkerThreadPool *CPLGetGlobalWorkerThreadPool( int nThreads )
+{
+    CPLMutexHolderD( &hGlobalPoolMutex );
+
+    if( poGlobalPool == NULL )
+        poGlobalPool = new CPLWorkerThreadPool();
+
+    if( poGlobalPool->GetThreadCount() < nThreads )
+        poGlobalPool->Setup( nThreads );
+
+    if( poGlobalPool->GetThreadCount() == 0 )
+        return NULL;
+
+    return poGlobalPool;
+}
+
+/************************************************************************/
+/*                  CPLCleanupGlobalWorkerThreadPool()                  */
+/************************************************************************/
+
+/** Stop the threads of the process-wide pool of worker threads.
+ *
+ * Called by GDALDestroyDriverManager().
+ */
+void CPLCleanupGlobalWorkerThreadPool()
+{
+    if( hGlobalPoolMutex != NULL )
+    {
+        {
+            CPLMutexHolderD( &hGlobalPoolMutex );
+            delete poGlobalPool;
+            poGlobalPool = NULL;
+        }
+        CPLDestroyMutex( hGlobalPoolMutex );
+        hGlobalPoolMutex = NULL;
+    }
+}
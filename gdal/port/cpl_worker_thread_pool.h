@@ -0,0 +1,92 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  CPL worker thread pool
+ *
+ **********************************************************************
+ * Copyright (c) 2015, The GDAL project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef _CPL_WORKER_THREAD_POOL_H_INCLUDED_
+#define _CPL_WORKER_THREAD_POOL_H_INCLUDED_
+
+#include "cpl_multiproc.h"
+
+#include <vector>
+#include <deque>
+
+/**
+ * \file cpl_worker_thread_pool.h
+ *
+ * Class to manage a pool of worker threads.
+ */
+
+#ifndef DOXYGEN_SKIP
+typedef struct
+{
+    CPLThreadFunc pfnFunc;
+    void         *pData;
+    int          *pnGroupPendingJobs;
+} CPLWorkerThreadJob;
+#endif
+
+/** Pool of worker threads processing jobs in submission order.
+ *
+ * Jobs can be submitted as part of a group, identified by a counter of
+ * pending jobs owned by the caller, and be waited for independently of the
+ * other jobs of the pool with WaitGroupCompletion().  This allows a single
+ * pool to be shared by several users (see CPLGetGlobalWorkerThreadPool()).
+ */
+class CPL_DLL CPLWorkerThreadPool
+{
+        std::vector<CPLJoinableThread*> ahThreads;
+        std::deque<CPLWorkerThreadJob>  asJobQueue;
+
+        CPLMutex           *hMutex;
+        CPLCond            *hCondJob;   /* signaled when a job is queued */
+        CPLCond            *hCondDone;  /* signaled when a job is done */
+
+        int                 nPendingJobs; /* queued and running jobs */
+        int                 bStop;
+
+        static void         WorkerThreadFunction( void* pData );
+        int                 LaunchThreads( int nThreads );
+
+    public:
+                            CPLWorkerThreadPool();
+                           ~CPLWorkerThreadPool();
+
+        int                 Setup( int nThreads );
+        int                 SubmitJob( CPLThreadFunc pfnFunc, void* pData,
+                                       int* pnGroupPendingJobs = NULL );
+        void                WaitCompletion( int nMaxRemainingJobs = 0 );
+        int                 WaitGroupCompletion( int* pnGroupPendingJobs,
+                                                 double dfMaxWaitInSeconds = -1.0,
+                                                 int nMaxRemainingJobs = 0 );
+
+        int                 GetThreadCount() const;
+};
+
+CPLWorkerThreadPool CPL_DLL *CPLGetGlobalWorkerThreadPool( int nThreads );
+void CPL_DLL CPLCleanupGlobalWorkerThreadPool( void );
+
+#endif // _CPL_WORKER_THREAD_POOL_H_INCLUDED_